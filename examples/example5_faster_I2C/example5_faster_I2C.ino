@@ -10,6 +10,10 @@
   This example also allows you to run the accel and gyro at different rates,
   should you want to.
 
+  The status, temperature, gyro and accel registers are read together with
+  getAllData() which only needs a single I2C transaction per loop. The
+  "Ready" flags tell us which of the sensors had new data.
+
   Tested on ATmega328P (16MHz). Please see this issue for more detail:
   https://github.com/sparkfun/SparkFun_6DoF_ISM330DHCX_Arduino_Library/issues/7#issuecomment-1295767690
   
@@ -36,9 +40,8 @@
 
 SparkFun_ISM330DHCX myISM;
 
-// Structs for X,Y,Z data
-sfe_ism_data_t accelData;
-sfe_ism_data_t gyroData;
+// Struct for status, temperature and X,Y,Z data
+sfe_ism_all_data_t allData;
 
 void setup()
 {
@@ -113,23 +116,25 @@ void loop()
   
   while (millis() < (startTime + 10000)) // Loop for 10 seconds
   {
+    // Read the status, temperature, gyro and accel data in one go
+    if (!myISM.getAllData(&allData))
+      continue;
+
     // Check if accel data is available.
-    if (myISM.checkAccelStatus())
+    if (allData.accelReady)
     {
-      myISM.getAccel(&accelData); // Read the accel data
-      totalAccelX += accelData.xData; // Sum it
-      totalAccelY += accelData.yData;
-      totalAccelZ += accelData.zData;
+      totalAccelX += allData.accelData.xData; // Sum it
+      totalAccelY += allData.accelData.yData;
+      totalAccelZ += allData.accelData.zData;
       countA += 1; // Increment the count
     }
 
     // Check if gyro data is available.
-    if (myISM.checkGyroStatus())
+    if (allData.gyroReady)
     {
-      myISM.getGyro(&gyroData); // Read the gyro data
-      totalGyroX += gyroData.xData; // Sum it
-      totalGyroY += gyroData.yData;
-      totalGyroZ += gyroData.zData;
+      totalGyroX += allData.gyroData.xData; // Sum it
+      totalGyroY += allData.gyroData.yData;
+      totalGyroZ += allData.gyroData.zData;
       countG += 1; // Increment the count
     }
   }
@@ -154,23 +159,23 @@ void loop()
   Serial.println("Final readings were:");
   Serial.print("Accel: ");
   Serial.print("X: ");
-  Serial.print(accelData.xData);
+  Serial.print(allData.accelData.xData);
   Serial.print(" ");
   Serial.print("Y: ");
-  Serial.print(accelData.yData);
+  Serial.print(allData.accelData.yData);
   Serial.print(" ");
   Serial.print("Z: ");
-  Serial.print(accelData.zData);
+  Serial.print(allData.accelData.zData);
   Serial.println(" ");
   Serial.print("Gyro: ");
   Serial.print("X: ");
-  Serial.print(gyroData.xData);
+  Serial.print(allData.gyroData.xData);
   Serial.print(" ");
   Serial.print("Y: ");
-  Serial.print(gyroData.yData);
+  Serial.print(allData.gyroData.yData);
   Serial.print(" ");
   Serial.print("Z: ");
-  Serial.println(gyroData.zData);
+  Serial.println(allData.gyroData.zData);
   Serial.println();
 
   delay(1000);
@@ -1,10 +1,11 @@
 #pragma once
 #include "sfe_ism330dhcx.h"
+#include "sfe_ism330dhcx_static.h"
 #include "sfe_bus.h"
 #include <Wire.h>
 #include <SPI.h>
 
-class SparkFun_ISM330DHCX : public QwDevISM330DHCX
+class SparkFun_ISM330DHCX : public QwDevISM330DHCXStatic<sfe_ISM330DHCX::QwI2C>
 {
 public:
 
@@ -75,7 +76,7 @@ private:
 
 };
 
-class SparkFun_ISM330DHCX_SPI : public QwDevISM330DHCX
+class SparkFun_ISM330DHCX_SPI : public QwDevISM330DHCXStatic<sfe_ISM330DHCX::SfeSPI>
 {
 public:
 
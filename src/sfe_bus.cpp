@@ -44,13 +44,57 @@
 // and Serial Peripheral Interface (SPI). 
 
 #include "sfe_bus.h"
+
+namespace sfe_ISM330DHCX {
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+// transferBatch()
+//
+// Runs each transaction of the batch in order, stopping at the first error.
+
+int QwIDeviceBus::transferBatch(uint8_t address, QwBusTransfer* transfers, uint8_t count)
+{
+	int retVal;
+
+	for( uint8_t i = 0; i < count; i++ )
+	{
+		if( transfers[i].read )
+			retVal = readRegisterRegion(address, transfers[i].reg, transfers[i].data, transfers[i].length);
+		else
+			retVal = writeRegisterRegion(address, transfers[i].reg, transfers[i].data, transfers[i].length);
+
+		if( retVal != 0 )
+			return -1;
+	}
+
+	return 0;
+}
+
+}
+
+#ifdef ARDUINO
+
 #include <Arduino.h>
+#include <string.h>
+
+// Bytes requested from the Wire buffer at a time. Defaults to the receive
+// buffer size of the platform's Wire library, define it to override.
+#ifndef ISM_I2C_CHUNK_SIZE
+#if defined(I2C_BUFFER_LENGTH)
+#define ISM_I2C_CHUNK_SIZE I2C_BUFFER_LENGTH
+#elif defined(BUFFER_LENGTH)
+#define ISM_I2C_CHUNK_SIZE BUFFER_LENGTH
+#elif defined(SERIAL_BUFFER_SIZE)
+#define ISM_I2C_CHUNK_SIZE SERIAL_BUFFER_SIZE
+#else
+#define ISM_I2C_CHUNK_SIZE 32
+#endif
+#endif
 
-#define kMaxTransferBuffer 32
 #define SPI_READ 0x80
 
-// What we use for transfer chunk size
-const static uint16_t kChunkSize = kMaxTransferBuffer;
+// What we use for transfer chunk size, requestFrom() counts in a byte on most cores
+const static uint16_t kChunkSize = ISM_I2C_CHUNK_SIZE > 255 ? 255 : ISM_I2C_CHUNK_SIZE;
 
 //////////////////////////////////////////////////////////////////////////////////////////////////
 // Constructor
@@ -151,8 +195,10 @@ int QwI2C::writeRegisterRegion(uint8_t i2c_address, uint8_t offset, const uint8_
 //
 // Reads a block of data from an i2c register on the devices.
 //
-// For large buffers, the data is chuncked over KMaxI2CBufferLength at a time
-//
+// The register address is followed by a repeated start and the read is kept
+// open across chunks of kChunkSize, only the last chunk sends a stop. The
+// device keeps incrementing its address between chunks so a large read has a
+// single register address phase.
 //
 int QwI2C::readRegisterRegion(uint8_t addr, uint8_t reg, uint8_t *data, uint16_t numBytes)
 {
@@ -162,26 +208,22 @@ int QwI2C::readRegisterRegion(uint8_t addr, uint8_t reg, uint8_t *data, uint16_t
 	if (!_i2cPort)
 		return -1;
 
-	uint16_t i;                   // counter in loop
-	bool bFirstInter = true; // Flag for first iteration - used to send register
-
-	while (numBytes > 0)
-	{
-		_i2cPort->beginTransmission(addr);
+	uint16_t i; // counter in loop
 
-		if (bFirstInter)
-		{
-			_i2cPort->write(reg);
-			bFirstInter = false;
-		}
+	_i2cPort->beginTransmission(addr);
+	_i2cPort->write(reg);
 
-		if (_i2cPort->endTransmission() != 0)
-			return -1; // error with the end transmission
+	// Repeated start, the bus is kept for the read
+	if (_i2cPort->endTransmission(false) != 0)
+		return -1; // error with the end transmission
 
-		// We're chunking in data - keeping the max chunk to kMaxI2CBufferLength
+	while (numBytes > 0)
+	{
+		// We're chunking in data - keeping the max chunk to kChunkSize
 		nChunk = numBytes > kChunkSize ? kChunkSize : numBytes;
 
-		nReturned = _i2cPort->requestFrom((int)addr, (int)nChunk, (int)true);
+		// Stop only after the last chunk
+		nReturned = _i2cPort->requestFrom((int)addr, (int)nChunk, (int)(nChunk == numBytes));
 
 		// No data returned, no dice
 		if (nReturned == 0)
@@ -206,7 +248,7 @@ int QwI2C::readRegisterRegion(uint8_t addr, uint8_t reg, uint8_t *data, uint16_t
 // Constructor
 //
 
-SfeSPI::SfeSPI(void) : _spiPort{nullptr}
+SfeSPI::SfeSPI(void) : _spiPort{nullptr}, _transferHook{nullptr}
 {
 }
 
@@ -277,56 +319,75 @@ bool SfeSPI::ping(uint8_t i2c_address)
 }
 
 //////////////////////////////////////////////////////////////////////////////////////////////////
-// writeRegisterByte()
+// setTransferHook()
 //
-// Write a byte to a register
+// Sets the function used for buffer transfers, nullptr for SPIClass::transfer(buf, len).
 
-bool SfeSPI::writeRegisterByte(uint8_t i2c_address, uint8_t offset, uint8_t dataToWrite)
+void SfeSPI::setTransferHook(SfeSPITransferHook hook)
 {
-	// Make compiler understand we don't use this variable, and do not print
-	// warning.
-	(void)i2c_address;
-	if( !_spiPort )
-		return false;
+	_transferHook = hook;
+}
 
-	// Apply settings
-	_spiPort->beginTransaction(_sfeSPISettings);
-	// Signal communication start
-	digitalWrite(_cs, LOW);
+//////////////////////////////////////////////////////////////////////////////////////////////////
+// transferBuffer()
+//
+// Sends the buffer and overwrites it with the received bytes.
 
-	_spiPort->transfer(offset);
-	_spiPort->transfer(dataToWrite);
+void SfeSPI::transferBuffer(uint8_t* buffer, size_t length)
+{
+	if( _transferHook )
+		_transferHook(_spiPort, buffer, length);
+	else
+		_spiPort->transfer(buffer, length);
+}
 
-	// End communcation
-	digitalWrite(_cs, HIGH);
-	_spiPort->endTransaction();
+//////////////////////////////////////////////////////////////////////////////////////////////////
+// writeRegisterByte()
+//
+// Write a byte to a register
 
-	return true;
+bool SfeSPI::writeRegisterByte(uint8_t i2c_address, uint8_t offset, uint8_t dataToWrite)
+{
+	return writeRegisterRegion(i2c_address, offset, &dataToWrite, 1) == 0;
 }
 
 
 //////////////////////////////////////////////////////////////////////////////////////////////////
 // writeRegisterRegion()
 //
-// Write a block of data to a device.
+// Write a block of data to a device. The register byte and the data are staged
+// in the scratch buffer so each piece goes out as one buffer transfer.
 
 int SfeSPI::writeRegisterRegion(uint8_t i2c_address, uint8_t offset, const uint8_t *data, uint16_t length)
 {
 	// Make compiler understand we don't use this variable, and do not print
 	// warning.
 	(void)i2c_address;
-	uint16_t i;
+	uint16_t nChunk;
+	uint16_t nStaged = 1;
+
+	if( !_spiPort )
+		return -1;
+
+	_scratch[0] = offset;
 
 	// Apply settings
 	_spiPort->beginTransaction(_sfeSPISettings);
 	// Signal communication start
 	digitalWrite(_cs, LOW);
-	_spiPort->transfer(offset);
 
-	for(i = 0; i < length; i++)
+	do
 	{
-		_spiPort->transfer(*data++);
-	}
+		nChunk = length > sizeof(_scratch) - nStaged ? sizeof(_scratch) - nStaged : length;
+		memcpy(&_scratch[nStaged], data, nChunk);
+
+		transferBuffer(_scratch, nStaged + nChunk);
+
+		data += nChunk;
+		length -= nChunk;
+		nStaged = 0;
+
+	} while( length > 0 );
 
 	// End communication
 	digitalWrite(_cs, HIGH);
@@ -339,9 +400,9 @@ int SfeSPI::writeRegisterRegion(uint8_t i2c_address, uint8_t offset, const uint8
 //
 // Reads a block of data from the register on the device.
 //
-//
-//
-
+// Short reads go out as a single buffer transfer with the register byte in
+// front of the data. Longer reads, like a FIFO drain, send the register byte
+// and then transfer the caller's buffer in place.
 
 int SfeSPI::readRegisterRegion(uint8_t addr, uint8_t reg, uint8_t *data, uint16_t numBytes)
 {
@@ -351,19 +412,28 @@ int SfeSPI::readRegisterRegion(uint8_t addr, uint8_t reg, uint8_t *data, uint16_
 	if (!_spiPort)
 		return -1;
 
-	uint16_t i; // counter in loop
+	// A leading "1" must be added to transfer with register to indicate a "read"
+	reg = (reg | SPI_READ);
 
 	// Apply settings
 	_spiPort->beginTransaction(_sfeSPISettings);
 	// Signal communication start
 	digitalWrite(_cs, LOW);
-	// A leading "1" must be added to transfer with register to indicate a "read"
-	reg = (reg | SPI_READ);
-	_spiPort->transfer(reg);
 
-	for(i = 0; i < numBytes; i++)
+	if( numBytes < sizeof(_scratch) )
 	{
-		*data++ = _spiPort->transfer(0x00);
+		_scratch[0] = reg;
+		memset(&_scratch[1], 0, numBytes);
+
+		transferBuffer(_scratch, numBytes + 1);
+		memcpy(data, &_scratch[1], numBytes);
+	}
+	else
+	{
+		_spiPort->transfer(reg);
+
+		memset(data, 0, numBytes);
+		transferBuffer(data, numBytes);
 	}
 
 	// End transaction
@@ -374,3 +444,5 @@ int SfeSPI::readRegisterRegion(uint8_t addr, uint8_t reg, uint8_t *data, uint16_
 }
 
 }
+
+#endif // ARDUINO
@@ -42,16 +42,35 @@
 // over the respective data buses: Inter-Integrated Circuit (I2C)
 // and Serial Peripheral Interface (SPI). For ease of implementation
 // an abstract interface (QwIDeviceBus) is used. 
+//
+// The Arduino implementations are only built when compiling with the Arduino
+// toolchain so the interface can also be used by host and Linux builds.
 
 #pragma once
 
+#include <stdint.h>
 
-
+#ifdef ARDUINO
 #include <Wire.h>
 #include <SPI.h>
+#endif
 
 namespace sfe_ISM330DHCX {
 
+/**
+ * @brief      One register transaction of a batch.
+ *
+ *             Writes send "length" bytes from "data" starting at "reg", reads
+ *             fill "data" with "length" bytes starting at "reg".
+ */
+struct QwBusTransfer
+{
+	uint8_t reg;
+	uint8_t* data;
+	uint16_t length;
+	bool read;
+};
+
 /**
  * @brief      This class describes a QwI2C device bus.
  *
@@ -69,8 +88,26 @@ class QwIDeviceBus
 
 		virtual int readRegisterRegion(uint8_t addr, uint8_t reg, uint8_t* data, uint16_t numBytes) = 0;
 
+		// Runs several register transactions in order. Buses that can chain
+		// transactions into a single transfer override this, the default
+		// issues them one at a time.
+		virtual int transferBatch(uint8_t address, QwBusTransfer* transfers, uint8_t count);
+
 };
 
+#ifdef ARDUINO
+
+// Bytes SfeSPI stages so the register byte and short transactions go out as a
+// single buffer transfer. Longer reads are transferred in place.
+#ifndef ISM_SPI_SCRATCH_SIZE
+#define ISM_SPI_SCRATCH_SIZE 32
+#endif
+
+// Replaces SPIClass::transfer(buf, len) for the data phase of SfeSPI, e.g. to
+// hand the buffer to a DMA driver. The buffer is sent and overwritten with the
+// received bytes, chip select is asserted for the whole call.
+typedef void (*SfeSPITransferHook)(SPIClass* spiPort, uint8_t* buffer, size_t length);
+
 /**
  * @brief      This class describes a QwI2C
  *
@@ -126,12 +163,20 @@ class SfeSPI : public QwIDeviceBus
 
 		int readRegisterRegion(uint8_t addr, uint8_t reg, uint8_t* data, uint16_t numBytes);
 
+		void setTransferHook(SfeSPITransferHook hook);
+
 	private:
 
+		void transferBuffer(uint8_t* buffer, size_t length);
+
 		SPIClass* _spiPort; 
 		// Settings are used for every transaction.
 		SPISettings _sfeSPISettings;
 		uint8_t _cs; 
+		SfeSPITransferHook _transferHook;
+		uint8_t _scratch[ISM_SPI_SCRATCH_SIZE];
 };
 
+#endif // ARDUINO
+
 };
@@ -0,0 +1,422 @@
+// sfe_bus_linux.cpp
+//
+// This is a library written for SparkFun Qwiic ISM330DHCX boards
+//
+// SparkFun sells these boards at its website: www.sparkfun.com
+//
+// Do you like this library? Help support SparkFun. Buy a board!
+//
+//SparkFun Qwiic 6DoF - ISM330DHCX        https://www.sparkfun.com/products/19764
+//
+// Repository:
+//     https://github.com/sparkfun/SparkFun_6DoF_ISM330DHCX_Arduino_Library
+//
+//
+// SparkFun code, firmware, and software is released under the MIT
+// License(http://opensource.org/licenses/MIT).
+//
+// SPDX-License-Identifier: MIT
+
+// The following classes specify the behavior for communicating over the
+// Linux user space bus drivers.
+
+#include "sfe_bus_linux.h"
+
+#if defined(__linux__) && !defined(ARDUINO)
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+#include <linux/i2c.h>
+#include <linux/i2c-dev.h>
+#include <linux/spi/spidev.h>
+#include <vector>
+
+// Register written by ping(), moving the address pointer there has no side effects
+#define kPingRegister 0x0F
+
+// Messages the i2c-dev driver accepts in a single I2C_RDWR call
+#define kMaxRdwrMessages I2C_RDWR_IOCTL_MAX_MSGS
+
+#define SPI_READ 0x80
+
+// Register transactions chained into a single SPI_IOC_MESSAGE call
+#define kMaxSpiTransactions 16
+
+namespace sfe_ISM330DHCX {
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+// Constructor
+//
+
+QwLinuxI2C::QwLinuxI2C(void) : _fd{-1}
+{
+}
+
+QwLinuxI2C::~QwLinuxI2C()
+{
+	end();
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+// I2C init()
+//
+// Methods to init/setup this device. The caller provides the bus number or the
+// path of the i2c-dev device.
+
+bool QwLinuxI2C::init(uint8_t bus)
+{
+	char device[20];
+
+	snprintf(device, sizeof(device), "/dev/i2c-%u", bus);
+
+	return init(device);
+}
+
+bool QwLinuxI2C::init(const char* device)
+{
+	// if we don't have a device open already
+	if( _fd >= 0 )
+		return false;
+
+	_fd = open(device, O_RDWR);
+
+	return _fd >= 0;
+}
+
+void QwLinuxI2C::end()
+{
+	if( _fd >= 0 )
+		close(_fd);
+
+	_fd = -1;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+// rdwr()
+//
+// Hands the messages to the i2c-dev driver.
+
+int QwLinuxI2C::rdwr(struct i2c_rdwr_ioctl_data* rdwrData)
+{
+	if( _fd < 0 )
+		return -1;
+
+	return ioctl(_fd, I2C_RDWR, rdwrData) < 0 ? -1 : 0;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+// ping()
+//
+// Is a device connected? Sets the register address pointer, which is acked by
+// the device without touching any data.
+
+bool QwLinuxI2C::ping(uint8_t address)
+{
+	uint8_t reg = kPingRegister;
+	struct i2c_msg msg = {address, 0, 1, &reg};
+	struct i2c_rdwr_ioctl_data rdwrData = {&msg, 1};
+
+	return rdwr(&rdwrData) == 0;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+// writeRegisterByte()
+//
+// Write a byte to a register
+
+bool QwLinuxI2C::writeRegisterByte(uint8_t address, uint8_t offset, uint8_t data)
+{
+	return writeRegisterRegion(address, offset, &data, 1) == 0;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+// writeRegisterRegion()
+//
+// Write a block of data to a device.
+
+int QwLinuxI2C::writeRegisterRegion(uint8_t address, uint8_t offset, const uint8_t* data, uint16_t length)
+{
+	QwBusTransfer transfer = {offset, const_cast<uint8_t*>(data), length, false};
+
+	return transferBatch(address, &transfer, 1);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+// readRegisterRegion()
+//
+// Reads a block of data from an i2c register on the device. The register
+// address write and the read are one I2C_RDWR call, so the read is not
+// interrupted by a stop condition and has no chunk limit.
+
+int QwLinuxI2C::readRegisterRegion(uint8_t addr, uint8_t reg, uint8_t* data, uint16_t numBytes)
+{
+	struct i2c_msg msgs[2] = {{addr, 0, 1, &reg},
+	                          {addr, I2C_M_RD, numBytes, data}};
+	struct i2c_rdwr_ioctl_data rdwrData = {msgs, 2};
+
+	return rdwr(&rdwrData);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+// transferBatch()
+//
+// Each write is a message holding the register address and the data, each read
+// is a register address message followed by a read message. The messages are
+// sent in as few I2C_RDWR calls as the driver allows.
+
+int QwLinuxI2C::transferBatch(uint8_t address, QwBusTransfer* transfers, uint8_t count)
+{
+	struct i2c_msg msgs[kMaxRdwrMessages];
+	struct i2c_rdwr_ioctl_data rdwrData = {msgs, 0};
+	size_t writeBytes = 0;
+	size_t pos = 0;
+
+	for( uint8_t i = 0; i < count; i++ )
+	{
+		if( !transfers[i].read )
+			writeBytes += transfers[i].length + 1;
+	}
+
+	// Writes need the register address in front of the data
+	std::vector<uint8_t> buffer(writeBytes);
+
+	for( uint8_t i = 0; i < count; i++ )
+	{
+		QwBusTransfer* transfer = &transfers[i];
+		uint32_t needed = transfer->read ? 2 : 1;
+
+		if( !transfer->read && transfer->length == 0xFFFF )
+			return -1;
+
+		if( rdwrData.nmsgs + needed > kMaxRdwrMessages )
+		{
+			if( rdwr(&rdwrData) != 0 )
+				return -1;
+
+			rdwrData.nmsgs = 0;
+		}
+
+		if( transfer->read )
+		{
+			msgs[rdwrData.nmsgs++] = {address, 0, 1, &transfer->reg};
+			msgs[rdwrData.nmsgs++] = {address, I2C_M_RD, transfer->length, transfer->data};
+		}
+		else
+		{
+			buffer[pos] = transfer->reg;
+			if( transfer->length )
+				memcpy(&buffer[pos + 1], transfer->data, transfer->length);
+
+			msgs[rdwrData.nmsgs++] = {address, 0, (uint16_t)(transfer->length + 1), &buffer[pos]};
+			pos += transfer->length + 1;
+		}
+	}
+
+	if( rdwrData.nmsgs && rdwr(&rdwrData) != 0 )
+		return -1;
+
+	return 0;
+}
+
+
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+// Constructor
+//
+
+QwLinuxSPI::QwLinuxSPI(void) : _fd{-1}, _speedHz{0}
+{
+}
+
+QwLinuxSPI::~QwLinuxSPI()
+{
+	end();
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+// SPI init()
+//
+// Methods to init/setup this device. The caller provides the bus and chip
+// select numbers or the path of the spidev device.
+
+bool QwLinuxSPI::init(uint8_t bus, uint8_t cs, uint32_t speedHz)
+{
+	char device[24];
+
+	snprintf(device, sizeof(device), "/dev/spidev%u.%u", bus, cs);
+
+	return init(device, speedHz);
+}
+
+bool QwLinuxSPI::init(const char* device, uint32_t speedHz)
+{
+	uint8_t mode = SPI_MODE_3;
+	uint8_t bits = 8;
+
+	// if we don't have a device open already
+	if( _fd >= 0 )
+		return false;
+
+	_fd = open(device, O_RDWR);
+	if( _fd < 0 )
+		return false;
+
+	if( ioctl(_fd, SPI_IOC_WR_MODE, &mode) < 0 ||
+	    ioctl(_fd, SPI_IOC_WR_BITS_PER_WORD, &bits) < 0 ||
+	    ioctl(_fd, SPI_IOC_WR_MAX_SPEED_HZ, &speedHz) < 0 )
+	{
+		end();
+		return false;
+	}
+
+	_speedHz = speedHz;
+
+	return true;
+}
+
+void QwLinuxSPI::end()
+{
+	if( _fd >= 0 )
+		close(_fd);
+
+	_fd = -1;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+// message()
+//
+// Hands the transfers to the spidev driver.
+
+int QwLinuxSPI::message(struct spi_ioc_transfer* transfers, uint32_t count)
+{
+	if( _fd < 0 )
+		return -1;
+
+	return ioctl(_fd, SPI_IOC_MESSAGE(count), transfers) < 0 ? -1 : 0;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+// ping()
+//
+// Is a device connected? The SPI ping is not relevant but is defined here to keep consistency with
+// I2C class i.e. provided for the interface.
+
+bool QwLinuxSPI::ping(uint8_t address)
+{
+	(void)address;
+	return _fd >= 0;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+// writeRegisterByte()
+//
+// Write a byte to a register
+
+bool QwLinuxSPI::writeRegisterByte(uint8_t address, uint8_t offset, uint8_t data)
+{
+	return writeRegisterRegion(address, offset, &data, 1) == 0;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+// writeRegisterRegion()
+//
+// Write a block of data to a device.
+
+int QwLinuxSPI::writeRegisterRegion(uint8_t address, uint8_t offset, const uint8_t* data, uint16_t length)
+{
+	QwBusTransfer transfer = {offset, const_cast<uint8_t*>(data), length, false};
+
+	return transferBatch(address, &transfer, 1);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+// readRegisterRegion()
+//
+// Reads a block of data from the register on the device.
+
+int QwLinuxSPI::readRegisterRegion(uint8_t addr, uint8_t reg, uint8_t* data, uint16_t numBytes)
+{
+	QwBusTransfer transfer = {reg, data, numBytes, true};
+
+	return transferBatch(addr, &transfer, 1);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+// transferBatch()
+//
+// Each register transaction is a pair of transfers: the register address then
+// the data, with chip select held between them. Chip select is released after
+// the pair when another transaction follows. As many transactions as fit
+// the driver's buffer are sent in one SPI_IOC_MESSAGE call.
+//
+// A transaction longer than the buffer can't be sent, spidev would reject it
+// with EMSGSIZE. The batch then fails before anything is sent.
+
+int QwLinuxSPI::transferBatch(uint8_t address, QwBusTransfer* transfers, uint8_t count)
+{
+	(void)address;
+	struct spi_ioc_transfer xfers[kMaxSpiTransactions * 2];
+	uint8_t regs[kMaxSpiTransactions];
+	uint32_t numXfers = 0;
+	uint32_t numBytes = 0;
+
+	for( uint8_t i = 0; i < count; i++ )
+	{
+		if( transfers[i].length + 1 > ISM_SPIDEV_BUFSIZ )
+			return -1;
+	}
+
+	memset(xfers, 0, sizeof(xfers));
+
+	for( uint8_t i = 0; i < count; i++ )
+	{
+		QwBusTransfer* transfer = &transfers[i];
+		uint32_t length = transfer->length + 1;
+
+		if( numXfers && (numXfers == sizeof(xfers) / sizeof(xfers[0]) || numBytes + length > ISM_SPIDEV_BUFSIZ) )
+		{
+			// Don't keep chip select asserted past the end of the message
+			xfers[numXfers - 1].cs_change = 0;
+
+			if( message(xfers, numXfers) != 0 )
+				return -1;
+
+			memset(xfers, 0, sizeof(xfers));
+			numXfers = 0;
+			numBytes = 0;
+		}
+
+		// A leading "1" must be added to transfer with register to indicate a "read"
+		regs[numXfers / 2] = transfer->read ? (transfer->reg | SPI_READ) : transfer->reg;
+
+		xfers[numXfers].tx_buf = (unsigned long)&regs[numXfers / 2];
+		xfers[numXfers].len = 1;
+		xfers[numXfers].speed_hz = _speedHz;
+		numXfers++;
+
+		if( transfer->read )
+			xfers[numXfers].rx_buf = (unsigned long)transfer->data;
+		else
+			xfers[numXfers].tx_buf = (unsigned long)transfer->data;
+		xfers[numXfers].len = transfer->length;
+		xfers[numXfers].speed_hz = _speedHz;
+		xfers[numXfers].cs_change = 1;
+		numXfers++;
+
+		numBytes += length;
+	}
+
+	if( numXfers == 0 )
+		return 0;
+
+	xfers[numXfers - 1].cs_change = 0;
+
+	return message(xfers, numXfers);
+}
+
+}
+
+#endif // __linux__
@@ -0,0 +1,138 @@
+// sfe_bus_linux.h
+//
+// This is a library written for SparkFun Qwiic ISM330DHCX boards
+//
+// SparkFun sells these boards at its website: www.sparkfun.com
+//
+// Do you like this library? Help support SparkFun. Buy a board!
+//
+//SparkFun Qwiic 6DoF - ISM330DHCX        https://www.sparkfun.com/products/19764
+//
+// Repository:
+//     https://github.com/sparkfun/SparkFun_6DoF_ISM330DHCX_Arduino_Library
+//
+//
+// SparkFun code, firmware, and software is released under the MIT
+// License(http://opensource.org/licenses/MIT).
+//
+// SPDX-License-Identifier: MIT
+
+// The following classes implement the abstract interface (QwIDeviceBus) on
+// top of the Linux user space bus drivers so the library can run on single
+// board computers.
+//
+// The kernel calls are made through a protected virtual method of each class
+// so they can be replaced by an in-process fake for testing.
+//
+// They are only built for Linux targets.
+
+#pragma once
+
+#if defined(__linux__) && !defined(ARDUINO)
+
+#include "sfe_bus.h"
+
+// Bytes spidev moves in a single SPI_IOC_MESSAGE call, the "bufsiz" module
+// parameter of the driver. A longer SPI transaction fails.
+#ifndef ISM_SPIDEV_BUFSIZ
+#define ISM_SPIDEV_BUFSIZ 4096
+#endif
+
+struct i2c_rdwr_ioctl_data;
+struct spi_ioc_transfer;
+
+namespace sfe_ISM330DHCX {
+
+/**
+ * @brief      This class describes a QwLinuxI2C
+ *
+ *             Defines behavior for an I2C implementation based around the
+ *             i2c-dev interface (/dev/i2c-N). A register read is a single
+ *             I2C_RDWR call with a repeated start between the register
+ *             address and the data, and is not split into chunks.
+ */
+class QwLinuxI2C : public QwIDeviceBus
+{
+	public:
+
+		QwLinuxI2C(void);
+
+		virtual ~QwLinuxI2C();
+
+		// Opens /dev/i2c-<bus>
+		bool init(uint8_t bus);
+
+		// Opens the given i2c-dev device path
+		bool init(const char* device);
+
+		void end();
+
+		bool ping(uint8_t address);
+
+		bool writeRegisterByte(uint8_t address, uint8_t offset, uint8_t data);
+
+		int writeRegisterRegion(uint8_t address, uint8_t offset, const uint8_t* data, uint16_t length);
+
+		int readRegisterRegion(uint8_t addr, uint8_t reg, uint8_t* data, uint16_t numBytes);
+
+		// Sends the batch as combined I2C_RDWR calls, each write and read is
+		// a message and a repeated start separates them.
+		int transferBatch(uint8_t address, QwBusTransfer* transfers, uint8_t count);
+
+	protected:
+
+		// Issues the I2C_RDWR ioctl, override to replace the kernel driver.
+		virtual int rdwr(struct i2c_rdwr_ioctl_data* rdwrData);
+
+		int _fd;
+};
+
+/**
+ * @brief      This class describes a QwLinuxSPI
+ *
+ *             Defines behavior for a SPI implementation based around the
+ *             spidev interface (/dev/spidevB.C). Every register transaction is
+ *             one SPI message with chip select held for its whole length.
+ *             Paramaters like "address" are kept although irrelevant to SPI
+ *             due to the use of the abstract class as interface, QwIDeviceBus.
+ */
+class QwLinuxSPI : public QwIDeviceBus
+{
+	public:
+
+		QwLinuxSPI(void);
+
+		virtual ~QwLinuxSPI();
+
+		// Opens /dev/spidev<bus>.<cs>
+		bool init(uint8_t bus, uint8_t cs, uint32_t speedHz = 3000000);
+
+		// Opens the given spidev device path, the device uses SPI mode 3.
+		bool init(const char* device, uint32_t speedHz = 3000000);
+
+		void end();
+
+		bool ping(uint8_t address);
+
+		bool writeRegisterByte(uint8_t address, uint8_t offset, uint8_t data);
+
+		int writeRegisterRegion(uint8_t address, uint8_t offset, const uint8_t* data, uint16_t length);
+
+		int readRegisterRegion(uint8_t addr, uint8_t reg, uint8_t* data, uint16_t numBytes);
+
+		// Chains the batch into SPI_IOC_MESSAGE calls, chip select is released
+		// between the transactions.
+		int transferBatch(uint8_t address, QwBusTransfer* transfers, uint8_t count);
+
+	protected:
+
+		// Issues the SPI_IOC_MESSAGE ioctl, override to replace the kernel driver.
+		virtual int message(struct spi_ioc_transfer* transfers, uint32_t count);
+
+		int _fd;
+		uint32_t _speedHz;
+};
+
+};
+
+#endif // __linux__
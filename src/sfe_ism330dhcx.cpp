@@ -1,4 +1,5 @@
 #include "sfe_ism330dhcx.h"
+#include <string.h>
 
 //////////////////////////////////////////////////////////////////////////////
 // init()
@@ -20,6 +21,9 @@ bool QwDevISM330DHCX::init(void)
 		if (getUniqueId() != ISM330DHCX_ID)
 			return false; 
 
+		// The device may have been configured before we got here
+		if (!syncFullScale())
+			return false;
 
     return true;
 }
@@ -89,7 +93,53 @@ void QwDevISM330DHCX::setCommunicationBus(sfe_ISM330DHCX::QwIDeviceBus &theBus)
 
 int32_t QwDevISM330DHCX::writeRegisterRegion(uint8_t offset, uint8_t *data, uint16_t length)
 {
-    return _sfeBus->writeRegisterRegion(_i2cAddress, offset, data, length);
+	int32_t retVal;
+
+	if( _deferConfig )
+	{
+		if( deferWrite(offset, data, length) )
+			return 0;
+
+		// Keep the device's write order, pending registers go out first
+		retVal = flushConfig();
+		if( retVal != 0 )
+			return retVal;
+	}
+
+	// Bank switches the device doesn't need to see yet
+	if( offset == ISM330DHCX_FUNC_CFG_ACCESS && length == 1 && _bankKnown &&
+	    (data[0] == _deviceFuncCfg || _bankSessions > 0) )
+	{
+		updateShadow(offset, data, length);
+		return 0;
+	}
+
+	if( offset > ISM330DHCX_FUNC_CFG_ACCESS || offset + length <= ISM330DHCX_FUNC_CFG_ACCESS )
+	{
+		retVal = syncBank();
+		if( retVal != 0 )
+			return retVal;
+	}
+
+	retVal = _sfeBus->writeRegisterRegion(_i2cAddress, offset, data, length);
+
+	// The device state is unknown after a failed write
+	if( retVal != 0 )
+	{
+		_shadowValid = false;
+		_bankKnown = false;
+		return retVal;
+	}
+
+	if( offset <= ISM330DHCX_FUNC_CFG_ACCESS && offset + length > ISM330DHCX_FUNC_CFG_ACCESS )
+	{
+		_deviceFuncCfg = data[ISM330DHCX_FUNC_CFG_ACCESS - offset];
+		_bankKnown = true;
+	}
+
+	updateShadow(offset, data, length);
+
+	return 0;
 }
 
 //////////////////////////////////////////////////////////////////////////////
@@ -105,489 +155,2948 @@ int32_t QwDevISM330DHCX::writeRegisterRegion(uint8_t offset, uint8_t *data, uint
 
 int32_t QwDevISM330DHCX::readRegisterRegion(uint8_t offset, uint8_t *data, uint16_t length)
 {
-    return _sfeBus->readRegisterRegion(_i2cAddress, offset, data, length);
-}
+	if( shadowCovers(offset, length) )
+	{
+		memcpy(data, shadowRegister(offset), length);
+		return 0;
+	}
 
-//////////////////////////////////////////////////////////////////////////////
-// setAccelFullScale()
-//
-// Sets the scale of the acceleromter's readings 2g - 16g
-//
-//  Parameter    Description
-//  ---------    -----------------------------
-//  val          The scale to be applied to the accelerometer (0 - 3)
-//
-// See sfe_ism330dhcx_defs.h for a list of valid arguments
-//
+	// The selected bank is known without asking the device
+	if( offset == ISM330DHCX_FUNC_CFG_ACCESS && length == 1 && _bankKnown )
+	{
+		data[0] = _shadow[ISM330DHCX_FUNC_CFG_ACCESS];
+		return 0;
+	}
 
-bool QwDevISM330DHCX::setAccelFullScale(uint8_t val)
-{
-	//0 = 2g, 1 = 16g, 2 = 4g, 3 = 8g
-	if( val > 3 )
-		return false;
-	
-	int32_t retVal = (ism330dhcx_xl_full_scale_set(&sfe_dev, 
-																								(ism330dhcx_fs_xl_t)val));
-	
-	fullScaleAccel = val; 
+	// The device must see the pending configuration before it is read
+	if( _deferConfig && flushConfig() != 0 )
+		return -1;
 
-	if( retVal != 0 )
-		return false; 
+	if( syncBank() != 0 )
+		return -1;
 
-	return true; 
-}
+	if( _sfeBus->readRegisterRegion(_i2cAddress, offset, data, length) != 0 )
+		return -1;
+
+	if( offset <= ISM330DHCX_FUNC_CFG_ACCESS && offset + length > ISM330DHCX_FUNC_CFG_ACCESS )
+	{
+		_deviceFuncCfg = data[ISM330DHCX_FUNC_CFG_ACCESS - offset];
+		_shadow[ISM330DHCX_FUNC_CFG_ACCESS] = _deviceFuncCfg;
+		_bank = _deviceFuncCfg >> 6;
+		_bankKnown = true;
+	}
 
+	return 0;
+}
 
 //////////////////////////////////////////////////////////////////////////////
-// setGyroFullScale()
-//
-// Sets the scale of the gyroscopes's readings 125, 250, 500, 1000, 2000, 4000 degrees per second
-//
-//  Parameter    Description
-//  ---------    -----------------------------
-//  val          The scale to be applied to the gyroscope (0,1,2,4,6,12)
-//   
-// See sfe_ism330dhcx_defs.h for a list of valid arguments
+// beginConfig()
 //
-bool QwDevISM330DHCX::setGyroFullScale(uint8_t val)
+// Starts a configuration transaction. Until commitConfig() the setters' writes
+// to the user bank control registers only update the register shadow, which is
+// enabled if needed. Any other access to the device writes the pending
+// registers first.
+
+bool QwDevISM330DHCX::beginConfig()
 {
-	//0,1,2,4,8,12
-	if( val > 12 )
-		return false;
-	
-	int32_t retVal = ism330dhcx_gy_full_scale_set(&sfe_dev,
-																							  (ism330dhcx_fs_g_t)val);
-	
-	fullScaleGyro = val; 
+	if( !_shadowEnabled || !_shadowValid )
+	{
+		if( !enableShadow() )
+			return false;
+	}
 
-	if( retVal != 0 )
-		return false; 
+	memset(_dirty, 0, sizeof(_dirty));
+	_deferConfig = true;
 
-	return true; 
+	return true;
 }
 
 //////////////////////////////////////////////////////////////////////////////
-// getAccelFullScale()
-//
-// Retrieves the scale of the accelerometer's readings 
+// commitConfig()
 //
+// Ends a configuration transaction, writing each changed register once. Runs
+// of registers are written in bursts, all of them in a single bus batch.
 
-uint8_t QwDevISM330DHCX::getAccelFullScale()
+bool QwDevISM330DHCX::commitConfig()
 {
+	int32_t retVal = flushConfig();
 
-	ism330dhcx_fs_xl_t val; 
-	int32_t retVal = ism330dhcx_xl_full_scale_get(&sfe_dev, &val);
+	_deferConfig = false;
 
-	if( retVal != 0 )
-		return -1; 
-	
-	return (uint8_t)val; 
+	return retVal == 0;
 }
 
 //////////////////////////////////////////////////////////////////////////////
-// getGyroFullScale()
-//
-// Retrieves the scale of the gyroscope's readings
+// deferWrite()
 //
+// Records a write in the shadow when every register it touches is a shadowed
+// user bank control register. Bank switches, software resets and reboots are
+// left for the device.
 
-uint8_t QwDevISM330DHCX::getGyroFullScale()
+bool QwDevISM330DHCX::deferWrite(uint8_t offset, const uint8_t *data, uint16_t length)
 {
-	ism330dhcx_fs_g_t val;
-	int32_t retVal = ism330dhcx_gy_full_scale_get(&sfe_dev, &val);
+	uint8_t reg;
 
-	if( retVal != 0 )
-		return -1;
+	if( !_shadowValid || _bank != ISM330DHCX_USER_BANK || length == 0 )
+		return false;
 
-	return (uint8_t)val;
+	for( uint16_t i = 0; i < length; i++ )
+	{
+		reg = offset + i;
+
+		if( reg == ISM330DHCX_FUNC_CFG_ACCESS || !shadowRegister(reg) )
+			return false;
+
+		if( reg == ISM330DHCX_CTRL3_C && (data[i] & 0x81) )
+			return false;
+
+		// RST_COUNTER_BDR acts on the write itself
+		if( reg == ISM330DHCX_COUNTER_BDR_REG1 && (data[i] & 0x40) )
+			return false;
+	}
+
+	updateShadow(offset, data, length);
+
+	for( uint16_t i = 0; i < length; i++ )
+	{
+		reg = offset + i;
+		_dirty[reg >> 3] |= 1 << (reg & 0x07);
+	}
+
+	return true;
 }
 
 //////////////////////////////////////////////////////////////////////////////
-// getUniqueId()
-//
-// Retrieves the the device's ID: 0x6B for the ISM330DHCX
+// flushConfig()
 //
+// Writes the pending registers. A run spans from a changed register to the
+// last changed register that can be reached through shadowed registers, the
+// unchanged ones in between are written with their current value.
 
-uint8_t QwDevISM330DHCX::getUniqueId()
+int32_t QwDevISM330DHCX::flushConfig()
 {
+	sfe_ISM330DHCX::QwBusTransfer runs[ISM_CONFIG_MAX_RUNS];
+	uint8_t numRuns = 0;
+	uint8_t reg = 0;
+	uint8_t last;
+	int32_t retVal;
 
-	uint8_t buff = 0;
-	int32_t retVal = (ism330dhcx_device_id_get(&sfe_dev, &buff));
+	while( reg < sizeof(_shadow) )
+	{
+		if( !(_dirty[reg >> 3] & (1 << (reg & 0x07))) )
+		{
+			reg++;
+			continue;
+		}
+
+		last = reg;
+		for( uint8_t next = reg + 1; next < sizeof(_shadow) && shadowRegister(next); next++ )
+		{
+			if( _dirty[next >> 3] & (1 << (next & 0x07)) )
+				last = next;
+		}
+
+		runs[numRuns].reg = reg;
+		runs[numRuns].data = &_shadow[reg];
+		runs[numRuns].length = last - reg + 1;
+		runs[numRuns].read = false;
+		numRuns++;
+
+		reg = last + 1;
+	}
 
-	if(retVal != 0)
-		return 0; 
-	
-	return buff;
-}
+	memset(_dirty, 0, sizeof(_dirty));
+
+	if( numRuns == 0 )
+		return 0;
+
+	retVal = syncBank();
+	if( retVal != 0 )
+		return retVal;
+
+	retVal = _sfeBus->transferBatch(_i2cAddress, runs, numRuns);
+	if( retVal != 0 )
+		_shadowValid = false;
 
+	return retVal;
+}
 
 //////////////////////////////////////////////////////////////////////////////
-// getTemp()
-//
-// Gets the temperature
+// syncBank()
 //
+// Writes a bank switch held back by a bank session to the device.
 
-int16_t QwDevISM330DHCX::getTemp()
+int32_t QwDevISM330DHCX::syncBank()
 {
-	
-	int16_t tempVal;	
-	int32_t retVal = ism330dhcx_temperature_raw_get(&sfe_dev, &tempVal);
+	uint8_t funcCfg = _shadow[ISM330DHCX_FUNC_CFG_ACCESS];
+	int32_t retVal;
+
+	if( !_bankKnown || funcCfg == _deviceFuncCfg )
+		return 0;
 
+	retVal = _sfeBus->writeRegisterRegion(_i2cAddress, ISM330DHCX_FUNC_CFG_ACCESS, &funcCfg, 1);
 	if( retVal != 0 )
-		return -1;
+	{
+		_shadowValid = false;
+		_bankKnown = false;
+		return retVal;
+	}
 
-	return tempVal;
+	_deviceFuncCfg = funcCfg;
 
+	return 0;
 }
 
-
 //////////////////////////////////////////////////////////////////////////////
-// getRawAccel()
+// beginBankSession()
 //
-// Retrieves raw register values for accelerometer data 
+// Selects a register bank for several accesses. The driver always knows the
+// selected bank and skips switches to the bank already selected, but the ST
+// functions return to the user bank after every sensor hub or embedded
+// function access. Within a session those switches are held back until a
+// register of the user bank is actually accessed, so a run of sensor hub or
+// embedded function calls costs one switch in and one switch out. Sessions
+// nest, every beginBankSession() needs an endBankSession().
 //
 //  Parameter    Description
 //  ---------    -----------------------------
-//  accelData    Accel data type pointer at which data will be stored. 
+//  bank         ISM330DHCX_USER_BANK, _SENSOR_HUB_BANK or _EMBEDDED_FUNC_BANK
 
-bool QwDevISM330DHCX::getRawAccel(sfe_ism_raw_data_t* accelData)
+bool QwDevISM330DHCX::beginBankSession(uint8_t bank)
 {
-	int16_t tempVal[3] = {0};	
-	int32_t retVal = ism330dhcx_acceleration_raw_get(&sfe_dev, tempVal);
+	int32_t retVal;
+	uint8_t funcCfg;
 
-	if( retVal != 0 )
+	if( bank > ISM330DHCX_EMBEDDED_FUNC_BANK )
 		return false;
 
-	accelData->xData = tempVal[0];
-	accelData->yData = tempVal[1];
-	accelData->zData = tempVal[2];
+	// Held back switches need the device's bank
+	if( !_bankKnown && readRegisterRegion(ISM330DHCX_FUNC_CFG_ACCESS, &funcCfg, 1) != 0 )
+		return false;
 
-	return true;
+	_bankSessions++;
 
-}
+	retVal = ism330dhcx_mem_bank_set(&sfe_dev, (ism330dhcx_reg_access_t)bank);
+
+	if( retVal != 0 )
+		return false;
 
+	return true;
+}
 
 //////////////////////////////////////////////////////////////////////////////
-// getRawGyro()
-//
-// Retrieves raw register values for gyroscope data 
-//
-//  Parameter    Description
-//  ---------   -----------------------------
-//  gyroData    Gyro data type pointer at which data will be stored. 
+// endBankSession()
 //
+// Ends a bank session. The outermost session returns the device to the user
+// bank.
 
-bool QwDevISM330DHCX::getRawGyro(sfe_ism_raw_data_t* gyroData)
+bool QwDevISM330DHCX::endBankSession()
 {
-	
-	int16_t tempVal[3] = {0};	
-	int32_t retVal = ism330dhcx_angular_rate_raw_get(&sfe_dev, tempVal);
+	int32_t retVal;
 
-	if( retVal != 0 )
+	if( _bankSessions == 0 )
 		return false;
 
+	if( --_bankSessions > 0 )
+		return true;
+
+	retVal = ism330dhcx_mem_bank_set(&sfe_dev, ISM330DHCX_USER_BANK);
 
-	gyroData->xData = tempVal[0];
-	gyroData->yData = tempVal[1];
-	gyroData->zData = tempVal[2];
+	if( retVal != 0 )
+		return false;
 
 	return true;
-
 }
 
-
 //////////////////////////////////////////////////////////////////////////////
-// getAccel()
+// enableShadow()
 //
-// Retrieves raw register values and converts them according to the full scale settings
+// Keeps a copy of the writable control registers of the user bank, and of the
+// embedded function bank's enable, interrupt routing and page registers. Reads
+// of those registers are served from the copy and writes go through to the
+// device as well as the copy, so the read-modify-write setters only write. The
+// copy is loaded from the device when enabled.
 //
 //  Parameter    Description
-//  ---------   -----------------------------
-//  accelData    Accel data type pointer at which data will be stored. 
-//
+//  ---------    -----------------------------
+//  enable       Enables/Disables the shadow
 
-bool QwDevISM330DHCX::getAccel(sfe_ism_data_t* accelData)
+bool QwDevISM330DHCX::enableShadow(bool enable)
 {
-	
-	int16_t tempVal[3] = {0};	
-	int32_t retVal = ism330dhcx_acceleration_raw_get(&sfe_dev, tempVal);
+	_shadowEnabled = enable;
+	_shadowValid = false;
 
-	if( retVal != 0 )
-		return false;
-	
-	// "fullScaleAccel" is a private variable that keeps track of the users settings
-	// so that the register values can be converted accordingly
-	switch( fullScaleAccel ){
-		case 0:
-			accelData->xData = convert2gToMg(tempVal[0]);
-			accelData->yData = convert2gToMg(tempVal[1]);
-			accelData->zData = convert2gToMg(tempVal[2]);
-			break;
-		case 1:
-			accelData->xData = convert16gToMg(tempVal[0]);
-			accelData->yData = convert16gToMg(tempVal[1]);
-			accelData->zData = convert16gToMg(tempVal[2]);
-			break;
-		case 2:
-			accelData->xData = convert4gToMg(tempVal[0]);
-			accelData->yData = convert4gToMg(tempVal[1]);
-			accelData->zData = convert4gToMg(tempVal[2]);
-			break;
-		case 3:
-			accelData->xData = convert8gToMg(tempVal[0]);
-			accelData->yData = convert8gToMg(tempVal[1]);
-			accelData->zData = convert8gToMg(tempVal[2]);
-			break;
-		default:
-			return false; //Something has gone wrong
-	}
+	if( !enable )
+		return true;
 
-	return true;
+	return syncShadow();
 }
 
 //////////////////////////////////////////////////////////////////////////////
-// getGyro()
-//
-// Retrieves raw register values and converts them according to the full scale settings
+// syncShadow()
 //
-//  Parameter    Description
-//  ---------   -----------------------------
-//  gyroData    Gyroscope data type pointer at which data will be stored. 
+// Loads the register shadow from the device. The user bank takes three bursts:
+// FUNC_CFG_ACCESS through CTRL10_C, TAP_CFG0 through MD2_CFG and the user
+// offset registers. The embedded function bank takes three more between two
+// bank switches. The shadow is dropped by a software reset or reboot of the
+// device, call this once getDeviceReset() reports the reset is complete.
 //
+// The user register bank must be selected.
 
-
-bool QwDevISM330DHCX::getGyro(sfe_ism_data_t* gyroData)
+bool QwDevISM330DHCX::syncShadow()
 {
-	
-	int16_t tempVal[3] = {0};	
-	int32_t retVal = ism330dhcx_angular_rate_raw_get(&sfe_dev, tempVal);
+	int32_t retVal;
+	uint8_t bank;
 
-	if( retVal != 0 )
+	if( !_shadowEnabled )
 		return false;
 
-	// "fullScaleGyro" is a private variable that keeps track of the users settings
-	// so that the register values can be converted accordingly
-	switch( fullScaleGyro ){
-		case 0:
-			gyroData->xData = convert250dpsToMdps(tempVal[0]);
-			gyroData->yData = convert250dpsToMdps(tempVal[1]);
-			gyroData->zData = convert250dpsToMdps(tempVal[2]);
-			break;
-		case 1:
-			gyroData->xData = convert4000dpsToMdps(tempVal[0]);
-			gyroData->yData = convert4000dpsToMdps(tempVal[1]);
-			gyroData->zData = convert4000dpsToMdps(tempVal[2]);
-			break;
-		case 2:
-			gyroData->xData = convert125dpsToMdps(tempVal[0]);
-			gyroData->yData = convert125dpsToMdps(tempVal[1]);
-			gyroData->zData = convert125dpsToMdps(tempVal[2]);
-			break;
-		case 4:
-			gyroData->xData = convert500dpsToMdps(tempVal[0]);
-			gyroData->yData = convert500dpsToMdps(tempVal[1]);
-			gyroData->zData = convert500dpsToMdps(tempVal[2]);
-			break;
-		case 8:
-			gyroData->xData = convert1000dpsToMdps(tempVal[0]);
-			gyroData->yData = convert1000dpsToMdps(tempVal[1]);
-			gyroData->zData = convert1000dpsToMdps(tempVal[2]);
-			break;
-		case 12:
-			gyroData->xData = convert2000dpsToMdps(tempVal[0]);
-			gyroData->yData = convert2000dpsToMdps(tempVal[1]);
-			gyroData->zData = convert2000dpsToMdps(tempVal[2]);
-			break;
-		default:
-			return false; //Something has gone wrong
-	}
+	_shadowValid = false;
 
-	return true;
-}
+	if( syncBank() != 0 )
+		return false;
 
+	retVal = _sfeBus->readRegisterRegion(_i2cAddress, ISM330DHCX_FUNC_CFG_ACCESS,
+	                                     &_shadow[ISM330DHCX_FUNC_CFG_ACCESS],
+	                                     ISM330DHCX_CTRL10_C - ISM330DHCX_FUNC_CFG_ACCESS + 1);
+	if( retVal != 0 )
+		return false;
 
+	_deviceFuncCfg = _shadow[ISM330DHCX_FUNC_CFG_ACCESS];
+	_bankKnown = true;
+	_bank = _deviceFuncCfg >> 6;
+	if( _bank != ISM330DHCX_USER_BANK )
+		return false;
 
-//////////////////////////////////////////////////////////////////////////////////
-// Conversions Methods
-// 
-//
+	retVal = _sfeBus->readRegisterRegion(_i2cAddress, ISM330DHCX_TAP_CFG0, &_shadow[ISM330DHCX_TAP_CFG0],
+	                                     ISM330DHCX_MD2_CFG - ISM330DHCX_TAP_CFG0 + 1);
+	if( retVal != 0 )
+		return false;
+
+	retVal = _sfeBus->readRegisterRegion(_i2cAddress, ISM330DHCX_X_OFS_USR, &_shadow[ISM330DHCX_X_OFS_USR],
+	                                     ISM330DHCX_Z_OFS_USR - ISM330DHCX_X_OFS_USR + 1);
+	if( retVal != 0 )
+		return false;
+
+	bank = (uint8_t)ISM330DHCX_EMBEDDED_FUNC_BANK << 6;
+	retVal = _sfeBus->writeRegisterRegion(_i2cAddress, ISM330DHCX_FUNC_CFG_ACCESS, &bank, 1);
+	if( retVal != 0 )
+		return false;
+
+	retVal = _sfeBus->readRegisterRegion(_i2cAddress, ISM330DHCX_PAGE_SEL, &_embShadow[ISM330DHCX_PAGE_SEL],
+	                                     ISM330DHCX_EMB_FUNC_EN_B - ISM330DHCX_PAGE_SEL + 1);
+	if( retVal == 0 )
+		retVal = _sfeBus->readRegisterRegion(_i2cAddress, ISM330DHCX_EMB_FUNC_INT1, &_embShadow[ISM330DHCX_EMB_FUNC_INT1],
+		                                     ISM330DHCX_MLC_INT2 - ISM330DHCX_EMB_FUNC_INT1 + 1);
+	if( retVal == 0 )
+		retVal = _sfeBus->readRegisterRegion(_i2cAddress, ISM330DHCX_PAGE_RW, &_embShadow[ISM330DHCX_PAGE_RW], 1);
+
+	if( retVal == 0 )
+	{
+		_bank = ISM330DHCX_EMBEDDED_FUNC_BANK;
+		trackEventSources(ISM330DHCX_EMB_FUNC_EN_A, _embShadow[ISM330DHCX_EMB_FUNC_EN_A]);
+		trackEventSources(ISM330DHCX_EMB_FUNC_EN_B, _embShadow[ISM330DHCX_EMB_FUNC_EN_B]);
+		_bank = ISM330DHCX_USER_BANK;
+	}
+
+	// Back to the user bank even if a read failed
+	bank = _shadow[ISM330DHCX_FUNC_CFG_ACCESS];
+	if( _sfeBus->writeRegisterRegion(_i2cAddress, ISM330DHCX_FUNC_CFG_ACCESS, &bank, 1) != 0 )
+	{
+		_bankKnown = false;
+		return false;
+	}
+
+	if( retVal != 0 )
+		return false;
+
+	_shadowValid = true;
+
+	return true;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// shadowRegister()
+//
+// Returns the shadow copy of a register in the selected bank, nullptr if the
+// register isn't shadowed. FUNC_CFG_ACCESS is visible from every bank.
+
+uint8_t* QwDevISM330DHCX::shadowRegister(uint8_t reg)
+{
+	if( reg == ISM330DHCX_FUNC_CFG_ACCESS )
+		return &_shadow[reg];
+
+	if( _bank == ISM330DHCX_USER_BANK )
+	{
+		if( reg == ISM330DHCX_PIN_CTRL ||
+		    (reg >= ISM330DHCX_FIFO_CTRL1 && reg <= ISM330DHCX_INT2_CTRL) ||
+		    (reg >= ISM330DHCX_CTRL1_XL && reg <= ISM330DHCX_CTRL10_C) ||
+		    (reg >= ISM330DHCX_TAP_CFG0 && reg <= ISM330DHCX_MD2_CFG) ||
+		    (reg >= ISM330DHCX_X_OFS_USR && reg <= ISM330DHCX_Z_OFS_USR) )
+			return &_shadow[reg];
+	}
+	else if( _bank == ISM330DHCX_EMBEDDED_FUNC_BANK )
+	{
+		if( reg == ISM330DHCX_PAGE_SEL ||
+		    (reg >= ISM330DHCX_EMB_FUNC_EN_A && reg <= ISM330DHCX_EMB_FUNC_EN_B) ||
+		    (reg >= ISM330DHCX_EMB_FUNC_INT1 && reg <= ISM330DHCX_MLC_INT2) ||
+		    reg == ISM330DHCX_PAGE_RW )
+			return &_embShadow[reg];
+	}
+
+	return nullptr;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// shadowCovers()
+//
+// True when every register of the region can be read from the shadow.
+
+bool QwDevISM330DHCX::shadowCovers(uint8_t offset, uint16_t length)
+{
+	if( !_shadowEnabled || !_shadowValid || length == 0 )
+		return false;
+
+	for( uint16_t i = 0; i < length; i++ )
+	{
+		if( !shadowRegister(offset + i) )
+			return false;
+	}
+
+	return true;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// updateShadow()
+//
+// Follows a write to the device: tracks the selected register bank, copies
+// the written control registers and drops the shadow on a software reset or
+// reboot. Bits that clear themselves are not kept.
+
+void QwDevISM330DHCX::updateShadow(uint8_t offset, const uint8_t *data, uint16_t length)
+{
+	uint8_t reg;
+	uint8_t* copy;
+
+	for( uint16_t i = 0; i < length; i++ )
+	{
+		reg = offset + i;
+		copy = shadowRegister(reg);
+
+		if( reg == ISM330DHCX_FUNC_CFG_ACCESS )
+			_bank = data[i] >> 6;
+
+		trackEventSources(reg, data[i]);
+
+		if( !copy )
+			continue;
+
+		*copy = data[i];
+
+		if( _bank != ISM330DHCX_USER_BANK )
+			continue;
+
+		// RST_COUNTER_BDR
+		if( reg == ISM330DHCX_COUNTER_BDR_REG1 )
+			*copy &= ~0x40;
+
+		// SW_RESET and BOOT restore the registers' defaults
+		if( reg == ISM330DHCX_CTRL3_C && (data[i] & 0x81) )
+		{
+			_shadowValid = false;
+			_bank = ISM330DHCX_USER_BANK;
+			*copy &= ~0x81;
+		}
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// trackEventSources()
+//
+// Follows writes to the enables of the pedometer, tilt and significant motion
+// detection, the FSM, the MLC and the sensor hub, and to the routing of the 
+// FIFO interrupts. getEvents() only reads their status when one of them is on.
+
+void QwDevISM330DHCX::trackEventSources(uint8_t reg, uint8_t val)
+{
+	uint8_t source;
+
+	if( _bank == ISM330DHCX_EMBEDDED_FUNC_BANK && reg == ISM330DHCX_EMB_FUNC_EN_A )
+	{
+		source = 0x01;
+		val &= 0x38; // PEDO_EN, TILT_EN, SIGN_MOTION_EN
+	}
+	else if( _bank == ISM330DHCX_EMBEDDED_FUNC_BANK && reg == ISM330DHCX_EMB_FUNC_EN_B )
+	{
+		source = 0x02;
+		val &= 0x11; // FSM_EN, MLC_EN
+	}
+	else if( _bank == ISM330DHCX_SENSOR_HUB_BANK && reg == ISM330DHCX_MASTER_CONFIG )
+	{
+		source = 0x04;
+		val &= 0x04; // MASTER_ON
+	}
+	else if( _bank == ISM330DHCX_USER_BANK && (reg == ISM330DHCX_INT1_CTRL || reg == ISM330DHCX_INT2_CTRL) )
+	{
+		source = reg == ISM330DHCX_INT1_CTRL ? 0x08 : 0x10;
+		val &= 0x78; // FIFO and batch counter interrupts
+	}
+	else
+		return;
+
+	if( val )
+		_eventSources |= source;
+	else
+		_eventSources &= ~source;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// setAccelFullScale()
+//
+// Sets the scale of the acceleromter's readings 2g - 16g
+//
+//  Parameter    Description
+//  ---------    -----------------------------
+//  val          The scale to be applied to the accelerometer (0 - 3)
+//
+// See sfe_ism330dhcx_defs.h for a list of valid arguments
+//
+
+bool QwDevISM330DHCX::setAccelFullScale(uint8_t val)
+{
+	//0 = 2g, 1 = 16g, 2 = 4g, 3 = 8g
+	if( val > 3 )
+		return false;
+	
+	int32_t retVal = (ism330dhcx_xl_full_scale_set(&sfe_dev, 
+																								(ism330dhcx_fs_xl_t)val));
+
+	if( retVal != 0 )
+		return false; 
+
+	return setAccelSensitivity(val); 
+}
+
+
+//////////////////////////////////////////////////////////////////////////////
+// setGyroFullScale()
+//
+// Sets the scale of the gyroscopes's readings 125, 250, 500, 1000, 2000, 4000 degrees per second
+//
+//  Parameter    Description
+//  ---------    -----------------------------
+//  val          The scale to be applied to the gyroscope (0,1,2,4,6,12)
+//   
+// See sfe_ism330dhcx_defs.h for a list of valid arguments
+//
+bool QwDevISM330DHCX::setGyroFullScale(uint8_t val)
+{
+	//0,1,2,4,8,12
+	if( val > 12 )
+		return false;
+	
+	int32_t retVal = ism330dhcx_gy_full_scale_set(&sfe_dev,
+																							  (ism330dhcx_fs_g_t)val);
+
+	if( retVal != 0 )
+		return false; 
+
+	return setGyroSensitivity(val); 
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// syncFullScale()
+//
+// Reads CTRL1_XL and CTRL2_G in one transaction and updates the sensitivity
+// used to convert the accelerometer and gyroscope data. Called by init() and
+// once getDeviceReset() reports a completed reset.
+//
+
+bool QwDevISM330DHCX::syncFullScale()
+{
+	uint8_t buff[2];
+	int32_t retVal = readRegisterRegion(ISM330DHCX_CTRL1_XL, buff, 2);
+
+	if( retVal != 0 )
+		return false;
+
+	// FS_XL is bits 3:2 of CTRL1_XL
+	if( !setAccelSensitivity((buff[0] >> 2) & 0x03) )
+		return false;
+
+	// FS_4000 (bit 0) selects 4000dps whatever the rest of CTRL2_G holds,
+	// then FS_125 (bit 1) 125dps, else FS_G (bits 3:2)
+	if( buff[1] & 0x01 )
+		return setGyroSensitivity(ISM_4000dps);
+
+	if( buff[1] & 0x02 )
+		return setGyroSensitivity(ISM_125dps);
+
+	return setGyroSensitivity(buff[1] & 0x0C);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// setAccelSensitivity()
+//
+// Resolves the accelerometer's full scale setting to its sensitivity
+//
+//  Parameter    Description
+//  ---------    -----------------------------
+//  val          The full scale setting (0 - 3)
+//
+
+bool QwDevISM330DHCX::setAccelSensitivity(uint8_t val)
+{
+	//0 = 2g, 1 = 16g, 2 = 4g, 3 = 8g
+	switch( val ){
+		case 0:
+			_accelSensitivityUg = 61;
+			break;
+		case 1:
+			_accelSensitivityUg = 488;
+			break;
+		case 2:
+			_accelSensitivityUg = 122;
+			break;
+		case 3:
+			_accelSensitivityUg = 244;
+			break;
+		default:
+			return false;
+	}
+
+	updateSensitivity();
+
+	return true;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// setGyroSensitivity()
+//
+// Resolves the gyroscope's full scale setting to its sensitivity
+//
+//  Parameter    Description
+//  ---------    -----------------------------
+//  val          The full scale setting (0,1,2,4,8,12)
+//
+
+bool QwDevISM330DHCX::setGyroSensitivity(uint8_t val)
+{
+	// In mdps/LSB with ISM_GYRO_INT_FRAC_BITS fractional bits
+	switch( val ){
+		case 0:
+			_gyroSensitivityFixed = ISM_GYRO_INT_SENSITIVITY(8.75);
+			break;
+		case 1:
+			_gyroSensitivityFixed = ISM_GYRO_INT_SENSITIVITY(140);
+			break;
+		case 2:
+			_gyroSensitivityFixed = ISM_GYRO_INT_SENSITIVITY(4.375);
+			break;
+		case 4:
+			_gyroSensitivityFixed = ISM_GYRO_INT_SENSITIVITY(17.5);
+			break;
+		case 8:
+			_gyroSensitivityFixed = ISM_GYRO_INT_SENSITIVITY(35);
+			break;
+		case 12:
+			_gyroSensitivityFixed = ISM_GYRO_INT_SENSITIVITY(70);
+			break;
+		default:
+			return false;
+	}
+
+	updateSensitivity();
+
+	return true;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// updateSensitivity()
+//
+// Folds the output unit into the float sensitivities so a conversion stays a
+// single multiply per axis.
+//
+
+void QwDevISM330DHCX::updateSensitivity()
+{
+	const double ugToMg = 1e-3;
+	const double mdpsToDps = 1e-3;
+	const double fixedToMdps = 1.0 / (1L << ISM_GYRO_INT_FRAC_BITS);
+
+	switch( _outputUnits ){
+		case ISM_UNITS_SI:
+			_accelSensitivity = (float)(_accelSensitivityUg * ugToMg * ISM_STANDARD_GRAVITY * 1e-3);
+			_gyroSensitivity = (float)(_gyroSensitivityFixed * fixedToMdps * mdpsToDps * (3.14159265358979323846 / 180.0));
+			break;
+		case ISM_UNITS_G_DPS:
+			_accelSensitivity = (float)(_accelSensitivityUg * ugToMg * 1e-3);
+			_gyroSensitivity = (float)(_gyroSensitivityFixed * fixedToMdps * mdpsToDps);
+			break;
+		default:
+			_accelSensitivity = (float)(_accelSensitivityUg * ugToMg);
+			_gyroSensitivity = (float)(_gyroSensitivityFixed * fixedToMdps);
+			break;
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// setOutputUnits()
+//
+// Selects the units of the float accelerometer and gyroscope outputs. Applies
+// to getAccel(), getGyro(), getAllData() and the block conversions. The
+// integer API and the convertXXToMg/Mdps helpers are unaffected.
+//
+//  Parameter    Description
+//  ---------    -----------------------------
+//  units        ISM_UNITS_MG_MDPS, ISM_UNITS_SI (m/s^2, rad/s) or
+//               ISM_UNITS_G_DPS
+//
+
+bool QwDevISM330DHCX::setOutputUnits(uint8_t units)
+{
+	if( units > ISM_UNITS_G_DPS )
+		return false;
+
+	_outputUnits = units;
+	updateSensitivity();
+
+	return true;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// getOutputUnits()
+//
+// Retrieves the units selected with setOutputUnits()
+//
+
+uint8_t QwDevISM330DHCX::getOutputUnits()
+{
+	return _outputUnits;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// getAccelFullScale()
+//
+// Retrieves the scale of the accelerometer's readings 
+//
+
+uint8_t QwDevISM330DHCX::getAccelFullScale()
+{
+
+	ism330dhcx_fs_xl_t val; 
+	int32_t retVal = ism330dhcx_xl_full_scale_get(&sfe_dev, &val);
+
+	if( retVal != 0 )
+		return -1; 
+	
+	return (uint8_t)val; 
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// getGyroFullScale()
+//
+// Retrieves the scale of the gyroscope's readings
+//
+
+uint8_t QwDevISM330DHCX::getGyroFullScale()
+{
+	ism330dhcx_fs_g_t val;
+	int32_t retVal = ism330dhcx_gy_full_scale_get(&sfe_dev, &val);
+
+	if( retVal != 0 )
+		return -1;
+
+	return (uint8_t)val;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// getUniqueId()
+//
+// Retrieves the the device's ID: 0x6B for the ISM330DHCX
+//
+
+uint8_t QwDevISM330DHCX::getUniqueId()
+{
+
+	uint8_t buff = 0;
+	int32_t retVal = (ism330dhcx_device_id_get(&sfe_dev, &buff));
+
+	if(retVal != 0)
+		return 0; 
+	
+	return buff;
+}
+
+
+//////////////////////////////////////////////////////////////////////////////
+// getTemp()
+//
+// Gets the temperature
+//
+
+int16_t QwDevISM330DHCX::getTemp()
+{
+	
+	int16_t tempVal;	
+	int32_t retVal = ism330dhcx_temperature_raw_get(&sfe_dev, &tempVal);
+
+	if( retVal != 0 )
+		return -1;
+
+	return tempVal;
+
+}
+
+
+//////////////////////////////////////////////////////////////////////////////
+// getRawAccel()
+//
+// Retrieves raw register values for accelerometer data 
+//
+//  Parameter    Description
+//  ---------    -----------------------------
+//  accelData    Accel data type pointer at which data will be stored. 
+
+bool QwDevISM330DHCX::getRawAccel(sfe_ism_raw_data_t* accelData)
+{
+	int16_t tempVal[3] = {0};	
+	int32_t retVal = ism330dhcx_acceleration_raw_get(&sfe_dev, tempVal);
+
+	if( retVal != 0 )
+		return false;
+
+	accelData->xData = tempVal[0];
+	accelData->yData = tempVal[1];
+	accelData->zData = tempVal[2];
+
+	return true;
+
+}
+
+
+//////////////////////////////////////////////////////////////////////////////
+// getRawGyro()
+//
+// Retrieves raw register values for gyroscope data 
+//
+//  Parameter    Description
+//  ---------   -----------------------------
+//  gyroData    Gyro data type pointer at which data will be stored. 
+//
+
+bool QwDevISM330DHCX::getRawGyro(sfe_ism_raw_data_t* gyroData)
+{
+	
+	int16_t tempVal[3] = {0};	
+	int32_t retVal = ism330dhcx_angular_rate_raw_get(&sfe_dev, tempVal);
+
+	if( retVal != 0 )
+		return false;
+
+
+	gyroData->xData = tempVal[0];
+	gyroData->yData = tempVal[1];
+	gyroData->zData = tempVal[2];
+
+	return true;
+
+}
+
+
+//////////////////////////////////////////////////////////////////////////////
+// getAccel()
+//
+// Retrieves raw register values and converts them according to the full scale settings
+//
+//  Parameter    Description
+//  ---------   -----------------------------
+//  accelData    Accel data type pointer at which data will be stored. 
+//
+
+bool QwDevISM330DHCX::getAccel(sfe_ism_data_t* accelData)
+{
+	
+	sfe_ism_raw_data_t tempVal;	
+
+	if( !getRawAccel(&tempVal) )
+		return false;
+	
+	return convertAccelData(&tempVal, accelData);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// getGyro()
+//
+// Retrieves raw register values and converts them according to the full scale settings
+//
+//  Parameter    Description
+//  ---------   -----------------------------
+//  gyroData    Gyroscope data type pointer at which data will be stored. 
+//
+
+
+bool QwDevISM330DHCX::getGyro(sfe_ism_data_t* gyroData)
+{
+	
+	sfe_ism_raw_data_t tempVal;	
+
+	if( !getRawGyro(&tempVal) )
+		return false;
+
+	return convertGyroData(&tempVal, gyroData);
+}
+
+
+//////////////////////////////////////////////////////////////////////////////
+// getRawAllData()
+//
+// Retrieves the status, temperature, gyroscope and accelerometer registers in
+// a single bus transaction. STATUS_REG (0x1E) through OUTZ_H_A (0x2D) are
+// contiguous so one 16 byte burst read replaces the separate status, temp,
+// gyro and accel reads.
+//
+//  Parameter    Description
+//  ---------   -----------------------------
+//  allData     Raw data type pointer at which data will be stored. 
+//
+
+bool QwDevISM330DHCX::getRawAllData(sfe_ism_raw_all_data_t* allData)
+{
+	// STATUS_REG, (reserved), OUT_TEMP_L/H, OUTX_L_G ... OUTZ_H_A
+	uint8_t buff[16];
+	int32_t retVal = readRegisterRegion(ISM330DHCX_STATUS_REG, buff, sizeof(buff));
+
+	if( retVal != 0 )
+		return false;
+
+	decodeRawAllData(buff, allData);
+
+	return true;
+}
+
+
+//////////////////////////////////////////////////////////////////////////////
+// decodeRawAllData()
+//
+// Unpacks the 16 byte burst read from STATUS_REG through OUTZ_H_A.
+//
+//  Parameter    Description
+//  ---------   -----------------------------
+//  buff        The bytes read from the device
+//  allData     Raw data type pointer at which data will be stored. 
+//
+
+void QwDevISM330DHCX::decodeRawAllData(const uint8_t* buff, sfe_ism_raw_all_data_t* allData)
+{
+	allData->status = buff[0];
+	allData->tempData = (int16_t)((buff[3] << 8) | buff[2]);
+
+	allData->gyroData.xData = (int16_t)((buff[5] << 8) | buff[4]);
+	allData->gyroData.yData = (int16_t)((buff[7] << 8) | buff[6]);
+	allData->gyroData.zData = (int16_t)((buff[9] << 8) | buff[8]);
+
+	allData->accelData.xData = (int16_t)((buff[11] << 8) | buff[10]);
+	allData->accelData.yData = (int16_t)((buff[13] << 8) | buff[12]);
+	allData->accelData.zData = (int16_t)((buff[15] << 8) | buff[14]);
+}
+
+
+//////////////////////////////////////////////////////////////////////////////
+// getAllData()
+//
+// Retrieves the status, temperature, gyroscope and accelerometer data in a
+// single bus transaction and converts them according to the full scale settings.
+// The "Ready" flags report which of the sensors had new data available
+// when the burst was read.
+//
+//  Parameter    Description
+//  ---------   -----------------------------
+//  allData     Data type pointer at which data will be stored. 
+//
+
+bool QwDevISM330DHCX::getAllData(sfe_ism_all_data_t* allData)
+{
+	sfe_ism_raw_all_data_t rawData;
+
+	if( !getRawAllData(&rawData) )
+		return false;
+
+	return convertAllData(&rawData, allData);
+}
+
+
+//////////////////////////////////////////////////////////////////////////////
+// convertAllData()
+//
+// Converts a raw combined read according to the full scale settings
+//
+//  Parameter    Description
+//  ---------   -----------------------------
+//  rawData     Raw data type pointer holding the combined read
+//  allData     Data type pointer at which data will be stored. 
+//
+
+bool QwDevISM330DHCX::convertAllData(const sfe_ism_raw_all_data_t* rawData, sfe_ism_all_data_t* allData)
+{
+	const ism330dhcx_status_reg_t* status = (const ism330dhcx_status_reg_t*)&rawData->status;
+
+	allData->accelReady = (status->xlda == 1);
+	allData->gyroReady = (status->gda == 1);
+	allData->tempReady = (status->tda == 1);
+	allData->tempData = convertToCelsius(rawData->tempData);
+
+	if( !convertGyroData(&rawData->gyroData, &allData->gyroData) )
+		return false;
+
+	return convertAccelData(&rawData->accelData, &allData->accelData);
+}
+
+
+//////////////////////////////////////////////////////////////////////////////
+// getIntAccel()
+//
+// Retrieves raw register values and converts them to micro-g with integer math
+//
+//  Parameter    Description
+//  ---------   -----------------------------
+//  accelData    Integer data type pointer at which data will be stored. 
+//
+
+bool QwDevISM330DHCX::getIntAccel(sfe_ism_int_data_t* accelData)
+{
+	sfe_ism_raw_data_t tempVal;	
+
+	if( !getRawAccel(&tempVal) )
+		return false;
+
+	convertIntAccel(&tempVal, accelData);
+
+	return true;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// getIntGyro()
+//
+// Retrieves raw register values and converts them to mdps with
+// ISM_GYRO_INT_FRAC_BITS fractional bits with integer math
+//
+//  Parameter    Description
+//  ---------   -----------------------------
+//  gyroData    Integer data type pointer at which data will be stored. 
+//
+
+bool QwDevISM330DHCX::getIntGyro(sfe_ism_int_data_t* gyroData)
+{
+	sfe_ism_raw_data_t tempVal;	
+
+	if( !getRawGyro(&tempVal) )
+		return false;
+
+	convertIntGyro(&tempVal, gyroData);
+
+	return true;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// getIntTemp()
+//
+// Retrieves the temperature in milli-degrees Celsius
+//
+//  Parameter    Description
+//  ---------   -----------------------------
+//  tempData    Pointer at which the temperature will be stored. 
+//
+
+bool QwDevISM330DHCX::getIntTemp(int32_t* tempData)
+{
+	int16_t tempVal;	
+	int32_t retVal = ism330dhcx_temperature_raw_get(&sfe_dev, &tempVal);
+
+	if( retVal != 0 )
+		return false;
+
+	*tempData = convertIntTemp(tempVal);
+
+	return true;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// getIntAllData()
+//
+// Integer version of getAllData(), one bus transaction for the status, 
+// temperature, gyroscope and accelerometer data.
+//
+//  Parameter    Description
+//  ---------   -----------------------------
+//  allData     Integer data type pointer at which data will be stored. 
+//
+
+bool QwDevISM330DHCX::getIntAllData(sfe_ism_int_all_data_t* allData)
+{
+	sfe_ism_raw_all_data_t rawData;
+
+	if( !getRawAllData(&rawData) )
+		return false;
+
+	convertIntAllData(&rawData, allData);
+
+	return true;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// convertIntAllData()
+//
+// Converts a raw combined read with integer math
+//
+//  Parameter    Description
+//  ---------   -----------------------------
+//  rawData     Raw data type pointer holding the combined read
+//  allData     Integer data type pointer at which data will be stored. 
+//
+
+void QwDevISM330DHCX::convertIntAllData(const sfe_ism_raw_all_data_t* rawData, sfe_ism_int_all_data_t* allData)
+{
+	const ism330dhcx_status_reg_t* status = (const ism330dhcx_status_reg_t*)&rawData->status;
+
+	allData->accelReady = (status->xlda == 1);
+	allData->gyroReady = (status->gda == 1);
+	allData->tempReady = (status->tda == 1);
+	allData->tempData = convertIntTemp(rawData->tempData);
+
+	convertIntGyro(&rawData->gyroData, &allData->gyroData);
+	convertIntAccel(&rawData->accelData, &allData->accelData);
+}
+
+
+
+//////////////////////////////////////////////////////////////////////////////////
+// Conversions Methods
+// 
+//
 
 float QwDevISM330DHCX::convert2gToMg(int16_t data)
 {
-	return(ism330dhcx_from_fs2g_to_mg(data));
+	return(ism330dhcx_from_fs2g_to_mg(data));
+}
+
+float QwDevISM330DHCX::convert4gToMg(int16_t data)
+{
+	return(ism330dhcx_from_fs4g_to_mg(data));
+}
+
+float QwDevISM330DHCX::convert8gToMg(int16_t data)
+{
+	return(ism330dhcx_from_fs8g_to_mg(data));
+}
+
+float QwDevISM330DHCX::convert16gToMg(int16_t data)
+{
+	return(ism330dhcx_from_fs16g_to_mg(data));
+}
+
+float QwDevISM330DHCX::convert125dpsToMdps(int16_t data)
+{
+	return(ism330dhcx_from_fs125dps_to_mdps(data));
+}
+
+float QwDevISM330DHCX::convert250dpsToMdps(int16_t data)
+{
+	return(ism330dhcx_from_fs250dps_to_mdps(data));
+}
+
+float QwDevISM330DHCX::convert500dpsToMdps(int16_t data)
+{
+	return(ism330dhcx_from_fs500dps_to_mdps(data));
+}
+
+float QwDevISM330DHCX::convert1000dpsToMdps(int16_t data)
+{
+	return(ism330dhcx_from_fs1000dps_to_mdps(data));
+}
+
+float QwDevISM330DHCX::convert2000dpsToMdps(int16_t data)
+{
+	return(ism330dhcx_from_fs2000dps_to_mdps(data));
+}
+
+float QwDevISM330DHCX::convert4000dpsToMdps(int16_t data)
+{
+	return(ism330dhcx_from_fs4000dps_to_mdps(data));
+}
+
+float QwDevISM330DHCX::convertToCelsius(int16_t data)
+{
+	return(ism330dhcx_from_lsb_to_celsius(data));
+}
+
+//
+//
+//////////////////////////////////////////////////////////////////////////////////
+
+
+
+//////////////////////////////////////////////////////////////////////////////////
+// General Settings
+//
+// 
+//
+//
+
+
+//////////////////////////////////////////////////////////////////////////////////
+// setDeviceConfig()
+//
+// 
+//  Parameter   Description
+//  ---------   -----------------------------
+//  enable      Enable the general device configuration - this is a configuration 
+//							register in the ISM330DHCX, not a library implementation. 
+
+bool QwDevISM330DHCX::setDeviceConfig(bool enable)
+{
+	int32_t retVal;
+
+	retVal = ism330dhcx_device_conf_set(&sfe_dev, (uint8_t)enable);
+
+	if( retVal != 0 )
+		return false;
+
+	return true;
+}
+
+
+//////////////////////////////////////////////////////////////////////////////////
+// deviceReset()
+// 
+// Resets the deivice to default settings
+// 
+// When the register shadow is enabled call syncShadow() once getDeviceReset()
+// reports the reset is complete.
+// 
+
+bool QwDevISM330DHCX::deviceReset()
+{
+	int32_t retVal;
+
+	retVal = ism330dhcx_reset_set(&sfe_dev, 1);
+
+	if( retVal != 0 )
+		return false;
+
+	// Full scale defaults until getDeviceReset() reads them back
+	setAccelSensitivity(ISM_2g);
+	setGyroSensitivity(ISM_250dps);
+	_fifoCompression = false;
+	resetFifoDecoder();
+
+	return true;
+}
+
+//////////////////////////////////////////////////////////////////////////////////
+// getDeviceReset()
+// 
+// Checks to see that the reset bit has been set
+// 
+
+bool QwDevISM330DHCX::getDeviceReset()
+{
+
+	int32_t retVal;
+	uint8_t tempVal;
+	retVal = ism330dhcx_reset_get(&sfe_dev, &tempVal);
+
+	if( retVal != 0 )
+		return false;
+
+	if( (tempVal & 0x01) == 0x00 ){
+		return syncFullScale(); 
+	}
+
+	return false; 
+	
+}
+
+
+//////////////////////////////////////////////////////////////////////////////////
+// setAccelSlopeFilter()
+// 
+// Sets the accelerometer's slope filter
+// 
+//  Parameter   Description
+//  ---------   -----------------------------
+//  val         This parameter determines the intensity of the filter - (0x00 - 0x37) 
+//
+// See sfe_ism330dhcx_defs.h for a list of valid arguments
+
+bool QwDevISM330DHCX::setAccelSlopeFilter(uint8_t val)
+{
+	int32_t retVal;
+	if( val > 0x37 )
+		return false;
+
+	retVal = ism330dhcx_xl_hp_path_on_out_set(&sfe_dev,
+                                         (ism330dhcx_hp_slope_xl_en_t)val);
+
+	if( retVal != 0 )
+		return false;
+
+	return true;
+}
+
+
+
+//////////////////////////////////////////////////////////////////////////////////
+// setAccelFilterLP2()
+// 
+// Enables the accelerometer's high resolution slope filter
+// 
+//  Parameter   Description
+//  ---------   -----------------------------
+//  enable      Enables/Disables the high resolution slope filter
+//
+
+bool QwDevISM330DHCX::setAccelFilterLP2(bool enable)
+{
+	int32_t retVal;
+
+	retVal = ism330dhcx_xl_filter_lp2_set(&sfe_dev, (uint8_t)enable);
+
+	if( retVal != 0 )
+		return false;
+
+	return true;
+}
+
+
+//////////////////////////////////////////////////////////////////////////////////
+// setGyroFilterLP1()
+// 
+// Enables the gyroscope's slope filter
+// 
+//  Parameter   Description
+//  ---------   -----------------------------
+//  enable      Enables/Disables the high resolution slope filter
+//
+
+bool QwDevISM330DHCX::setGyroFilterLP1(bool enable)
+{
+	int32_t retVal;
+
+	retVal = ism330dhcx_gy_filter_lp1_set(&sfe_dev, (uint8_t)enable);
+
+	if( retVal != 0 )
+		return false;
+
+	return true;
+}
+
+//////////////////////////////////////////////////////////////////////////////////
+// setGyroLP1Bandwidth()
+// 
+// Sets the low pass filter's bandwidth for the gyroscope
+// 
+//  Parameter   Description
+//  ---------   -----------------------------
+//  val					Sets the bandwidth's value
+//
+// See sfe_ism330dhcx_defs.h for a list of valid arguments
+//
+
+bool QwDevISM330DHCX::setGyroLP1Bandwidth(uint8_t val)
+{
+	int32_t retVal;
+	if( val > 7 )
+		return false;
+
+	retVal = ism330dhcx_gy_lp1_bandwidth_set(&sfe_dev, 
+																				  (ism330dhcx_ftype_t)val);
+
+	if( retVal != 0 )
+		return false;
+
+	return true;
+}
+
+
+//////////////////////////////////////////////////////////////////////////////////
+// setBlockDataUpdate()
+// 
+// Data is not updated until both MSB and LSB have been read from output registers
+// 
+//  Parameter   Description
+//  ---------   -----------------------------
+//  enable			Enable/disables block data update.
+//
+
+bool QwDevISM330DHCX::setBlockDataUpdate(bool enable)
+{
+
+	int32_t retVal = ism330dhcx_block_data_update_set(&sfe_dev, (uint8_t)enable);
+
+	if( retVal != 0 )
+		return false;
+
+	return true; 
+}
+
+
+//////////////////////////////////////////////////////////////////////////////////
+// getBlockDataUpdate()
+// 
+// Retrieves the bit indicating whether block data update is enabled. 
+// 
+//
+
+uint8_t QwDevISM330DHCX::getBlockDataUpdate()
+{
+
+	uint8_t tempVal;
+	int32_t retVal = ism330dhcx_block_data_update_get(&sfe_dev, &tempVal);
+
+	(void)retVal;
+	return tempVal; 
+}
+
+
+//////////////////////////////////////////////////////////////////////////////////
+// setAccelDataRate()
+// 
+// This sets the data output rate for the accelerometer.
+// 
+//  Parameter   Description
+//  ---------   -----------------------------
+//  rate        Sets the output data rate, expects some value < 11. 
+//
+// See sfe_ism330dhcx_defs.h for a list of valid arguments
+
+bool QwDevISM330DHCX::setAccelDataRate(uint8_t rate)
+{
+	if( rate > 11 )
+		return false; 
+
+	int32_t retVal = ism330dhcx_xl_data_rate_set(&sfe_dev, (ism330dhcx_odr_xl_t)rate);
+
+	if( retVal != 0)
+		return false;
+
+	return true; 
+}
+
+
+//////////////////////////////////////////////////////////////////////////////////
+// setGyroDataRate()
+// 
+// This sets the data output rate for the gyroscope.
+// 
+//  Parameter   Description
+//  ---------   -----------------------------
+//  rate        Sets the output data rate, expects some value < 10. 
+//
+// See sfe_ism330dhcx_defs.h for a list of valid arguments
+//
+
+bool QwDevISM330DHCX::setGyroDataRate(uint8_t rate)
+{
+	if( rate > 10 )
+		return false;
+
+	int32_t retVal = ism330dhcx_gy_data_rate_set(&sfe_dev,(ism330dhcx_odr_g_t)rate);
+
+	if( retVal != 0 )
+		return false;
+
+	return true; 
+}
+
+
+
+//////////////////////////////////////////////////////////////////////////////////
+// enableTimestamp()
+// 
+// Enables time stamp counter
+// 
+//  Parameter   Description
+//  ---------   -----------------------------
+//  enable      Enables/disables time stamp counter
+//
+
+bool QwDevISM330DHCX::enableTimestamp(bool enable)
+{
+	int32_t retVal;
+
+	retVal = ism330dhcx_timestamp_set(&sfe_dev, (uint8_t)enable);
+
+	if( retVal != 0 )
+		return false;
+
+	return true;
+}
+
+
+//////////////////////////////////////////////////////////////////////////////////
+// resetTimestamp()
+// 
+// Resets time stamp counter
+// 
+//
+
+bool QwDevISM330DHCX::resetTimestamp()
+{
+	int32_t retVal; 
+
+	retVal = ism330dhcx_timestamp_rst(&sfe_dev);
+
+	if( retVal != 0 )
+		return false;
+
+	// The FIFO's next TIMESTAMP word starts over
+	_fifoAnchorValid = false;
+
+	return true;
+}
+
+//////////////////////////////////////////////////////////////////////////////////
+// getTimestamp()
+//
+// Reads the 32 bit timestamp counter, TIMESTAMP0 - TIMESTAMP3 in one burst.
+//
+//  Parameter   Description
+//  ---------   -----------------------------
+//  ticks       Counter value, 25us per tick at the nominal oscillator rate
+//
+
+bool QwDevISM330DHCX::getTimestamp(uint32_t* ticks)
+{
+	uint8_t buff[4];
+	int32_t retVal = readRegisterRegion(ISM330DHCX_TIMESTAMP0, buff, 4);
+
+	if( retVal != 0 )
+		return false;
+
+	*ticks = ((uint32_t)buff[3] << 24) | ((uint32_t)buff[2] << 16) |
+	         ((uint32_t)buff[1] << 8) | buff[0];
+
+	return true;
+}
+
+//////////////////////////////////////////////////////////////////////////////////
+// syncClock()
+//
+// Adds a pair of device and host time to the clock model. The host clock is 
+// read before and after the timestamp and the midpoint is used, so the bus 
+// latency doesn't bias the offset. The first call also seeds the model's rate
+// with INTERNAL_FREQ_FINE - the register is read only on this part so the 
+// deviation is corrected on the host instead.
+//
+//  Parameter   Description
+//  ---------   -----------------------------
+//  clock       The clock model to update
+//
+
+bool QwDevISM330DHCX::syncClock(QwISM330DHCXClock* clock)
+{
+	uint8_t freqFine;
+	uint32_t ticks;
+	uint64_t before;
+	uint64_t after;
+	int32_t retVal;
+
+	if( clock->getNumPairs() == 0 )
+	{
+		retVal = ism330dhcx_odr_cal_reg_get(&sfe_dev, &freqFine);
+
+		if( retVal != 0 )
+			return false;
+
+		clock->setFreqFine((int8_t)freqFine);
+	}
+
+	before = clock->hostNow();
+
+	if( !getTimestamp(&ticks) )
+		return false;
+
+	after = clock->hostNow();
+
+	clock->addPair(ticks, before + (after - before) / 2);
+
+	return true;
+}
+//
+//
+//////////////////////////////////////////////////////////////////////////////////
+
+//////////////////////////////////////////////////////////////////////////////////
+// FIFO Settings
+//
+// 
+//
+//
+//  
+// 
+
+//////////////////////////////////////////////////////////////////////////////////
+// setFifoWatermark()
+// 
+// Sets the FIFO's watermark 
+// 
+//  Parameter   Description
+//  ---------   -----------------------------
+//  val					Sets the watermark, must be some value less than 511 (9 bit value)
+//
+
+bool QwDevISM330DHCX::setFifoWatermark(uint16_t val)
+{
+	int32_t retVal;
+
+	if( val > 511 ) 
+		return false; 
+
+	retVal = ism330dhcx_fifo_watermark_set(&sfe_dev, val);
+
+	if( retVal != 0 )
+		return false;
+
+	return true;
+}
+
+
+//////////////////////////////////////////////////////////////////////////////////
+// setFifoMode()
+// 
+// Sets the FIFO's mode. 
+// 
+//  Parameter   Description
+//  ---------   -----------------------------
+//  val					Selects the FIFO's mode
+//
+// See sfe_ism330dhcx_defs.h for a list of valid arguments
+//
+
+bool QwDevISM330DHCX::setFifoMode(uint8_t val)
+{
+	int32_t retVal;
+
+	if( val > 7 )
+		return false;
+
+	retVal = ism330dhcx_fifo_mode_set(&sfe_dev,
+                                 (ism330dhcx_fifo_mode_t)val);
+
+	if( retVal != 0 )
+		return false;
+
+	// Bypass empties the FIFO, the next word starts a new stream
+	if( val == ISM_BYPASS_MODE )
+		resetFifoDecoder();
+
+	return true;
+}
+
+
+//////////////////////////////////////////////////////////////////////////////////
+// setAccelFifoBatchSet()
+// 
+// Sets the batch data rate for the accelerometer
+// 
+//  Parameter   Description
+//  ---------   -----------------------------
+//  val					Sets the batch data rate. 
+//
+// See sfe_ism330dhcx_defs.h for a list of valid arguments
+//
+
+bool QwDevISM330DHCX::setAccelFifoBatchSet(uint8_t val)
+{
+	int32_t retVal;
+	if( val > 11)
+		return false;
+
+	retVal = ism330dhcx_fifo_xl_batch_set(&sfe_dev,
+                                     (ism330dhcx_bdr_xl_t)val);
+
+	if( retVal != 0 )
+		return false;
+
+	_fifoRatesValid = false;
+
+	return true;
+}
+
+
+
+//////////////////////////////////////////////////////////////////////////////////
+// setGyroFifoBatchSet()
+// 
+// Sets the batch data rate for the gyroscope
+// 
+//  Parameter   Description
+//  ---------   -----------------------------
+//  val					Sets the batch data rate. 
+//
+// See sfe_ism330dhcx_defs.h for a list of valid arguments
+
+bool QwDevISM330DHCX::setGyroFifoBatchSet(uint8_t val)
+{
+	int32_t retVal;
+	if( val > 11)
+		return false;
+
+	retVal = ism330dhcx_fifo_gy_batch_set(&sfe_dev,
+                                     (ism330dhcx_bdr_gy_t)val);
+
+	if( retVal != 0 )
+		return false;
+
+	_fifoRatesValid = false;
+
+	return true;
+}
+
+//////////////////////////////////////////////////////////////////////////////////
+// setFifoTimestampDec()
+// 
+// Sets the FIFO time stamp decimation rate.
+// 
+//  Parameter   Description
+//  ---------   -----------------------------
+//  val					Sets the time stamp decimation rate, 
+//
+// See sfe_ism330dhcx_defs.h for a list of valid arguments
+
+bool QwDevISM330DHCX::setFifoTimestampDec(uint8_t val)
+{
+	int32_t retVal;
+	if( val > 3 )
+		return false;
+
+	retVal = ism330dhcx_fifo_timestamp_decimation_set(&sfe_dev,
+                                                   (ism330dhcx_odr_ts_batch_t)val);
+
+	if( retVal != 0 )
+		return false;
+
+	return true;
+}
+
+//////////////////////////////////////////////////////////////////////////////////
+// getFifoLevel()
+// 
+// Retrieves the number of unread words in the FIFO. FIFO_STATUS1 and FIFO_STATUS2
+// are read together in a single transaction.
+//
+//  Parameter   Description
+//  ---------   -----------------------------
+//  level       Number of unread words
+//
+
+bool QwDevISM330DHCX::getFifoLevel(uint16_t* level)
+{
+	uint8_t buff[2];
+	int32_t retVal = readRegisterRegion(ISM330DHCX_FIFO_STATUS1, buff, 2);
+
+	if( retVal != 0 )
+		return false;
+
+	*level = (uint16_t)(((buff[1] & 0x03) << 8) | buff[0]);
+
+	return true;
+}
+
+
+//////////////////////////////////////////////////////////////////////////////////
+// readFifo()
+// 
+// Drains the words present in the FIFO and sorts them by their tag into the 
+// caller's accelerometer, gyroscope, temperature, timestamp and sensor hub 
+// buffers. The FIFO level is queried once, then the tagged words are read in
+// bursts of up to ISM_FIFO_READ_WORDS words from FIFO_DATA_OUT_TAG - the 
+// device rolls the address back to FIFO_DATA_OUT_TAG after FIFO_DATA_OUT_Z_H so
+// consecutive words are read without re-addressing.
+// 
+// At most maxWords words are read, the rest stay in the FIFO for the next call.
+// This bounds the time spent servicing a FIFO interrupt.
+// 
+//  Parameter   Description
+//  ---------   -----------------------------
+//  fifoData    Buffers to store the FIFO data into. The "num" members are 
+//              reset and then hold the number of entries stored.
+//  maxWords    Most words to read, all unread words by default
+//
+
+bool QwDevISM330DHCX::readFifo(sfe_ism_fifo_data_t* fifoData, uint16_t maxWords)
+{
+	RegisterReader reader = { this };
+
+	if( !beginFifoRead(fifoData) )
+		return false;
+
+	return drainFifo(reader, fifoData, maxWords);
+}
+
+
+//////////////////////////////////////////////////////////////////////////////////
+// beginFifoPipeline()
+// 
+// Sets the FIFO up to be drained from its interrupt instead of polling per 
+// sample. The FIFO is emptied, the watermark and overrun interrupts are routed
+// to the pin and Continuous mode is started. Select the batched data with 
+// setAccelFifoBatchSet() and setGyroFifoBatchSet() first.
+// 
+// When the pin fires call readFifo() with a maxWords that fits the buffers, 
+// from the main loop or an interrupt thread as the bus can't be used from an
+// interrupt handler on most targets. Each call reads the FIFO status and then
+// the unread words in bursts of ISM_FIFO_READ_WORDS. Words left behind keep
+// the watermark interrupt active.
+// 
+//  Parameter   Description
+//  ---------   -----------------------------
+//  watermark   FIFO words per interrupt, 1 - 511
+//  pin         Interrupt pin, 1 or 2
+//
+
+bool QwDevISM330DHCX::beginFifoPipeline(uint16_t watermark, uint8_t pin)
+{
+	if( watermark == 0 )
+		return false;
+
+	if( !setFifoMode(ISM_BYPASS_MODE) )
+		return false;
+
+	if( !setFifoWatermark(watermark) )
+		return false;
+
+	if( !setFifoInterrupt(pin, ISM_FIFO_INT_THRESHOLD | ISM_FIFO_INT_OVERRUN) )
+		return false;
+
+	return setFifoMode(ISM_STREAM_MODE);
+}
+
+
+//////////////////////////////////////////////////////////////////////////////////
+// readFifoRaw()
+// 
+// Reads unread FIFO words into the caller's buffer as the device sends them,
+// a tag byte and six data bytes per word, to be walked with QwFifoView. The 
+// words are read in a single burst straight into the buffer.
+// 
+// The words don't pass through the decoder of readFifo(), call 
+// resetFifoDecoder() before going back to readFifo().
+// 
+// The burst has to fit the bus, on QwLinuxSPI maxWords * ISM_FIFO_WORD_SIZE 
+// stays below ISM_SPIDEV_BUFSIZ or the read fails.
+// 
+//  Parameter   Description
+//  ---------   -----------------------------
+//  words       Buffer of at least maxWords * ISM_FIFO_WORD_SIZE bytes
+//  maxWords    Most words to read
+//  numWords    Number of words read
+//
+
+bool QwDevISM330DHCX::readFifoRaw(uint8_t* words, uint16_t maxWords, uint16_t* numWords)
+{
+	RegisterReader reader = { this };
+
+	return drainFifoRaw(reader, words, maxWords, numWords);
+}
+
+
+//////////////////////////////////////////////////////////////////////////////////
+// setBatchCounter()
+// 
+// Sets the counter of batched samples that raises the batch counter 
+// interrupt (ISM_FIFO_INT_BATCH_COUNTER) every "threshold" accelerometer or 
+// gyroscope samples written to the FIFO, independent of the watermark. The 
+// counter restarts from zero. Both counter registers are written in one burst,
+// DATAREADY_PULSED in the same register is kept.
+// 
+//  Parameter   Description
+//  ---------   -----------------------------
+//  sensor      ISM_XL_BATCH_EVENT or ISM_GY_BATCH_EVENT
+//  threshold   Samples per interrupt, 1 - 2047, 0 turns the counter off
+//
+
+bool QwDevISM330DHCX::setBatchCounter(uint8_t sensor, uint16_t threshold)
+{
+	int32_t retVal;
+	uint8_t buff[2];
+
+	if( sensor > ISM_GY_BATCH_EVENT || threshold > 2047 )
+		return false;
+
+	retVal = readRegisterRegion(ISM330DHCX_COUNTER_BDR_REG1, buff, 1);
+
+	if( retVal != 0 )
+		return false;
+
+	// DATAREADY_PULSED, RST_COUNTER_BDR, TRIG_COUNTER_BDR and CNT_BDR_TH[10:8]
+	buff[0] = (buff[0] & 0x80) | 0x40 | (sensor << 5) | (uint8_t)(threshold >> 8);
+	buff[1] = (uint8_t)(threshold & 0xFF);
+
+	retVal = writeRegisterRegion(ISM330DHCX_COUNTER_BDR_REG1, buff, 2);
+
+	if( retVal != 0 )
+		return false;
+
+	_blockSensor = sensor;
+	_blockSamples = threshold;
+	_blockOpen = false;
+	_blockCarried = 0;
+
+	return true;
+}
+
+
+//////////////////////////////////////////////////////////////////////////////////
+// resetBatchCounter()
+// 
+// Restarts the counter of batched samples from zero.
+//
+
+bool QwDevISM330DHCX::resetBatchCounter()
+{
+	int32_t retVal;
+
+	retVal = ism330dhcx_rst_batch_counter_set(&sfe_dev, 1);
+
+	if( retVal != 0 )
+		return false;
+
+	return true;
+}
+
+
+//////////////////////////////////////////////////////////////////////////////////
+// beginBlockPipeline()
+// 
+// Sets the FIFO up to be drained in blocks of a fixed number of samples, e.g.
+// the length of an FFT frame. The FIFO is emptied, the batch counter is set 
+// to "samples" of the sensor and its interrupt is routed to the pin with the
+// overrun interrupt, then Continuous mode is started. The watermark isn't 
+// used. Select the batched data with setAccelFifoBatchSet() and 
+// setGyroFifoBatchSet() first.
+// 
+// When the pin fires call readFifoBlock().
+// 
+//  Parameter   Description
+//  ---------   -----------------------------
+//  samples     Samples per block, 1 - 2047
+//  sensor      ISM_XL_BATCH_EVENT or ISM_GY_BATCH_EVENT
+//  pin         Interrupt pin, 1 or 2
+//
+
+bool QwDevISM330DHCX::beginBlockPipeline(uint16_t samples, uint8_t sensor, uint8_t pin)
+{
+	if( samples == 0 )
+		return false;
+
+	if( !setFifoMode(ISM_BYPASS_MODE) )
+		return false;
+
+	if( !setBatchCounter(sensor, samples) )
+		return false;
+
+	if( !setFifoInterrupt(pin, ISM_FIFO_INT_BATCH_COUNTER | ISM_FIFO_INT_OVERRUN) )
+		return false;
+
+	return setFifoMode(ISM_STREAM_MODE);
+}
+
+
+//////////////////////////////////////////////////////////////////////////////////
+// readFifoBlock()
+// 
+// Reads FIFO words until the buffers hold one block, the number of samples of
+// the sensor set with setBatchCounter(), and leaves the words after the block
+// in the FIFO. Bursts are limited to the samples still missing so no word of 
+// the next block is read. The last bursts of a block are shorter than 
+// ISM_FIFO_READ_WORDS.
+// 
+// A block the FIFO doesn't hold completely yet stays in the buffers and the 
+// next call completes it. With compression one word can hold up to three 
+// samples, the samples of the last word past the end of the block are kept by
+// the driver and start the next block.
+// 
+// Returns true once the buffers hold a complete block.
+// 
+//  Parameter   Description
+//  ---------   -----------------------------
+//  fifoData    Buffers to store the FIFO data into, the counted sensor's 
+//              buffer holds at least one block. The "num" members are reset
+//              when a new block starts.
+//
+
+bool QwDevISM330DHCX::readFifoBlock(sfe_ism_fifo_data_t* fifoData)
+{
+	RegisterReader reader = { this };
+	uint16_t* counted = _blockSensor == ISM_GY_BATCH_EVENT ? &fifoData->numGyro : &fifoData->numAccel;
+	uint16_t size = _blockSensor == ISM_GY_BATCH_EVENT ? fifoData->gyroSize : fifoData->accelSize;
+	bool ok;
+
+	if( _blockSamples == 0 || size < _blockSamples )
+		return false;
+
+	if( _blockOpen )
+	{
+		if( !prepareFifoDecoder() )
+			return false;
+	}
+	else
+	{
+		if( !beginFifoRead(fifoData) )
+			return false;
+
+		restoreBlockCarry(fifoData);
+	}
+
+	_blockReading = true;
+	ok = drainFifo(reader, fifoData, 0xFFFF, counted, _blockSamples);
+	_blockReading = false;
+
+	if( !ok )
+		return false;
+
+	_blockOpen = *counted < _blockSamples;
+
+	return !_blockOpen;
+}
+
+
+//////////////////////////////////////////////////////////////////////////////////
+// armCapture()
+// 
+// Arms the FIFO to capture a window of "depth" words around an event so the 
+// host and the bus can stay idle until it happens. The trigger events are 
+// routed to the pin in addition to what is routed there already, the device 
+// switches the FIFO's mode when the pin goes active.
+// 
+//  ISM_STREAM_TO_FIFO_MODE    The FIFO holds the latest words until the
+//                             trigger and stops once it holds "depth" words,
+//                             the window ends at the trigger.
+//  ISM_BYPASS_TO_FIFO_MODE    The window starts at the trigger and ends after
+//                             "depth" words.
+//  ISM_BYPASS_TO_STREAM_MODE  Words are collected from the trigger on until 
+//                             the FIFO is put back in bypass, readCapture() 
+//                             drains what is there.
+// 
+// The modes starting at the trigger also route the watermark interrupt to the
+// pin, it fires when "depth" words are in. Select the batched data first.
+// 
+//  Parameter      Description
+//  ---------      -----------------------------
+//  triggerEvents  ISM_EVENT_FREE_FALL, _WAKE_UP, _SINGLE_TAP, _DOUBLE_TAP, 
+//                 _6D or _SLEEP_CHANGE or'ed together
+//  pin            Interrupt pin, 1 or 2
+//  mode           One of the modes above
+//  depth          Words in the window, 1 - 511
+//
+
+bool QwDevISM330DHCX::armCapture(uint32_t triggerEvents, uint8_t pin, uint8_t mode, uint16_t depth)
+{
+	int32_t retVal;
+	uint32_t triggers = ISM_EVENT_FREE_FALL | ISM_EVENT_WAKE_UP | ISM_EVENT_SINGLE_TAP |
+	                    ISM_EVENT_DOUBLE_TAP | ISM_EVENT_6D | ISM_EVENT_SLEEP_CHANGE;
+	uint8_t ctrl;
+	uint8_t md;
+	uint8_t emb[4];
+	uint8_t cfg[8];     // TAP_CFG2 - MD2_CFG
+
+	if( triggerEvents == 0 || (triggerEvents & ~triggers) || (pin != 1 && pin != 2) )
+		return false;
+
+	if( mode != ISM_STREAM_TO_FIFO_MODE && mode != ISM_BYPASS_TO_FIFO_MODE && mode != ISM_BYPASS_TO_STREAM_MODE )
+		return false;
+
+	if( depth == 0 || depth > 511 )
+		return false;
+
+	if( !routeEvents(triggerEvents, pin, &ctrl, &md, emb) )
+		return false;
+
+	// Empties the FIFO and clears a previous trigger
+	_captureMode = 0;
+	if( !setFifoMode(ISM_BYPASS_MODE) )
+		return false;
+
+	if( !setFifoWatermark(depth) )
+		return false;
+
+	// STOP_ON_WTM limits the depth of the FIFO to the window
+	retVal = ism330dhcx_fifo_stop_on_wtm_set(&sfe_dev, mode != ISM_BYPASS_TO_STREAM_MODE);
+
+	if( retVal != 0 )
+		return false;
+
+	// INTERRUPTS_ENABLE and MDx_CFG
+	retVal = readRegisterRegion(ISM330DHCX_TAP_CFG2, cfg, 8);
+
+	if( retVal != 0 )
+		return false;
+
+	cfg[0] |= 0x80;
+	cfg[pin == 1 ? 6 : 7] |= md;
+
+	retVal = writeRegisterRegion(ISM330DHCX_TAP_CFG2, cfg, 8);
+
+	if( retVal != 0 )
+		return false;
+
+	// A window ending at the trigger reaches the watermark before it
+	if( mode != ISM_STREAM_TO_FIFO_MODE && !setFifoInterrupt(pin, ISM_FIFO_INT_THRESHOLD) )
+		return false;
+
+	if( !setFifoMode(mode) )
+		return false;
+
+	_captureMode = mode;
+	_captureDepth = depth;
+	_captureRead = 0;
+	_captureSources = (uint8_t)triggerEvents;
+	_captureTriggered = false;
+	_triggerMarked = false;
+
+	return true;
+}
+
+//////////////////////////////////////////////////////////////////////////////////
+// markTrigger()
+// 
+// Notes the time of the trigger from the timestamp counter. Optional, call it 
+// from the trigger's interrupt as early as possible to split a window that 
+// doesn't end or start at the trigger. 
+//
+
+bool QwDevISM330DHCX::markTrigger()
+{
+	if( !getTimestamp(&_triggerTicks) )
+		return false;
+
+	_triggerMarked = true;
+
+	return true;
 }
 
-float QwDevISM330DHCX::convert4gToMg(int16_t data)
+//////////////////////////////////////////////////////////////////////////////////
+// readCapture()
+// 
+// Drains the window of the armed capture and locates the trigger in it. The 
+// window may take several calls, the words read are counted across them and
+// the capture is complete once all "depth" words were read. A complete window
+// of the FIFO modes ends the capture, the FIFO is put back in bypass and 
+// armCapture() starts the next one.
+// 
+// Until the trigger the stream-to-FIFO mode overwrites the oldest words, 
+// nothing is read before markTrigger() was called or a trigger event shows in
+// ALL_INT_SRC. Reading ALL_INT_SRC clears its latched events.
+// 
+//  Parameter   Description
+//  ---------   -----------------------------
+//  capture     Buffers to store the window into, and where the trigger is
+//
+
+bool QwDevISM330DHCX::readCapture(sfe_ism_capture_t* capture)
 {
-	return(ism330dhcx_from_fs4g_to_mg(data));
+	RegisterReader reader = { this };
+	int32_t retVal;
+	uint8_t source;
+	uint16_t maxWords = 0xFFFF;
+	uint16_t numRead;
+
+	if( _captureMode == 0 )
+		return false;
+
+	if( !beginFifoRead(&capture->fifo) )
+		return false;
+
+	capture->complete = false;
+	capture->triggerTime = 0;
+	capture->accelBefore = 0;
+	capture->gyroBefore = 0;
+
+	if( _captureMode == ISM_STREAM_TO_FIFO_MODE && !_triggerMarked && !_captureTriggered )
+	{
+		retVal = readRegisterRegion(ISM330DHCX_ALL_INT_SRC, &source, 1);
+
+		if( retVal != 0 )
+			return false;
+
+		_captureTriggered = (source & _captureSources) != 0;
+
+		if( !_captureTriggered )
+			return true;
+	}
+
+	// The FIFO modes stop at the watermark, the rest belongs to no window
+	if( _captureMode != ISM_BYPASS_TO_STREAM_MODE )
+		maxWords = _captureDepth - _captureRead;
+
+	if( !drainFifo(reader, &capture->fifo, maxWords, nullptr, 0, &numRead) )
+		return false;
+
+	_captureRead = _captureRead + numRead < _captureDepth ? _captureRead + numRead : _captureDepth;
+	capture->complete = _captureRead >= _captureDepth;
+
+	locateTrigger(capture);
+
+	if( capture->complete && _captureMode != ISM_BYPASS_TO_STREAM_MODE )
+	{
+		_captureMode = 0;
+		return setFifoMode(ISM_BYPASS_MODE);
+	}
+
+	return true;
 }
 
-float QwDevISM330DHCX::convert8gToMg(int16_t data)
+//////////////////////////////////////////////////////////////////////////////////
+// locateTrigger()
+// 
+// Finds the time of the trigger, from markTrigger() if called or else from the
+// end of the window that is closest to it, and counts the samples before it.
+// 
+//  Parameter   Description
+//  ---------   -----------------------------
+//  capture     The window read by readCapture()
+//
+
+void QwDevISM330DHCX::locateTrigger(sfe_ism_capture_t* capture)
 {
-	return(ism330dhcx_from_fs8g_to_mg(data));
+	sfe_ism_fifo_data_t* fifo = &capture->fifo;
+	uint64_t ticks;
+	bool atEnd = _captureMode == ISM_STREAM_TO_FIFO_MODE;
+
+	capture->triggerTime = 0;
+	capture->accelBefore = atEnd ? fifo->numAccel : 0;
+	capture->gyroBefore = atEnd ? fifo->numGyro : 0;
+
+	if( !_fifoAnchorValid )
+		return;
+
+	if( _triggerMarked )
+	{
+		// The counter value closest to the last TIMESTAMP word
+		ticks = (_fifoAnchorTicks & ~(uint64_t)0xFFFFFFFF) | _triggerTicks;
+
+		if( ticks > _fifoAnchorTicks + 0x80000000 )
+			ticks -= (uint64_t)1 << 32;
+		else if( ticks + 0x80000000 < _fifoAnchorTicks )
+			ticks += (uint64_t)1 << 32;
+
+		capture->triggerTime = ticks * ISM_TIMESTAMP_NS;
+	}
+	else if( atEnd )
+	{
+		if( fifo->accelTime && fifo->numAccel )
+			capture->triggerTime = fifo->accelTime[fifo->numAccel - 1];
+
+		if( fifo->gyroTime && fifo->numGyro && fifo->gyroTime[fifo->numGyro - 1] > capture->triggerTime )
+			capture->triggerTime = fifo->gyroTime[fifo->numGyro - 1];
+
+		return;
+	}
+	else
+	{
+		if( fifo->accelTime && fifo->numAccel )
+			capture->triggerTime = fifo->accelTime[0];
+
+		if( fifo->gyroTime && fifo->numGyro && (capture->triggerTime == 0 || fifo->gyroTime[0] < capture->triggerTime) )
+			capture->triggerTime = fifo->gyroTime[0];
+
+		// Later reads of the window come after it
+		if( capture->triggerTime )
+		{
+			_triggerTicks = (uint32_t)(capture->triggerTime / ISM_TIMESTAMP_NS);
+			_triggerMarked = true;
+		}
+
+		return;
+	}
+
+	if( fifo->accelTime )
+	{
+		capture->accelBefore = 0;
+		while( capture->accelBefore < fifo->numAccel && fifo->accelTime[capture->accelBefore] < capture->triggerTime )
+			capture->accelBefore++;
+	}
+
+	if( fifo->gyroTime )
+	{
+		capture->gyroBefore = 0;
+		while( capture->gyroBefore < fifo->numGyro && fifo->gyroTime[capture->gyroBefore] < capture->triggerTime )
+			capture->gyroBefore++;
+	}
 }
 
-float QwDevISM330DHCX::convert16gToMg(int16_t data)
+
+//////////////////////////////////////////////////////////////////////////////////
+// setFifoCompression()
+// 
+// Enables the FIFO compression of the accelerometer and gyroscope data. readFifo()
+// decompresses the words so the caller still receives every sample. 
+// 
+//  Parameter   Description
+//  ---------   -----------------------------
+//  val         ISM_FIFO_COMPRESSION_OFF, _ALWAYS or the ratio of compressed to 
+//              uncompressed words (_8_TO_1, _16_TO_1, _32_TO_1).
+//
+// See sfe_ism330dhcx_defs.h for a list of valid arguments
+
+bool QwDevISM330DHCX::setFifoCompression(uint8_t val)
 {
-	return(ism330dhcx_from_fs16g_to_mg(data));
+	int32_t retVal;
+
+	if( val != ISM_FIFO_COMPRESSION_OFF && (val < ISM_FIFO_COMPRESSION_ALWAYS || val > ISM_FIFO_COMPRESSION_32_TO_1) )
+		return false;
+
+	retVal = ism330dhcx_compression_algo_set(&sfe_dev, (ism330dhcx_uncoptr_rate_t)val);
+
+	if( retVal != 0 )
+		return false;
+
+	// Restart the device's compressor so it doesn't reference a sample the 
+	// decoder hasn't seen.
+	if( val != ISM_FIFO_COMPRESSION_OFF )
+	{
+		retVal = ism330dhcx_compression_algo_init_set(&sfe_dev, 1);
+
+		if( retVal != 0 )
+			return false;
+	}
+
+	_fifoCompression = val != ISM_FIFO_COMPRESSION_OFF;
+	resetFifoDecoder();
+
+	return true;
 }
 
-float QwDevISM330DHCX::convert125dpsToMdps(int16_t data)
+//////////////////////////////////////////////////////////////////////////////////
+// resetFifoDecoder()
+// 
+// Forgets the previous samples and tag counter used to decode the FIFO. Call it 
+// after emptying the FIFO by other means than setFifoMode(ISM_BYPASS_MODE).
+//
+
+void QwDevISM330DHCX::resetFifoDecoder()
 {
-	return(ism330dhcx_from_fs125dps_to_mdps(data));
+	_fifoRatesValid = false;
+	_fifoTagValid = false;
+	_fifoSlot = 0;
+	_fifoLastAccel = {0, 0, 0};
+	_fifoLastGyro = {0, 0, 0};
+	_fifoAccelSeen = false;
+	_fifoGyroSeen = false;
+	_fifoAnchorValid = false;
+	_blockOpen = false;
+	_blockCarried = 0;
 }
 
-float QwDevISM330DHCX::convert250dpsToMdps(int16_t data)
+//////////////////////////////////////////////////////////////////////////////////
+// beginFifoRead()
+// 
+// Resets the counts of the caller's buffers and readies the decoder for a 
+// readFifo().
+// 
+//  Parameter   Description
+//  ---------   -----------------------------
+//  fifoData    Buffers the FIFO data will be stored into.
+//
+
+bool QwDevISM330DHCX::beginFifoRead(sfe_ism_fifo_data_t* fifoData)
 {
-	return(ism330dhcx_from_fs250dps_to_mdps(data));
+	fifoData->numAccel = 0;
+	fifoData->numGyro = 0;
+	fifoData->numTemp = 0;
+	fifoData->numTimestamp = 0;
+	fifoData->numHub = 0;
+	fifoData->numDropped = 0;
+	fifoData->accelMissing = 0;
+	fifoData->gyroMissing = 0;
+	fifoData->overrun = false;
+
+	_fifoPendingAccel = 0;
+	_fifoPendingGyro = 0;
+
+	return prepareFifoDecoder();
 }
 
-float QwDevISM330DHCX::convert500dpsToMdps(int16_t data)
+//////////////////////////////////////////////////////////////////////////////////
+// decodeFifoStatus()
+// 
+// Returns the number of unread words from FIFO_STATUS1/2 and notes an overrun.
+// 
+//  Parameter   Description
+//  ---------   -----------------------------
+//  status      FIFO_STATUS1 and FIFO_STATUS2
+//  fifoData    Buffers the FIFO data will be stored into.
+//
+
+uint16_t QwDevISM330DHCX::decodeFifoStatus(const uint8_t* status, sfe_ism_fifo_data_t* fifoData)
 {
-	return(ism330dhcx_from_fs500dps_to_mdps(data));
+	// FIFO_OVR_IA or FIFO_OVR_LATCHED, the latter clears when read
+	if( (status[1] & 0x48) || _fifoOverrunLatched )
+		fifoData->overrun = true;
+
+	_fifoOverrunLatched = false;
+
+	return (uint16_t)(((status[1] & 0x03) << 8) | status[0]);
 }
 
-float QwDevISM330DHCX::convert1000dpsToMdps(int16_t data)
+//////////////////////////////////////////////////////////////////////////////////
+// endFifoRead()
+// 
+// Timestamps the samples read after the last TIMESTAMP word by extrapolating 
+// from it.
+// 
+//  Parameter   Description
+//  ---------   -----------------------------
+//  fifoData    Buffers the FIFO data was stored into.
+//
+
+void QwDevISM330DHCX::endFifoRead(sfe_ism_fifo_data_t* fifoData)
 {
-	return(ism330dhcx_from_fs1000dps_to_mdps(data));
+	timeFifoSamples(fifoData);
 }
 
-float QwDevISM330DHCX::convert2000dpsToMdps(int16_t data)
+//////////////////////////////////////////////////////////////////////////////////
+// timeFifoSamples()
+// 
+// Turns the time slots stored in the time buffers since the last call into 
+// device time. The times are interpolated from the last TIMESTAMP word by the 
+// measured time slot period. Zero while no TIMESTAMP word has been read.
+// 
+//  Parameter   Description
+//  ---------   -----------------------------
+//  fifoData    Buffers the FIFO data was stored into.
+//
+
+void QwDevISM330DHCX::timeFifoSamples(sfe_ism_fifo_data_t* fifoData)
 {
-	return(ism330dhcx_from_fs2000dps_to_mdps(data));
+	if( fifoData->accelTime )
+	{
+		for( ; _fifoPendingAccel < fifoData->numAccel; _fifoPendingAccel++ )
+			fifoData->accelTime[_fifoPendingAccel] = fifoSlotToNs((uint32_t)fifoData->accelTime[_fifoPendingAccel]);
+	}
+
+	if( fifoData->gyroTime )
+	{
+		for( ; _fifoPendingGyro < fifoData->numGyro; _fifoPendingGyro++ )
+			fifoData->gyroTime[_fifoPendingGyro] = fifoSlotToNs((uint32_t)fifoData->gyroTime[_fifoPendingGyro]);
+	}
 }
 
-float QwDevISM330DHCX::convert4000dpsToMdps(int16_t data)
+//////////////////////////////////////////////////////////////////////////////////
+// fifoSlotToNs()
+// 
+// Device time of a FIFO time slot in nanoseconds, from the last TIMESTAMP word.
+// 
+//  Parameter   Description
+//  ---------   -----------------------------
+//  slot        The time slot
+//
+
+uint64_t QwDevISM330DHCX::fifoSlotToNs(uint32_t slot)
 {
-	return(ism330dhcx_from_fs4000dps_to_mdps(data));
+	int64_t ticks;
+
+	if( !_fifoAnchorValid )
+		return 0;
+
+	// Ticks in 1/256, the slot may be before the TIMESTAMP word
+	ticks = (int64_t)(_fifoAnchorTicks << 8) + (int64_t)(int32_t)(slot - _fifoAnchorSlot) * _fifoSlotTicks;
+
+	if( ticks < 0 )
+		return 0;
+
+	return ((uint64_t)ticks * ISM_TIMESTAMP_NS) >> 8;
 }
 
-float QwDevISM330DHCX::convertToCelsius(int16_t data)
+//////////////////////////////////////////////////////////////////////////////////
+// addFifoTimestamp()
+// 
+// Anchors the time slots to a TIMESTAMP word. The samples of the time slots 
+// before it are timed against the previous word with the slot period measured
+// between the two, the counter is extended to 64 bits across roll overs.
+// 
+//  Parameter   Description
+//  ---------   -----------------------------
+//  timestamp   The 32 bit TIMESTAMP word
+//  fifoData    Buffers the FIFO data is stored into.
+//
+
+void QwDevISM330DHCX::addFifoTimestamp(uint32_t timestamp, sfe_ism_fifo_data_t* fifoData)
 {
-	return(ism330dhcx_from_lsb_to_celsius(data));
+	uint64_t ticks;
+	uint32_t slots;
+
+	if( !_fifoAnchorValid )
+	{
+		// The samples before the first word are timed back from it
+		_fifoAnchorTicks = timestamp;
+		_fifoAnchorSlot = _fifoSlot;
+		_fifoSlotTicks = _fifoNominalSlotTicks;
+		_fifoAnchorValid = true;
+		timeFifoSamples(fifoData);
+		return;
+	}
+
+	ticks = (_fifoAnchorTicks & ~(uint64_t)0xFFFFFFFF) | timestamp;
+
+	if( ticks < _fifoAnchorTicks )
+		ticks += (uint64_t)1 << 32;
+
+	slots = _fifoSlot - _fifoAnchorSlot;
+
+	if( slots > 0 )
+		_fifoSlotTicks = (uint32_t)(((ticks - _fifoAnchorTicks) << 8) / slots);
+
+	timeFifoSamples(fifoData);
+
+	_fifoAnchorTicks = ticks;
+	_fifoAnchorSlot = _fifoSlot;
+}
+
+//////////////////////////////////////////////////////////////////////////////////
+// prepareFifoDecoder()
+// 
+// Reads the batch data rates the decoder needs to place compressed samples in 
+// time, once after they were changed.
+//
+
+bool QwDevISM330DHCX::prepareFifoDecoder()
+{
+	uint8_t buff[2];
+
+	if( _fifoRatesValid )
+		return true;
+
+	// FIFO_CTRL3 and FIFO_CTRL4
+	if( readRegisterRegion(ISM330DHCX_FIFO_CTRL3, buff, 2) != 0 )
+		return false;
+
+	// ODR_T_BATCH 1.6Hz, 12.5Hz or 52Hz, ranked as in setFifoRates()
+	switch( (buff[1] >> 4) & 0x03 )
+	{
+		case 1:
+			_fifoTempRank = 2;
+			break;
+		case 2:
+			_fifoTempRank = 5;
+			break;
+		case 3:
+			_fifoTempRank = 7;
+			break;
+		default:
+			_fifoTempRank = 0;
+			break;
+	}
+
+	setFifoRates(buff[0]);
+
+	return true;
 }
 
+//////////////////////////////////////////////////////////////////////////////////
+// setFifoRates()
+// 
+// Converts the batch data rates into the number of FIFO time slots between two 
+// samples of each sensor. The tag counter advances once per slot at the rate 
+// of the fastest batched sensor, the rates are all powers of two apart.
+// 
+//  Parameter   Description
+//  ---------   -----------------------------
+//  fifoCtrl3   BDR_GY in bits 7:4, BDR_XL in bits 3:0
 //
+
+void QwDevISM330DHCX::setFifoRates(uint8_t fifoCtrl3)
+{
+	uint8_t xlRank;
+	uint8_t gyRank;
+	uint8_t maxRank;
+
+	// Every rank doubles the rate: 12.5Hz is 5, 6667Hz is 14, the 6.5Hz 
+	// setting (11) is 4 and the 1.6Hz temperature rate 2.
+	xlRank = fifoCtrl3 & 0x0F;
+	xlRank = xlRank == 0 ? 0 : xlRank == 11 ? 4 : xlRank + 4;
+	gyRank = fifoCtrl3 >> 4;
+	gyRank = gyRank == 0 ? 0 : gyRank == 11 ? 4 : gyRank + 4;
+
+	maxRank = xlRank > gyRank ? xlRank : gyRank;
+	maxRank = _fifoTempRank > maxRank ? _fifoTempRank : maxRank;
+
+	_fifoAccelStep = xlRank ? (uint16_t)(1 << (maxRank - xlRank)) : 1;
+	_fifoGyroStep = gyRank ? (uint16_t)(1 << (maxRank - gyRank)) : 1;
+
+	// The rates derive from 6667Hz, 6 timestamp ticks. In 1/256 ticks.
+	if( maxRank )
+		_fifoNominalSlotTicks = (uint32_t)(6 * 256) << (14 - maxRank);
+
+	_fifoSlotTicks = _fifoNominalSlotTicks;
+
+	_fifoRatesValid = true;
+}
+
+//////////////////////////////////////////////////////////////////////////////////
+// sortFifoWord()
+// 
+// Copies a single tagged FIFO word into the buffer for its sensor, decompressing
+// accelerometer and gyroscope words.
+// 
+//  Parameter   Description
+//  ---------   -----------------------------
+//  word        The tag byte followed by the six data bytes
+//  fifoData    Buffers to store the FIFO data into.
 //
+
+void QwDevISM330DHCX::sortFifoWord(const uint8_t* word, sfe_ism_fifo_data_t* fifoData)
+{
+	uint8_t tagCnt = (word[0] >> 1) & 0x03;
+	uint32_t timestamp;
+
+	// The upper five bits are the sensor tag, bits 2:1 the tag counter that 
+	// advances with every time slot and bit 0 the parity.
+	if( _fifoTagValid )
+		_fifoSlot += (uint8_t)(tagCnt - _fifoTagCnt) & 0x03;
+
+	_fifoTagCnt = tagCnt;
+	_fifoTagValid = true;
+
+	switch( word[0] >> 3 )
+	{
+		case ISM330DHCX_XL_NC_TAG:
+		case ISM330DHCX_XL_NC_T_1_TAG:
+		case ISM330DHCX_XL_NC_T_2_TAG:
+		case ISM330DHCX_XL_2XC_TAG:
+		case ISM330DHCX_XL_3XC_TAG:
+			decodeFifoSamples(word, false, fifoData);
+			return;
+
+		case ISM330DHCX_GYRO_NC_TAG:
+		case ISM330DHCX_GYRO_NC_T_1_TAG:
+		case ISM330DHCX_GYRO_NC_T_2_TAG:
+		case ISM330DHCX_GYRO_2XC_TAG:
+		case ISM330DHCX_GYRO_3XC_TAG:
+			decodeFifoSamples(word, true, fifoData);
+			return;
+
+		case ISM330DHCX_CFG_CHANGE_TAG:
+			// The last data byte holds the new FIFO_CTRL3
+			setFifoRates(word[6]);
+			return;
+
+		case ISM330DHCX_TEMPERATURE_TAG:
+			if( fifoData->numTemp >= fifoData->tempSize )
+				break;
+			fifoData->tempData[fifoData->numTemp++] = (int16_t)((word[2] << 8) | word[1]);
+			return;
+
+		case ISM330DHCX_TIMESTAMP_TAG:
+			timestamp = ((uint32_t)word[4] << 24) | ((uint32_t)word[3] << 16) |
+			            ((uint32_t)word[2] << 8) | word[1];
+			addFifoTimestamp(timestamp, fifoData);
+			if( fifoData->numTimestamp >= fifoData->timestampSize )
+				break;
+			fifoData->timestampData[fifoData->numTimestamp++] = timestamp;
+			return;
+
+		case ISM330DHCX_SENSORHUB_SLAVE0_TAG:
+		case ISM330DHCX_SENSORHUB_SLAVE1_TAG:
+		case ISM330DHCX_SENSORHUB_SLAVE2_TAG:
+		case ISM330DHCX_SENSORHUB_SLAVE3_TAG:
+			if( fifoData->numHub >= fifoData->hubSize )
+				break;
+			fifoData->hubData[fifoData->numHub].sensor = (word[0] >> 3) - ISM330DHCX_SENSORHUB_SLAVE0_TAG;
+			memcpy(fifoData->hubData[fifoData->numHub].data, &word[1], 6);
+			fifoData->numHub++;
+			return;
+
+		default:
+			break;
+	}
+
+	fifoData->numDropped++;
+}
+
 //////////////////////////////////////////////////////////////////////////////////
+// decodeFifoSamples()
+// 
+// Reconstructs the samples held by an accelerometer or gyroscope word. T is the 
+// time slot of the word and T-1, T-2 are one and two sample periods before it.
+//
+//   NC, NC_T_1, NC_T_2   One uncompressed sample at T, T-1 or T-2
+//   2xC                  Samples at T-2 and T-1 as 8 bit differences
+//   3xC                  Samples at T-2, T-1 and T as 5 bit differences packed
+//                        x, y, z from the LSB into each 16 bit half-word
+//
+// Every difference is to the previous sample of the same sensor.
+// 
+//  Parameter   Description
+//  ---------   -----------------------------
+//  word        The tag byte followed by the six data bytes
+//  gyro        True for a gyroscope word
+//  fifoData    Buffers to store the FIFO data into.
+//
+
+void QwDevISM330DHCX::decodeFifoSamples(const uint8_t* word, bool gyro, sfe_ism_fifo_data_t* fifoData)
+{
+	sfe_ism_raw_data_t* last = gyro ? &_fifoLastGyro : &_fifoLastAccel;
+	uint32_t step = gyro ? _fifoGyroStep : _fifoAccelStep;
+	uint32_t age = 0;
+	uint16_t packed;
+
+	switch( word[0] >> 3 )
+	{
+		case ISM330DHCX_XL_2XC_TAG:
+		case ISM330DHCX_GYRO_2XC_TAG:
+			for( uint8_t i = 0; i < 2; i++ )
+			{
+				last->xData = (int16_t)(last->xData + (int8_t)word[1 + 3 * i]);
+				last->yData = (int16_t)(last->yData + (int8_t)word[2 + 3 * i]);
+				last->zData = (int16_t)(last->zData + (int8_t)word[3 + 3 * i]);
+				storeFifoSample(gyro, _fifoSlot - (2 - i) * step, fifoData);
+			}
+			return;
+
+		case ISM330DHCX_XL_3XC_TAG:
+		case ISM330DHCX_GYRO_3XC_TAG:
+			for( uint8_t i = 0; i < 3; i++ )
+			{
+				packed = (uint16_t)((word[2 + 2 * i] << 8) | word[1 + 2 * i]);
+
+				// Sign extend the 5 bit fields
+				last->xData = (int16_t)(last->xData + (int16_t)(((packed & 0x1F) ^ 0x10) - 0x10));
+				last->yData = (int16_t)(last->yData + (int16_t)((((packed >> 5) & 0x1F) ^ 0x10) - 0x10));
+				last->zData = (int16_t)(last->zData + (int16_t)((((packed >> 10) & 0x1F) ^ 0x10) - 0x10));
+				storeFifoSample(gyro, _fifoSlot - (2 - i) * step, fifoData);
+			}
+			return;
+
+		case ISM330DHCX_XL_NC_T_2_TAG:
+		case ISM330DHCX_GYRO_NC_T_2_TAG:
+			age = 2;
+			break;
 
+		case ISM330DHCX_XL_NC_T_1_TAG:
+		case ISM330DHCX_GYRO_NC_T_1_TAG:
+			age = 1;
+			break;
+
+		default:
+			break;
+	}
 
+	last->xData = (int16_t)((word[2] << 8) | word[1]);
+	last->yData = (int16_t)((word[4] << 8) | word[3]);
+	last->zData = (int16_t)((word[6] << 8) | word[5]);
+	storeFifoSample(gyro, _fifoSlot - age * step, fifoData);
+}
 
 //////////////////////////////////////////////////////////////////////////////////
-// General Settings
-//
+// storeFifoSample()
 // 
-//
-//
-
-
-//////////////////////////////////////////////////////////////////////////////////
-// setDeviceConfig()
-//
+// Appends the last decoded accelerometer or gyroscope sample to its buffer
 // 
 //  Parameter   Description
 //  ---------   -----------------------------
-//  enable      Enable the general device configuration - this is a configuration 
-//							register in the ISM330DHCX, not a library implementation. 
+//  gyro        True for the gyroscope
+//  slot        FIFO time slot of the sample
+//  fifoData    Buffers to store the FIFO data into.
+//
 
-bool QwDevISM330DHCX::setDeviceConfig(bool enable)
+void QwDevISM330DHCX::storeFifoSample(bool gyro, uint32_t slot, sfe_ism_fifo_data_t* fifoData)
 {
-	int32_t retVal;
+	uint32_t elapsed;
 
-	retVal = ism330dhcx_device_conf_set(&sfe_dev, (uint8_t)enable);
+	// A sample is due every "step" slots, a longer distance means samples 
+	// were lost.
+	if( gyro )
+	{
+		elapsed = slot - _fifoLastGyroSlot;
+		if( _fifoGyroSeen && elapsed > _fifoGyroStep )
+			fifoData->gyroMissing += (uint16_t)(elapsed / _fifoGyroStep - 1);
 
-	if( retVal != 0 )
-		return false;
+		_fifoLastGyroSlot = slot;
+		_fifoGyroSeen = true;
 
-	return true;
-}
+		if( carryBlockSample(true, slot, fifoData->numGyro) )
+			return;
+
+		if( fifoData->numGyro >= fifoData->gyroSize )
+		{
+			fifoData->numDropped++;
+			return;
+		}
+
+		if( fifoData->gyroSlot )
+			fifoData->gyroSlot[fifoData->numGyro] = slot;
+
+		// Holds the slot until timeFifoSamples() converts it
+		if( fifoData->gyroTime )
+			fifoData->gyroTime[fifoData->numGyro] = slot;
+
+		fifoData->gyroData[fifoData->numGyro++] = _fifoLastGyro;
+		return;
+	}
+
+	elapsed = slot - _fifoLastAccelSlot;
+	if( _fifoAccelSeen && elapsed > _fifoAccelStep )
+		fifoData->accelMissing += (uint16_t)(elapsed / _fifoAccelStep - 1);
+
+	_fifoLastAccelSlot = slot;
+	_fifoAccelSeen = true;
+
+	if( carryBlockSample(false, slot, fifoData->numAccel) )
+		return;
+
+	if( fifoData->numAccel >= fifoData->accelSize )
+	{
+		fifoData->numDropped++;
+		return;
+	}
+
+	if( fifoData->accelSlot )
+		fifoData->accelSlot[fifoData->numAccel] = slot;
 
+	if( fifoData->accelTime )
+		fifoData->accelTime[fifoData->numAccel] = slot;
+
+	fifoData->accelData[fifoData->numAccel++] = _fifoLastAccel;
+}
 
 //////////////////////////////////////////////////////////////////////////////////
-// deviceReset()
+// carryBlockSample()
 // 
-// Resets the deivice to default settings
+// Keeps the last decoded sample of the counted sensor when readFifoBlock() 
+// already holds the whole block, a compressed word can hold samples of the 
+// next block.
 // 
+//  Parameter   Description
+//  ---------   -----------------------------
+//  gyro        True for the gyroscope
+//  slot        FIFO time slot of the sample
+//  num         Samples of the sensor in the caller's buffer
+//
+// Returns true if the sample was kept for the next block
+//
 
-bool QwDevISM330DHCX::deviceReset()
+bool QwDevISM330DHCX::carryBlockSample(bool gyro, uint32_t slot, uint16_t num)
 {
-	int32_t retVal;
-
-	retVal = ism330dhcx_reset_set(&sfe_dev, 1);
+	if( !_blockReading || gyro != (_blockSensor == ISM_GY_BATCH_EVENT) || num < _blockSamples )
+		return false;
 
-	if( retVal != 0 )
+	if( _blockCarried >= sizeof(_blockCarrySlot) / sizeof(_blockCarrySlot[0]) )
 		return false;
 
+	_blockCarry[_blockCarried] = gyro ? _fifoLastGyro : _fifoLastAccel;
+	_blockCarrySlot[_blockCarried++] = slot;
+
 	return true;
 }
 
 //////////////////////////////////////////////////////////////////////////////////
-// getDeviceReset()
+// restoreBlockCarry()
 // 
-// Checks to see that the reset bit has been set
+// Starts a new block with the samples carried over from the previous one. The
+// times hold the slots until timeFifoSamples() converts them.
 // 
+//  Parameter   Description
+//  ---------   -----------------------------
+//  fifoData    Buffers of the new block, just reset by beginFifoRead()
+//
 
-bool QwDevISM330DHCX::getDeviceReset()
+void QwDevISM330DHCX::restoreBlockCarry(sfe_ism_fifo_data_t* fifoData)
 {
+	bool gyro = _blockSensor == ISM_GY_BATCH_EVENT;
+	sfe_ism_raw_data_t* data = gyro ? fifoData->gyroData : fifoData->accelData;
+	uint32_t* slots = gyro ? fifoData->gyroSlot : fifoData->accelSlot;
+	uint64_t* times = gyro ? fifoData->gyroTime : fifoData->accelTime;
+	uint16_t* num = gyro ? &fifoData->numGyro : &fifoData->numAccel;
+	uint8_t i;
+
+	// A block shorter than the carry takes what fits, the rest waits
+	for( i = 0; i < _blockCarried && *num < _blockSamples; i++ )
+	{
+		if( slots )
+			slots[*num] = _blockCarrySlot[i];
 
-	int32_t retVal;
-	uint8_t tempVal;
-	retVal = ism330dhcx_reset_get(&sfe_dev, &tempVal);
+		if( times )
+			times[*num] = _blockCarrySlot[i];
 
-	if( retVal != 0 )
-		return false;
+		data[(*num)++] = _blockCarry[i];
+	}
 
-	if( (tempVal & 0x01) == 0x00 ){
-		return true; 
+	for( uint8_t j = i; j < _blockCarried; j++ )
+	{
+		_blockCarry[j - i] = _blockCarry[j];
+		_blockCarrySlot[j - i] = _blockCarrySlot[j];
 	}
 
-	return false; 
-	
+	_blockCarried -= i;
 }
 
+//
+//
+//////////////////////////////////////////////////////////////////////////////////
 
 //////////////////////////////////////////////////////////////////////////////////
-// setAccelSlopeFilter()
+// Interrupt Settings
+//
 // 
-// Sets the accelerometer's slope filter
+//
+//
+//  
 // 
+
+//////////////////////////////////////////////////////////////////////////////////
+// setPinMode
+//
+// Sets the active state of the interrupt pin - high or low.  
+//
 //  Parameter   Description
 //  ---------   -----------------------------
-//  val         This parameter determines the intensity of the filter - (0x00 - 0x37) 
+//  openDrain   Set true for active low and false for active high
 //
-// See sfe_ism330dhcx_defs.h for a list of valid arguments
 
-bool QwDevISM330DHCX::setAccelSlopeFilter(uint8_t val)
+bool QwDevISM330DHCX::setPinMode(bool activeLow )
 {
 	int32_t retVal;
-	if( val > 0x37 )
-		return false;
 
-	retVal = ism330dhcx_xl_hp_path_on_out_set(&sfe_dev,
-                                         (ism330dhcx_hp_slope_xl_en_t)val);
+	//0 = active high :  active low, 1  
+	retVal = ism330dhcx_pin_polarity_set(&sfe_dev, (ism330dhcx_h_lactive_t)activeLow);
+
+	if( retVal != 0 )
+		return false;
+	
+	if( activeLow )
+		// pinmode must be set to push-pull when active low is set.
+		// See section 9.14 on pg 51 of datasheet for more information
+		retVal = ism330dhcx_pin_mode_set(&sfe_dev, (ism330dhcx_pp_od_t)0);
 
 	if( retVal != 0 )
 		return false;
 
-	return true;
+	return true; 
 }
 
 
-
 //////////////////////////////////////////////////////////////////////////////////
-// setAccelFilterLP2()
-// 
-// Enables the accelerometer's high resolution slope filter
-// 
+// setIntNotification
+//
+// Sets what the triggers an interrupt
+//
 //  Parameter   Description
 //  ---------   -----------------------------
-//  enable      Enables/Disables the high resolution slope filter
+//  val         Sets which event triggers an interrupt.   
 //
+// See sfe_ism330dhcx_defs.h for a list of valid arguments
 
-bool QwDevISM330DHCX::setAccelFilterLP2(bool enable)
+bool QwDevISM330DHCX::setIntNotification(uint8_t val)
 {
 	int32_t retVal;
+	if( val > 4)
+		return false;
 
-	retVal = ism330dhcx_xl_filter_lp2_set(&sfe_dev, (uint8_t)enable);
+	retVal = ism330dhcx_int_notification_set(&sfe_dev,
+                                        (ism330dhcx_lir_t)val);
 
 	if( retVal != 0 )
 		return false;
@@ -597,69 +3106,83 @@ bool QwDevISM330DHCX::setAccelFilterLP2(bool enable)
 
 
 //////////////////////////////////////////////////////////////////////////////////
-// setGyroFilterLP1()
-// 
-// Enables the gyroscope's slope filter
-// 
-//  Parameter   Description
-//  ---------   -----------------------------
-//  enable      Enables/Disables the high resolution slope filter
+// setAccelStatustoInt1
+//
+// Sends the accelerometer's data ready signal to interrupt one.
 //
 
-bool QwDevISM330DHCX::setGyroFilterLP1(bool enable)
+bool QwDevISM330DHCX::setAccelStatustoInt1(bool enable)
 {
+
 	int32_t retVal;
 
-	retVal = ism330dhcx_gy_filter_lp1_set(&sfe_dev, (uint8_t)enable);
+	ism330dhcx_pin_int1_route_t int1_route;
+
+	retVal = ism330dhcx_pin_int1_route_get(&sfe_dev, &int1_route);
 
 	if( retVal != 0 )
 		return false;
 
-	return true;
+	int1_route.int1_ctrl.int1_drdy_xl = (uint8_t)enable;
+	
+	retVal = ism330dhcx_pin_int1_route_set(&sfe_dev, &int1_route);
+
+	if( retVal != 0 )
+		return false;
+
+	return true; 
 }
 
+
 //////////////////////////////////////////////////////////////////////////////////
-// setGyroLP1Bandwidth()
-// 
-// Sets the low pass filter's bandwidth for the gyroscope
-// 
-//  Parameter   Description
-//  ---------   -----------------------------
-//  val					Sets the bandwidth's value
+// setAccelStatustoInt2
 //
-// See sfe_ism330dhcx_defs.h for a list of valid arguments
+// Sends the accelerometer's data ready signal to interrupt two.
 //
 
-bool QwDevISM330DHCX::setGyroLP1Bandwidth(uint8_t val)
+bool QwDevISM330DHCX::setAccelStatustoInt2(bool enable)
 {
+
 	int32_t retVal;
-	if( val > 7 )
+
+	ism330dhcx_pin_int2_route_t int2_route; 
+
+	retVal = ism330dhcx_pin_int2_route_get(&sfe_dev, &int2_route);
+
+	if( retVal != 0 )
 		return false;
 
-	retVal = ism330dhcx_gy_lp1_bandwidth_set(&sfe_dev, 
-																				  (ism330dhcx_ftype_t)val);
+	int2_route.int2_ctrl.int2_drdy_xl = (uint8_t)enable;
+	
+	retVal = ism330dhcx_pin_int2_route_set(&sfe_dev, &int2_route);
 
 	if( retVal != 0 )
 		return false;
 
-	return true;
+	return true; 
 }
 
 
 //////////////////////////////////////////////////////////////////////////////////
-// setBlockDataUpdate()
-// 
-// Data is not updated until both MSB and LSB have been read from output registers
-// 
-//  Parameter   Description
-//  ---------   -----------------------------
-//  enable			Enable/disables block data update.
+// setGyroStatustoInt1
 //
-
-bool QwDevISM330DHCX::setBlockDataUpdate(bool enable)
+// Sends the gyroscopes's data ready signal to interrupt one.
+//
+bool QwDevISM330DHCX::setGyroStatustoInt1(bool enable)
 {
 
-	int32_t retVal = ism330dhcx_block_data_update_set(&sfe_dev, (uint8_t)enable);
+	int32_t retVal;
+
+	ism330dhcx_pin_int1_route_t int1_route; 
+
+	retVal = ism330dhcx_pin_int1_route_get(&sfe_dev, &int1_route);
+
+	if( retVal != 0 )
+		return false;
+
+	int1_route.int1_ctrl.int1_drdy_g = (uint8_t)enable;
+	
+	retVal = ism330dhcx_pin_int1_route_set(&sfe_dev, &int1_route);
 
 	if( retVal != 0 )
 		return false;
@@ -669,110 +3192,270 @@ bool QwDevISM330DHCX::setBlockDataUpdate(bool enable)
 
 
 //////////////////////////////////////////////////////////////////////////////////
-// getBlockDataUpdate()
-// 
-// Retrieves the bit indicating whether block data update is enabled. 
-// 
+// setGyroStatustoInt2
 //
-
-uint8_t QwDevISM330DHCX::getBlockDataUpdate()
+// Sends the gyroscopes's data ready signal to interrupt two.
+//
+bool QwDevISM330DHCX::setGyroStatustoInt2(bool enable)
 {
 
-	uint8_t tempVal;
-	int32_t retVal = ism330dhcx_block_data_update_get(&sfe_dev, &tempVal);
+	int32_t retVal;
 
-	(void)retVal;
-	return tempVal; 
-}
+	ism330dhcx_pin_int2_route_t int2_route; 
+
+	retVal = ism330dhcx_pin_int2_route_get(&sfe_dev, &int2_route);
+
+	if( retVal != 0 )
+		return false;
+
+	int2_route.int2_ctrl.int2_drdy_g = (uint8_t)enable;
+	
+	retVal = ism330dhcx_pin_int2_route_set(&sfe_dev, &int2_route);
+
+	if( retVal != 0 )
+		return false;
 
+	return true; 
+}
 
 //////////////////////////////////////////////////////////////////////////////////
-// setAccelDataRate()
-// 
-// This sets the data output rate for the accelerometer.
-// 
+// setFifoInterrupt
+//
+// Selects the FIFO interrupts sent to an interrupt pin, replacing the FIFO 
+// interrupts previously routed to it. The other interrupts of the pin are kept.
+//
 //  Parameter   Description
 //  ---------   -----------------------------
-//  rate        Sets the output data rate, expects some value < 11. 
+//  pin         Interrupt pin, 1 or 2
+//  events      ISM_FIFO_INT_THRESHOLD, _OVERRUN, _FULL and _BATCH_COUNTER or'ed 
+//              together, 0 for none
 //
 // See sfe_ism330dhcx_defs.h for a list of valid arguments
 
-bool QwDevISM330DHCX::setAccelDataRate(uint8_t rate)
+bool QwDevISM330DHCX::setFifoInterrupt(uint8_t pin, uint8_t events)
 {
-	if( rate > 11 )
-		return false; 
+	int32_t retVal;
+	uint8_t mask = ISM_FIFO_INT_THRESHOLD | ISM_FIFO_INT_OVERRUN | ISM_FIFO_INT_FULL |
+	               ISM_FIFO_INT_BATCH_COUNTER;
+	uint8_t reg;
+	uint8_t ctrl;
 
-	int32_t retVal = ism330dhcx_xl_data_rate_set(&sfe_dev, (ism330dhcx_odr_xl_t)rate);
+	if( (pin != 1 && pin != 2) || (events & ~mask) )
+		return false;
 
-	if( retVal != 0)
+	// The FIFO bits are in the same place in INT1_CTRL and INT2_CTRL
+	reg = pin == 1 ? ISM330DHCX_INT1_CTRL : ISM330DHCX_INT2_CTRL;
+
+	retVal = readRegisterRegion(reg, &ctrl, 1);
+
+	if( retVal != 0 )
+		return false;
+
+	ctrl = (ctrl & ~mask) | events;
+
+	retVal = writeRegisterRegion(reg, &ctrl, 1);
+
+	if( retVal != 0 )
 		return false;
 
-	return true; 
+	return true;
 }
 
-
 //////////////////////////////////////////////////////////////////////////////////
-// setGyroDataRate()
-// 
-// This sets the data output rate for the gyroscope.
-// 
+// setInterruptRouting
+//
+// Routes the given events to the interrupt pins, replacing every event 
+// previously routed to them. INT1_CTRL and INT2_CTRL are written together, as
+// are MD1_CFG and MD2_CFG with TAP_CFG2 when the basic interrupts have to be
+// switched on or off. Registers that already hold the routing are not written
+// and with the register shadow enabled nothing is read. Embedded function, 
+// FSM and MLC events take one more write between two bank switches.
+//
+// ISM_EVENT_FSM routes all 16 FSM programs. Temperature data ready and the
+// timestamp end count can only be routed to INT2, the sensor hub end of 
+// operation only to INT1.
+//
 //  Parameter   Description
 //  ---------   -----------------------------
-//  rate        Sets the output data rate, expects some value < 10. 
+//  int1Events  ISM_EVENT_ bits for INT1
+//  int2Events  ISM_EVENT_ bits for INT2
 //
 // See sfe_ism330dhcx_defs.h for a list of valid arguments
-//
 
-bool QwDevISM330DHCX::setGyroDataRate(uint8_t rate)
+bool QwDevISM330DHCX::setInterruptRouting(uint32_t int1Events, uint32_t int2Events)
 {
-	if( rate > 10 )
+	int32_t retVal;
+	uint8_t ctrl[2];    // INT1_CTRL, INT2_CTRL
+	uint8_t md[2];      // MD1_CFG, MD2_CFG
+	uint8_t emb[8];     // EMB_FUNC_INT1 - MLC_INT2
+	uint8_t cfg[8];     // TAP_CFG2 - MD2_CFG
+	uint8_t current[8];
+	uint8_t offset;
+
+	if( !routeEvents(int1Events, 1, &ctrl[0], &md[0], &emb[0]) ||
+	    !routeEvents(int2Events, 2, &ctrl[1], &md[1], &emb[4]) )
 		return false;
 
-	int32_t retVal = ism330dhcx_gy_data_rate_set(&sfe_dev,(ism330dhcx_odr_g_t)rate);
+	// Embedded events first, MD1_CFG/MD2_CFG pass them on to the pins. The 
+	// bank is left alone when none are routed as the MD bits gate them.
+	if( md[0] & 0x02 || md[1] & 0x02 )
+	{
+		if( !beginBankSession(ISM330DHCX_EMBEDDED_FUNC_BANK) )
+			return false;
+
+		retVal = readRegisterRegion(ISM330DHCX_EMB_FUNC_INT1, current, 8);
+
+		if( retVal == 0 && memcmp(current, emb, 8) != 0 )
+			retVal = writeRegisterRegion(ISM330DHCX_EMB_FUNC_INT1, emb, 8);
+
+		if( !endBankSession() || retVal != 0 )
+			return false;
+	}
+
+	// INT1_CTRL keeps BOOT and DEN_DRDY_FLAG
+	retVal = readRegisterRegion(ISM330DHCX_INT1_CTRL, current, 2);
 
 	if( retVal != 0 )
 		return false;
 
-	return true; 
-}
+	ctrl[0] |= current[0] & 0x84;
+	ctrl[1] |= current[1] & 0x80;
+
+	if( memcmp(current, ctrl, 2) != 0 )
+	{
+		retVal = writeRegisterRegion(ISM330DHCX_INT1_CTRL, ctrl, 2);
+
+		if( retVal != 0 )
+			return false;
+	}
+
+	// TAP_CFG2 - MD2_CFG
+	retVal = readRegisterRegion(ISM330DHCX_TAP_CFG2, current, 8);
 
+	if( retVal != 0 )
+		return false;
+
+	memcpy(cfg, current, 8);
+	cfg[6] = md[0];
+	cfg[7] = md[1];
+
+	// INTERRUPTS_ENABLE, the free-fall, wake-up, tap, 6D and sleep change
+	// interrupts only reach the pins with it set.
+	if( (md[0] | md[1]) & 0xFC )
+		cfg[0] |= 0x80;
+	else
+		cfg[0] &= ~0x80;
+
+	offset = cfg[0] != current[0] ? 0 : 6;
+
+	if( memcmp(&current[offset], &cfg[offset], 8 - offset) != 0 )
+	{
+		retVal = writeRegisterRegion(ISM330DHCX_TAP_CFG2 + offset, &cfg[offset], 8 - offset);
+
+		if( retVal != 0 )
+			return false;
+	}
 
+	return true;
+}
 
 //////////////////////////////////////////////////////////////////////////////////
-// enableTimestamp()
-// 
-// Enables time stamp counter
-// 
+// routeEvents
+//
+// Works out INTx_CTRL, MDx_CFG and EMB_FUNC_INTx - MLC_INTx for the events of
+// one pin. Fails on events the pin can't signal.
+//
 //  Parameter   Description
 //  ---------   -----------------------------
-//  enable      Enables/disables time stamp counter
+//  events      ISM_EVENT_ bits
+//  pin         Interrupt pin, 1 or 2
+//  ctrl        INTx_CTRL
+//  md          MDx_CFG
+//  emb         EMB_FUNC_INTx, FSM_INTx_A, FSM_INTx_B and MLC_INTx
 //
 
-bool QwDevISM330DHCX::enableTimestamp(bool enable)
+bool QwDevISM330DHCX::routeEvents(uint32_t events, uint8_t pin, uint8_t* ctrl, uint8_t* md, uint8_t* emb)
 {
-	int32_t retVal;
+	*ctrl = 0;
+	*md = 0;
+
+	if( events & ISM_EVENT_ACCEL_READY )
+		*ctrl |= 0x01;
+	if( events & ISM_EVENT_GYRO_READY )
+		*ctrl |= 0x02;
+
+	if( events & ISM_EVENT_FIFO_THRESHOLD )
+		*ctrl |= 0x08;
+	if( events & ISM_EVENT_FIFO_OVERRUN )
+		*ctrl |= 0x10;
+	if( events & ISM_EVENT_FIFO_FULL )
+		*ctrl |= 0x20;
+	if( events & ISM_EVENT_BATCH_COUNTER )
+		*ctrl |= 0x40;
+
+	if( events & ISM_EVENT_6D )
+		*md |= 0x04;
+	if( events & ISM_EVENT_DOUBLE_TAP )
+		*md |= 0x08;
+	if( events & ISM_EVENT_FREE_FALL )
+		*md |= 0x10;
+	if( events & ISM_EVENT_WAKE_UP )
+		*md |= 0x20;
+	if( events & ISM_EVENT_SINGLE_TAP )
+		*md |= 0x40;
+	if( events & ISM_EVENT_SLEEP_CHANGE )
+		*md |= 0x80;
+
+	// Step detector, tilt, significant motion and FSM long counter
+	emb[0] = (uint8_t)(((events >> 9) & 0x38) | ((events >> 8) & 0x80));
+	emb[1] = events & ISM_EVENT_FSM ? 0xFF : 0x00;
+	emb[2] = emb[1];
+	emb[3] = (uint8_t)(events >> 24);
+
+	// INTx_EMB_FUNC
+	if( emb[0] | emb[1] | emb[3] )
+		*md |= 0x02;
+
+	if( pin == 1 )
+	{
+		if( events & (ISM_EVENT_TEMP_READY | ISM_EVENT_TIMESTAMP_END) )
+			return false;
 
-	retVal = ism330dhcx_timestamp_set(&sfe_dev, (uint8_t)enable);
+		// INT1_SHUB
+		if( events & ISM_EVENT_SENSOR_HUB_END )
+			*md |= 0x01;
+	}
+	else
+	{
+		if( events & ISM_EVENT_SENSOR_HUB_END )
+			return false;
 
-	if( retVal != 0 )
-		return false;
+		// INT2_DRDY_TEMP and INT2_TIMESTAMP
+		if( events & ISM_EVENT_TEMP_READY )
+			*ctrl |= 0x04;
+		if( events & ISM_EVENT_TIMESTAMP_END )
+			*md |= 0x01;
+	}
 
 	return true;
 }
 
-
 //////////////////////////////////////////////////////////////////////////////////
-// resetTimestamp()
-// 
-// Resets time stamp counter
-// 
+// setDataReadyMode
 //
-
-bool QwDevISM330DHCX::resetTimestamp()
+// Sets how the data ready signal is latched i.e. only return zero after interface reading
+// OR is pulsed. 
+//
+bool QwDevISM330DHCX::setDataReadyMode(uint8_t val)
 {
-	int32_t retVal; 
+	int32_t retVal;
 
-	retVal = ism330dhcx_timestamp_rst(&sfe_dev);
+	//0 = Latched, 1 = Pulsed
+	if( val > 1 )
+		return false;
+
+	retVal = ism330dhcx_data_ready_mode_set(&sfe_dev,
+                                       (ism330dhcx_dataready_pulsed_t)val);
 
 	if( retVal != 0 )
 		return false;
@@ -784,143 +3467,161 @@ bool QwDevISM330DHCX::resetTimestamp()
 //////////////////////////////////////////////////////////////////////////////////
 
 //////////////////////////////////////////////////////////////////////////////////
-// FIFO Settings
+// Sensor Hub Settings
 //
 // 
 //
 //
 //  
 // 
+// 
+
 
 //////////////////////////////////////////////////////////////////////////////////
-// setFifoWatermark()
-// 
-// Sets the FIFO's watermark 
+// setHubODR
+//
+// Sets the output data rate for the Sensor Hub.
 // 
 //  Parameter   Description
 //  ---------   -----------------------------
-//  val					Sets the watermark, must be some value less than 511 (9 bit value)
+//  rate				Selects the rate
 //
+// See sfe_ism330dhcx_defs.h for a list of valid arguments
 
-bool QwDevISM330DHCX::setFifoWatermark(uint16_t val)
+bool QwDevISM330DHCX::setHubODR(uint8_t rate)
 {
-	int32_t retVal;
-
-	if( val > 511 ) 
-		return false; 
+	//0 = 104Hz, 1 = 52Hz, 2 = 26Hz, 3 = 13Hz
+	if( rate > 3 )
+		return false;
 
-	retVal = ism330dhcx_fifo_watermark_set(&sfe_dev, val);
+	int32_t retVal = ism330dhcx_sh_data_rate_set(&sfe_dev, (ism330dhcx_shub_odr_t)rate);
 
 	if( retVal != 0 )
 		return false;
 
-	return true;
+	return true; 
 }
 
 
 //////////////////////////////////////////////////////////////////////////////////
-// setFifoMode()
-// 
-// Sets the FIFO's mode. 
+// setHubSensorRead
+//
+// Sets the general sensor hub settings, which sensor and their I2C address and register 
+// to read.
 // 
 //  Parameter   Description
 //  ---------   -----------------------------
-//  val					Selects the FIFO's mode
+//  sensor      Selects the external sensor (1-4)
+//  settings		The I2C address, register address, and number of reads for the external sensor
+//							that is connected in sensor hub mode.
 //
-// See sfe_ism330dhcx_defs.h for a list of valid arguments
 //
-
-bool QwDevISM330DHCX::setFifoMode(uint8_t val)
+bool QwDevISM330DHCX::setHubSensorRead(uint8_t sensor, sfe_hub_sensor_settings_t* settings)
 {
 	int32_t retVal;
+	ism330dhcx_sh_cfg_read_t tempSett;
 
-	if( val > 7 )
+	if( sensor > 3 )
 		return false;
 
-	retVal = ism330dhcx_fifo_mode_set(&sfe_dev,
-                                 (ism330dhcx_fifo_mode_t)val);
+	tempSett.slv_add = settings->address; 
+	tempSett.slv_subadd = settings->subAddress; 
+	tempSett.slv_len = settings->lenData; 
+
+
+	switch( sensor )
+	{
+		case 0:
+			retVal = ism330dhcx_sh_slv0_cfg_read(&sfe_dev, &tempSett);
+			break;
+		case 1:
+			retVal = ism330dhcx_sh_slv1_cfg_read(&sfe_dev, &tempSett);
+			break;
+		case 2:
+			retVal = ism330dhcx_sh_slv2_cfg_read(&sfe_dev, &tempSett);
+			break;
+		case 3:
+			retVal = ism330dhcx_sh_slv3_cfg_read(&sfe_dev, &tempSett);
+			break;
+		default:
+			return false;
+	}
+
 
 	if( retVal != 0 )
 		return false;
 
-	return true;
+	return true; 
 }
 
 
 //////////////////////////////////////////////////////////////////////////////////
-// setAccelFifoBatchSet()
-// 
-// Sets the batch data rate for the accelerometer
+// setHubSensorWrite
+//
+// Gives settings to the 6DoF with regards to the address, register, and data to write to an external
+// sensor. 
 // 
 //  Parameter   Description
 //  ---------   -----------------------------
-//  val					Sets the batch data rate. 
-//
-// See sfe_ism330dhcx_defs.h for a list of valid arguments
+//  settings    Struct containing the address, register, and data to write to the external sensor
 //
 
-bool QwDevISM330DHCX::setAccelFifoBatchSet(uint8_t val)
+bool QwDevISM330DHCX::setHubSensorWrite(sfe_hub_sensor_settings_t* settings)
 {
 	int32_t retVal;
-	if( val > 11)
-		return false;
+	ism330dhcx_sh_cfg_write_t tempSett;
 
-	retVal = ism330dhcx_fifo_xl_batch_set(&sfe_dev,
-                                     (ism330dhcx_bdr_xl_t)val);
+	tempSett.slv0_add = settings->address; 
+	tempSett.slv0_subadd = settings->subAddress; 
+	tempSett.slv0_data = settings->lenData; 
+
+	retVal = ism330dhcx_sh_cfg_write(&sfe_dev, &tempSett);
 
 	if( retVal != 0 )
 		return false;
 
-	return true;
+	return true; 
 }
 
-
-
 //////////////////////////////////////////////////////////////////////////////////
-// setGyroFifoBatchSet()
-// 
-// Sets the batch data rate for the gyroscope
+// setNumberHubSensors
+//
+// Sets the number of external sensor connected to the ISM
 // 
 //  Parameter   Description
 //  ---------   -----------------------------
-//  val					Sets the batch data rate. 
+//  numSensor   The number of sensors 0 - 3 = 4
 //
-// See sfe_ism330dhcx_defs.h for a list of valid arguments
 
-bool QwDevISM330DHCX::setGyroFifoBatchSet(uint8_t val)
+bool QwDevISM330DHCX::setNumberHubSensors(uint8_t numSensors)
 {
+
 	int32_t retVal;
-	if( val > 11)
-		return false;
+	if( numSensors > 3 ) 
+		return false; 
 
-	retVal = ism330dhcx_fifo_gy_batch_set(&sfe_dev,
-                                     (ism330dhcx_bdr_gy_t)val);
+	retVal = ism330dhcx_sh_slave_connected_set(&sfe_dev, 
+																					 (ism330dhcx_aux_sens_on_t)numSensors);
 
 	if( retVal != 0 )
 		return false;
 
-	return true;
+	return true; 
+
 }
 
+
 //////////////////////////////////////////////////////////////////////////////////
-// setFifoTimestampDec()
-// 
-// Sets the FIFO time stamp decimation rate.
-// 
-//  Parameter   Description
-//  ---------   -----------------------------
-//  val					Sets the time stamp decimation rate, 
+// enableSensorI2C
 //
-// See sfe_ism330dhcx_defs.h for a list of valid arguments
+// Enables the 6DoF as an I2C sensor controller
+// 
 
-bool QwDevISM330DHCX::setFifoTimestampDec(uint8_t val)
+bool QwDevISM330DHCX::enableSensorI2C(bool enable)
 {
 	int32_t retVal;
-	if( val > 3 )
-		return false;
 
-	retVal = ism330dhcx_fifo_timestamp_decimation_set(&sfe_dev,
-                                                   (ism330dhcx_odr_ts_batch_t)val);
+	retVal = ism330dhcx_sh_master_set(&sfe_dev, (uint8_t)enable);
 
 	if( retVal != 0 )
 		return false;
@@ -928,184 +3629,191 @@ bool QwDevISM330DHCX::setFifoTimestampDec(uint8_t val)
 	return true;
 }
 
-//
-//
-//////////////////////////////////////////////////////////////////////////////////
 
 //////////////////////////////////////////////////////////////////////////////////
-// Interrupt Settings
-//
-// 
-//
+// readPeripheralSensor
 //
-//  
+// Read external sensor hub data.  
 // 
-
-//////////////////////////////////////////////////////////////////////////////////
-// setPinMode
-//
-// Sets the active state of the interrupt pin - high or low.  
-//
 //  Parameter   Description
 //  ---------   -----------------------------
-//  openDrain   Set true for active low and false for active high
-//
+//  shReg       Pointer to store the data to be read. 
+//  len					Number of reads to be executed.
 
-bool QwDevISM330DHCX::setPinMode(bool activeLow )
+bool QwDevISM330DHCX::readPeripheralSensor(uint8_t* shReg, uint8_t len)
 {
 	int32_t retVal;
 
-	//0 = active high :  active low, 1  
-	retVal = ism330dhcx_pin_polarity_set(&sfe_dev, (ism330dhcx_h_lactive_t)activeLow);
-
-	if( retVal != 0 )
-		return false;
-	
-	if( activeLow )
-		// pinmode must be set to push-pull when active low is set.
-		// See section 9.14 on pg 51 of datasheet for more information
-		retVal = ism330dhcx_pin_mode_set(&sfe_dev, (ism330dhcx_pp_od_t)0);
-
+	retVal = ism330dhcx_sh_read_data_raw_get(&sfe_dev, (ism330dhcx_emb_sh_read_t*)shReg, len);
+
 	if( retVal != 0 )
 		return false;
 
-	return true; 
+	return true;
 }
 
 
 //////////////////////////////////////////////////////////////////////////////////
-// setIntNotification
-//
-// Sets what the triggers an interrupt
-//
-//  Parameter   Description
-//  ---------   -----------------------------
-//  val         Sets which event triggers an interrupt.   
+// getHubStatus
 //
-// See sfe_ism330dhcx_defs.h for a list of valid arguments
+// Checks whether communication with the external sensor has concluded. 
+//	
 
-bool QwDevISM330DHCX::setIntNotification(uint8_t val)
+bool QwDevISM330DHCX::getHubStatus()
 {
+
 	int32_t retVal;
-	if( val > 4)
-		return false;
+	ism330dhcx_status_master_t tempVal;
 
-	retVal = ism330dhcx_int_notification_set(&sfe_dev,
-                                        (ism330dhcx_lir_t)val);
+	retVal = ism330dhcx_sh_status_get(&sfe_dev, &tempVal);
 
 	if( retVal != 0 )
 		return false;
 
-	return true;
-}
+	if( tempVal.sens_hub_endop == 1 )
+		return true;
 
+	return false; 
+}
 
 //////////////////////////////////////////////////////////////////////////////////
-// setAccelStatustoInt1
-//
-// Sends the accelerometer's data ready signal to interrupt one.
+// getExternalSensorNack
 //
+// Retrieves communication status when communicating with external sensor
+//	
+//  Parameter   Description
+//  ---------   -----------------------------
+//  sensor			The sensor to check, (0-3)
 
-bool QwDevISM330DHCX::setAccelStatustoInt1(bool enable)
+
+bool QwDevISM330DHCX::getExternalSensorNack(uint8_t sensor)
 {
 
 	int32_t retVal;
+	ism330dhcx_status_master_t tempVal;
 
-	ism330dhcx_pin_int1_route_t int1_route;
-
-	retVal = ism330dhcx_pin_int1_route_get(&sfe_dev, &int1_route);
+	retVal = ism330dhcx_sh_status_get(&sfe_dev, &tempVal);
 
 	if( retVal != 0 )
 		return false;
 
-	int1_route.int1_ctrl.int1_drdy_xl = (uint8_t)enable;
-	
-	retVal = ism330dhcx_pin_int1_route_set(&sfe_dev, &int1_route);
+	switch( sensor ){
+		case 0:
+			if( tempVal.slave0_nack == 1 )
+				return true;
+			break;
+		case 1:
+			if( tempVal.slave1_nack == 1 )
+				return true;
+			break;
+		case 2:
+			if( tempVal.slave2_nack == 1 )
+				return true;
+			break;
+		case 3:
+			if( tempVal.slave3_nack == 1 )
+				return true;
+			break;
+		default:
+			return false;
+	}
 
-	if( retVal != 0 )
-		return false;
+	return false; 
+}
 
-	return true; 
+bool QwDevISM330DHCX::readMMCMagnetometer(uint8_t* magData, uint8_t len)
+{
+	return(readPeripheralSensor(magData, len));
 }
 
 
 //////////////////////////////////////////////////////////////////////////////////
-// setAccelStatustoInt2
-//
-// Sends the accelerometer's data ready signal to interrupt two.
+// setHubWriteMode
 //
+// Sets how often the 6DoF should write to the external sensor: once per cycle i.e. output 
+// data rate, or just once. 
+// 
+//  Parameter   Description
+//  ---------   -----------------------------
+//  config       How often to be written
 
-bool QwDevISM330DHCX::setAccelStatustoInt2(bool enable)
+bool QwDevISM330DHCX::setHubWriteMode(uint8_t config)
 {
-
 	int32_t retVal;
 
-	ism330dhcx_pin_int2_route_t int2_route; 
-
-	retVal = ism330dhcx_pin_int2_route_get(&sfe_dev, &int2_route);
-
-	if( retVal != 0 )
+	if( config > 1)
 		return false;
 
-	int2_route.int2_ctrl.int2_drdy_xl = (uint8_t)enable;
-	
-	retVal = ism330dhcx_pin_int2_route_set(&sfe_dev, &int2_route);
+	// 0 = Write each cycle 
+	// 1 = Write once
+	retVal = ism330dhcx_sh_write_mode_set(&sfe_dev,
+																			 (ism330dhcx_write_once_t)config);
 
 	if( retVal != 0 )
 		return false;
 
-	return true; 
+	return true;
 }
 
 
 //////////////////////////////////////////////////////////////////////////////////
-// setGyroStatustoInt1
+// setHubPassThrough
 //
-// Sends the gyroscopes's data ready signal to interrupt one.
+//	Allows the primary I2C data lines to communicate through the auxiliary I2C lines.
+//	
+//  Parameter   Description
+//  ---------   -----------------------------
+//  set					Enables/disables pass through
 //
-bool QwDevISM330DHCX::setGyroStatustoInt1(bool enable)
-{
 
-	int32_t retVal;
-
-	ism330dhcx_pin_int1_route_t int1_route; 
+bool QwDevISM330DHCX::setHubPassThrough(bool enable)
+{
 
-	retVal = ism330dhcx_pin_int1_route_get(&sfe_dev, &int1_route);
+	int32_t retVal = ism330dhcx_sh_pass_through_set(&sfe_dev, (uint8_t)enable);
 
 	if( retVal != 0 )
 		return false;
 
-	int1_route.int1_ctrl.int1_drdy_g = (uint8_t)enable;
-	
-	retVal = ism330dhcx_pin_int1_route_set(&sfe_dev, &int1_route);
+	return true; 
+}
+
+//////////////////////////////////////////////////////////////////////////////////
+// setHubFifoBatching
+//
+// Sets sensor hub FIFO batching
+//	
+//  Parameter   Description
+//  ---------   -----------------------------
+//  enable			Enable/disables fifo batching
+
+bool QwDevISM330DHCX::setHubFifoBatching(bool enable)
+{
+	int32_t retVal;
+
+	retVal = ism330dhcx_sh_batch_slave_0_set(&sfe_dev, (uint8_t)enable);
 
 	if( retVal != 0 )
 		return false;
 
-	return true; 
+	return true;
 }
 
 
 //////////////////////////////////////////////////////////////////////////////////
-// setGyroStatustoInt2
-//
-// Sends the gyroscopes's data ready signal to interrupt two.
+// setHubPullUps
 //
-bool QwDevISM330DHCX::setGyroStatustoInt2(bool enable)
+// Enables/Disables internal pullups on SDX/SCX lines
+//	
+//  Parameter   Description
+//  ---------   -----------------------------
+//  enable			Enable/disables internal pullups on SDX/SCX lines 
+
+bool QwDevISM330DHCX::setHubPullUps(bool enable)
 {
 
 	int32_t retVal;
 
-	ism330dhcx_pin_int2_route_t int2_route; 
-
-	retVal = ism330dhcx_pin_int2_route_get(&sfe_dev, &int2_route);
-
-	if( retVal != 0 )
-		return false;
-
-	int2_route.int2_ctrl.int2_drdy_g = (uint8_t)enable;
-	
-	retVal = ism330dhcx_pin_int2_route_set(&sfe_dev, &int2_route);
+	retVal = ism330dhcx_sh_pin_mode_set(&sfe_dev, (ism330dhcx_shub_pu_en_t)enable);
 
 	if( retVal != 0 )
 		return false;
@@ -1113,357 +3821,417 @@ bool QwDevISM330DHCX::setGyroStatustoInt2(bool enable)
 	return true; 
 }
 
+
 //////////////////////////////////////////////////////////////////////////////////
-// setDataReadyMode
-//
-// Sets how the data ready signal is latched i.e. only return zero after interface reading
-// OR is pulsed. 
+// resetSensorHub
 //
-bool QwDevISM330DHCX::setDataReadyMode(uint8_t val)
+// Resets all settings in the "Master Config" register
+//	
+
+bool QwDevISM330DHCX::resetSensorHub()
 {
-	int32_t retVal;
 
-	//0 = Latched, 1 = Pulsed
-	if( val > 1 )
-		return false;
+	int32_t retVal;  
 
-	retVal = ism330dhcx_data_ready_mode_set(&sfe_dev,
-                                       (ism330dhcx_dataready_pulsed_t)val);
+	retVal = ism330dhcx_sh_reset_set(&sfe_dev);
 
 	if( retVal != 0 )
 		return false;
 
-	return true;
+	return true; 
 }
 //
 //
 //////////////////////////////////////////////////////////////////////////////////
 
 //////////////////////////////////////////////////////////////////////////////////
-// Sensor Hub Settings
-//
+// loadUcf()
 // 
-//
-//
-//  
+// Applies a configuration exported by ST's Unico tools, e.g. a Machine Learning
+// Core program, from the register and value pairs of the header ST generates 
+// from the UCF file. 
 // 
+// Writes to consecutive registers are sent as one burst. The program bytes 
+// the configuration writes to PAGE_VALUE one by one are sent as one burst 
+// per run too, IF_INC is cleared for them so the device keeps writing 
+// PAGE_VALUE and advances the page address itself. The configuration's bank 
+// switches are held back until a register of the bank is accessed and 
+// switches to the selected bank are skipped.
 // 
-
-
-//////////////////////////////////////////////////////////////////////////////////
-// setHubODR
-//
-// Sets the output data rate for the Sensor Hub.
+// With verify each burst is read back and compared, the program bytes through
+// a page read. Bits that clear themselves aren't compared.
+// 
+// Not for use within beginConfig() and commitConfig().
 // 
 //  Parameter   Description
 //  ---------   -----------------------------
-//  rate				Selects the rate
+//  lines       Register writes in the order of the UCF file
+//  numLines    Number of writes
+//  verify      Read the configuration back
 //
-// See sfe_ism330dhcx_defs.h for a list of valid arguments
 
-bool QwDevISM330DHCX::setHubODR(uint8_t rate)
+bool QwDevISM330DHCX::loadUcf(const sfe_ism_ucf_line_t* lines, uint16_t numLines, bool verify)
 {
-	//0 = 104Hz, 1 = 52Hz, 2 = 26Hz, 3 = 13Hz
-	if( rate > 3 )
-		return false;
-
-	int32_t retVal = ism330dhcx_sh_data_rate_set(&sfe_dev, (ism330dhcx_shub_odr_t)rate);
+	sfe_ism_ucf_run_t run;
+	bool ok = true;
 
-	if( retVal != 0 )
+	if( !beginUcf(&run, verify) )
 		return false;
 
-	return true; 
-}
+	for( uint16_t i = 0; ok && i < numLines; i++ )
+		ok = addUcfLine(&run, lines[i].address, lines[i].data);
 
+	return endUcf(&run, ok);
+}
 
 //////////////////////////////////////////////////////////////////////////////////
-// setHubSensorRead
-//
-// Sets the general sensor hub settings, which sensor and their I2C address and register 
-// to read.
+// loadUcf()
+// 
+// Applies a configuration from the text of a UCF file as the table version 
+// does. The text is parsed as the writes go out, WAIT lines wait for the 
+// writes before them to reach the device first. Fails on a line that isn't a
+// write, a wait, a comment or blank.
 // 
 //  Parameter   Description
 //  ---------   -----------------------------
-//  sensor      Selects the external sensor (1-4)
-//  settings		The I2C address, register address, and number of reads for the external sensor
-//							that is connected in sensor hub mode.
-//
+//  text        UCF file, zero terminated
+//  verify      Read the configuration back
 //
-bool QwDevISM330DHCX::setHubSensorRead(uint8_t sensor, sfe_hub_sensor_settings_t* settings)
-{
-	int32_t retVal;
-	ism330dhcx_sh_cfg_read_t tempSett;
 
-	if( sensor > 3 )
+bool QwDevISM330DHCX::loadUcf(const char* text, bool verify)
+{
+	QwUcfReader reader(text);
+	sfe_ism_ucf_run_t run;
+	sfe_ism_ucf_line_t line;
+	uint16_t waitMs;
+	uint8_t kind;
+	bool ok = true;
+
+	if( !beginUcf(&run, verify) )
 		return false;
 
-	tempSett.slv_add = settings->address; 
-	tempSett.slv_subadd = settings->subAddress; 
-	tempSett.slv_len = settings->lenData; 
-
-
-	switch( sensor )
+	while( ok )
 	{
-		case 0:
-			retVal = ism330dhcx_sh_slv0_cfg_read(&sfe_dev, &tempSett);
-			break;
-		case 1:
-			retVal = ism330dhcx_sh_slv1_cfg_read(&sfe_dev, &tempSett);
-			break;
-		case 2:
-			retVal = ism330dhcx_sh_slv2_cfg_read(&sfe_dev, &tempSett);
-			break;
-		case 3:
-			retVal = ism330dhcx_sh_slv3_cfg_read(&sfe_dev, &tempSett);
+		kind = reader.next(&line, &waitMs);
+
+		if( kind == ISM_UCF_WRITE )
+			ok = addUcfLine(&run, line.address, line.data);
+		else if( kind == ISM_UCF_WAIT )
+			ok = flushUcfRun(&run) && QwUcfReader::wait(waitMs);
+		else
+		{
+			ok = kind == ISM_UCF_END;
 			break;
-		default:
-			return false;
+		}
 	}
 
-
-	if( retVal != 0 )
-		return false;
-
-	return true; 
-}
-
+	return endUcf(&run, ok);
+}
 
 //////////////////////////////////////////////////////////////////////////////////
-// setHubSensorWrite
-//
-// Gives settings to the 6DoF with regards to the address, register, and data to write to an external
-// sensor. 
+// beginUcf()
+// 
+// Starts applying a UCF configuration in a bank session.
 // 
 //  Parameter   Description
 //  ---------   -----------------------------
-//  settings    Struct containing the address, register, and data to write to the external sensor
+//  run         Writes collected for the next burst
+//  verify      Read each burst back
 //
 
-bool QwDevISM330DHCX::setHubSensorWrite(sfe_hub_sensor_settings_t* settings)
+bool QwDevISM330DHCX::beginUcf(sfe_ism_ucf_run_t* run, bool verify)
 {
-	int32_t retVal;
-	ism330dhcx_sh_cfg_write_t tempSett;
-
-	tempSett.slv0_add = settings->address; 
-	tempSett.slv0_subadd = settings->subAddress; 
-	tempSett.slv0_data = settings->lenData; 
+	if( _deferConfig )
+		return false;
 
-	retVal = ism330dhcx_sh_cfg_write(&sfe_dev, &tempSett);
+	if( !beginBankSession(ISM330DHCX_USER_BANK) )
+		return false;
 
-	if( retVal != 0 )
+	if( readRegisterRegion(ISM330DHCX_CTRL3_C, &run->ctrl3, 1) != 0 )
+	{
+		endBankSession();
 		return false;
+	}
 
-	return true; 
+	run->ctrl3 &= ~0x81; // BOOT and SW_RESET
+	run->incOff = !(run->ctrl3 & 0x04);
+	run->length = 0;
+	run->page = false;
+	run->pageStart = 0;
+	run->pageAddress = 0;
+	run->verify = verify;
+
+	return true;
 }
 
 //////////////////////////////////////////////////////////////////////////////////
-// setNumberHubSensors
-//
-// Sets the number of external sensor connected to the ISM
+// addUcfLine()
+// 
+// Adds a write to the run when the device would write the same register in a 
+// burst, otherwise the run is sent and a new one started. Bank switches and 
+// CTRL3_C, which decides how bursts are addressed, are written on their own.
 // 
 //  Parameter   Description
 //  ---------   -----------------------------
-//  numSensor   The number of sensors 0 - 3 = 4
+//  run         Writes collected for the next burst
+//  address     Register of the selected bank
+//  data        Value written
 //
 
-bool QwDevISM330DHCX::setNumberHubSensors(uint8_t numSensors)
+bool QwDevISM330DHCX::addUcfLine(sfe_ism_ucf_run_t* run, uint8_t address, uint8_t data)
 {
+	bool emb = _bank == ISM330DHCX_EMBEDDED_FUNC_BANK;
+	bool page = emb && address == ISM330DHCX_PAGE_VALUE;
+	bool single = address == ISM330DHCX_FUNC_CFG_ACCESS || 
+	              (_bank == ISM330DHCX_USER_BANK && address == ISM330DHCX_CTRL3_C);
 
-	int32_t retVal;
-	if( numSensors > 3 ) 
-		return false; 
-
-	retVal = ism330dhcx_sh_slave_connected_set(&sfe_dev, 
-																					 (ism330dhcx_aux_sens_on_t)numSensors);
-
-	if( retVal != 0 )
-		return false;
-
-	return true; 
+	if( emb && address == ISM330DHCX_PAGE_ADDRESS )
+		run->pageAddress = data;
 
-}
+	if( single || run->length == 0 || run->length == ISM_UCF_RUN_BYTES || page != run->page ||
+	    address != (page ? run->reg : run->reg + run->length) )
+	{
+		if( !flushUcfRun(run) )
+			return false;
 
+		if( single )
+		{
+			if( address == ISM330DHCX_CTRL3_C )
+			{
+				run->ctrl3 = data & ~0x81;
+				run->incOff = !(data & 0x04);
+			}
 
-//////////////////////////////////////////////////////////////////////////////////
-// enableSensorI2C
-//
-// Enables the 6DoF as an I2C sensor controller
-// 
+			return writeRegisterRegion(address, &data, 1) == 0;
+		}
 
-bool QwDevISM330DHCX::enableSensorI2C(bool enable)
-{
-	int32_t retVal;
+		run->reg = address;
+		run->page = page;
+		run->pageStart = run->pageAddress;
+	}
 
-	retVal = ism330dhcx_sh_master_set(&sfe_dev, (uint8_t)enable);
+	run->data[run->length++] = data;
 
-	if( retVal != 0 )
-		return false;
+	// The device advances the page address with every byte
+	if( page )
+		run->pageAddress++;
 
 	return true;
 }
 
-
 //////////////////////////////////////////////////////////////////////////////////
-// readPeripheralSensor
-//
-// Read external sensor hub data.  
+// flushUcfRun()
+// 
+// Sends the collected writes as one burst and reads them back when verifying.
 // 
 //  Parameter   Description
 //  ---------   -----------------------------
-//  shReg       Pointer to store the data to be read. 
-//  len					Number of reads to be executed.
+//  run         Writes collected for the burst
+//
 
-bool QwDevISM330DHCX::readPeripheralSensor(uint8_t* shReg, uint8_t len)
+bool QwDevISM330DHCX::flushUcfRun(sfe_ism_ucf_run_t* run)
 {
 	int32_t retVal;
 
-	retVal = ism330dhcx_sh_read_data_raw_get(&sfe_dev, (ism330dhcx_emb_sh_read_t*)shReg, len);
+	if( run->length == 0 )
+		return true;
+
+	// Register bursts increment the address, page bursts must not
+	if( run->length > 1 && !setUcfIncrement(run, !run->page) )
+		return false;
+
+	if( run->page )
+	{
+		// The shadow has no PAGE_VALUE, and the registers after it weren't 
+		// written
+		retVal = syncBank();
+
+		if( retVal == 0 )
+			retVal = _sfeBus->writeRegisterRegion(_i2cAddress, run->reg, run->data, run->length);
+
+		if( retVal != 0 )
+		{
+			_shadowValid = false;
+			_bankKnown = false;
+		}
+	}
+	else
+		retVal = writeRegisterRegion(run->reg, run->data, run->length);
 
 	if( retVal != 0 )
 		return false;
 
+	if( run->verify && !verifyUcfRun(run) )
+		return false;
+
+	run->length = 0;
+
 	return true;
 }
 
-
 //////////////////////////////////////////////////////////////////////////////////
-// getHubStatus
+// setUcfIncrement()
+// 
+// Sets IF_INC in CTRL3_C, from whichever bank the configuration has selected.
+// 
+//  Parameter   Description
+//  ---------   -----------------------------
+//  run         Writes collected for the next burst
+//  increment   Whether bursts access consecutive registers
 //
-// Checks whether communication with the external sensor has concluded. 
-//	
 
-bool QwDevISM330DHCX::getHubStatus()
+bool QwDevISM330DHCX::setUcfIncrement(sfe_ism_ucf_run_t* run, bool increment)
 {
+	uint8_t funcCfg = _shadow[ISM330DHCX_FUNC_CFG_ACCESS];
+	uint8_t userBank = funcCfg & 0x3F;
+	uint8_t ctrl3;
 
-	int32_t retVal;
-	ism330dhcx_status_master_t tempVal;
+	if( increment != run->incOff )
+		return true;
 
-	retVal = ism330dhcx_sh_status_get(&sfe_dev, &tempVal);
+	ctrl3 = increment ? run->ctrl3 | 0x04 : run->ctrl3 & ~0x04;
 
-	if( retVal != 0 )
+	if( writeRegisterRegion(ISM330DHCX_FUNC_CFG_ACCESS, &userBank, 1) != 0 )
 		return false;
 
-	if( tempVal.sens_hub_endop == 1 )
-		return true;
+	if( writeRegisterRegion(ISM330DHCX_CTRL3_C, &ctrl3, 1) != 0 )
+		return false;
 
-	return false; 
+	run->incOff = !increment;
+
+	return writeRegisterRegion(ISM330DHCX_FUNC_CFG_ACCESS, &funcCfg, 1) == 0;
 }
 
 //////////////////////////////////////////////////////////////////////////////////
-// getExternalSensorNack
-//
-// Retrieves communication status when communicating with external sensor
-//	
+// verifyUcfRun()
+// 
+// Reads a burst back from the device, not the shadow. Program bytes are read 
+// through PAGE_VALUE in page read mode, then the page is left in write mode at 
+// the next address as the configuration expects.
+// 
 //  Parameter   Description
 //  ---------   -----------------------------
-//  sensor			The sensor to check, (0-3)
-
+//  run         Writes of the burst
+//
 
-bool QwDevISM330DHCX::getExternalSensorNack(uint8_t sensor)
+bool QwDevISM330DHCX::verifyUcfRun(sfe_ism_ucf_run_t* run)
 {
+	uint8_t readBack[ISM_UCF_RUN_BYTES];
+	uint8_t pageRw = _embShadow[ISM330DHCX_PAGE_RW];
+	uint8_t val;
+	uint8_t mask;
 
-	int32_t retVal;
-	ism330dhcx_status_master_t tempVal;
+	if( run->page )
+	{
+		val = (pageRw & ~0x60) | 0x20;
 
-	retVal = ism330dhcx_sh_status_get(&sfe_dev, &tempVal);
+		if( writeRegisterRegion(ISM330DHCX_PAGE_RW, &val, 1) != 0 ||
+		    writeRegisterRegion(ISM330DHCX_PAGE_ADDRESS, &run->pageStart, 1) != 0 )
+			return false;
+	}
 
-	if( retVal != 0 )
+	if( syncBank() != 0 )
 		return false;
 
-	switch( sensor ){
-		case 0:
-			if( tempVal.slave0_nack == 1 )
-				return true;
-			break;
-		case 1:
-			if( tempVal.slave1_nack == 1 )
-				return true;
-			break;
-		case 2:
-			if( tempVal.slave2_nack == 1 )
-				return true;
-			break;
-		case 3:
-			if( tempVal.slave3_nack == 1 )
-				return true;
-			break;
-		default:
+	if( _sfeBus->readRegisterRegion(_i2cAddress, run->reg, readBack, run->length) != 0 )
+		return false;
+
+	if( run->page )
+	{
+		if( writeRegisterRegion(ISM330DHCX_PAGE_RW, &pageRw, 1) != 0 ||
+		    writeRegisterRegion(ISM330DHCX_PAGE_ADDRESS, &run->pageAddress, 1) != 0 )
 			return false;
 	}
 
-	return false; 
-}
+	for( uint8_t i = 0; i < run->length; i++ )
+	{
+		mask = 0xFF;
 
-bool QwDevISM330DHCX::readMMCMagnetometer(uint8_t* magData, uint8_t len)
-{
-	return(readPeripheralSensor(magData, len));
-}
+		// RST_COUNTER_BDR, and the embedded function init requests
+		if( _bank == ISM330DHCX_USER_BANK && run->reg + i == ISM330DHCX_COUNTER_BDR_REG1 )
+			mask = ~0x40;
+		else if( _bank == ISM330DHCX_EMBEDDED_FUNC_BANK && !run->page &&
+		         (run->reg + i == ISM330DHCX_EMB_FUNC_INIT_A || run->reg + i == ISM330DHCX_EMB_FUNC_INIT_B) )
+			mask = 0;
+
+		if( (readBack[i] ^ run->data[i]) & mask )
+			return false;
+	}
 
+	return true;
+}
 
 //////////////////////////////////////////////////////////////////////////////////
-// setHubWriteMode
-//
-// Sets how often the 6DoF should write to the external sensor: once per cycle i.e. output 
-// data rate, or just once. 
+// endUcf()
+// 
+// Sends the last burst, leaves IF_INC as the configuration set it and ends 
+// the bank session. The session and IF_INC are restored after a failure too.
 // 
 //  Parameter   Description
 //  ---------   -----------------------------
-//  config       How often to be written
+//  run         Writes collected for the last burst
+//  ok          Whether the configuration was applied so far
+//
 
-bool QwDevISM330DHCX::setHubWriteMode(uint8_t config)
+bool QwDevISM330DHCX::endUcf(sfe_ism_ucf_run_t* run, bool ok)
 {
-	int32_t retVal;
+	if( ok )
+		ok = flushUcfRun(run);
 
-	if( config > 1)
-		return false;
-
-	// 0 = Write each cycle 
-	// 1 = Write once
-	retVal = ism330dhcx_sh_write_mode_set(&sfe_dev,
-																			 (ism330dhcx_write_once_t)config);
+	if( !setUcfIncrement(run, run->ctrl3 & 0x04) )
+		ok = false;
 
-	if( retVal != 0 )
-		return false;
+	if( !endBankSession() )
+		ok = false;
 
-	return true;
+	return ok;
 }
 
-
 //////////////////////////////////////////////////////////////////////////////////
-// setHubPassThrough
-//
-//	Allows the primary I2C data lines to communicate through the auxiliary I2C lines.
-//	
+// enableMlc()
+// 
+// Enables the Machine Learning Core, which also requests its initialization.
+// Load its program with loadUcf() first, the decision tree results are 
+// reported by getEvents() as ISM_EVENT_MLC1 - MLC8 and can be routed with 
+// setInterruptRouting().
+// 
 //  Parameter   Description
 //  ---------   -----------------------------
-//  set					Enables/disables pass through
+//  enable      Enables/disables the Machine Learning Core
 //
 
-bool QwDevISM330DHCX::setHubPassThrough(bool enable)
+bool QwDevISM330DHCX::enableMlc(bool enable)
 {
+	int32_t retVal;
 
-	int32_t retVal = ism330dhcx_sh_pass_through_set(&sfe_dev, (uint8_t)enable);
+	retVal = ism330dhcx_mlc_set(&sfe_dev, (uint8_t)enable);
 
 	if( retVal != 0 )
 		return false;
 
-	return true; 
+	return true;
 }
 
 //////////////////////////////////////////////////////////////////////////////////
-// setHubFifoBatching
-//
-// Sets sensor hub FIFO batching
-//	
+// setMlcDataRate()
+// 
+// Sets the rate the Machine Learning Core runs its decision trees at.
+// 
 //  Parameter   Description
 //  ---------   -----------------------------
-//  enable			Enable/disables fifo batching
+//  rate        ISM_MLC_ODR_12Hz5, _26Hz, _52Hz or _104Hz
+//
+// See sfe_ism330dhcx_defs.h for a list of valid arguments
+//
 
-bool QwDevISM330DHCX::setHubFifoBatching(bool enable)
+bool QwDevISM330DHCX::setMlcDataRate(uint8_t rate)
 {
 	int32_t retVal;
 
-	retVal = ism330dhcx_sh_batch_slave_0_set(&sfe_dev, (uint8_t)enable);
+	if( rate > ISM_MLC_ODR_104Hz )
+		return false;
+
+	retVal = ism330dhcx_mlc_data_rate_set(&sfe_dev, (ism330dhcx_mlc_odr_t)rate);
 
 	if( retVal != 0 )
 		return false;
@@ -1471,51 +4239,50 @@ bool QwDevISM330DHCX::setHubFifoBatching(bool enable)
 	return true;
 }
 
-
 //////////////////////////////////////////////////////////////////////////////////
-// setHubPullUps
+// getMlcStatus()
+// 
+// Retrieves which decision trees raised an interrupt, MLC1 in bit 0. Read from 
+// the user bank without a bank switch.
 //
-// Enables/Disables internal pullups on SDX/SCX lines
-//	
-//  Parameter   Description
-//  ---------   -----------------------------
-//  enable			Enable/disables internal pullups on SDX/SCX lines 
 
-bool QwDevISM330DHCX::setHubPullUps(bool enable)
+uint8_t QwDevISM330DHCX::getMlcStatus()
 {
-
 	int32_t retVal;
+	ism330dhcx_mlc_status_mainpage_t status;
 
-	retVal = ism330dhcx_sh_pin_mode_set(&sfe_dev, (ism330dhcx_shub_pu_en_t)enable);
+	retVal = ism330dhcx_mlc_status_get(&sfe_dev, &status);
 
 	if( retVal != 0 )
-		return false;
+		return 0;
 
-	return true; 
+	return *(uint8_t*)&status;
 }
 
-
 //////////////////////////////////////////////////////////////////////////////////
-// resetSensorHub
+// getMlcOutputs()
+// 
+// Reads the results of the eight decision trees, MLC0_SRC - MLC7_SRC, in one
+// burst. Inside a bank session of the embedded function bank no bank switch
+// is needed.
+// 
+//  Parameter   Description
+//  ---------   -----------------------------
+//  outputs     Buffer for 8 results, the first decision tree's first
 //
-// Resets all settings in the "Master Config" register
-//	
 
-bool QwDevISM330DHCX::resetSensorHub()
+bool QwDevISM330DHCX::getMlcOutputs(uint8_t* outputs)
 {
+	int32_t retVal;
 
-	int32_t retVal;  
-
-	retVal = ism330dhcx_sh_reset_set(&sfe_dev);
+	retVal = ism330dhcx_mlc_out_get(&sfe_dev, outputs);
 
 	if( retVal != 0 )
 		return false;
 
-	return true; 
+	return true;
 }
-//
-//
-//////////////////////////////////////////////////////////////////////////////////
+
 
 //////////////////////////////////////////////////////////////////////////////////
 // Self Test
@@ -1644,3 +4411,88 @@ bool QwDevISM330DHCX::checkTempStatus()
 
 }
 
+//////////////////////////////////////////////////////////////////////////////////
+// getEvents()
+//
+// Retrieves the pending events in place of ism330dhcx_all_sources_get(), which
+// reads a dozen registers across the register banks. ALL_INT_SRC, WAKE_UP_SRC,
+// TAP_SRC, D6D_SRC and STATUS_REG are read in a single burst. The embedded
+// function, FSM, MLC and sensor hub status are read from their copies in the 
+// user bank with a second burst, and only when one of them was enabled through
+// this driver. The same burst covers FIFO_STATUS1/2 when FIFO interrupts are 
+// routed.
+//
+// Reading ALL_INT_SRC clears the latched interrupts and the wake-up, tap and 
+// 6D source registers, read those first where the axis or direction of an 
+// event is needed.
+//
+//  Parameter   Description
+//  ---------   -----------------------------
+//  events      Pending events and the source register details
+//
+
+bool QwDevISM330DHCX::getEvents(sfe_ism_events_t* events)
+{
+	int32_t retVal;
+	uint8_t buff[7];
+	uint8_t first = ISM330DHCX_EMB_FUNC_STATUS_MAINPAGE;
+	uint8_t last = ISM330DHCX_STATUS_MASTER_MAINPAGE;
+
+	// ALL_INT_SRC - STATUS_REG
+	retVal = readRegisterRegion(ISM330DHCX_ALL_INT_SRC, buff, 5);
+
+	if( retVal != 0 )
+		return false;
+
+	events->events = (buff[0] & 0xBF) | ((uint32_t)(buff[4] & 0x07) << 8);
+	events->fsmStatus = 0;
+
+	if( !_eventSources )
+		return true;
+
+	if( !(_eventSources & 0x07) )
+		first = ISM330DHCX_FIFO_STATUS1;
+
+	if( _eventSources & 0x18 )
+		last = ISM330DHCX_FIFO_STATUS2;
+
+	// EMB_FUNC_STATUS_MAINPAGE - FIFO_STATUS2, buff[] is indexed from the
+	// first of them whichever part is read.
+	retVal = readRegisterRegion(first, &buff[first - ISM330DHCX_EMB_FUNC_STATUS_MAINPAGE], last - first + 1);
+
+	if( retVal != 0 )
+		return false;
+
+	if( last == ISM330DHCX_FIFO_STATUS2 )
+	{
+		// FIFO_WTM_IA, FIFO_OVR_IA, FIFO_FULL_IA and COUNTER_BDR_IA
+		events->events |= (uint32_t)(buff[6] & 0xF0) << 14;
+
+		// Reading FIFO_STATUS2 cleared FIFO_OVR_LATCHED, readFifo() still 
+		// has to report it.
+		if( buff[6] & 0x08 )
+		{
+			_fifoOverrunLatched = true;
+			events->events |= ISM_EVENT_FIFO_OVERRUN;
+		}
+	}
+
+	if( first != ISM330DHCX_EMB_FUNC_STATUS_MAINPAGE )
+		return true;
+
+	// IS_STEP_DET, IS_TILT, IS_SIGMOT and IS_FSM_LC
+	events->events |= (uint32_t)(buff[0] & 0x38) << 9;
+	events->events |= (uint32_t)(buff[0] & 0x80) << 8;
+
+	events->fsmStatus = (uint16_t)((buff[2] << 8) | buff[1]);
+	if( events->fsmStatus )
+		events->events |= ISM_EVENT_FSM;
+
+	// SENS_HUB_ENDOP
+	if( buff[4] & 0x01 )
+		events->events |= ISM_EVENT_SENSOR_HUB_END;
+
+	events->events |= (uint32_t)buff[3] << 24;
+
+	return true;
+}
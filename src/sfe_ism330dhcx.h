@@ -1,11 +1,52 @@
+#pragma once
+
 #include "sfe_bus.h"
 #include "sfe_ism_shim.h"
+#include "sfe_ism_batch.h"
+#include "sfe_ism_clock.h"
+#include "sfe_ism_ucf.h"
 #include "sfe_ism330dhcx_defs.h"
 
 
 #define ISM330DHCX_ADDRESS_LOW 0x6A
 #define ISM330DHCX_ADDRESS_HIGH 0x6B
 
+// Most bursts commitConfig() needs: PIN_CTRL, FIFO_CTRL1 - INT2_CTRL, CTRL1_XL -
+// CTRL10_C, TAP_CFG0 - MD2_CFG and the user offsets.
+#define ISM_CONFIG_MAX_RUNS 5
+
+// Fractional bits of the integer gyroscope output, 0 - 8. Every gyroscope 
+// sensitivity is a whole number of 1/8 mdps, 3 bits or more keep the 
+// conversion exact and up to 8 bits keep the 4000dps range within an int32.
+#ifndef ISM_GYRO_INT_FRAC_BITS
+#define ISM_GYRO_INT_FRAC_BITS 8
+#endif
+
+#if ISM_GYRO_INT_FRAC_BITS < 0 || ISM_GYRO_INT_FRAC_BITS > 8
+#error "ISM_GYRO_INT_FRAC_BITS must be 0 - 8"
+#endif
+
+// A gyroscope sensitivity in mdps/LSB as the factor of the integer output
+#define ISM_GYRO_INT_SENSITIVITY(mdps) ((int32_t)((mdps) * (1L << ISM_GYRO_INT_FRAC_BITS) + 0.5))
+
+// Nominal period of the timestamp counter in nanoseconds
+#define ISM_TIMESTAMP_NS 25000
+
+// Each FIFO word is a tag byte followed by six data bytes
+#define ISM_FIFO_WORD_SIZE 7
+
+// Number of FIFO words read per bus transaction while draining the FIFO. The
+// words are staged on the stack so keep this small on parts with little RAM.
+#ifndef ISM_FIFO_READ_WORDS
+#define ISM_FIFO_READ_WORDS 16
+#endif
+
+// Most UCF writes loadUcf() stages for a single burst, on the stack twice when
+// verifying.
+#ifndef ISM_UCF_RUN_BYTES
+#define ISM_UCF_RUN_BYTES 32
+#endif
+
 struct sfe_ism_raw_data_t
 {
 	int16_t xData;	
@@ -13,6 +54,9 @@ struct sfe_ism_raw_data_t
 	int16_t zData;
 };
 
+// The block conversions treat an array of these as packed x, y, z values
+static_assert(sizeof(sfe_ism_raw_data_t) == 3 * sizeof(int16_t), "sfe_ism_raw_data_t must be packed");
+
 struct sfe_ism_data_t
 {
 	float xData;	
@@ -21,6 +65,170 @@ struct sfe_ism_data_t
 };
 
 
+// Status, temperature, gyroscope and accelerometer output registers as read
+// in a single burst starting at STATUS_REG.
+struct sfe_ism_raw_all_data_t
+{
+	uint8_t status;
+	int16_t tempData;
+	sfe_ism_raw_data_t gyroData;
+	sfe_ism_raw_data_t accelData;
+};
+
+struct sfe_ism_all_data_t
+{
+	bool accelReady;
+	bool gyroReady;
+	bool tempReady;
+	float tempData;
+	sfe_ism_data_t gyroData;
+	sfe_ism_data_t accelData;
+};
+
+
+// Integer outputs for targets without an FPU. Accelerometer values are in
+// micro-g, gyroscope values in mdps with ISM_GYRO_INT_FRAC_BITS fractional bits
+// and temperature in milli-degrees Celsius.
+struct sfe_ism_int_data_t
+{
+	int32_t xData;
+	int32_t yData;
+	int32_t zData;
+};
+
+struct sfe_ism_int_all_data_t
+{
+	bool accelReady;
+	bool gyroReady;
+	bool tempReady;
+	int32_t tempData;
+	sfe_ism_int_data_t gyroData;
+	sfe_ism_int_data_t accelData;
+};
+
+
+// One accelerometer and gyroscope sample, e.g. for QwSampleRing. The time is
+// in ns when known.
+struct sfe_ism_sample_t
+{
+	uint64_t time;
+	sfe_ism_raw_data_t accelData;
+	sfe_ism_raw_data_t gyroData;
+};
+
+// Separate x, y and z buffers for block conversions, each holds at least as
+// many values as the block being converted.
+struct sfe_ism_block_data_t
+{
+	float* xData;
+	float* yData;
+	float* zData;
+};
+
+struct sfe_ism_int_block_data_t
+{
+	int32_t* xData;
+	int32_t* yData;
+	int32_t* zData;
+};
+
+
+struct sfe_ism_fifo_hub_data_t
+{
+	uint8_t sensor;
+	uint8_t data[6];
+};
+
+// Caller owned buffers that readFifo() sorts the FIFO words into. Any stream
+// can be left as a nullptr with a size of zero if it isn't batched. The
+// "num" members hold the number of entries stored by the last readFifo().
+struct sfe_ism_fifo_data_t
+{
+	sfe_ism_raw_data_t* accelData;
+	uint16_t accelSize;
+	uint16_t numAccel;
+
+	sfe_ism_raw_data_t* gyroData;
+	uint16_t gyroSize;
+	uint16_t numGyro;
+
+	int16_t* tempData;
+	uint16_t tempSize;
+	uint16_t numTemp;
+
+	uint32_t* timestampData;
+	uint16_t timestampSize;
+	uint16_t numTimestamp;
+
+	sfe_ism_fifo_hub_data_t* hubData;
+	uint16_t hubSize;
+	uint16_t numHub;
+
+	// Samples that had no room in their buffer and words with an unhandled tag
+	uint16_t numDropped;
+
+	// Optional, sized like accelData/gyroData. The FIFO time slot of every
+	// sample counted in periods of the fastest batched sensor, samples with the
+	// same slot were taken together.
+	uint32_t* accelSlot;
+	uint32_t* gyroSlot;
+
+	// Optional, sized like accelData/gyroData. Device time of every sample in
+	// nanoseconds extended to 64 bits, interpolated between the TIMESTAMP words
+	// (enableTimestamp() and setFifoTimestampDec()). Zero until the first
+	// TIMESTAMP word was read.
+	uint64_t* accelTime;
+	uint64_t* gyroTime;
+
+	// Samples that never reached the FIFO or were lost between the ones read,
+	// and whether the FIFO overran since the previous readFifo().
+	uint16_t accelMissing;
+	uint16_t gyroMissing;
+	bool overrun;
+};
+
+
+// A triggered capture, readCapture() sorts the window into the buffers of
+// "fifo" like readFifo(). Sample times need accelTime/gyroTime buffers and the
+// timestamp batched with enableTimestamp() and setFifoTimestampDec().
+struct sfe_ism_capture_t
+{
+	sfe_ism_fifo_data_t fifo;
+
+	// Device time of the trigger in ns and the samples taken before it
+	uint64_t triggerTime;
+	uint16_t accelBefore;
+	uint16_t gyroBefore;
+
+	// All "depth" words of the window were read, over one or more calls
+	bool complete;
+};
+
+// Events pending at getEvents(), ISM_EVENT_ bits, and which of the 16 FSM
+// programs raised ISM_EVENT_FSM.
+struct sfe_ism_events_t
+{
+	uint32_t events;
+	uint16_t fsmStatus; // FSM1 in bit 0
+};
+
+// The UCF writes loadUcf() has collected for the next burst: a run of 
+// consecutive registers, or of bytes written to PAGE_VALUE which the device
+// stores at consecutive page addresses.
+struct sfe_ism_ucf_run_t
+{
+	uint8_t reg;
+	uint8_t length;
+	bool page;
+	uint8_t pageStart;   // Page address of the run's first byte
+	uint8_t pageAddress; // Page address of the next byte written
+	uint8_t ctrl3;       // CTRL3_C as the configuration leaves it
+	bool incOff;         // IF_INC cleared on the device for page bursts
+	bool verify;
+	uint8_t data[ISM_UCF_RUN_BYTES];
+};
+
+
 struct sfe_hub_sensor_settings_t
 {
 	uint8_t address;
@@ -72,8 +280,21 @@ public:
 	void setCommunicationBus(sfe_ISM330DHCX::QwIDeviceBus &theBus, uint8_t i2cAddress);
 	void setCommunicationBus(sfe_ISM330DHCX::QwIDeviceBus &theBus);
 
+	// Register Shadow
+	bool enableShadow(bool enable = true);
+	bool syncShadow();
+	bool beginConfig();
+	bool commitConfig();
+
+	// Register Banks
+	bool beginBankSession(uint8_t bank);
+	bool endBankSession();
+
 	bool setAccelFullScale(uint8_t val);
 	bool setGyroFullScale(uint8_t val);
+	bool syncFullScale();
+	bool setOutputUnits(uint8_t units);
+	uint8_t getOutputUnits();
 	uint8_t getAccelFullScale();
 	uint8_t getGyroFullScale();
 	uint8_t getUniqueId();
@@ -84,6 +305,14 @@ public:
 	bool getRawGyro(sfe_ism_raw_data_t* gyroData);
 	bool getAccel(sfe_ism_data_t* accelData);
 	bool getGyro(sfe_ism_data_t* gyroData);
+	bool getRawAllData(sfe_ism_raw_all_data_t* allData);
+	bool getAllData(sfe_ism_all_data_t* allData);
+
+	// Integer Data retrieval
+	bool getIntAccel(sfe_ism_int_data_t* accelData);
+	bool getIntGyro(sfe_ism_int_data_t* gyroData);
+	bool getIntTemp(int32_t* tempData);
+	bool getIntAllData(sfe_ism_int_all_data_t* allData);
 
 	// General Settings
 	bool setDeviceConfig(bool enable = true);
@@ -99,12 +328,16 @@ public:
 	bool setGyroDataRate(uint8_t rate);
 	bool enableTimestamp(bool enable = true);
 	bool resetTimestamp();
+	bool getTimestamp(uint32_t* ticks);
+	bool syncClock(QwISM330DHCXClock* clock);
 
 	// Interrupt Settings
 	bool setAccelStatustoInt1(bool enable = true);
 	bool setAccelStatustoInt2(bool enable = true);
 	bool setGyroStatustoInt1(bool enable = true);
 	bool setGyroStatustoInt2(bool enable = true);
+	bool setFifoInterrupt(uint8_t pin, uint8_t events);
+	bool setInterruptRouting(uint32_t int1Events, uint32_t int2Events);
 	bool setIntNotification(uint8_t val);
 	bool setDataReadyMode(uint8_t val);
 	bool setPinMode(bool activeLow = true);
@@ -115,6 +348,21 @@ public:
 	bool setAccelFifoBatchSet(uint8_t val);
 	bool setGyroFifoBatchSet(uint8_t val);
 	bool setFifoTimestampDec(uint8_t val);
+	bool getFifoLevel(uint16_t* level);
+	bool readFifo(sfe_ism_fifo_data_t* fifoData, uint16_t maxWords = 0xFFFF);
+	bool beginFifoPipeline(uint16_t watermark, uint8_t pin);
+	bool readFifoRaw(uint8_t* words, uint16_t maxWords, uint16_t* numWords);
+	bool setBatchCounter(uint8_t sensor, uint16_t threshold);
+	bool resetBatchCounter();
+	bool beginBlockPipeline(uint16_t samples, uint8_t sensor, uint8_t pin);
+	bool readFifoBlock(sfe_ism_fifo_data_t* fifoData);
+
+	// Triggered Capture
+	bool armCapture(uint32_t triggerEvents, uint8_t pin, uint8_t mode, uint16_t depth);
+	bool markTrigger();
+	bool readCapture(sfe_ism_capture_t* capture);
+	bool setFifoCompression(uint8_t val);
+	void resetFifoDecoder();
 
 	// Sensor Hub Settings
 	bool setHubODR(uint8_t rate);
@@ -132,6 +380,14 @@ public:
 	bool getExternalSensorNack(uint8_t sensor);
 	bool resetSensorHub();
 
+	// Machine Learning Core
+	bool loadUcf(const sfe_ism_ucf_line_t* lines, uint16_t numLines, bool verify = true);
+	bool loadUcf(const char* text, bool verify = true);
+	bool enableMlc(bool enable = true);
+	bool setMlcDataRate(uint8_t rate);
+	uint8_t getMlcStatus();
+	bool getMlcOutputs(uint8_t* outputs);
+
 	// Self Test
 	bool setAccelSelfTest(uint8_t val);
 	bool setGyroSelfTest(uint8_t val);
@@ -142,6 +398,7 @@ public:
 	bool checkAccelStatus();
 	bool checkGyroStatus();
 	bool checkTempStatus();
+	bool getEvents(sfe_ism_events_t* events);
 
 	// Conversions
 	float convert2gToMg(int16_t data);
@@ -156,14 +413,318 @@ public:
 	float convert4000dpsToMdps(int16_t data);
 	float convertToCelsius(int16_t data);
 
-private:
+	// Converts the three raw axes with the sensitivity of the current full scale
+	// in the units selected with setOutputUnits(), e.g. for readFifo() samples
+	bool convertAccelData(const sfe_ism_raw_data_t* rawData, sfe_ism_data_t* accelData)
+	{
+		accelData->xData = rawData->xData * _accelSensitivity;
+		accelData->yData = rawData->yData * _accelSensitivity;
+		accelData->zData = rawData->zData * _accelSensitivity;
+		return true;
+	}
+
+	bool convertGyroData(const sfe_ism_raw_data_t* rawData, sfe_ism_data_t* gyroData)
+	{
+		gyroData->xData = rawData->xData * _gyroSensitivity;
+		gyroData->yData = rawData->yData * _gyroSensitivity;
+		gyroData->zData = rawData->zData * _gyroSensitivity;
+		return true;
+	}
+
+	// Integer conversions of "num" consecutive samples, e.g. from readFifo()
+	void convertIntAccel(const sfe_ism_raw_data_t* rawData, sfe_ism_int_data_t* accelData, uint16_t num = 1)
+	{
+		for( uint16_t i = 0; i < num; i++ )
+		{
+			accelData[i].xData = rawData[i].xData * _accelSensitivityUg;
+			accelData[i].yData = rawData[i].yData * _accelSensitivityUg;
+			accelData[i].zData = rawData[i].zData * _accelSensitivityUg;
+		}
+	}
+
+	void convertIntGyro(const sfe_ism_raw_data_t* rawData, sfe_ism_int_data_t* gyroData, uint16_t num = 1)
+	{
+		for( uint16_t i = 0; i < num; i++ )
+		{
+			gyroData[i].xData = rawData[i].xData * _gyroSensitivityFixed;
+			gyroData[i].yData = rawData[i].yData * _gyroSensitivityFixed;
+			gyroData[i].zData = rawData[i].zData * _gyroSensitivityFixed;
+		}
+	}
+
+	// Block conversions of "num" samples into separate x, y and z buffers, in
+	// the same units as the single sample conversions.
+	void convertAccelBlock(const sfe_ism_raw_data_t* rawData, uint16_t num, sfe_ism_block_data_t* accelData)
+	{
+		sfe_ism_scale_block(&rawData->xData, num, _accelSensitivity, accelData->xData, accelData->yData, accelData->zData);
+	}
 
+	void convertGyroBlock(const sfe_ism_raw_data_t* rawData, uint16_t num, sfe_ism_block_data_t* gyroData)
+	{
+		sfe_ism_scale_block(&rawData->xData, num, _gyroSensitivity, gyroData->xData, gyroData->yData, gyroData->zData);
+	}
+
+	void convertAccelBlock(const sfe_ism_raw_data_t* rawData, uint16_t num, sfe_ism_int_block_data_t* accelData)
+	{
+		sfe_ism_scale_block_int(&rawData->xData, num, _accelSensitivityUg, accelData->xData, accelData->yData, accelData->zData);
+	}
+
+	void convertGyroBlock(const sfe_ism_raw_data_t* rawData, uint16_t num, sfe_ism_int_block_data_t* gyroData)
+	{
+		sfe_ism_scale_block_int(&rawData->xData, num, _gyroSensitivityFixed, gyroData->xData, gyroData->yData, gyroData->zData);
+	}
+
+	// 256 LSB per degree, 0 at 25C
+	int32_t convertIntTemp(int16_t data)
+	{
+		return 25000 + ((int32_t)data * 125) / 32;
+	}
+
+protected:
+
+	void decodeRawAllData(const uint8_t* buff, sfe_ism_raw_all_data_t* allData);
+	bool convertAllData(const sfe_ism_raw_all_data_t* rawData, sfe_ism_all_data_t* allData);
+	void convertIntAllData(const sfe_ism_raw_all_data_t* rawData, sfe_ism_int_all_data_t* allData);
+	bool setAccelSensitivity(uint8_t val);
+	bool setGyroSensitivity(uint8_t val);
+	void updateSensitivity();
+	bool prepareFifoDecoder();
+	bool beginFifoRead(sfe_ism_fifo_data_t* fifoData);
+	uint16_t decodeFifoStatus(const uint8_t* status, sfe_ism_fifo_data_t* fifoData);
+	void endFifoRead(sfe_ism_fifo_data_t* fifoData);
+	template <class Reader>
+	bool drainFifo(Reader readChunk, sfe_ism_fifo_data_t* fifoData, uint16_t maxWords, const uint16_t* counted = nullptr, uint16_t target = 0, uint16_t* numRead = nullptr);
+	template <class Reader>
+	bool drainFifoRaw(Reader readChunk, uint8_t* words, uint16_t maxWords, uint16_t* numWords);
+	void timeFifoSamples(sfe_ism_fifo_data_t* fifoData);
+	uint64_t fifoSlotToNs(uint32_t slot);
+	void addFifoTimestamp(uint32_t timestamp, sfe_ism_fifo_data_t* fifoData);
+	void setFifoRates(uint8_t fifoCtrl3);
+	void sortFifoWord(const uint8_t* word, sfe_ism_fifo_data_t* fifoData);
+	void decodeFifoSamples(const uint8_t* word, bool gyro, sfe_ism_fifo_data_t* fifoData);
+	void storeFifoSample(bool gyro, uint32_t slot, sfe_ism_fifo_data_t* fifoData);
+	bool carryBlockSample(bool gyro, uint32_t slot, uint16_t num);
+	void restoreBlockCarry(sfe_ism_fifo_data_t* fifoData);
+	uint8_t* shadowRegister(uint8_t reg);
+	bool shadowCovers(uint8_t offset, uint16_t length);
+	void updateShadow(uint8_t offset, const uint8_t *data, uint16_t length);
+	bool deferWrite(uint8_t offset, const uint8_t *data, uint16_t length);
+	int32_t flushConfig();
+	int32_t syncBank();
+	void trackEventSources(uint8_t reg, uint8_t val);
+	bool routeEvents(uint32_t events, uint8_t pin, uint8_t* ctrl, uint8_t* md, uint8_t* emb);
+	void locateTrigger(sfe_ism_capture_t* capture);
+	bool beginUcf(sfe_ism_ucf_run_t* run, bool verify);
+	bool addUcfLine(sfe_ism_ucf_run_t* run, uint8_t address, uint8_t data);
+	bool flushUcfRun(sfe_ism_ucf_run_t* run);
+	bool setUcfIncrement(sfe_ism_ucf_run_t* run, bool increment);
+	bool verifyUcfRun(sfe_ism_ucf_run_t* run);
+	bool endUcf(sfe_ism_ucf_run_t* run, bool ok);
+
+	// Chunk reader of drainFifo() through the ST context
+	struct RegisterReader
+	{
+		QwDevISM330DHCX* dev;
+
+		int32_t operator()(uint8_t reg, uint8_t* data, uint16_t length)
+		{
+			return dev->readRegisterRegion(reg, data, length);
+		}
+	};
 
 	sfe_ISM330DHCX::QwIDeviceBus *_sfeBus;
 	uint8_t _i2cAddress;
 	uint8_t _cs;
 	stmdev_ctx_t sfe_dev;
-	uint8_t fullScaleAccel = 0; //Powered down by default
-	uint8_t fullScaleGyro = 0;  //Powered down by default
+	// Sensitivity of the current full scale, 2g and 250dps by default
+	float _accelSensitivity = 0.061f; // Output unit/LSB
+	float _gyroSensitivity = 8.75f;
+	uint8_t _outputUnits = ISM_UNITS_MG_MDPS;
+	int32_t _accelSensitivityUg = 61;
+	int32_t _gyroSensitivityFixed = ISM_GYRO_INT_SENSITIVITY(8.75);
+
+	// Copies of the writable control registers, indexed by address
+	bool _shadowEnabled = false;
+	bool _shadowValid = false;
+	uint8_t _bank = ISM330DHCX_USER_BANK;
+	uint8_t _shadow[ISM330DHCX_Z_OFS_USR + 1];
+	uint8_t _embShadow[ISM330DHCX_PAGE_RW + 1];
+
+	// FUNC_CFG_ACCESS as last written to or read from the device. Inside a bank
+	// session a bank switch only changes the shadow copy, the device follows
+	// before it is next accessed.
+	bool _bankKnown = false;
+	uint8_t _deviceFuncCfg = 0;
+	uint8_t _bankSessions = 0;
+
+	// Embedded function, FSM, MLC and sensor hub sources enabled and FIFO
+	// interrupts routed through the driver, one bit per register.
+	uint8_t _eventSources = 0;
+
+	// Registers changed since beginConfig(), one bit per user bank register
+	bool _deferConfig = false;
+	uint8_t _dirty[(ISM330DHCX_Z_OFS_USR + 8) / 8];
+
+	// FIFO decoder, compressed words are differences to the previous sample
+	// of the same sensor.
+	bool _fifoRatesValid = false;
+	bool _fifoTagValid = false;
+	uint8_t _fifoTagCnt = 0;
+	uint32_t _fifoSlot = 0;
+	uint16_t _fifoAccelStep = 1;  // Slots per sample
+	uint16_t _fifoGyroStep = 1;
+	uint8_t _fifoTempRank = 0;
+	bool _fifoCompression = false;
+	sfe_ism_raw_data_t _fifoLastAccel = {0, 0, 0};
+	sfe_ism_raw_data_t _fifoLastGyro = {0, 0, 0};
+
+	// Blocks of the batch counter, a block read in part is open. Samples of a
+	// compressed word past the end of a block are carried into the next one.
+	uint8_t _blockSensor = 0;
+	uint16_t _blockSamples = 0;
+	bool _blockOpen = false;
+	bool _blockReading = false;
+	uint8_t _blockCarried = 0;
+	sfe_ism_raw_data_t _blockCarry[2];
+	uint32_t _blockCarrySlot[2];
+
+	// Triggered capture, the mode is zero when none is armed. Words of the 
+	// window read so far and whether the trigger was seen in ALL_INT_SRC.
+	uint8_t _captureMode = 0;
+	uint16_t _captureDepth = 0;
+	uint16_t _captureRead = 0;
+	uint8_t _captureSources = 0;
+	bool _captureTriggered = false;
+	bool _triggerMarked = false;
+	uint32_t _triggerTicks = 0;
+
+	// Gap detection and sample timing. Slot periods are in 1/256 timestamp
+	// ticks, the anchor is the last TIMESTAMP word.
+	bool _fifoAccelSeen = false;
+	bool _fifoGyroSeen = false;
+	uint32_t _fifoLastAccelSlot = 0;
+	uint32_t _fifoLastGyroSlot = 0;
+	uint16_t _fifoPendingAccel = 0;
+	uint16_t _fifoPendingGyro = 0;
+	bool _fifoOverrunLatched = false;  // FIFO_OVR_LATCHED seen by getEvents()
+	bool _fifoAnchorValid = false;
+	uint64_t _fifoAnchorTicks = 0;
+	uint32_t _fifoAnchorSlot = 0;
+	uint32_t _fifoSlotTicks = 6 * 256;
+	uint32_t _fifoNominalSlotTicks = 6 * 256;
 };
 
+//////////////////////////////////////////////////////////////////////////////////
+// drainFifo()
+// 
+// Reads the FIFO status and then up to maxWords words in bursts of up to 
+// ISM_FIFO_READ_WORDS, sorting them into the caller's buffers. Shared by the
+// FIFO reads of QwDevISM330DHCX and QwDevISM330DHCXStatic, which differ only
+// in how a burst is read.
+// 
+// With "counted" the drain stops once it reaches "target", bursts are limited
+// to the samples still missing as a word holds at most one sample of a sensor.
+// A compressed word holds up to three, bursts are then limited to a third of
+// the samples missing, rounded up, and the last word can overshoot "target" by
+// up to two samples.
+// 
+//  Parameter   Description
+//  ---------   -----------------------------
+//  readChunk   Called as readChunk(reg, data, length), returns 0 on success
+//  fifoData    Buffers to store the FIFO data into, readied by the caller
+//  maxWords    Most words to read
+//  counted     Sample count to stop at, e.g. &fifoData->numAccel, or nullptr
+//  target      Value of *counted to stop at
+//  numRead     Number of words read, or nullptr
+//
+
+template <class Reader>
+bool QwDevISM330DHCX::drainFifo(Reader readChunk, sfe_ism_fifo_data_t* fifoData, uint16_t maxWords, const uint16_t* counted, uint16_t target, uint16_t* numRead)
+{
+	uint8_t buff[ISM_FIFO_READ_WORDS * ISM_FIFO_WORD_SIZE];
+	uint16_t numWords;
+	uint16_t nChunk;
+	uint16_t missing;
+
+	if( numRead )
+		*numRead = 0;
+
+	// FIFO_STATUS1 and FIFO_STATUS2
+	if( readChunk(ISM330DHCX_FIFO_STATUS1, buff, 2) != 0 )
+		return false;
+
+	numWords = decodeFifoStatus(buff, fifoData);
+
+	if( numWords > maxWords )
+		numWords = maxWords;
+
+	while( numWords > 0 && (!counted || *counted < target) )
+	{
+		nChunk = numWords > ISM_FIFO_READ_WORDS ? ISM_FIFO_READ_WORDS : numWords;
+
+		if( counted )
+		{
+			missing = target - *counted;
+
+			if( _fifoCompression )
+				missing = (missing + 2) / 3;
+
+			if( nChunk > missing )
+				nChunk = missing;
+		}
+
+		if( readChunk(ISM330DHCX_FIFO_DATA_OUT_TAG, buff, nChunk * ISM_FIFO_WORD_SIZE) != 0 )
+			return false;
+
+		for( uint16_t i = 0; i < nChunk; i++ )
+			sortFifoWord(&buff[i * ISM_FIFO_WORD_SIZE], fifoData);
+
+		numWords -= nChunk;
+
+		if( numRead )
+			*numRead += nChunk;
+	}
+
+	endFifoRead(fifoData);
+
+	return true;
+}
+
+//////////////////////////////////////////////////////////////////////////////////
+// drainFifoRaw()
+// 
+// Reads the FIFO status and then up to maxWords words in a single burst 
+// straight into the caller's buffer, undecoded.
+// 
+//  Parameter   Description
+//  ---------   -----------------------------
+//  readChunk   Called as readChunk(reg, data, length), returns 0 on success
+//  words       Buffer of at least maxWords * ISM_FIFO_WORD_SIZE bytes
+//  maxWords    Most words to read
+//  numWords    Number of words read
+//
+
+template <class Reader>
+bool QwDevISM330DHCX::drainFifoRaw(Reader readChunk, uint8_t* words, uint16_t maxWords, uint16_t* numWords)
+{
+	uint8_t status[2];
+	uint16_t level;
+
+	*numWords = 0;
+
+	if( readChunk(ISM330DHCX_FIFO_STATUS1, status, 2) != 0 )
+		return false;
+
+	level = (uint16_t)(((status[1] & 0x03) << 8) | status[0]);
+
+	if( level > maxWords )
+		level = maxWords;
+
+	if( level > 0 && readChunk(ISM330DHCX_FIFO_DATA_OUT_TAG, words, level * ISM_FIFO_WORD_SIZE) != 0 )
+		return false;
+
+	*numWords = level;
+
+	return true;
+}
+
@@ -12,6 +12,16 @@
 #define ISM_2000dps   12
 #define ISM_4000dps   1
 
+//Float Output Units
+#define ISM_UNITS_MG_MDPS  0 // mg, mdps
+#define ISM_UNITS_SI       1 // m/s^2, rad/s
+#define ISM_UNITS_G_DPS    2 // g, dps
+
+// Used by ISM_UNITS_SI, in m/s^2
+#ifndef ISM_STANDARD_GRAVITY
+#define ISM_STANDARD_GRAVITY 9.80665
+#endif
+
 //Acceleromter Output Data Rate
 #define ISM_XL_ODR_OFF     0
 #define ISM_XL_ODR_12Hz5   1
@@ -100,8 +110,8 @@
 #define ISM_XL_BATCH_AT_833Hz    0x07
 #define ISM_XL_BATCH_AT_1667Hz   0x08
 #define ISM_XL_BATCH_AT_3333Hz   0x09
-#define ISM_XL_BATCH_AT_6667Hz   0x010
-#define ISM_XL_BATCH_6Hz5        0x011
+#define ISM_XL_BATCH_AT_6667Hz   0x0A
+#define ISM_XL_BATCH_6Hz5        0x0B
 
 //FIFO Gyroscope Batch Settings
 #define ISM_GY_NOT_BATCHED      0x00
@@ -114,8 +124,20 @@
 #define ISM_GY_BATCH_AT_833Hz    0x07
 #define ISM_GY_BATCH_AT_1667Hz   0x08
 #define ISM_GY_BATCH_AT_3333Hz   0x09
-#define ISM_GY_BATCH_AT_6667Hz   0x010
-#define ISM_GY_BATCH_6Hz5        0x011
+#define ISM_GY_BATCH_AT_6667Hz   0x0A
+#define ISM_GY_BATCH_6Hz5        0x0B
+
+//FIFO Batch Counter, the sensor whose batched samples are counted
+#define ISM_XL_BATCH_EVENT  0x00
+#define ISM_GY_BATCH_EVENT  0x01
+
+//FIFO Compression, the ratios force an uncompressed word at least every
+//8, 16 or 32 batched words.
+#define ISM_FIFO_COMPRESSION_OFF      0x00
+#define ISM_FIFO_COMPRESSION_ALWAYS   0x04
+#define ISM_FIFO_COMPRESSION_8_TO_1   0x05
+#define ISM_FIFO_COMPRESSION_16_TO_1  0x06
+#define ISM_FIFO_COMPRESSION_32_TO_1  0x07
 
 //Decimation rate
 #define ISM_NO_DECIMATION 0x00
@@ -129,7 +151,42 @@
 #define ISM_BASE_PULSED_EMB_LATCHED   0x02
 #define ISM_ALL_INT_LATCHED           0x03
 
+//Events reported by getEvents(). The low byte follows ALL_INT_SRC.
+#define ISM_EVENT_FREE_FALL        0x00000001
+#define ISM_EVENT_WAKE_UP          0x00000002
+#define ISM_EVENT_SINGLE_TAP       0x00000004
+#define ISM_EVENT_DOUBLE_TAP       0x00000008
+#define ISM_EVENT_6D               0x00000010
+#define ISM_EVENT_SLEEP_CHANGE     0x00000020
+#define ISM_EVENT_TIMESTAMP_END    0x00000080
+#define ISM_EVENT_ACCEL_READY      0x00000100
+#define ISM_EVENT_GYRO_READY       0x00000200
+#define ISM_EVENT_TEMP_READY       0x00000400
+#define ISM_EVENT_STEP             0x00001000
+#define ISM_EVENT_TILT             0x00002000
+#define ISM_EVENT_SIG_MOTION       0x00004000
+#define ISM_EVENT_FSM_LONG_COUNTER 0x00008000
+#define ISM_EVENT_FSM              0x00010000 // Any FSM, see fsmStatus
+#define ISM_EVENT_SENSOR_HUB_END   0x00020000
+#define ISM_EVENT_BATCH_COUNTER    0x00040000 // Bits 21:18 follow FIFO_STATUS2
+#define ISM_EVENT_FIFO_FULL        0x00080000
+#define ISM_EVENT_FIFO_OVERRUN     0x00100000
+#define ISM_EVENT_FIFO_THRESHOLD   0x00200000
+#define ISM_EVENT_MLC1             0x01000000 // MLC1 - MLC8 in the top byte
+
+//FIFO interrupts, the bits of INT1_CTRL and INT2_CTRL
+#define ISM_FIFO_INT_THRESHOLD      0x08
+#define ISM_FIFO_INT_OVERRUN        0x10
+#define ISM_FIFO_INT_FULL           0x20
+#define ISM_FIFO_INT_BATCH_COUNTER  0x40
+
 #define ISM_SH_ODR_104Hz 0x00
 #define ISM_SH_ODR_52Hz  0x01
 #define ISM_SH_ODR_26Hz  0x02
 #define ISM_SH_ODR_13Hz  0x03
+
+//Machine Learning Core data rates
+#define ISM_MLC_ODR_12Hz5 0x00
+#define ISM_MLC_ODR_26Hz  0x01
+#define ISM_MLC_ODR_52Hz  0x02
+#define ISM_MLC_ODR_104Hz 0x03
@@ -0,0 +1,1048 @@
+// sfe_ism330dhcx_sim.cpp
+//
+// This is a library written for SparkFun Qwiic ISM330DHCX boards
+//
+// SparkFun sells these boards at its website: www.sparkfun.com
+//
+// Do you like this library? Help support SparkFun. Buy a board!
+//
+//SparkFun Qwiic 6DoF - ISM330DHCX        https://www.sparkfun.com/products/19764
+//
+// Repository:
+//     https://github.com/sparkfun/SparkFun_6DoF_ISM330DHCX_Arduino_Library
+//
+//
+// SparkFun code, firmware, and software is released under the MIT
+// License(http://opensource.org/licenses/MIT).
+//
+// SPDX-License-Identifier: MIT
+
+// Software model of the ISM330DHCX used for host side tests and benchmarks.
+// Register addresses and bit positions follow the ST register definitions.
+
+#include "sfe_ism330dhcx_sim.h"
+
+#ifndef ARDUINO
+
+#include "st_src/ism330dhcx_reg.h"
+#include <string.h>
+
+#define kUserBank 0
+#define kHubBank 1
+#define kEmbBank 2
+
+// Used for events that are not scheduled
+#define kNever 0xFFFFFFFFFFFFFFFFULL
+
+// Timestamp resolution of the device in ns
+#define kTimestampNs 25000
+
+// Output data rates and batch data rates in Hz, indexed by the register codes.
+// Accelerometer code 11 is 1.6Hz for the ODR and 6.5Hz for the batch rate.
+static const float kOdrHz[12] = {0.0f, 12.5f, 26.0f, 52.0f, 104.0f, 208.0f, 416.0f, 833.0f,
+                                 1666.0f, 3332.0f, 6667.0f, 1.6f};
+static const float kBdrHz[12] = {0.0f, 12.5f, 26.0f, 52.0f, 104.0f, 208.0f, 417.0f, 833.0f,
+                                 1667.0f, 3333.0f, 6667.0f, 6.5f};
+
+// Temperature batch rates, FIFO_CTRL4 ODR_T_BATCH
+static const float kTempBdrHz[4] = {0.0f, 1.6f, 12.5f, 52.0f};
+
+// Timestamp batch decimation, FIFO_CTRL4 ODR_TS_BATCH
+static const uint8_t kTimestampDec[4] = {0, 1, 8, 32};
+
+namespace sfe_ISM330DHCX {
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+// Default source - device lying flat, not moving at 25 degrees Celsius
+
+void QwSimSource::accel(uint64_t timeNs, float* mg)
+{
+	(void)timeNs;
+	mg[0] = 0.0f;
+	mg[1] = 0.0f;
+	mg[2] = 1000.0f;
+}
+
+void QwSimSource::gyro(uint64_t timeNs, float* mdps)
+{
+	(void)timeNs;
+	mdps[0] = 0.0f;
+	mdps[1] = 0.0f;
+	mdps[2] = 0.0f;
+}
+
+float QwSimSource::temp(uint64_t timeNs)
+{
+	(void)timeNs;
+	return 25.0f;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+// Helpers
+
+// The level of a batch data rate code, used to find how often a sensor batches
+// relative to the fastest one. The 6.5Hz code sits below 12.5Hz.
+static uint8_t bdrLevel(uint8_t code)
+{
+	return code == 11 ? 0 : code;
+}
+
+static void putInt16(uint8_t* buff, int16_t val)
+{
+	buff[0] = (uint8_t)((uint16_t)val & 0xFF);
+	buff[1] = (uint8_t)((uint16_t)val >> 8);
+}
+
+static int16_t toRaw(float val, float sensitivity)
+{
+	float raw = val / sensitivity;
+
+	if( raw > 32767.0f )
+		return 32767;
+	if( raw < -32768.0f )
+		return -32768;
+
+	return (int16_t)(raw < 0 ? raw - 0.5f : raw + 0.5f);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+// Constructor
+//
+
+QwSimISM330DHCX::QwSimISM330DHCX(uint8_t address) : _address{address}, _source{&_defaultSource},
+	_now{0}, _clockPpm{0}, _transactionNs{0}, _byteNs{0}
+{
+	powerOn();
+	resetStats();
+}
+
+void QwSimISM330DHCX::setSource(QwSimSource* source)
+{
+	_source = source ? source : &_defaultSource;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+// powerOn()
+//
+// Loads the default value of every bank, as after the supply is applied.
+
+void QwSimISM330DHCX::powerOn()
+{
+	memset(_regs, 0, sizeof(_regs));
+	memset(_pages, 0, sizeof(_pages));
+
+	_regs[kEmbBank][ISM330DHCX_PAGE_SEL] = 0x01;
+	_regs[kEmbBank][ISM330DHCX_EMB_FUNC_ODR_CFG_B] = 0x4B;
+	_regs[kEmbBank][ISM330DHCX_EMB_FUNC_ODR_CFG_C] = 0x15;
+
+	softReset();
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+// softReset()
+//
+// Loads the default value of the user bank registers, as CTRL3_C SW_RESET does.
+
+void QwSimISM330DHCX::softReset()
+{
+	memset(_regs[kUserBank], 0, sizeof(_regs[kUserBank]));
+
+	_regs[kUserBank][ISM330DHCX_PIN_CTRL] = 0x3F;
+	_regs[kUserBank][ISM330DHCX_WHO_AM_I] = ISM330DHCX_ID;
+	_regs[kUserBank][ISM330DHCX_CTRL3_C] = 0x04;
+	_regs[kUserBank][ISM330DHCX_CTRL9_XL] = 0xE0;
+	// Factory trimmed oscillator deviation, 0.15% per LSB
+	_regs[kUserBank][ISM330DHCX_INTERNAL_FREQ_FINE] = (uint8_t)(int8_t)(_clockPpm / 1500);
+
+	_bank = kUserBank;
+
+	_fifoHead = 0;
+	_fifoCount = 0;
+	_fifoOverrun = false;
+	_fifoOverrunLatched = false;
+	_fifoTriggered = false;
+	_batchCount = 0;
+	_batchCountFlag = false;
+
+	_tsStart = _now;
+	_tsOffset = 0;
+	_tsLatched = 0;
+	_tagCounter = 0;
+	_nextTemp = kNever;
+
+	restartAccel();
+	restartGyro();
+	restartFifo();
+}
+
+void QwSimISM330DHCX::advance(uint64_t ns)
+{
+	uint64_t end = _now + ns;
+	uint64_t next;
+
+	for(;;)
+	{
+		next = _nextAccel;
+		if( _nextGyro < next )
+			next = _nextGyro;
+		if( _nextTemp < next )
+			next = _nextTemp;
+		if( _nextSlot < next )
+			next = _nextSlot;
+		if( _nextTempBatch < next )
+			next = _nextTempBatch;
+
+		if( next > end )
+			break;
+
+		_now = next;
+
+		if( _nextAccel == next )
+		{
+			sampleAccel();
+			_nextAccel += period(kOdrHz[_regs[kUserBank][ISM330DHCX_CTRL1_XL] >> 4]);
+		}
+
+		if( _nextGyro == next )
+		{
+			sampleGyro();
+			_nextGyro += period(kOdrHz[_regs[kUserBank][ISM330DHCX_CTRL2_G] >> 4]);
+		}
+
+		if( _nextTemp == next )
+		{
+			sampleTemp();
+			_nextTemp += period(52.0f);
+		}
+
+		if( _nextSlot == next )
+			batchSlot();
+
+		if( _nextTempBatch == next )
+			batchTemp();
+	}
+
+	_now = end;
+}
+
+uint64_t QwSimISM330DHCX::getTime() const
+{
+	return _now;
+}
+
+void QwSimISM330DHCX::setBusTiming(uint32_t transactionNs, uint32_t byteNs)
+{
+	_transactionNs = transactionNs;
+	_byteNs = byteNs;
+}
+
+void QwSimISM330DHCX::setClockError(int32_t ppm)
+{
+	_clockPpm = ppm;
+	_regs[kUserBank][ISM330DHCX_INTERNAL_FREQ_FINE] = (uint8_t)(int8_t)(ppm / 1500);
+}
+
+void QwSimISM330DHCX::setTimestamp(uint32_t ticks)
+{
+	_tsStart = _now;
+	_tsOffset = ticks;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+// injectEvent()
+//
+// Sets the source register bits of the event, the FIFO is triggered when the
+// event is routed to one of the interrupt pins through MD1_CFG or MD2_CFG.
+
+void QwSimISM330DHCX::injectEvent(QwSimEvent event)
+{
+	uint8_t* regs = _regs[kUserBank];
+	uint8_t mdBit = 0;
+
+	switch( event )
+	{
+		case kSimFreeFall:
+			regs[ISM330DHCX_WAKE_UP_SRC] |= 0x20;
+			regs[ISM330DHCX_ALL_INT_SRC] |= 0x01;
+			mdBit = 0x10;
+			break;
+		case kSimWakeUp:
+			regs[ISM330DHCX_WAKE_UP_SRC] |= 0x09;
+			regs[ISM330DHCX_ALL_INT_SRC] |= 0x02;
+			mdBit = 0x20;
+			break;
+		case kSimSingleTap:
+			regs[ISM330DHCX_TAP_SRC] |= 0x61;
+			regs[ISM330DHCX_ALL_INT_SRC] |= 0x04;
+			mdBit = 0x40;
+			break;
+		case kSimDoubleTap:
+			regs[ISM330DHCX_TAP_SRC] |= 0x51;
+			regs[ISM330DHCX_ALL_INT_SRC] |= 0x08;
+			mdBit = 0x08;
+			break;
+		case kSim6D:
+			regs[ISM330DHCX_D6D_SRC] |= 0x60;
+			regs[ISM330DHCX_ALL_INT_SRC] |= 0x10;
+			mdBit = 0x04;
+			break;
+		case kSimSleepChange:
+			regs[ISM330DHCX_WAKE_UP_SRC] |= 0x40;
+			regs[ISM330DHCX_ALL_INT_SRC] |= 0x20;
+			mdBit = 0x80;
+			break;
+	}
+
+	if( (regs[ISM330DHCX_MD1_CFG] | regs[ISM330DHCX_MD2_CFG]) & mdBit )
+		_fifoTriggered = true;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+// getInt1() / getInt2()
+//
+// The level of the interrupt pins given the routing registers and the current
+// status of the device.
+
+bool QwSimISM330DHCX::getInt1()
+{
+	const uint8_t* regs = _regs[kUserBank];
+	uint8_t status = regs[ISM330DHCX_STATUS_REG];
+	uint8_t fifo = fifoStatus2();
+	uint8_t ctrl = regs[ISM330DHCX_INT1_CTRL];
+	uint8_t md = regs[ISM330DHCX_MD1_CFG];
+	bool active = false;
+
+	active |= (ctrl & 0x01) && (status & 0x01);
+	active |= (ctrl & 0x02) && (status & 0x02);
+	active |= (ctrl & 0x08) && (fifo & 0x80);
+	active |= (ctrl & 0x10) && (fifo & 0x40);
+	active |= (ctrl & 0x20) && (fifo & 0x20);
+	active |= (ctrl & 0x40) && (fifo & 0x10);
+
+	if( regs[ISM330DHCX_TAP_CFG2] & 0x80 )
+	{
+		active |= (md & 0x04) && (regs[ISM330DHCX_D6D_SRC] & 0x40);
+		active |= (md & 0x08) && (regs[ISM330DHCX_TAP_SRC] & 0x10);
+		active |= (md & 0x10) && (regs[ISM330DHCX_WAKE_UP_SRC] & 0x20);
+		active |= (md & 0x20) && (regs[ISM330DHCX_WAKE_UP_SRC] & 0x08);
+		active |= (md & 0x40) && (regs[ISM330DHCX_TAP_SRC] & 0x20);
+		active |= (md & 0x80) && (regs[ISM330DHCX_WAKE_UP_SRC] & 0x40);
+	}
+
+	active |= (md & 0x01) && (regs[ISM330DHCX_STATUS_MASTER_MAINPAGE] & 0x01);
+	active |= (md & 0x02) && (regs[ISM330DHCX_EMB_FUNC_STATUS_MAINPAGE] |
+	                          regs[ISM330DHCX_FSM_STATUS_A_MAINPAGE] |
+	                          regs[ISM330DHCX_FSM_STATUS_B_MAINPAGE] |
+	                          regs[ISM330DHCX_MLC_STATUS_MAINPAGE]);
+
+	// H_LACTIVE
+	return (regs[ISM330DHCX_CTRL3_C] & 0x20) ? !active : active;
+}
+
+bool QwSimISM330DHCX::getInt2()
+{
+	const uint8_t* regs = _regs[kUserBank];
+	uint8_t status = regs[ISM330DHCX_STATUS_REG];
+	uint8_t fifo = fifoStatus2();
+	uint8_t ctrl = regs[ISM330DHCX_INT2_CTRL];
+	uint8_t md = regs[ISM330DHCX_MD2_CFG];
+	bool active = false;
+
+	active |= (ctrl & 0x01) && (status & 0x01);
+	active |= (ctrl & 0x02) && (status & 0x02);
+	active |= (ctrl & 0x04) && (status & 0x04);
+	active |= (ctrl & 0x08) && (fifo & 0x80);
+	active |= (ctrl & 0x10) && (fifo & 0x40);
+	active |= (ctrl & 0x20) && (fifo & 0x20);
+	active |= (ctrl & 0x40) && (fifo & 0x10);
+
+	if( regs[ISM330DHCX_TAP_CFG2] & 0x80 )
+	{
+		active |= (md & 0x04) && (regs[ISM330DHCX_D6D_SRC] & 0x40);
+		active |= (md & 0x08) && (regs[ISM330DHCX_TAP_SRC] & 0x10);
+		active |= (md & 0x10) && (regs[ISM330DHCX_WAKE_UP_SRC] & 0x20);
+		active |= (md & 0x20) && (regs[ISM330DHCX_WAKE_UP_SRC] & 0x08);
+		active |= (md & 0x40) && (regs[ISM330DHCX_TAP_SRC] & 0x20);
+		active |= (md & 0x80) && (regs[ISM330DHCX_WAKE_UP_SRC] & 0x40);
+	}
+
+	active |= (md & 0x02) && (regs[ISM330DHCX_EMB_FUNC_STATUS_MAINPAGE] |
+	                          regs[ISM330DHCX_FSM_STATUS_A_MAINPAGE] |
+	                          regs[ISM330DHCX_FSM_STATUS_B_MAINPAGE] |
+	                          regs[ISM330DHCX_MLC_STATUS_MAINPAGE]);
+
+	return (regs[ISM330DHCX_CTRL3_C] & 0x20) ? !active : active;
+}
+
+uint16_t QwSimISM330DHCX::getFifoLevel() const
+{
+	return _fifoCount;
+}
+
+uint8_t QwSimISM330DHCX::peekRegister(uint8_t bank, uint8_t reg) const
+{
+	if( bank > kEmbBank )
+		return 0;
+
+	return _regs[bank][reg & 0x7F];
+}
+
+void QwSimISM330DHCX::pokeRegister(uint8_t bank, uint8_t reg, uint8_t val)
+{
+	if( bank > kEmbBank )
+		return;
+
+	_regs[bank][reg & 0x7F] = val;
+}
+
+uint8_t QwSimISM330DHCX::peekPage(uint8_t page, uint8_t address) const
+{
+	return _pages[page & 0x0F][address];
+}
+
+const QwSimStats& QwSimISM330DHCX::getStats() const
+{
+	return _stats;
+}
+
+void QwSimISM330DHCX::resetStats()
+{
+	memset(&_stats, 0, sizeof(_stats));
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+// QwIDeviceBus implementation
+//
+
+bool QwSimISM330DHCX::ping(uint8_t address)
+{
+	return address == _address;
+}
+
+bool QwSimISM330DHCX::writeRegisterByte(uint8_t address, uint8_t offset, uint8_t data)
+{
+	return writeRegisterRegion(address, offset, &data, 1) == 0;
+}
+
+int QwSimISM330DHCX::writeRegisterRegion(uint8_t address, uint8_t offset, const uint8_t* data, uint16_t length)
+{
+	(void)address;
+	uint8_t reg = offset & 0x7F;
+
+	_stats.numWrites++;
+	_stats.bytesWritten += length;
+
+	for( uint16_t i = 0; i < length; i++ )
+	{
+		if( reg == ISM330DHCX_FUNC_CFG_ACCESS )
+			_stats.numBankWrites++;
+
+		writeRegister(reg, data[i]);
+
+		// IF_INC
+		if( _regs[kUserBank][ISM330DHCX_CTRL3_C] & 0x04 )
+			reg = (reg + 1) & 0x7F;
+	}
+
+	chargeBus(length);
+	return 0;
+}
+
+int QwSimISM330DHCX::readRegisterRegion(uint8_t addr, uint8_t reg, uint8_t* data, uint16_t numBytes)
+{
+	(void)addr;
+	reg &= 0x7F;
+
+	_stats.numReads++;
+	_stats.bytesRead += numBytes;
+
+	for( uint16_t i = 0; i < numBytes; i++ )
+	{
+		data[i] = readRegister(reg);
+
+		if( !(_regs[kUserBank][ISM330DHCX_CTRL3_C] & 0x04) )
+			continue;
+
+		// The FIFO output registers roll back to the tag so words can be read
+		// back to back.
+		if( _bank == kUserBank && reg == ISM330DHCX_FIFO_DATA_OUT_Z_H )
+			reg = ISM330DHCX_FIFO_DATA_OUT_TAG;
+		else
+			reg = (reg + 1) & 0x7F;
+	}
+
+	chargeBus(numBytes);
+	return 0;
+}
+
+void QwSimISM330DHCX::chargeBus(uint16_t numBytes)
+{
+	if( _transactionNs || _byteNs )
+		advance(_transactionNs + (uint64_t)_byteNs * numBytes);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+// readRegister()
+//
+// Reads a register of the selected bank along with any read side effects.
+
+uint8_t QwSimISM330DHCX::readRegister(uint8_t reg)
+{
+	uint8_t* regs = _regs[kUserBank];
+	uint8_t val;
+
+	// FUNC_CFG_ACCESS is visible from every bank
+	if( reg == ISM330DHCX_FUNC_CFG_ACCESS )
+		return regs[reg];
+
+	if( _bank == kEmbBank )
+	{
+		uint8_t* emb = _regs[kEmbBank];
+
+		// Page read through PAGE_VALUE, the page address auto-increments
+		if( reg == ISM330DHCX_PAGE_VALUE && (emb[ISM330DHCX_PAGE_RW] & 0x20) )
+			return _pages[emb[ISM330DHCX_PAGE_SEL] >> 4][emb[ISM330DHCX_PAGE_ADDRESS]++];
+
+		return emb[reg];
+	}
+
+	if( _bank == kHubBank )
+		return _regs[kHubBank][reg];
+
+	switch( reg )
+	{
+		case ISM330DHCX_ALL_INT_SRC:
+			val = regs[reg];
+			regs[ISM330DHCX_ALL_INT_SRC] = 0;
+			regs[ISM330DHCX_WAKE_UP_SRC] = 0;
+			regs[ISM330DHCX_TAP_SRC] = 0;
+			regs[ISM330DHCX_D6D_SRC] &= 0x80;
+			return val;
+
+		case ISM330DHCX_WAKE_UP_SRC:
+			val = regs[reg];
+			regs[reg] = 0;
+			regs[ISM330DHCX_ALL_INT_SRC] &= ~0x23;
+			return val;
+
+		case ISM330DHCX_TAP_SRC:
+			val = regs[reg];
+			regs[reg] = 0;
+			regs[ISM330DHCX_ALL_INT_SRC] &= ~0x0C;
+			return val;
+
+		case ISM330DHCX_D6D_SRC:
+			val = regs[reg];
+			regs[reg] &= 0x80;
+			regs[ISM330DHCX_ALL_INT_SRC] &= ~0x10;
+			return val;
+
+		case ISM330DHCX_OUT_TEMP_L:
+		case ISM330DHCX_OUT_TEMP_H:
+			regs[ISM330DHCX_STATUS_REG] &= ~0x04;
+			return regs[reg];
+
+		case ISM330DHCX_FIFO_STATUS1:
+			return (uint8_t)(_fifoCount & 0xFF);
+
+		case ISM330DHCX_FIFO_STATUS2:
+			val = fifoStatus2();
+			_fifoOverrunLatched = false;
+			_batchCountFlag = false;
+			return val;
+
+		case ISM330DHCX_TIMESTAMP0:
+			_tsLatched = timestampTicks();
+			return (uint8_t)(_tsLatched & 0xFF);
+		case ISM330DHCX_TIMESTAMP1:
+			return (uint8_t)((_tsLatched >> 8) & 0xFF);
+		case ISM330DHCX_TIMESTAMP2:
+			return (uint8_t)((_tsLatched >> 16) & 0xFF);
+		case ISM330DHCX_TIMESTAMP3:
+			return (uint8_t)((_tsLatched >> 24) & 0xFF);
+
+		case ISM330DHCX_FIFO_DATA_OUT_TAG:
+			popFifo();
+			return regs[reg];
+
+		default:
+			break;
+	}
+
+	if( reg >= ISM330DHCX_OUTX_L_G && reg <= ISM330DHCX_OUTZ_H_G )
+		regs[ISM330DHCX_STATUS_REG] &= ~0x02;
+	else if( reg >= ISM330DHCX_OUTX_L_A && reg <= ISM330DHCX_OUTZ_H_A )
+		regs[ISM330DHCX_STATUS_REG] &= ~0x01;
+
+	return regs[reg];
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+// writeRegister()
+//
+// Writes a register of the selected bank, read only registers are ignored.
+
+void QwSimISM330DHCX::writeRegister(uint8_t reg, uint8_t val)
+{
+	uint8_t* regs = _regs[kUserBank];
+	uint8_t old;
+
+	if( reg == ISM330DHCX_FUNC_CFG_ACCESS )
+	{
+		regs[reg] = val & 0xC0;
+		_bank = (val >> 6) > kEmbBank ? kEmbBank : (val >> 6);
+		return;
+	}
+
+	if( _bank == kEmbBank )
+	{
+		uint8_t* emb = _regs[kEmbBank];
+
+		// Page write through PAGE_VALUE, the page address auto-increments
+		if( reg == ISM330DHCX_PAGE_VALUE && (emb[ISM330DHCX_PAGE_RW] & 0x40) )
+		{
+			_pages[emb[ISM330DHCX_PAGE_SEL] >> 4][emb[ISM330DHCX_PAGE_ADDRESS]++] = val;
+			return;
+		}
+
+		emb[reg] = val;
+		return;
+	}
+
+	if( _bank == kHubBank )
+	{
+		_regs[kHubBank][reg] = val;
+		return;
+	}
+
+	switch( reg )
+	{
+		case ISM330DHCX_PIN_CTRL:
+		case ISM330DHCX_FIFO_CTRL1:
+		case ISM330DHCX_FIFO_CTRL2:
+		case ISM330DHCX_COUNTER_BDR_REG2:
+		case ISM330DHCX_INT1_CTRL:
+		case ISM330DHCX_INT2_CTRL:
+		case ISM330DHCX_CTRL4_C:
+		case ISM330DHCX_CTRL5_C:
+		case ISM330DHCX_CTRL6_C:
+		case ISM330DHCX_CTRL7_G:
+		case ISM330DHCX_CTRL8_XL:
+		case ISM330DHCX_CTRL9_XL:
+			regs[reg] = val;
+			return;
+
+		case ISM330DHCX_FIFO_CTRL3:
+			regs[reg] = val;
+			restartFifo();
+			return;
+
+		case ISM330DHCX_FIFO_CTRL4:
+			old = regs[reg];
+			regs[reg] = val;
+
+			// Bypass empties the FIFO and re-arms the trigger
+			if( (val & 0x07) == ISM330DHCX_BYPASS_MODE )
+			{
+				_fifoHead = 0;
+				_fifoCount = 0;
+				_fifoOverrun = false;
+				_fifoTriggered = false;
+			}
+
+			if( (old & 0xF0) != (val & 0xF0) )
+				restartFifo();
+			return;
+
+		case ISM330DHCX_COUNTER_BDR_REG1:
+			// RST_COUNTER_BDR clears itself
+			if( val & 0x40 )
+				_batchCount = 0;
+			regs[reg] = val & ~0x40;
+			return;
+
+		case ISM330DHCX_CTRL1_XL:
+			old = regs[reg];
+			regs[reg] = val;
+			if( (old >> 4) != (val >> 4) )
+			{
+				restartAccel();
+				restartFifo();
+			}
+			return;
+
+		case ISM330DHCX_CTRL2_G:
+			old = regs[reg];
+			regs[reg] = val;
+			if( (old >> 4) != (val >> 4) )
+			{
+				restartGyro();
+				restartFifo();
+			}
+			return;
+
+		case ISM330DHCX_CTRL3_C:
+			if( val & 0x01 )
+			{
+				softReset();
+				return;
+			}
+			// BOOT clears itself once the trimming values are reloaded
+			regs[reg] = val & ~0x80;
+			return;
+
+		case ISM330DHCX_CTRL10_C:
+			old = regs[reg];
+			regs[reg] = val;
+			if( (old ^ val) & 0x20 )
+			{
+				if( val & 0x20 )
+					_tsStart = _now;
+				else
+					_tsOffset = timestampTicks();
+			}
+			return;
+
+		case ISM330DHCX_TIMESTAMP2:
+			// Writing 0xAA resets the timestamp counter
+			if( val == 0xAA )
+			{
+				_tsStart = _now;
+				_tsOffset = 0;
+			}
+			return;
+
+		default:
+			break;
+	}
+
+	if( (reg >= ISM330DHCX_TAP_CFG0 && reg <= ISM330DHCX_MD2_CFG) ||
+	    (reg >= ISM330DHCX_INT_OIS && reg <= ISM330DHCX_Z_OFS_USR) )
+		regs[reg] = val;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+// Sample generation
+//
+
+uint64_t QwSimISM330DHCX::period(float hz) const
+{
+	// A fast oscillator shortens every period
+	double scale = 1.0 + (double)_clockPpm * 1e-6;
+	return (uint64_t)(1e9 / ((double)hz * scale) + 0.5);
+}
+
+uint32_t QwSimISM330DHCX::timestampTicks() const
+{
+	if( !(_regs[kUserBank][ISM330DHCX_CTRL10_C] & 0x20) )
+		return _tsOffset;
+
+	double scale = 1.0 + (double)_clockPpm * 1e-6;
+	return _tsOffset + (uint32_t)((double)(_now - _tsStart) * scale / kTimestampNs);
+}
+
+void QwSimISM330DHCX::restartAccel()
+{
+	uint8_t code = _regs[kUserBank][ISM330DHCX_CTRL1_XL] >> 4;
+
+	_nextAccel = (code && code < 12) ? _now + period(kOdrHz[code]) : kNever;
+
+	if( _nextAccel == kNever && (_regs[kUserBank][ISM330DHCX_CTRL2_G] >> 4) == 0 )
+		_nextTemp = kNever;
+	else if( _nextTemp == kNever || _nextTemp < _now )
+		_nextTemp = _now + period(52.0f);
+}
+
+void QwSimISM330DHCX::restartGyro()
+{
+	uint8_t code = _regs[kUserBank][ISM330DHCX_CTRL2_G] >> 4;
+
+	_nextGyro = (code && code < 11) ? _now + period(kOdrHz[code]) : kNever;
+
+	if( _nextGyro == kNever && (_regs[kUserBank][ISM330DHCX_CTRL1_XL] >> 4) == 0 )
+		_nextTemp = kNever;
+	else if( _nextTemp == kNever || _nextTemp < _now )
+		_nextTemp = _now + period(52.0f);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+// restartFifo()
+//
+// Schedules the batching time slots. A slot runs at the batch rate of the
+// fastest batched sensor and advances the tag counter.
+
+void QwSimISM330DHCX::restartFifo()
+{
+	const uint8_t* regs = _regs[kUserBank];
+	uint8_t bdrXl = regs[ISM330DHCX_FIFO_CTRL3] & 0x0F;
+	uint8_t bdrGy = regs[ISM330DHCX_FIFO_CTRL3] >> 4;
+	uint8_t odrT = (regs[ISM330DHCX_FIFO_CTRL4] >> 4) & 0x03;
+	uint8_t fastest = 0;
+	bool batching = false;
+
+	if( bdrXl && bdrXl < 12 && (regs[ISM330DHCX_CTRL1_XL] >> 4) )
+	{
+		fastest = bdrXl;
+		batching = true;
+	}
+
+	if( bdrGy && bdrGy < 12 && (regs[ISM330DHCX_CTRL2_G] >> 4) )
+	{
+		if( !batching || bdrLevel(bdrGy) > bdrLevel(fastest) )
+			fastest = bdrGy;
+		batching = true;
+	}
+
+	_slot = 0;
+	_nextSlot = batching ? _now + period(kBdrHz[fastest]) : kNever;
+	_nextTempBatch = odrT ? _now + period(kTempBdrHz[odrT]) : kNever;
+}
+
+void QwSimISM330DHCX::sampleAccel()
+{
+	uint8_t* regs = _regs[kUserBank];
+	// FS_XL: 2g, 16g, 4g, 8g
+	static const float kSensitivity[4] = {0.061f, 0.488f, 0.122f, 0.244f};
+	float sens = kSensitivity[(regs[ISM330DHCX_CTRL1_XL] >> 2) & 0x03];
+	float mg[3];
+
+	_source->accel(_now, mg);
+
+	for( uint8_t i = 0; i < 3; i++ )
+		putInt16(&regs[ISM330DHCX_OUTX_L_A + 2 * i], toRaw(mg[i], sens));
+
+	regs[ISM330DHCX_STATUS_REG] |= 0x01;
+}
+
+void QwSimISM330DHCX::sampleGyro()
+{
+	uint8_t* regs = _regs[kUserBank];
+	// FS_G: 250, 500, 1000, 2000 dps with FS_125 and FS_4000 taking priority
+	static const float kSensitivity[4] = {8.75f, 17.5f, 35.0f, 70.0f};
+	uint8_t fs = regs[ISM330DHCX_CTRL2_G] & 0x0F;
+	float sens;
+	float mdps[3];
+
+	if( fs & 0x01 )
+		sens = 140.0f;
+	else if( fs & 0x02 )
+		sens = 4.375f;
+	else
+		sens = kSensitivity[fs >> 2];
+
+	_source->gyro(_now, mdps);
+
+	for( uint8_t i = 0; i < 3; i++ )
+		putInt16(&regs[ISM330DHCX_OUTX_L_G + 2 * i], toRaw(mdps[i], sens));
+
+	regs[ISM330DHCX_STATUS_REG] |= 0x02;
+}
+
+void QwSimISM330DHCX::sampleTemp()
+{
+	uint8_t* regs = _regs[kUserBank];
+
+	// 256 LSB/C with 0 at 25C
+	putInt16(&regs[ISM330DHCX_OUT_TEMP_L], toRaw(_source->temp(_now) - 25.0f, 1.0f / 256.0f));
+	regs[ISM330DHCX_STATUS_REG] |= 0x04;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+// batchSlot()
+//
+// Stores the words of a batching time slot: the timestamp when its decimation
+// is due, then each sensor whose batch rate divides into the slot.
+
+void QwSimISM330DHCX::batchSlot()
+{
+	const uint8_t* regs = _regs[kUserBank];
+	uint8_t bdrXl = regs[ISM330DHCX_FIFO_CTRL3] & 0x0F;
+	uint8_t bdrGy = regs[ISM330DHCX_FIFO_CTRL3] >> 4;
+	bool xlOn = bdrXl && bdrXl < 12 && (regs[ISM330DHCX_CTRL1_XL] >> 4);
+	bool gyOn = bdrGy && bdrGy < 12 && (regs[ISM330DHCX_CTRL2_G] >> 4);
+	uint8_t fastest = 0;
+	uint8_t dec = kTimestampDec[regs[ISM330DHCX_FIFO_CTRL4] >> 6];
+	uint8_t data[6] = {0};
+
+	if( xlOn )
+		fastest = bdrLevel(bdrXl);
+	if( gyOn && bdrLevel(bdrGy) > fastest )
+		fastest = bdrLevel(bdrGy);
+
+	_tagCounter = (_tagCounter + 1) & 0x03;
+
+	if( dec && (regs[ISM330DHCX_CTRL10_C] & 0x20) && (_slot % dec) == 0 )
+	{
+		uint32_t ticks = timestampTicks();
+		data[0] = (uint8_t)(ticks & 0xFF);
+		data[1] = (uint8_t)((ticks >> 8) & 0xFF);
+		data[2] = (uint8_t)((ticks >> 16) & 0xFF);
+		data[3] = (uint8_t)((ticks >> 24) & 0xFF);
+		pushFifo(ISM330DHCX_TIMESTAMP_TAG, data);
+	}
+
+	if( gyOn && (_slot % (1UL << (fastest - bdrLevel(bdrGy)))) == 0 )
+	{
+		sampleGyro();
+		pushFifo(ISM330DHCX_GYRO_NC_TAG, &regs[ISM330DHCX_OUTX_L_G]);
+
+		// TRIG_COUNTER_BDR selects the gyroscope
+		if( regs[ISM330DHCX_COUNTER_BDR_REG1] & 0x20 )
+			_batchCount++;
+	}
+
+	if( xlOn && (_slot % (1UL << (fastest - bdrLevel(bdrXl)))) == 0 )
+	{
+		sampleAccel();
+		pushFifo(ISM330DHCX_XL_NC_TAG, &regs[ISM330DHCX_OUTX_L_A]);
+
+		if( !(regs[ISM330DHCX_COUNTER_BDR_REG1] & 0x20) )
+			_batchCount++;
+	}
+
+	uint16_t threshold = ((regs[ISM330DHCX_COUNTER_BDR_REG1] & 0x07) << 8) |
+	                     regs[ISM330DHCX_COUNTER_BDR_REG2];
+
+	if( threshold && _batchCount >= threshold )
+	{
+		_batchCount = 0;
+		_batchCountFlag = true;
+	}
+
+	_slot++;
+	_nextSlot += period(kBdrHz[fastest == 0 ? 11 : fastest]);
+}
+
+void QwSimISM330DHCX::batchTemp()
+{
+	uint8_t odrT = (_regs[kUserBank][ISM330DHCX_FIFO_CTRL4] >> 4) & 0x03;
+	uint8_t data[6] = {0};
+
+	sampleTemp();
+	memcpy(data, &_regs[kUserBank][ISM330DHCX_OUT_TEMP_L], 2);
+	pushFifo(ISM330DHCX_TEMPERATURE_TAG, data);
+
+	_nextTempBatch += period(kTempBdrHz[odrT]);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+// pushFifo()
+//
+// Stores a tagged word according to the FIFO mode.
+
+void QwSimISM330DHCX::pushFifo(uint8_t tag, const uint8_t* data)
+{
+	uint8_t mode = _regs[kUserBank][ISM330DHCX_FIFO_CTRL4] & 0x07;
+	bool continuous;
+
+	switch( mode )
+	{
+		case ISM330DHCX_FIFO_MODE:
+			continuous = false;
+			break;
+		case ISM330DHCX_STREAM_TO_FIFO_MODE:
+			continuous = !_fifoTriggered;
+			break;
+		case ISM330DHCX_BYPASS_TO_STREAM_MODE:
+			if( !_fifoTriggered )
+				return;
+			continuous = true;
+			break;
+		case ISM330DHCX_STREAM_MODE:
+			continuous = true;
+			break;
+		case ISM330DHCX_BYPASS_TO_FIFO_MODE:
+			if( !_fifoTriggered )
+				return;
+			continuous = false;
+			break;
+		default:
+			return;
+	}
+
+	if( _fifoCount >= fifoCapacity() )
+	{
+		_fifoOverrun = true;
+		_fifoOverrunLatched = true;
+
+		if( !continuous )
+			return;
+
+		// Continuous mode discards the oldest word
+		_fifoHead = (_fifoHead + 1) % kFifoWords;
+		_fifoCount--;
+	}
+
+	uint8_t* word = _fifo[(_fifoHead + _fifoCount) % kFifoWords];
+	uint8_t tagByte = (uint8_t)((tag << 3) | (_tagCounter << 1));
+	uint8_t ones = 0;
+
+	for( uint8_t i = 0; i < 8; i++ )
+		ones += (tagByte >> i) & 0x01;
+
+	// Parity bit keeps an even number of ones in the tag byte
+	word[0] = tagByte | (ones & 0x01);
+	memcpy(&word[1], data, 6);
+	_fifoCount++;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+// popFifo()
+//
+// Moves the oldest word into the FIFO_DATA_OUT registers.
+
+void QwSimISM330DHCX::popFifo()
+{
+	uint8_t* out = &_regs[kUserBank][ISM330DHCX_FIFO_DATA_OUT_TAG];
+
+	if( _fifoCount == 0 )
+	{
+		memset(out, 0, 7);
+		return;
+	}
+
+	memcpy(out, _fifo[_fifoHead], 7);
+	_fifoHead = (_fifoHead + 1) % kFifoWords;
+	_fifoCount--;
+
+	if( _fifoCount < fifoCapacity() )
+		_fifoOverrun = false;
+}
+
+uint16_t QwSimISM330DHCX::fifoCapacity() const
+{
+	// STOP_ON_WTM limits the depth to the watermark
+	if( (_regs[kUserBank][ISM330DHCX_FIFO_CTRL2] & 0x80) && fifoWatermark() )
+		return fifoWatermark();
+
+	return kFifoWords;
+}
+
+uint16_t QwSimISM330DHCX::fifoWatermark() const
+{
+	return ((_regs[kUserBank][ISM330DHCX_FIFO_CTRL2] & 0x01) << 8) |
+	       _regs[kUserBank][ISM330DHCX_FIFO_CTRL1];
+}
+
+uint8_t QwSimISM330DHCX::fifoStatus2() const
+{
+	uint8_t val = (uint8_t)((_fifoCount >> 8) & 0x03);
+	uint16_t watermark = fifoWatermark();
+
+	if( _fifoOverrunLatched )
+		val |= 0x08;
+	if( _batchCountFlag )
+		val |= 0x10;
+	if( _fifoCount >= fifoCapacity() )
+		val |= 0x20;
+	if( _fifoOverrun )
+		val |= 0x40;
+	if( watermark && _fifoCount >= watermark )
+		val |= 0x80;
+
+	return val;
+}
+
+}
+
+#endif // ARDUINO
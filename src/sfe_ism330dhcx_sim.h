@@ -0,0 +1,213 @@
+// sfe_ism330dhcx_sim.h
+//
+// This is a library written for SparkFun Qwiic ISM330DHCX boards
+//
+// SparkFun sells these boards at its website: www.sparkfun.com
+//
+// Do you like this library? Help support SparkFun. Buy a board!
+//
+//SparkFun Qwiic 6DoF - ISM330DHCX        https://www.sparkfun.com/products/19764
+//
+// Repository:
+//     https://github.com/sparkfun/SparkFun_6DoF_ISM330DHCX_Arduino_Library
+//
+//
+// SparkFun code, firmware, and software is released under the MIT
+// License(http://opensource.org/licenses/MIT).
+//
+// SPDX-License-Identifier: MIT
+
+// The following classes describe a software model of the ISM330DHCX that
+// is connected through the same abstract interface (QwIDeviceBus) as the real
+// I2C and SPI buses. It lets the whole QwDevISM330DHCX API, and the ST register
+// layer below it, run on a host machine without hardware or Arduino headers.
+//
+// The model keeps the user, sensor hub and embedded function register banks,
+// switches between them through FUNC_CFG_ACCESS, auto-increments the register
+// address, generates samples at the configured output data rates from a
+// pluggable source and batches them into a tagged FIFO. Time only moves when
+// advance() is called, or per transaction when a bus timing is given.
+//
+// It is only built for host targets.
+
+#pragma once
+
+#ifndef ARDUINO
+
+#include "sfe_bus.h"
+
+namespace sfe_ISM330DHCX {
+
+/**
+ * @brief      Supplies the physical values the simulated sensor measures.
+ *
+ *             The default implementation is a device lying flat and still at
+ *             room temperature. Derive from this class to feed other waveforms.
+ */
+class QwSimSource
+{
+	public:
+
+		virtual ~QwSimSource() {}
+
+		// Acceleration in mg for the X, Y and Z axes
+		virtual void accel(uint64_t timeNs, float* mg);
+
+		// Angular rate in mdps for the X, Y and Z axes
+		virtual void gyro(uint64_t timeNs, float* mdps);
+
+		// Temperature in degrees Celsius
+		virtual float temp(uint64_t timeNs);
+};
+
+// Events that can be injected into the simulated device.
+enum QwSimEvent
+{
+	kSimFreeFall = 0,
+	kSimWakeUp,
+	kSimSingleTap,
+	kSimDoubleTap,
+	kSim6D,
+	kSimSleepChange
+};
+
+// Bus traffic seen by the simulated device.
+struct QwSimStats
+{
+	uint32_t numReads;
+	uint32_t numWrites;
+	uint32_t bytesRead;
+	uint32_t bytesWritten;
+	uint32_t numBankWrites;
+};
+
+/**
+ * @brief      This class describes a simulated ISM330DHCX.
+ *
+ *             Implements the QwIDeviceBus interface so it can be handed to
+ *             QwDevISM330DHCX::setCommunicationBus() in place of a real bus.
+ */
+class QwSimISM330DHCX : public QwIDeviceBus
+{
+	public:
+
+		// FIFO depth in words
+		static const uint16_t kFifoWords = 512;
+
+		QwSimISM330DHCX(uint8_t address = 0x6B);
+
+		// Sets the source of the simulated measurements, nullptr for the default.
+		void setSource(QwSimSource* source);
+
+		// Returns the device to its power on state.
+		void powerOn();
+
+		// Moves simulated time forward, generating samples on the way.
+		void advance(uint64_t ns);
+
+		uint64_t getTime() const;
+
+		// Time charged per bus transaction and per byte transferred. Zero for
+		// both (the default) means transactions take no simulated time.
+		void setBusTiming(uint32_t transactionNs, uint32_t byteNs);
+
+		// Deviation of the device's internal oscillator, in parts per million.
+		void setClockError(int32_t ppm);
+
+		// Sets the timestamp counter, e.g. close to its roll over.
+		void setTimestamp(uint32_t ticks);
+
+		// Sets the event's source bits, drives routed interrupt pins and
+		// triggers the FIFO in the event-triggered modes.
+		void injectEvent(QwSimEvent event);
+
+		bool getInt1();
+		bool getInt2();
+
+		uint16_t getFifoLevel() const;
+
+		// Direct register access that bypasses the bus and its side effects.
+		uint8_t peekRegister(uint8_t bank, uint8_t reg) const;
+		void pokeRegister(uint8_t bank, uint8_t reg, uint8_t val);
+
+		// Byte of an embedded function page, page 0 - 15 as in PAGE_SEL.
+		uint8_t peekPage(uint8_t page, uint8_t address) const;
+
+		const QwSimStats& getStats() const;
+		void resetStats();
+
+		bool ping(uint8_t address);
+
+		bool writeRegisterByte(uint8_t address, uint8_t offset, uint8_t data);
+
+		int writeRegisterRegion(uint8_t address, uint8_t offset, const uint8_t* data, uint16_t length);
+
+		int readRegisterRegion(uint8_t addr, uint8_t reg, uint8_t* data, uint16_t numBytes);
+
+	private:
+
+		uint8_t readRegister(uint8_t reg);
+		void writeRegister(uint8_t reg, uint8_t val);
+		void softReset();
+		void chargeBus(uint16_t numBytes);
+
+		void restartAccel();
+		void restartGyro();
+		void restartFifo();
+		void sampleAccel();
+		void sampleGyro();
+		void sampleTemp();
+		void batchSlot();
+		void batchTemp();
+		void pushFifo(uint8_t tag, const uint8_t* data);
+		void popFifo();
+
+		uint16_t fifoCapacity() const;
+		uint16_t fifoWatermark() const;
+		uint8_t fifoStatus2() const;
+		uint32_t timestampTicks() const;
+		uint64_t period(float hz) const;
+
+		uint8_t _address;
+		QwSimSource _defaultSource;
+		QwSimSource* _source;
+
+		// User, sensor hub and embedded function banks
+		uint8_t _regs[3][128];
+		uint8_t _bank;
+
+		// Embedded function pages written through PAGE_VALUE
+		uint8_t _pages[16][256];
+
+		uint8_t _fifo[kFifoWords][7];
+		uint16_t _fifoHead;
+		uint16_t _fifoCount;
+		bool _fifoOverrun;
+		bool _fifoOverrunLatched;
+		bool _fifoTriggered;
+		uint16_t _batchCount;
+		bool _batchCountFlag;
+
+		uint64_t _now;
+		uint64_t _nextAccel;
+		uint64_t _nextGyro;
+		uint64_t _nextTemp;
+		uint64_t _nextSlot;
+		uint64_t _nextTempBatch;
+		uint32_t _slot;
+		uint8_t _tagCounter;
+
+		uint64_t _tsStart;
+		uint32_t _tsOffset;
+		uint32_t _tsLatched;
+
+		int32_t _clockPpm;
+		uint32_t _transactionNs;
+		uint32_t _byteNs;
+
+		QwSimStats _stats;
+};
+
+};
+
+#endif // ARDUINO
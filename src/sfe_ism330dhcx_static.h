@@ -0,0 +1,265 @@
+// sfe_ism330dhcx_static.h
+//
+// This is a library written for SparkFun Qwiic ISM330DHCX boards
+//
+// SparkFun sells these boards at its website: www.sparkfun.com
+//
+// Do you like this library? Help support SparkFun. Buy a board!
+//
+//SparkFun Qwiic 6DoF - ISM330DHCX        https://www.sparkfun.com/products/19764
+//
+// Repository:
+//     https://github.com/sparkfun/SparkFun_6DoF_ISM330DHCX_Arduino_Library
+//
+//
+// SparkFun code, firmware, and software is released under the MIT
+// License(http://opensource.org/licenses/MIT).
+//
+// SPDX-License-Identifier: MIT
+
+// QwDevISM330DHCXStatic is a QwDevISM330DHCX that knows the type of its bus.
+// The sample, status and FIFO reads call the bus class's readRegisterRegion()
+// directly instead of going through the ST context's function pointers and 
+// the virtual QwIDeviceBus methods. The call is devirtualized, not inlined:
+// the bus methods of QwI2C and SfeSPI are out of line in sfe_bus.cpp, what's 
+// saved are the two indirect calls and the ST wrapper of every read. The FIFO
+// reads share the drain loop of the base class. Everything else is inherited
+// unchanged.
+
+#pragma once
+
+#include "sfe_ism330dhcx.h"
+
+template <class Bus>
+class QwDevISM330DHCXStatic : public QwDevISM330DHCX
+{
+public:
+
+	QwDevISM330DHCXStatic() : _bus{nullptr} {};
+
+	/**
+	 * @brief      Sets the communication bus.
+	 *
+	 * @param      theBus      The Bus object to use
+	 * @param[in]  i2cAddress  The bus i2c address of the target device.
+	 */
+	void setCommunicationBus(Bus &theBus, uint8_t i2cAddress)
+	{
+		QwDevISM330DHCX::setCommunicationBus(theBus, i2cAddress);
+		_bus = &theBus;
+	}
+
+	void setCommunicationBus(Bus &theBus)
+	{
+		QwDevISM330DHCX::setCommunicationBus(theBus);
+		_bus = &theBus;
+	}
+
+	int16_t getTemp()
+	{
+		uint8_t buff[2];
+
+		if( readDirect(ISM330DHCX_OUT_TEMP_L, buff, 2) != 0 )
+			return -1;
+
+		return (int16_t)((buff[1] << 8) | buff[0]);
+	}
+
+	bool getRawAccel(sfe_ism_raw_data_t* accelData)
+	{
+		return readRawData(ISM330DHCX_OUTX_L_A, accelData);
+	}
+
+	bool getRawGyro(sfe_ism_raw_data_t* gyroData)
+	{
+		return readRawData(ISM330DHCX_OUTX_L_G, gyroData);
+	}
+
+	bool getAccel(sfe_ism_data_t* accelData)
+	{
+		sfe_ism_raw_data_t tempVal;
+
+		if( !getRawAccel(&tempVal) )
+			return false;
+
+		return convertAccelData(&tempVal, accelData);
+	}
+
+	bool getGyro(sfe_ism_data_t* gyroData)
+	{
+		sfe_ism_raw_data_t tempVal;
+
+		if( !getRawGyro(&tempVal) )
+			return false;
+
+		return convertGyroData(&tempVal, gyroData);
+	}
+
+	bool getRawAllData(sfe_ism_raw_all_data_t* allData)
+	{
+		// STATUS_REG, (reserved), OUT_TEMP_L/H, OUTX_L_G ... OUTZ_H_A
+		uint8_t buff[16];
+
+		if( readDirect(ISM330DHCX_STATUS_REG, buff, sizeof(buff)) != 0 )
+			return false;
+
+		decodeRawAllData(buff, allData);
+
+		return true;
+	}
+
+	bool getAllData(sfe_ism_all_data_t* allData)
+	{
+		sfe_ism_raw_all_data_t rawData;
+
+		if( !getRawAllData(&rawData) )
+			return false;
+
+		return convertAllData(&rawData, allData);
+	}
+
+	bool getIntAccel(sfe_ism_int_data_t* accelData)
+	{
+		sfe_ism_raw_data_t tempVal;
+
+		if( !getRawAccel(&tempVal) )
+			return false;
+
+		convertIntAccel(&tempVal, accelData);
+		return true;
+	}
+
+	bool getIntGyro(sfe_ism_int_data_t* gyroData)
+	{
+		sfe_ism_raw_data_t tempVal;
+
+		if( !getRawGyro(&tempVal) )
+			return false;
+
+		convertIntGyro(&tempVal, gyroData);
+		return true;
+	}
+
+	bool getIntTemp(int32_t* tempData)
+	{
+		uint8_t buff[2];
+
+		if( readDirect(ISM330DHCX_OUT_TEMP_L, buff, 2) != 0 )
+			return false;
+
+		*tempData = convertIntTemp((int16_t)((buff[1] << 8) | buff[0]));
+		return true;
+	}
+
+	bool getIntAllData(sfe_ism_int_all_data_t* allData)
+	{
+		sfe_ism_raw_all_data_t rawData;
+
+		if( !getRawAllData(&rawData) )
+			return false;
+
+		convertIntAllData(&rawData, allData);
+		return true;
+	}
+
+	// Status
+	bool checkStatus()
+	{
+		return (readStatus() & 0x03) == 0x03;
+	}
+
+	bool checkAccelStatus()
+	{
+		return readStatus() & 0x01;
+	}
+
+	bool checkGyroStatus()
+	{
+		return readStatus() & 0x02;
+	}
+
+	bool checkTempStatus()
+	{
+		return readStatus() & 0x04;
+	}
+
+	// FIFO
+	bool getFifoLevel(uint16_t* level)
+	{
+		uint8_t buff[2];
+
+		if( readDirect(ISM330DHCX_FIFO_STATUS1, buff, 2) != 0 )
+			return false;
+
+		*level = (uint16_t)(((buff[1] & 0x03) << 8) | buff[0]);
+
+		return true;
+	}
+
+	bool readFifo(sfe_ism_fifo_data_t* fifoData, uint16_t maxWords = 0xFFFF)
+	{
+		DirectReader reader = { this };
+
+		if( !beginFifoRead(fifoData) )
+			return false;
+
+		return drainFifo(reader, fifoData, maxWords);
+	}
+
+	bool readFifoRaw(uint8_t* words, uint16_t maxWords, uint16_t* numWords)
+	{
+		DirectReader reader = { this };
+
+		return drainFifoRaw(reader, words, maxWords, numWords);
+	}
+
+protected:
+
+	// A deferred configuration or a bank switch held back by a bank session
+	// has to reach the device before it is read, that path stays with the
+	// base class.
+	int32_t readDirect(uint8_t reg, uint8_t* data, uint16_t length)
+	{
+		if( _deferConfig || _bankSessions > 0 || !_bus )
+			return readRegisterRegion(reg, data, length);
+
+		return _bus->Bus::readRegisterRegion(_i2cAddress, reg, data, length);
+	}
+
+	bool readRawData(uint8_t reg, sfe_ism_raw_data_t* rawData)
+	{
+		uint8_t buff[6];
+
+		if( readDirect(reg, buff, 6) != 0 )
+			return false;
+
+		rawData->xData = (int16_t)((buff[1] << 8) | buff[0]);
+		rawData->yData = (int16_t)((buff[3] << 8) | buff[2]);
+		rawData->zData = (int16_t)((buff[5] << 8) | buff[4]);
+
+		return true;
+	}
+
+	// Chunk reader of drainFifo() through readDirect()
+	struct DirectReader
+	{
+		QwDevISM330DHCXStatic* dev;
+
+		int32_t operator()(uint8_t reg, uint8_t* data, uint16_t length)
+		{
+			return dev->readDirect(reg, data, length);
+		}
+	};
+
+	uint8_t readStatus()
+	{
+		uint8_t status;
+
+		if( readDirect(ISM330DHCX_STATUS_REG, &status, 1) != 0 )
+			return 0;
+
+		return status;
+	}
+
+	Bus* _bus;
+};
@@ -0,0 +1,264 @@
+// sfe_ism_batch.cpp
+//
+// This is a library written for SparkFun Qwiic ISM330DHCX boards
+//
+// SparkFun sells these boards at its website: www.sparkfun.com
+//
+// Do you like this library? Help support SparkFun. Buy a board!
+//
+//SparkFun Qwiic 6DoF - ISM330DHCX        https://www.sparkfun.com/products/19764
+//
+// Repository:
+//     https://github.com/sparkfun/SparkFun_6DoF_ISM330DHCX_Arduino_Library
+//
+//
+// SparkFun code, firmware, and software is released under the MIT
+// License(http://opensource.org/licenses/MIT).
+//
+// SPDX-License-Identifier: MIT
+
+#include "sfe_ism_batch.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#if defined(__SSE4_1__)
+#include <smmintrin.h>
+#endif
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+#if defined(__AVX2__)
+
+// Eight samples are 24 values spread over three vectors. The lanes holding x,
+// y and z in each vector don't overlap, so two blends gather one axis into a
+// vector and a single permute puts it in order.
+#define SFE_ISM_DEINTERLEAVE_X(v0, v1, v2, blend) blend(blend(v0, v1, 0x92), v2, 0x24)
+#define SFE_ISM_DEINTERLEAVE_Y(v0, v1, v2, blend) blend(blend(v0, v1, 0x24), v2, 0x49)
+#define SFE_ISM_DEINTERLEAVE_Z(v0, v1, v2, blend) blend(blend(v0, v1, 0x49), v2, 0x92)
+
+static inline void loadBlock8(const int16_t* raw, __m256i* v0, __m256i* v1, __m256i* v2)
+{
+	*v0 = _mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i*)raw));
+	*v1 = _mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i*)(raw + 8)));
+	*v2 = _mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i*)(raw + 16)));
+}
+
+#elif defined(__SSE2__)
+
+// Four samples are 12 values spread over three vectors.
+static inline void loadBlock4(const int16_t* raw, __m128i* v0, __m128i* v1, __m128i* v2)
+{
+	__m128i lo = _mm_loadu_si128((const __m128i*)raw);
+	__m128i hi = _mm_loadl_epi64((const __m128i*)(raw + 8));
+
+	// Sign extend by placing each value in the upper half of a 32 bit lane
+	*v0 = _mm_srai_epi32(_mm_unpacklo_epi16(lo, lo), 16);
+	*v1 = _mm_srai_epi32(_mm_unpackhi_epi16(lo, lo), 16);
+	*v2 = _mm_srai_epi32(_mm_unpacklo_epi16(hi, hi), 16);
+}
+
+static inline void deinterleave4(__m128 v0, __m128 v1, __m128 v2, __m128* x, __m128* y, __m128* z)
+{
+	__m128 t = _mm_shuffle_ps(v1, v2, _MM_SHUFFLE(2, 1, 3, 2));
+
+	*x = _mm_shuffle_ps(v0, t, _MM_SHUFFLE(2, 0, 3, 0));
+	*y = _mm_shuffle_ps(_mm_shuffle_ps(v0, v1, _MM_SHUFFLE(0, 0, 1, 1)), t, _MM_SHUFFLE(3, 1, 2, 0));
+	*z = _mm_shuffle_ps(_mm_shuffle_ps(v0, v1, _MM_SHUFFLE(1, 1, 2, 2)), v2, _MM_SHUFFLE(3, 0, 2, 0));
+}
+
+#endif
+
+//////////////////////////////////////////////////////////////////////////////
+// sfe_ism_scale_block()
+//
+// Converts "num" interleaved samples to floats multiplied by "scale"
+//
+//  Parameter    Description
+//  ---------   -----------------------------
+//  raw          Interleaved x, y, z input samples
+//  num          Number of samples (triplets)
+//  scale        Multiplier applied to every value
+//  xData        Output buffers of at least "num" values each
+//  yData
+//  zData
+//
+
+void sfe_ism_scale_block(const int16_t* raw, uint16_t num, float scale,
+						float* xData, float* yData, float* zData)
+{
+	uint16_t i = 0;
+
+#if defined(__AVX2__)
+
+	const __m256 vScale = _mm256_set1_ps(scale);
+	const __m256i xIdx = _mm256_setr_epi32(0, 3, 6, 1, 4, 7, 2, 5);
+	const __m256i yIdx = _mm256_setr_epi32(1, 4, 7, 2, 5, 0, 3, 6);
+	const __m256i zIdx = _mm256_setr_epi32(2, 5, 0, 3, 6, 1, 4, 7);
+	__m256i i0, i1, i2;
+	__m256 v0, v1, v2;
+
+	for( ; i + 8 <= num; i += 8, raw += 24 )
+	{
+		loadBlock8(raw, &i0, &i1, &i2);
+
+		v0 = _mm256_mul_ps(_mm256_cvtepi32_ps(i0), vScale);
+		v1 = _mm256_mul_ps(_mm256_cvtepi32_ps(i1), vScale);
+		v2 = _mm256_mul_ps(_mm256_cvtepi32_ps(i2), vScale);
+
+		_mm256_storeu_ps(xData + i, _mm256_permutevar8x32_ps(SFE_ISM_DEINTERLEAVE_X(v0, v1, v2, _mm256_blend_ps), xIdx));
+		_mm256_storeu_ps(yData + i, _mm256_permutevar8x32_ps(SFE_ISM_DEINTERLEAVE_Y(v0, v1, v2, _mm256_blend_ps), yIdx));
+		_mm256_storeu_ps(zData + i, _mm256_permutevar8x32_ps(SFE_ISM_DEINTERLEAVE_Z(v0, v1, v2, _mm256_blend_ps), zIdx));
+	}
+
+#elif defined(__SSE2__)
+
+	const __m128 vScale = _mm_set1_ps(scale);
+	__m128i i0, i1, i2;
+	__m128 x, y, z;
+
+	for( ; i + 4 <= num; i += 4, raw += 12 )
+	{
+		loadBlock4(raw, &i0, &i1, &i2);
+
+		deinterleave4(_mm_cvtepi32_ps(i0), _mm_cvtepi32_ps(i1), _mm_cvtepi32_ps(i2), &x, &y, &z);
+
+		_mm_storeu_ps(xData + i, _mm_mul_ps(x, vScale));
+		_mm_storeu_ps(yData + i, _mm_mul_ps(y, vScale));
+		_mm_storeu_ps(zData + i, _mm_mul_ps(z, vScale));
+	}
+
+#elif defined(__ARM_NEON)
+
+	int16x8x3_t v;
+
+	// vld3 splits the triplets while loading
+	for( ; i + 8 <= num; i += 8, raw += 24 )
+	{
+		v = vld3q_s16(raw);
+
+		vst1q_f32(xData + i, vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_low_s16(v.val[0]))), scale));
+		vst1q_f32(xData + i + 4, vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_high_s16(v.val[0]))), scale));
+		vst1q_f32(yData + i, vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_low_s16(v.val[1]))), scale));
+		vst1q_f32(yData + i + 4, vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_high_s16(v.val[1]))), scale));
+		vst1q_f32(zData + i, vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_low_s16(v.val[2]))), scale));
+		vst1q_f32(zData + i + 4, vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_high_s16(v.val[2]))), scale));
+	}
+
+#else
+
+	// Unrolled by four, this keeps single issue FPUs (Cortex-M4F/M7) busy
+	// between the loads.
+	for( ; i + 4 <= num; i += 4, raw += 12 )
+	{
+		xData[i] = raw[0] * scale;
+		yData[i] = raw[1] * scale;
+		zData[i] = raw[2] * scale;
+		xData[i + 1] = raw[3] * scale;
+		yData[i + 1] = raw[4] * scale;
+		zData[i + 1] = raw[5] * scale;
+		xData[i + 2] = raw[6] * scale;
+		yData[i + 2] = raw[7] * scale;
+		zData[i + 2] = raw[8] * scale;
+		xData[i + 3] = raw[9] * scale;
+		yData[i + 3] = raw[10] * scale;
+		zData[i + 3] = raw[11] * scale;
+	}
+
+#endif
+
+	for( ; i < num; i++, raw += 3 )
+	{
+		xData[i] = raw[0] * scale;
+		yData[i] = raw[1] * scale;
+		zData[i] = raw[2] * scale;
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// sfe_ism_scale_block_int()
+//
+// Converts "num" interleaved samples to int32 values multiplied by "scale"
+//
+//  Parameter    Description
+//  ---------   -----------------------------
+//  raw          Interleaved x, y, z input samples
+//  num          Number of samples (triplets)
+//  scale        Multiplier applied to every value
+//  xData        Output buffers of at least "num" values each
+//  yData
+//  zData
+//
+
+void sfe_ism_scale_block_int(const int16_t* raw, uint16_t num, int32_t scale,
+						int32_t* xData, int32_t* yData, int32_t* zData)
+{
+	uint16_t i = 0;
+
+#if defined(__AVX2__)
+
+	const __m256i vScale = _mm256_set1_epi32(scale);
+	const __m256i xIdx = _mm256_setr_epi32(0, 3, 6, 1, 4, 7, 2, 5);
+	const __m256i yIdx = _mm256_setr_epi32(1, 4, 7, 2, 5, 0, 3, 6);
+	const __m256i zIdx = _mm256_setr_epi32(2, 5, 0, 3, 6, 1, 4, 7);
+	__m256i v0, v1, v2;
+
+	for( ; i + 8 <= num; i += 8, raw += 24 )
+	{
+		loadBlock8(raw, &v0, &v1, &v2);
+
+		v0 = _mm256_mullo_epi32(v0, vScale);
+		v1 = _mm256_mullo_epi32(v1, vScale);
+		v2 = _mm256_mullo_epi32(v2, vScale);
+
+		_mm256_storeu_si256((__m256i*)(xData + i), _mm256_permutevar8x32_epi32(SFE_ISM_DEINTERLEAVE_X(v0, v1, v2, _mm256_blend_epi32), xIdx));
+		_mm256_storeu_si256((__m256i*)(yData + i), _mm256_permutevar8x32_epi32(SFE_ISM_DEINTERLEAVE_Y(v0, v1, v2, _mm256_blend_epi32), yIdx));
+		_mm256_storeu_si256((__m256i*)(zData + i), _mm256_permutevar8x32_epi32(SFE_ISM_DEINTERLEAVE_Z(v0, v1, v2, _mm256_blend_epi32), zIdx));
+	}
+
+#elif defined(__SSE4_1__)
+
+	const __m128i vScale = _mm_set1_epi32(scale);
+	__m128i i0, i1, i2;
+	__m128 x, y, z;
+
+	// The shuffles only move lanes, they work on the integers reinterpreted
+	// as floats.
+	for( ; i + 4 <= num; i += 4, raw += 12 )
+	{
+		loadBlock4(raw, &i0, &i1, &i2);
+
+		deinterleave4(_mm_castsi128_ps(i0), _mm_castsi128_ps(i1), _mm_castsi128_ps(i2), &x, &y, &z);
+
+		_mm_storeu_si128((__m128i*)(xData + i), _mm_mullo_epi32(_mm_castps_si128(x), vScale));
+		_mm_storeu_si128((__m128i*)(yData + i), _mm_mullo_epi32(_mm_castps_si128(y), vScale));
+		_mm_storeu_si128((__m128i*)(zData + i), _mm_mullo_epi32(_mm_castps_si128(z), vScale));
+	}
+
+#elif defined(__ARM_NEON)
+
+	int16x8x3_t v;
+
+	for( ; i + 8 <= num; i += 8, raw += 24 )
+	{
+		v = vld3q_s16(raw);
+
+		vst1q_s32(xData + i, vmulq_n_s32(vmovl_s16(vget_low_s16(v.val[0])), scale));
+		vst1q_s32(xData + i + 4, vmulq_n_s32(vmovl_s16(vget_high_s16(v.val[0])), scale));
+		vst1q_s32(yData + i, vmulq_n_s32(vmovl_s16(vget_low_s16(v.val[1])), scale));
+		vst1q_s32(yData + i + 4, vmulq_n_s32(vmovl_s16(vget_high_s16(v.val[1])), scale));
+		vst1q_s32(zData + i, vmulq_n_s32(vmovl_s16(vget_low_s16(v.val[2])), scale));
+		vst1q_s32(zData + i + 4, vmulq_n_s32(vmovl_s16(vget_high_s16(v.val[2])), scale));
+	}
+
+#endif
+
+	for( ; i < num; i++, raw += 3 )
+	{
+		xData[i] = raw[0] * scale;
+		yData[i] = raw[1] * scale;
+		zData[i] = raw[2] * scale;
+	}
+}
@@ -0,0 +1,36 @@
+// sfe_ism_batch.h
+//
+// This is a library written for SparkFun Qwiic ISM330DHCX boards
+//
+// SparkFun sells these boards at its website: www.sparkfun.com
+//
+// Do you like this library? Help support SparkFun. Buy a board!
+//
+//SparkFun Qwiic 6DoF - ISM330DHCX        https://www.sparkfun.com/products/19764
+//
+// Repository:
+//     https://github.com/sparkfun/SparkFun_6DoF_ISM330DHCX_Arduino_Library
+//
+//
+// SparkFun code, firmware, and software is released under the MIT
+// License(http://opensource.org/licenses/MIT).
+//
+// SPDX-License-Identifier: MIT
+
+// Block conversion of interleaved x, y, z samples (as stored by readFifo() or
+// read from the output registers) into separate x, y and z buffers scaled to
+// physical units. All three axes share one scale factor.
+//
+// The kernels use AVX2, SSE2 (SSE4.1 for the integer version) or NEON when the
+// compiler targets them and fall back to a plain loop otherwise.
+
+#pragma once
+
+#include <stdint.h>
+
+// Interleaved input: raw[3*i] = x, raw[3*i + 1] = y, raw[3*i + 2] = z
+void sfe_ism_scale_block(const int16_t* raw, uint16_t num, float scale,
+						float* xData, float* yData, float* zData);
+
+void sfe_ism_scale_block_int(const int16_t* raw, uint16_t num, int32_t scale,
+						int32_t* xData, int32_t* yData, int32_t* zData);
@@ -0,0 +1,250 @@
+// sfe_ism_clock.cpp
+//
+// This is a library written for SparkFun Qwiic ISM330DHCX boards
+//
+// SparkFun sells these boards at its website: www.sparkfun.com
+//
+// Do you like this library? Help support SparkFun. Buy a board!
+//
+//SparkFun Qwiic 6DoF - ISM330DHCX        https://www.sparkfun.com/products/19764
+//
+// Repository:
+//     https://github.com/sparkfun/SparkFun_6DoF_ISM330DHCX_Arduino_Library
+//
+//
+// SparkFun code, firmware, and software is released under the MIT
+// License(http://opensource.org/licenses/MIT).
+//
+// SPDX-License-Identifier: MIT
+
+#include "sfe_ism_clock.h"
+#include "sfe_ism330dhcx.h"
+
+#if defined(ARDUINO)
+#include <Arduino.h>
+
+// micros() extended past its 71 minute roll over, called at least that often
+static uint64_t defaultHostClock()
+{
+	static uint32_t last = 0;
+	static uint32_t high = 0;
+	uint32_t now = micros();
+
+	if( now < last )
+		high++;
+
+	last = now;
+
+	return ((((uint64_t)high) << 32) | now) * 1000;
+}
+
+#elif defined(__linux__)
+#include <time.h>
+
+static uint64_t defaultHostClock()
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+#else
+#define defaultHostClock nullptr
+#endif
+
+QwISM330DHCXClock::QwISM330DHCXClock() : _hostClock{defaultHostClock}, _forget{1.0 - 1.0 / 32}, _nominalSlope{1.0}
+{
+	reset();
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// reset()
+//
+// Forgets every pair. The window, host clock and nominal rate are kept.
+//
+
+void QwISM330DHCXClock::reset()
+{
+	_numPairs = 0;
+	_lastTicks = 0;
+	_deviceRef = 0;
+	_hostRef = 0;
+	_weight = 0;
+	_meanDevice = 0;
+	_meanHost = 0;
+	_varDevice = 0;
+	_covar = 0;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// setHostClock()
+//
+// Sets the host clock used by QwDevISM330DHCX::syncClock()
+//
+//  Parameter    Description
+//  ---------    -----------------------------
+//  hostClock    Function returning a monotonic time in nanoseconds
+//
+
+void QwISM330DHCXClock::setHostClock(sfe_ism_host_clock_t hostClock)
+{
+	_hostClock = hostClock;
+}
+
+uint64_t QwISM330DHCXClock::hostNow()
+{
+	return _hostClock ? _hostClock() : 0;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// setWindow()
+//
+// Sets how many of the most recent pairs dominate the fit. Longer windows
+// average out more read latency jitter, shorter ones follow temperature
+// driven drift faster.
+//
+//  Parameter    Description
+//  ---------    -----------------------------
+//  pairs        Effective number of pairs, 0 weighs all pairs equally
+//
+
+void QwISM330DHCXClock::setWindow(uint16_t pairs)
+{
+	_forget = pairs ? 1.0 - 1.0 / pairs : 1.0;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// setFreqFine()
+//
+// Sets the rate used until the fit has two pairs from the factory trimmed
+// oscillator deviation. The counter runs at 40kHz * (1 + 0.0015 * freqFine).
+//
+//  Parameter    Description
+//  ---------    -----------------------------
+//  freqFine     INTERNAL_FREQ_FINE
+//
+
+void QwISM330DHCXClock::setFreqFine(int8_t freqFine)
+{
+	_nominalSlope = 1.0 / (1.0 + 0.0015 * freqFine);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// ticksToNs()
+//
+// Converts a 32 bit counter value to device time in ns. The counter rolls
+// over every 29.8 hours, values are placed in the roll over period closest to
+// the last pair.
+//
+//  Parameter    Description
+//  ---------    -----------------------------
+//  deviceTicks  Value of TIMESTAMP0 - TIMESTAMP3
+//
+
+uint64_t QwISM330DHCXClock::ticksToNs(uint32_t deviceTicks)
+{
+	int32_t delta = (int32_t)(deviceTicks - (uint32_t)_lastTicks);
+	int64_t ticks = (int64_t)_lastTicks + delta;
+
+	if( ticks < 0 )
+		ticks = deviceTicks;
+
+	return (uint64_t)ticks * ISM_TIMESTAMP_NS;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// addPair()
+//
+// Adds a device counter value and the host time it was read at to the fit.
+//
+//  Parameter    Description
+//  ---------    -----------------------------
+//  deviceTicks  Value of TIMESTAMP0 - TIMESTAMP3
+//  hostNs       Host time of the read
+//
+
+void QwISM330DHCXClock::addPair(uint32_t deviceTicks, uint64_t hostNs)
+{
+	uint64_t deviceNs = ticksToNs(deviceTicks);
+	double x;
+	double y;
+	double dx;
+
+	_lastTicks = deviceNs / ISM_TIMESTAMP_NS;
+
+	if( _numPairs == 0 )
+	{
+		_deviceRef = deviceNs;
+		_hostRef = hostNs;
+	}
+
+	x = (double)(int64_t)(deviceNs - _deviceRef);
+	y = (double)(int64_t)(hostNs - _hostRef);
+
+	// Exponentially weighted mean and covariance, updated in the numerically
+	// stable (Welford) form.
+	_weight = _weight * _forget + 1.0;
+	dx = x - _meanDevice;
+	_meanDevice += dx / _weight;
+	_meanHost += (y - _meanHost) / _weight;
+	_varDevice = _varDevice * _forget + dx * (x - _meanDevice);
+	_covar = _covar * _forget + dx * (y - _meanHost);
+
+	if( _numPairs < 0xFFFF )
+		_numPairs++;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// slope()
+//
+// Host ns per device ns
+//
+
+double QwISM330DHCXClock::slope()
+{
+	// Pairs closer than a microsecond don't carry a rate
+	if( _numPairs < 2 || _varDevice < 1e6 )
+		return _nominalSlope;
+
+	return _covar / _varDevice;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// toHostNs()
+//
+// Converts a device time to host time, zero before the first pair.
+//
+//  Parameter    Description
+//  ---------    -----------------------------
+//  deviceNs     Device time in ns, e.g. from ticksToNs() or readFifo()
+//
+
+uint64_t QwISM330DHCXClock::toHostNs(uint64_t deviceNs)
+{
+	double x;
+
+	if( _numPairs == 0 )
+		return 0;
+
+	x = (double)(int64_t)(deviceNs - _deviceRef) - _meanDevice;
+
+	return _hostRef + (uint64_t)(int64_t)(_meanHost + slope() * x);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// getSkewPpm()
+//
+// Retrieves how much faster host time passes than device time in ppm
+//
+
+float QwISM330DHCXClock::getSkewPpm()
+{
+	return (float)((slope() - 1.0) * 1e6);
+}
+
+uint16_t QwISM330DHCXClock::getNumPairs()
+{
+	return _numPairs;
+}
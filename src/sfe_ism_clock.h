@@ -0,0 +1,89 @@
+// sfe_ism_clock.h
+//
+// This is a library written for SparkFun Qwiic ISM330DHCX boards
+//
+// SparkFun sells these boards at its website: www.sparkfun.com
+//
+// Do you like this library? Help support SparkFun. Buy a board!
+//
+//SparkFun Qwiic 6DoF - ISM330DHCX        https://www.sparkfun.com/products/19764
+//
+// Repository:
+//     https://github.com/sparkfun/SparkFun_6DoF_ISM330DHCX_Arduino_Library
+//
+//
+// SparkFun code, firmware, and software is released under the MIT
+// License(http://opensource.org/licenses/MIT).
+//
+// SPDX-License-Identifier: MIT
+
+// QwISM330DHCXClock relates the device's timestamp counter to a host clock.
+// QwDevISM330DHCX::syncClock() pairs a read of the counter with the host time
+// around it, the pairs feed an exponentially weighted least squares fit of
+// host time against device time. Any device time, such as the FIFO sample
+// times from readFifo(), can then be converted to host time.
+//
+// Device times are in nanoseconds at the nominal 25us counter period, the fit
+// absorbs the real oscillator rate. Until two pairs have been added the rate
+// reported by INTERNAL_FREQ_FINE is used.
+
+#pragma once
+
+#include <stdint.h>
+
+// Returns a monotonic host time in nanoseconds
+typedef uint64_t (*sfe_ism_host_clock_t)(void);
+
+class QwISM330DHCXClock
+{
+public:
+
+	QwISM330DHCXClock();
+
+	// Forgets every pair, needed after the device's counter was reset
+	void reset();
+
+	// The default host clock is micros() on Arduino and CLOCK_MONOTONIC on
+	// Linux, other targets have to provide one.
+	void setHostClock(sfe_ism_host_clock_t hostClock);
+	uint64_t hostNow();
+
+	// Effective number of recent pairs the fit is weighted over
+	void setWindow(uint16_t pairs);
+
+	// INTERNAL_FREQ_FINE, the oscillator's deviation in steps of 0.15%
+	void setFreqFine(int8_t freqFine);
+
+	void addPair(uint32_t deviceTicks, uint64_t hostNs);
+	uint64_t toHostNs(uint64_t deviceNs);
+
+	// Device time in ns of a counter value, extended to 64 bits against the
+	// last pair.
+	uint64_t ticksToNs(uint32_t deviceTicks);
+
+	// Host ns per device ns minus one, in parts per million
+	float getSkewPpm();
+	uint16_t getNumPairs();
+
+private:
+
+	double slope();
+
+	sfe_ism_host_clock_t _hostClock;
+	double _forget;
+	double _nominalSlope;
+
+	uint16_t _numPairs;
+	uint64_t _lastTicks;
+
+	// First pair, the fit is kept relative to it
+	uint64_t _deviceRef;
+	uint64_t _hostRef;
+
+	// Weighted sums: weight, means and (co)variance
+	double _weight;
+	double _meanDevice;
+	double _meanHost;
+	double _varDevice;
+	double _covar;
+};
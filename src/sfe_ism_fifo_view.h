@@ -0,0 +1,167 @@
+// sfe_ism_fifo_view.h
+//
+// This is a library written for SparkFun Qwiic ISM330DHCX boards
+//
+// SparkFun sells these boards at its website: www.sparkfun.com
+//
+// Do you like this library? Help support SparkFun. Buy a board!
+//
+//SparkFun Qwiic 6DoF - ISM330DHCX        https://www.sparkfun.com/products/19764
+//
+// Repository:
+//     https://github.com/sparkfun/SparkFun_6DoF_ISM330DHCX_Arduino_Library
+//
+//
+// SparkFun code, firmware, and software is released under the MIT
+// License(http://opensource.org/licenses/MIT).
+//
+// SPDX-License-Identifier: MIT
+
+// QwFifoView walks the raw FIFO words QwDevISM330DHCX::readFifoRaw() read into
+// a caller owned buffer. Nothing is copied, a word's fields are decoded from
+// the buffer when they are asked for, so any number of views can walk the
+// same buffer for the cost of a pointer and a count each.
+//
+// Compressed words only hold differences to earlier samples and need the
+// state readFifo() keeps, the view reports them but can't expand them.
+
+#pragma once
+
+#include <stdint.h>
+
+#include "sfe_ism330dhcx.h"
+
+class QwFifoWord
+{
+public:
+
+	QwFifoWord(const uint8_t* word) : _word{word} {};
+
+	// ISM330DHCX_XL_NC_TAG, ISM330DHCX_TIMESTAMP_TAG, ...
+	uint8_t tag() const
+	{
+		return _word[0] >> 3;
+	}
+
+	// Advances with every FIFO time slot, modulo 4
+	uint8_t tagCount() const
+	{
+		return (_word[0] >> 1) & 0x03;
+	}
+
+	// The six data bytes
+	const uint8_t* data() const
+	{
+		return &_word[1];
+	}
+
+	bool isAccel() const
+	{
+		return tag() == ISM330DHCX_XL_NC_TAG;
+	}
+
+	bool isGyro() const
+	{
+		return tag() == ISM330DHCX_GYRO_NC_TAG;
+	}
+
+	bool isCompressed() const
+	{
+		return tag() >= ISM330DHCX_XL_NC_T_2_TAG && tag() <= ISM330DHCX_GYRO_3XC_TAG;
+	}
+
+	// X, Y and Z of an uncompressed accelerometer or gyroscope word
+	void getRaw(sfe_ism_raw_data_t* rawData) const
+	{
+		rawData->xData = value(0);
+		rawData->yData = value(1);
+		rawData->zData = value(2);
+	}
+
+	// Temperature word
+	int16_t getTemp() const
+	{
+		return value(0);
+	}
+
+	// Timestamp counter of a TIMESTAMP word
+	uint32_t getTimestamp() const
+	{
+		return ((uint32_t)_word[4] << 24) | ((uint32_t)_word[3] << 16) |
+		       ((uint32_t)_word[2] << 8) | _word[1];
+	}
+
+	// Sensor hub peripheral 0 - 3 of a SENSORHUB_SLAVE word
+	uint8_t getHubSensor() const
+	{
+		return tag() - ISM330DHCX_SENSORHUB_SLAVE0_TAG;
+	}
+
+private:
+
+	int16_t value(uint8_t axis) const
+	{
+		return (int16_t)((_word[2 + 2 * axis] << 8) | _word[1 + 2 * axis]);
+	}
+
+	const uint8_t* _word;
+};
+
+class QwFifoView
+{
+public:
+
+	class iterator
+	{
+	public:
+
+		iterator(const uint8_t* word) : _word{word} {};
+
+		QwFifoWord operator*() const
+		{
+			return QwFifoWord(_word);
+		}
+
+		iterator& operator++()
+		{
+			_word += ISM_FIFO_WORD_SIZE;
+			return *this;
+		}
+
+		bool operator!=(const iterator& other) const
+		{
+			return _word != other._word;
+		}
+
+	private:
+
+		const uint8_t* _word;
+	};
+
+	QwFifoView(const uint8_t* words, uint16_t numWords) : _words{words}, _numWords{numWords} {};
+
+	iterator begin() const
+	{
+		return iterator(_words);
+	}
+
+	iterator end() const
+	{
+		return iterator(_words + _numWords * ISM_FIFO_WORD_SIZE);
+	}
+
+	uint16_t size() const
+	{
+		return _numWords;
+	}
+
+	QwFifoWord operator[](uint16_t index) const
+	{
+		return QwFifoWord(_words + index * ISM_FIFO_WORD_SIZE);
+	}
+
+private:
+
+	const uint8_t* _words;
+	uint16_t _numWords;
+};
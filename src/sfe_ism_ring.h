@@ -0,0 +1,218 @@
+// sfe_ism_ring.h
+//
+// This is a library written for SparkFun Qwiic ISM330DHCX boards
+//
+// SparkFun sells these boards at its website: www.sparkfun.com
+//
+// Do you like this library? Help support SparkFun. Buy a board!
+//
+//SparkFun Qwiic 6DoF - ISM330DHCX        https://www.sparkfun.com/products/19764
+//
+// Repository:
+//     https://github.com/sparkfun/SparkFun_6DoF_ISM330DHCX_Arduino_Library
+//
+//
+// SparkFun code, firmware, and software is released under the MIT
+// License(http://opensource.org/licenses/MIT).
+//
+// SPDX-License-Identifier: MIT
+
+// QwSampleRing is a fixed capacity single producer, single consumer queue for
+// handing samples from an interrupt (or an IRQ thread on Linux) to the main
+// loop without locks or heap. One context may only push and one other context
+// may only pop.
+//
+// The read and write counters run freely and are only ever written by their
+// own side. They are std::atomic where the toolchain has it, on AVR where a 16
+// bit access isn't atomic they are accessed with interrupts masked. On hosts
+// each counter sits on its own cache line so the two sides don't contend.
+//
+// When the ring is full push() drops the new samples and counts them as
+// overruns, samples that were already queued are never overwritten.
+
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+
+#include "sfe_ism330dhcx.h"
+
+#if defined(ARDUINO_ARCH_AVR)
+#include <util/atomic.h>
+#else
+#include <atomic>
+#endif
+
+#ifndef ISM_CACHE_LINE_SIZE
+#if defined(ARDUINO)
+#define ISM_CACHE_LINE_SIZE 4
+#else
+#define ISM_CACHE_LINE_SIZE 64
+#endif
+#endif
+
+#if defined(ARDUINO_ARCH_AVR)
+
+class QwRingCounter
+{
+public:
+
+	QwRingCounter() : _value{0} {};
+
+	uint16_t load() const
+	{
+		uint16_t value;
+
+		ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+		{
+			value = _value;
+		}
+
+		return value;
+	}
+
+	void store(uint16_t value)
+	{
+		ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+		{
+			_value = value;
+		}
+	}
+
+private:
+
+	volatile uint16_t _value;
+};
+
+typedef uint16_t sfe_ism_ring_count_t;
+
+#else
+
+class QwRingCounter
+{
+public:
+
+	QwRingCounter() : _value{0} {};
+
+	uint32_t load() const
+	{
+		return _value.load(std::memory_order_acquire);
+	}
+
+	void store(uint32_t value)
+	{
+		_value.store(value, std::memory_order_release);
+	}
+
+private:
+
+	std::atomic<uint32_t> _value;
+};
+
+typedef uint32_t sfe_ism_ring_count_t;
+
+#endif
+
+template <class T, uint16_t Capacity>
+class QwSampleRing
+{
+	static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+public:
+
+	QwSampleRing() {};
+
+	////////////////////////////////////////////////////////////////////////
+	// Producer side
+
+	bool push(const T& item)
+	{
+		return push(&item, 1) == 1;
+	}
+
+	// Queues as many of "count" items as fit and returns that number
+	uint16_t push(const T* items, uint16_t count)
+	{
+		sfe_ism_ring_count_t head = _head.load();
+		uint16_t space = (uint16_t)(Capacity - (sfe_ism_ring_count_t)(head - _tail.load()));
+		uint16_t n = count < space ? count : space;
+
+		copyIn(head, items, n);
+		_head.store((sfe_ism_ring_count_t)(head + n));
+
+		if( n < count )
+			_overruns.store((sfe_ism_ring_count_t)(_overruns.load() + count - n));
+
+		return n;
+	}
+
+	////////////////////////////////////////////////////////////////////////
+	// Consumer side
+
+	bool pop(T* item)
+	{
+		return pop(item, 1) == 1;
+	}
+
+	// Removes up to "maxCount" items and returns the number removed
+	uint16_t pop(T* items, uint16_t maxCount)
+	{
+		sfe_ism_ring_count_t tail = _tail.load();
+		uint16_t used = (uint16_t)(sfe_ism_ring_count_t)(_head.load() - tail);
+		uint16_t n = maxCount < used ? maxCount : used;
+
+		copyOut(tail, items, n);
+		_tail.store((sfe_ism_ring_count_t)(tail + n));
+
+		return n;
+	}
+
+	////////////////////////////////////////////////////////////////////////
+	// Either side
+
+	uint16_t size() const
+	{
+		return (uint16_t)(sfe_ism_ring_count_t)(_head.load() - _tail.load());
+	}
+
+	uint16_t capacity() const
+	{
+		return Capacity;
+	}
+
+	// Items push() had no room for, counted by the producer
+	uint32_t getOverruns() const
+	{
+		return _overruns.load();
+	}
+
+private:
+
+	// Copies in at most two pieces, before and after the wrap
+	void copyIn(sfe_ism_ring_count_t head, const T* items, uint16_t n)
+	{
+		uint16_t start = head & (Capacity - 1);
+		uint16_t first = n < Capacity - start ? n : Capacity - start;
+
+		memcpy(&_items[start], items, first * sizeof(T));
+		memcpy(&_items[0], items + first, (n - first) * sizeof(T));
+	}
+
+	void copyOut(sfe_ism_ring_count_t tail, T* items, uint16_t n)
+	{
+		uint16_t start = tail & (Capacity - 1);
+		uint16_t first = n < Capacity - start ? n : Capacity - start;
+
+		memcpy(items, &_items[start], first * sizeof(T));
+		memcpy(items + first, &_items[0], (n - first) * sizeof(T));
+	}
+
+	// Written by the producer
+	alignas(ISM_CACHE_LINE_SIZE) QwRingCounter _head;
+	QwRingCounter _overruns;
+
+	// Written by the consumer
+	alignas(ISM_CACHE_LINE_SIZE) QwRingCounter _tail;
+
+	alignas(ISM_CACHE_LINE_SIZE) T _items[Capacity];
+};
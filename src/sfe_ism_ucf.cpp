@@ -0,0 +1,196 @@
+// sfe_ism_ucf.cpp
+//
+// This is a library written for SparkFun Qwiic ISM330DHCX boards
+//
+// SparkFun sells these boards at its website: www.sparkfun.com
+//
+// Do you like this library? Help support SparkFun. Buy a board!
+//
+//SparkFun Qwiic 6DoF - ISM330DHCX        https://www.sparkfun.com/products/19764
+//
+// Repository:
+//     https://github.com/sparkfun/SparkFun_6DoF_ISM330DHCX_Arduino_Library
+//
+//
+// SparkFun code, firmware, and software is released under the MIT
+// License(http://opensource.org/licenses/MIT).
+//
+// SPDX-License-Identifier: MIT
+
+#include "sfe_ism_ucf.h"
+#include <string.h>
+
+#if defined(ARDUINO)
+#include <Arduino.h>
+#elif defined(__linux__)
+#include <time.h>
+#endif
+
+//////////////////////////////////////////////////////////////////////////////
+// next()
+//
+// Parses the next line that writes a register or waits. Blank lines and
+// comments are skipped, any other line is an error.
+//
+//  Parameter    Description
+//  ---------    -----------------------------
+//  line         Register and value of an "Ac" line
+//  waitMs       Milliseconds of a "WAIT" line
+//
+// Returns ISM_UCF_WRITE, ISM_UCF_WAIT, ISM_UCF_END or ISM_UCF_ERROR
+//
+
+uint8_t QwUcfReader::next(sfe_ism_ucf_line_t* line, uint16_t* waitMs)
+{
+	uint32_t ms;
+
+	while( *_text )
+	{
+		_line++;
+
+		while( *_text == ' ' || *_text == '\t' )
+			_text++;
+
+		if( _text[0] == 'A' && _text[1] == 'c' )
+		{
+			_text += 2;
+
+			if( !parseHex(&line->address) || !parseHex(&line->data) || !endOfLine() )
+				return ISM_UCF_ERROR;
+
+			return ISM_UCF_WRITE;
+		}
+
+		if( strncmp(_text, "WAIT", 4) == 0 )
+		{
+			_text += 4;
+
+			while( *_text == ' ' || *_text == '\t' )
+				_text++;
+
+			if( *_text < '0' || *_text > '9' )
+				return ISM_UCF_ERROR;
+
+			for( ms = 0; *_text >= '0' && *_text <= '9'; _text++ )
+			{
+				ms = ms * 10 + (*_text - '0');
+
+				if( ms > 0xFFFF )
+					return ISM_UCF_ERROR;
+			}
+
+			if( !endOfLine() )
+				return ISM_UCF_ERROR;
+
+			*waitMs = (uint16_t)ms;
+			return ISM_UCF_WAIT;
+		}
+
+		if( _text[0] == '-' && _text[1] == '-' )
+		{
+			while( *_text && *_text != '\n' )
+				_text++;
+		}
+
+		if( !endOfLine() )
+			return ISM_UCF_ERROR;
+	}
+
+	return ISM_UCF_END;
+}
+
+uint16_t QwUcfReader::getLine()
+{
+	return _line;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// parseHex()
+//
+// Parses a byte of one or two hex digits after white space.
+//
+
+bool QwUcfReader::parseHex(uint8_t* val)
+{
+	uint8_t digits = 0;
+	uint8_t digit;
+	char c;
+
+	if( *_text != ' ' && *_text != '\t' )
+		return false;
+
+	while( *_text == ' ' || *_text == '\t' )
+		_text++;
+
+	for( *val = 0; ; _text++ )
+	{
+		c = *_text;
+
+		if( c >= '0' && c <= '9' )
+			digit = c - '0';
+		else if( c >= 'A' && c <= 'F' )
+			digit = c - 'A' + 10;
+		else if( c >= 'a' && c <= 'f' )
+			digit = c - 'a' + 10;
+		else
+			break;
+
+		if( ++digits > 2 )
+			return false;
+
+		*val = (*val << 4) | digit;
+	}
+
+	return digits > 0;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// endOfLine()
+//
+// Skips trailing white space and the line break.
+//
+
+bool QwUcfReader::endOfLine()
+{
+	while( *_text == ' ' || *_text == '\t' || *_text == '\r' )
+		_text++;
+
+	if( *_text == '\n' )
+	{
+		_text++;
+		return true;
+	}
+
+	return *_text == '\0';
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// wait()
+//
+// Pauses for a WAIT line.
+//
+//  Parameter    Description
+//  ---------    -----------------------------
+//  ms           Milliseconds to wait
+//
+
+bool QwUcfReader::wait(uint16_t ms)
+{
+#if defined(ARDUINO)
+	delay(ms);
+	return true;
+#elif defined(__linux__)
+	struct timespec ts;
+
+	ts.tv_sec = ms / 1000;
+	ts.tv_nsec = (long)(ms % 1000) * 1000000L;
+
+	while( nanosleep(&ts, &ts) != 0 )
+		;
+
+	return true;
+#else
+	(void)ms;
+	return false;
+#endif
+}
@@ -0,0 +1,71 @@
+// sfe_ism_ucf.h
+//
+// This is a library written for SparkFun Qwiic ISM330DHCX boards
+//
+// SparkFun sells these boards at its website: www.sparkfun.com
+//
+// Do you like this library? Help support SparkFun. Buy a board!
+//
+//SparkFun Qwiic 6DoF - ISM330DHCX        https://www.sparkfun.com/products/19764
+//
+// Repository:
+//     https://github.com/sparkfun/SparkFun_6DoF_ISM330DHCX_Arduino_Library
+//
+//
+// SparkFun code, firmware, and software is released under the MIT
+// License(http://opensource.org/licenses/MIT).
+//
+// SPDX-License-Identifier: MIT
+
+// ST's Unico tools export Machine Learning Core and FSM programs as UCF files,
+// the register writes that configure the device. Every write is a line
+// "Ac <register> <value>" in hex, "WAIT <ms>" lines pause the sequence and
+// lines starting with "--" are comments.
+//
+// QwUcfReader walks UCF text, e.g. a file embedded as a string or received at
+// run time, one write at a time without copying it. For programs known at
+// build time the headers ST generates from UCF files hold the same writes as
+// an array of register and value pairs, those can be passed to
+// QwDevISM330DHCX::loadUcf() directly.
+
+#pragma once
+
+#include <stdint.h>
+
+// One "Ac" line. Laid out like ucf_line_t of ST's generated headers.
+struct sfe_ism_ucf_line_t
+{
+	uint8_t address;
+	uint8_t data;
+};
+
+// What QwUcfReader::next() found
+#define ISM_UCF_END    0
+#define ISM_UCF_WRITE  1
+#define ISM_UCF_WAIT   2
+#define ISM_UCF_ERROR  3
+
+class QwUcfReader
+{
+public:
+
+	QwUcfReader(const char* text) : _text{text}, _line{0} {};
+
+	// Parses the next write or wait, skipping comments and blank lines
+	uint8_t next(sfe_ism_ucf_line_t* line, uint16_t* waitMs);
+
+	// Line number of the last write, wait or error, starting at 1
+	uint16_t getLine();
+
+	// Pauses for a WAIT line. delay() on Arduino and nanosleep() on Linux,
+	// false on other targets.
+	static bool wait(uint16_t ms);
+
+private:
+
+	bool parseHex(uint8_t* val);
+	bool endOfLine();
+
+	const char* _text;
+	uint16_t _line;
+};
@@ -0,0 +1,24 @@
+// Arduino.h
+//
+// The parts of the Arduino core sfe_bus.cpp uses, so the Arduino buses build
+// on the host against the mock SPIClass and TwoWire in SPI.h and Wire.h.
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+#define LOW 0
+#define HIGH 1
+
+#define MSBFIRST 1
+#define SPI_MODE3 3
+
+// Forwards chip select changes to the mock SPI port
+void digitalWrite(uint8_t pin, uint8_t val);
+
+inline void delay(unsigned long ms)
+{
+	(void)ms;
+}
@@ -0,0 +1,111 @@
+// SPI.h
+//
+// Mock SPIClass for the host tests. It counts the calls the driver makes and
+// answers like the device: the first byte after chip select is the register,
+// bit 7 set for a read, the following bytes read or write a 128 byte register
+// file with auto increment.
+
+#pragma once
+
+#include "Arduino.h"
+
+// Chip select pin the tests hand to SfeSPI
+#define MOCK_SPI_CS 10
+
+class SPISettings
+{
+public:
+	SPISettings() {}
+	SPISettings(uint32_t clock, uint8_t bitOrder, uint8_t dataMode)
+	{
+		(void)clock;
+		(void)bitOrder;
+		(void)dataMode;
+	}
+};
+
+struct SPIMockStats
+{
+	uint32_t numTransactions;	// beginTransaction() calls
+	uint32_t numByteTransfers;	// transfer(uint8_t) calls
+	uint32_t numBufferTransfers;	// transfer(void*, size_t) calls
+	uint32_t bytesTransferred;
+};
+
+class SPIClass
+{
+public:
+
+	SPIClass() : stats{}, registers{}, _selected{false}, _haveRegister{false}, _read{false}, _reg{0} {}
+
+	void begin() {}
+
+	void beginTransaction(SPISettings settings)
+	{
+		(void)settings;
+		stats.numTransactions++;
+	}
+
+	void endTransaction() {}
+
+	uint8_t transfer(uint8_t data)
+	{
+		stats.numByteTransfers++;
+		return exchange(data);
+	}
+
+	void transfer(void* buffer, size_t length)
+	{
+		uint8_t* data = (uint8_t*)buffer;
+
+		stats.numBufferTransfers++;
+
+		for( size_t i = 0; i < length; i++ )
+			data[i] = exchange(data[i]);
+	}
+
+	// Called through digitalWrite() of the chip select pin
+	void select(bool selected)
+	{
+		_selected = selected;
+		_haveRegister = false;
+	}
+
+	SPIMockStats stats;
+	uint8_t registers[128];
+
+private:
+
+	uint8_t exchange(uint8_t data)
+	{
+		uint8_t ret = 0;
+
+		stats.bytesTransferred++;
+
+		if( !_selected )
+			return 0xFF;
+
+		if( !_haveRegister )
+		{
+			_reg = data & 0x7F;
+			_read = (data & 0x80) != 0;
+			_haveRegister = true;
+			return 0;
+		}
+
+		if( _read )
+			ret = registers[_reg];
+		else
+			registers[_reg] = data;
+
+		_reg = (_reg + 1) & 0x7F;
+		return ret;
+	}
+
+	bool _selected;
+	bool _haveRegister;
+	bool _read;
+	uint8_t _reg;
+};
+
+extern SPIClass SPI;
@@ -0,0 +1,23 @@
+// Wire.h
+//
+// TwoWire stand in so QwI2C builds on the host, it acknowledges nothing.
+
+#pragma once
+
+#include "Arduino.h"
+
+#define BUFFER_LENGTH 32
+
+class TwoWire
+{
+public:
+	void begin() {}
+	void beginTransmission(uint8_t address) { (void)address; }
+	size_t write(uint8_t data) { (void)data; return 1; }
+	size_t write(const uint8_t* data, size_t length) { (void)data; return length; }
+	uint8_t endTransmission(bool stop = true) { (void)stop; return 2; }
+	uint8_t requestFrom(int address, int length, int stop) { (void)address; (void)length; (void)stop; return 0; }
+	int read() { return -1; }
+};
+
+extern TwoWire Wire;
@@ -0,0 +1,16 @@
+// arduino.cpp
+//
+// Instances of the mock Arduino core.
+
+#include "Arduino.h"
+#include "SPI.h"
+#include "Wire.h"
+
+SPIClass SPI;
+TwoWire Wire;
+
+void digitalWrite(uint8_t pin, uint8_t val)
+{
+	if( pin == MOCK_SPI_CS )
+		SPI.select(val == LOW);
+}
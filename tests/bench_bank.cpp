@@ -0,0 +1,145 @@
+// bench_bank.cpp
+//
+// Bus transactions of sensor hub operations on the simulated device. "before"
+// runs the same ST calls through a plain ST context as the driver did before 
+// it tracked the register bank, every bank switch a read and a write of 
+// FUNC_CFG_ACCESS. "after" goes through QwDevISM330DHCX, which skips switches
+// to the selected bank and holds back the switches of a bank session. The
+// driver's counts are checked so a regression fails the benchmark.
+
+#include "sfe_ism330dhcx.h"
+#include "sfe_ism330dhcx_sim.h"
+#include "test_util.h"
+
+using namespace sfe_ISM330DHCX;
+
+#define BENCH_ROUNDS 100
+
+static int32_t plainWrite(void* handle, uint8_t reg, const uint8_t* data, uint16_t length)
+{
+	return ((QwSimISM330DHCX*)handle)->writeRegisterRegion(ISM330DHCX_ADDRESS_HIGH, reg, data, length);
+}
+
+static int32_t plainRead(void* handle, uint8_t reg, uint8_t* data, uint16_t length)
+{
+	return ((QwSimISM330DHCX*)handle)->readRegisterRegion(ISM330DHCX_ADDRESS_HIGH, reg, data, length);
+}
+
+static double takeTransactions(QwSimISM330DHCX& sim)
+{
+	double n = (double)(sim.getStats().numReads + sim.getStats().numWrites) / BENCH_ROUNDS;
+
+	sim.resetStats();
+	return n;
+}
+
+static void report(const char* name, double before, double after)
+{
+	if( before > 0 )
+		printf("%-36s transactions before %5.1f  after %5.1f\n", name, before, after);
+	else
+		printf("%-36s transactions before     -  after %5.1f\n", name, after);
+}
+
+int main()
+{
+	QwSimISM330DHCX sim;
+	QwDevISM330DHCX dev;
+	stmdev_ctx_t plain = { plainWrite, plainRead, &sim };
+	sfe_hub_sensor_settings_t settings = { 0x30, 0x00, 6 };
+	ism330dhcx_sh_cfg_read_t plainSettings = { 0x30, 0x00, 6 };
+	ism330dhcx_status_master_t status;
+	uint8_t data[6];
+	double before;
+	double after;
+
+	dev.setCommunicationBus(sim, ISM330DHCX_ADDRESS_HIGH);
+	dev.init();
+	sim.resetStats();
+
+	// One sensor hub read
+	for( int i = 0; i < BENCH_ROUNDS; i++ )
+		ism330dhcx_sh_read_data_raw_get(&plain, (ism330dhcx_emb_sh_read_t*)data, 6);
+	before = takeTransactions(sim);
+
+	for( int i = 0; i < BENCH_ROUNDS; i++ )
+		dev.readPeripheralSensor(data, 6);
+	after = takeTransactions(sim);
+
+	report("readPeripheralSensor()", before, after);
+	CHECK_EQ(after, 3);
+
+	// Configuring two hub sensors
+	for( int i = 0; i < BENCH_ROUNDS; i++ )
+	{
+		ism330dhcx_sh_slv0_cfg_read(&plain, &plainSettings);
+		ism330dhcx_sh_slv1_cfg_read(&plain, &plainSettings);
+		ism330dhcx_sh_slave_connected_set(&plain, ISM330DHCX_SLV_0_1);
+		ism330dhcx_sh_data_rate_set(&plain, ISM330DHCX_SH_ODR_104Hz);
+	}
+	before = takeTransactions(sim);
+
+	for( int i = 0; i < BENCH_ROUNDS; i++ )
+	{
+		dev.setHubSensorRead(0, &settings);
+		dev.setHubSensorRead(1, &settings);
+		dev.setNumberHubSensors(2);
+		dev.setHubODR(ISM_SH_ODR_104Hz);
+	}
+	after = takeTransactions(sim);
+
+	report("4 hub setters", before, after);
+	CHECK_EQ(after, 20);
+
+	for( int i = 0; i < BENCH_ROUNDS; i++ )
+	{
+		dev.beginBankSession(ISM330DHCX_SENSOR_HUB_BANK);
+		dev.setHubSensorRead(0, &settings);
+		dev.setHubSensorRead(1, &settings);
+		dev.setNumberHubSensors(2);
+		dev.setHubODR(ISM_SH_ODR_104Hz);
+		dev.endBankSession();
+	}
+	after = takeTransactions(sim);
+
+	report("  ... in one bank session", 0, after);
+	CHECK_EQ(after, 14);
+
+	// Reading two hub sensors and the hub status
+	for( int i = 0; i < BENCH_ROUNDS; i++ )
+	{
+		ism330dhcx_sh_read_data_raw_get(&plain, (ism330dhcx_emb_sh_read_t*)data, 6);
+		ism330dhcx_sh_read_data_raw_get(&plain, (ism330dhcx_emb_sh_read_t*)data, 6);
+		ism330dhcx_sh_status_get(&plain, &status);
+	}
+	before = takeTransactions(sim);
+
+	for( int i = 0; i < BENCH_ROUNDS; i++ )
+	{
+		dev.readPeripheralSensor(data, 6);
+		dev.readPeripheralSensor(data, 6);
+		dev.getHubStatus();
+	}
+	after = takeTransactions(sim);
+
+	report("2 reads + getHubStatus()", before, after);
+
+	for( int i = 0; i < BENCH_ROUNDS; i++ )
+	{
+		dev.beginBankSession(ISM330DHCX_SENSOR_HUB_BANK);
+		dev.readPeripheralSensor(data, 6);
+		dev.readPeripheralSensor(data, 6);
+		dev.getHubStatus();
+		dev.endBankSession();
+	}
+	after = takeTransactions(sim);
+
+	report("  ... in one bank session", 0, after);
+	CHECK_EQ(after, 5);
+
+	// Every path leaves the user bank selected
+	CHECK_EQ(sim.peekRegister(ISM330DHCX_USER_BANK, ISM330DHCX_FUNC_CFG_ACCESS), 0);
+	CHECK_EQ(dev.getUniqueId(), ISM330DHCX_ID);
+
+	return testResult("bench_bank");
+}
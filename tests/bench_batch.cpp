@@ -0,0 +1,105 @@
+// bench_batch.cpp
+//
+// Host time per sample of the block conversions of sfe_ism_batch.cpp at 64, 
+// 512 and 4096 samples, next to a plain per sample loop. Build with e.g. 
+// OPT="-O2 -mavx2" for the other x86 kernels.
+
+#include "sfe_ism_batch.h"
+#include "test_util.h"
+#include <stdlib.h>
+
+#define BENCH_MAX_SAMPLES 4096
+// Samples converted per measurement, whatever the block size
+#define BENCH_TOTAL_SAMPLES (1 << 24)
+
+static int16_t raw[3 * BENCH_MAX_SAMPLES];
+static float xData[BENCH_MAX_SAMPLES];
+static float yData[BENCH_MAX_SAMPLES];
+static float zData[BENCH_MAX_SAMPLES];
+static int32_t xInt[BENCH_MAX_SAMPLES];
+static int32_t yInt[BENCH_MAX_SAMPLES];
+static int32_t zInt[BENCH_MAX_SAMPLES];
+
+// Keeps the conversions from being optimized away
+static volatile float sink;
+
+__attribute__((noinline))
+static void loopBlock(const int16_t* in, uint16_t num, float scale, float* x, float* y, float* z)
+{
+	for( uint16_t i = 0; i < num; i++, in += 3 )
+	{
+		x[i] = in[0] * scale;
+		y[i] = in[1] * scale;
+		z[i] = in[2] * scale;
+	}
+}
+
+__attribute__((noinline))
+static void loopBlockInt(const int16_t* in, uint16_t num, int32_t scale, int32_t* x, int32_t* y, int32_t* z)
+{
+	for( uint16_t i = 0; i < num; i++, in += 3 )
+	{
+		x[i] = in[0] * scale;
+		y[i] = in[1] * scale;
+		z[i] = in[2] * scale;
+	}
+}
+
+static void bench(uint16_t num)
+{
+	uint32_t rounds = BENCH_TOTAL_SAMPLES / num;
+	uint64_t start;
+	double kernel;
+	double loop;
+	double kernelInt;
+	double loopInt;
+
+	start = benchNowNs();
+	for( uint32_t r = 0; r < rounds; r++ )
+	{
+		sfe_ism_scale_block(raw, num, 0.061f, xData, yData, zData);
+		sink = xData[r % num];
+	}
+	kernel = (double)(benchNowNs() - start) / rounds / num;
+
+	start = benchNowNs();
+	for( uint32_t r = 0; r < rounds; r++ )
+	{
+		loopBlock(raw, num, 0.061f, xData, yData, zData);
+		sink = xData[r % num];
+	}
+	loop = (double)(benchNowNs() - start) / rounds / num;
+
+	start = benchNowNs();
+	for( uint32_t r = 0; r < rounds; r++ )
+	{
+		sfe_ism_scale_block_int(raw, num, 61, xInt, yInt, zInt);
+		sink = (float)xInt[r % num];
+	}
+	kernelInt = (double)(benchNowNs() - start) / rounds / num;
+
+	start = benchNowNs();
+	for( uint32_t r = 0; r < rounds; r++ )
+	{
+		loopBlockInt(raw, num, 61, xInt, yInt, zInt);
+		sink = (float)xInt[r % num];
+	}
+	loopInt = (double)(benchNowNs() - start) / rounds / num;
+
+	printf("%4u samples  float %5.2f ns/sample (loop %5.2f)  int %5.2f ns/sample (loop %5.2f)\n",
+		num, kernel, loop, kernelInt, loopInt);
+}
+
+int main()
+{
+	srand(1);
+
+	for( int i = 0; i < 3 * BENCH_MAX_SAMPLES; i++ )
+		raw[i] = (int16_t)(rand() & 0xFFFF);
+
+	bench(64);
+	bench(512);
+	bench(4096);
+
+	return 0;
+}
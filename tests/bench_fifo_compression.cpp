@@ -0,0 +1,89 @@
+// bench_fifo_compression.cpp
+//
+// Bus bytes per sample and host decode time of readFifo() with and without 
+// FIFO compression, for a device at rest, slow motion and fast motion. The 
+// streams are built by FifoStreamBus's model of the compressor.
+
+#include "fifo_stream.h"
+#include "test_util.h"
+#include <stdlib.h>
+
+using namespace sfe_ISM330DHCX;
+
+// Fits the 10 bit FIFO level
+#define BENCH_SAMPLES 960
+#define BENCH_ROUNDS 500
+
+static sfe_ism_raw_data_t samples[BENCH_SAMPLES];
+static sfe_ism_raw_data_t accel[BENCH_SAMPLES];
+
+static void makeSignal(int noise, int slope)
+{
+	for( int i = 0; i < BENCH_SAMPLES; i++ )
+	{
+		samples[i].xData = (int16_t)(slope * (i % 64) + rand() % (2 * noise + 1) - noise);
+		samples[i].yData = (int16_t)(-slope * (i % 64) + rand() % (2 * noise + 1) - noise);
+		samples[i].zData = (int16_t)(8192 + rand() % (2 * noise + 1) - noise);
+	}
+}
+
+static void bench(const char* name, bool compress)
+{
+	FifoStreamBus bus;
+	QwDevISM330DHCX dev;
+	sfe_ism_fifo_data_t fifo = {};
+	uint16_t words;
+	uint64_t start;
+	uint64_t elapsed;
+
+	fifo.accelData = accel;
+	fifo.accelSize = BENCH_SAMPLES;
+
+	bus.setBatchRates(0x06);
+	bus.addSamples(false, 0, samples, BENCH_SAMPLES, compress);
+	words = bus.getLevel();
+
+	dev.setCommunicationBus(bus, ISM330DHCX_ADDRESS_HIGH);
+
+	start = benchNowNs();
+
+	for( int round = 0; round < BENCH_ROUNDS; round++ )
+	{
+		bus.rewind();
+		dev.resetFifoDecoder();
+		dev.readFifo(&fifo);
+	}
+
+	elapsed = benchNowNs() - start;
+
+	printf("%-12s %-12s %4u words  %5.2f bus bytes/sample  %5.1f ns/sample%s\n",
+		name, compress ? "compressed" : "plain", words,
+		(double)bus.bytesRead / BENCH_ROUNDS / BENCH_SAMPLES,
+		(double)elapsed / BENCH_ROUNDS / BENCH_SAMPLES,
+		fifo.numAccel == BENCH_SAMPLES ? "" : "  (samples lost)");
+}
+
+int main()
+{
+	static const struct
+	{
+		const char* name;
+		int noise;
+		int slope;
+	} signals[] = {
+		{ "at rest", 3, 0 },
+		{ "slow motion", 10, 40 },
+		{ "fast motion", 400, 0 },
+	};
+
+	srand(1);
+
+	for( const auto& signal : signals )
+	{
+		makeSignal(signal.noise, signal.slope);
+		bench(signal.name, false);
+		bench(signal.name, true);
+	}
+
+	return 0;
+}
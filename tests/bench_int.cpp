@@ -0,0 +1,94 @@
+// bench_int.cpp
+//
+// Host time per sample of the integer gyroscope and accelerometer conversions
+// next to the float conversions. The host has an FPU, on targets without one
+// the float path is a software multiply per axis.
+
+#include "sfe_ism330dhcx.h"
+#include "sfe_ism330dhcx_sim.h"
+#include "test_util.h"
+#include <stdlib.h>
+
+using namespace sfe_ISM330DHCX;
+
+#define BENCH_SAMPLES 512
+#define BENCH_ROUNDS 2000
+
+static sfe_ism_raw_data_t raw[BENCH_SAMPLES];
+static sfe_ism_int_data_t fixed[BENCH_SAMPLES];
+static sfe_ism_data_t floats[BENCH_SAMPLES];
+
+// Keeps the conversions from being optimized away
+static volatile int32_t sink;
+
+static void report(const char* name, uint64_t elapsed)
+{
+	printf("%-24s %6.2f ns/sample\n", name, (double)elapsed / BENCH_ROUNDS / BENCH_SAMPLES);
+}
+
+int main()
+{
+	QwSimISM330DHCX sim;
+	QwDevISM330DHCX dev;
+	uint64_t start;
+
+	dev.setCommunicationBus(sim, ISM330DHCX_ADDRESS_HIGH);
+	dev.init();
+	dev.setAccelFullScale(ISM_4g);
+	dev.setGyroFullScale(ISM_2000dps);
+
+	srand(1);
+
+	for( int i = 0; i < BENCH_SAMPLES; i++ )
+	{
+		raw[i].xData = (int16_t)(rand() & 0xFFFF);
+		raw[i].yData = (int16_t)(rand() & 0xFFFF);
+		raw[i].zData = (int16_t)(rand() & 0xFFFF);
+	}
+
+	start = benchNowNs();
+
+	for( int round = 0; round < BENCH_ROUNDS; round++ )
+	{
+		dev.convertIntGyro(raw, fixed, BENCH_SAMPLES);
+		sink = fixed[round % BENCH_SAMPLES].xData;
+	}
+
+	report("gyro, integer", benchNowNs() - start);
+
+	start = benchNowNs();
+
+	for( int round = 0; round < BENCH_ROUNDS; round++ )
+	{
+		for( int i = 0; i < BENCH_SAMPLES; i++ )
+			dev.convertGyroData(&raw[i], &floats[i]);
+
+		sink = (int32_t)floats[round % BENCH_SAMPLES].xData;
+	}
+
+	report("gyro, float", benchNowNs() - start);
+
+	start = benchNowNs();
+
+	for( int round = 0; round < BENCH_ROUNDS; round++ )
+	{
+		dev.convertIntAccel(raw, fixed, BENCH_SAMPLES);
+		sink = fixed[round % BENCH_SAMPLES].xData;
+	}
+
+	report("accel, integer", benchNowNs() - start);
+
+	start = benchNowNs();
+
+	for( int round = 0; round < BENCH_ROUNDS; round++ )
+	{
+		for( int i = 0; i < BENCH_SAMPLES; i++ )
+			dev.convertAccelData(&raw[i], &floats[i]);
+
+		sink = (int32_t)floats[round % BENCH_SAMPLES].xData;
+	}
+
+	report("accel, float", benchNowNs() - start);
+
+	return 0;
+}
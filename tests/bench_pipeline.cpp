@@ -0,0 +1,111 @@
+// bench_pipeline.cpp
+//
+// Host wakeups and bus transactions per second of simulated time for reading
+// accelerometer and gyroscope at 833Hz and 6.6kHz: once per data ready 
+// interrupt with getRawAllData(), and once per FIFO watermark interrupt set 
+// up by beginFifoPipeline() with readFifo(). A wakeup is a rising edge of
+// INT1, polled every 10us.
+
+#include "sfe_ism330dhcx.h"
+#include "sfe_ism330dhcx_sim.h"
+#include "test_util.h"
+
+using namespace sfe_ISM330DHCX;
+
+#define BENCH_POLL_NS 10000ULL
+#define BENCH_TIME_NS 1000000000ULL
+
+static sfe_ism_raw_data_t accel[512];
+static sfe_ism_raw_data_t gyro[512];
+
+// Watermark 0 reads every sample on its data ready interrupt
+static void bench(const char* name, uint8_t dataRate, uint8_t batchRate, uint16_t watermark)
+{
+	QwSimISM330DHCX sim;
+	QwDevISM330DHCX dev;
+	sfe_ism_fifo_data_t fifo = {};
+	sfe_ism_raw_all_data_t allData;
+	uint32_t wakeups = 0;
+	uint32_t samples = 0;
+	uint32_t lost = 0;
+	bool level;
+	bool lastLevel = false;
+	char mode[24];
+
+	fifo.accelData = accel;
+	fifo.accelSize = 512;
+	fifo.gyroData = gyro;
+	fifo.gyroSize = 512;
+
+	dev.setCommunicationBus(sim, ISM330DHCX_ADDRESS_HIGH);
+	dev.init();
+	dev.deviceReset();
+	dev.setDeviceConfig();
+	dev.setBlockDataUpdate();
+	dev.setAccelDataRate(dataRate);
+	dev.setGyroDataRate(dataRate);
+
+	if( watermark == 0 )
+	{
+		dev.setAccelStatustoInt1();
+		dev.setGyroStatustoInt1();
+	}
+	else
+	{
+		dev.setAccelFifoBatchSet(batchRate);
+		dev.setGyroFifoBatchSet(batchRate);
+		dev.beginFifoPipeline(watermark, 1);
+	}
+
+	sim.resetStats();
+
+	for( uint64_t t = 0; t < BENCH_TIME_NS; t += BENCH_POLL_NS )
+	{
+		sim.advance(BENCH_POLL_NS);
+		level = sim.getInt1();
+
+		if( level && !lastLevel )
+		{
+			wakeups++;
+
+			if( watermark == 0 )
+			{
+				dev.getRawAllData(&allData);
+				samples++;
+			}
+			else
+			{
+				dev.readFifo(&fifo, 512);
+				samples += fifo.numAccel;
+				lost += fifo.accelMissing + fifo.gyroMissing + fifo.overrun;
+			}
+
+			level = sim.getInt1();
+		}
+
+		lastLevel = level;
+	}
+
+	if( watermark )
+		snprintf(mode, sizeof(mode), "FIFO wtm %u", watermark);
+	else
+		snprintf(mode, sizeof(mode), "data ready");
+
+	printf("%-6s %-13s wakeups/s %5u  transactions/s %5u  bytes/s %6u  accel samples %5u%s\n",
+		name, mode,
+		wakeups, sim.getStats().numReads + sim.getStats().numWrites,
+		sim.getStats().bytesRead + sim.getStats().bytesWritten, samples,
+		lost ? "  (samples lost)" : "");
+}
+
+int main()
+{
+	bench("833Hz", ISM_XL_ODR_833Hz, ISM_XL_BATCH_AT_833Hz, 0);
+	bench("833Hz", ISM_XL_ODR_833Hz, ISM_XL_BATCH_AT_833Hz, 64);
+	bench("833Hz", ISM_XL_ODR_833Hz, ISM_XL_BATCH_AT_833Hz, 256);
+	bench("6.6kHz", ISM_XL_ODR_6667Hz, ISM_XL_BATCH_AT_6667Hz, 0);
+	bench("6.6kHz", ISM_XL_ODR_6667Hz, ISM_XL_BATCH_AT_6667Hz, 64);
+	bench("6.6kHz", ISM_XL_ODR_6667Hz, ISM_XL_BATCH_AT_6667Hz, 256);
+
+	return 0;
+}
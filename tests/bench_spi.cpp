@@ -0,0 +1,84 @@
+// bench_spi.cpp
+//
+// SPIClass calls and host time per sample of SfeSPI against the mock SPIClass,
+// next to the byte at a time transfers SfeSPI used to make: one transfer()
+// for the register byte and one for every data byte.
+
+#include "sfe_bus.h"
+#include "sfe_ism330dhcx.h"
+#include "test_util.h"
+
+using namespace sfe_ISM330DHCX;
+
+#define BENCH_ROUNDS 100000
+
+static void benchRead(SfeSPI& bus, const char* name, uint16_t length, uint16_t samples)
+{
+	uint8_t data[ISM_FIFO_READ_WORDS * ISM_FIFO_WORD_SIZE];
+	uint64_t start;
+	uint64_t elapsed;
+	uint32_t calls;
+
+	SPI.stats = SPIMockStats();
+	start = benchNowNs();
+
+	for( uint32_t i = 0; i < BENCH_ROUNDS; i++ )
+		bus.readRegisterRegion(0, 0x1E, data, length);
+
+	elapsed = benchNowNs() - start;
+	calls = SPI.stats.numByteTransfers + SPI.stats.numBufferTransfers;
+
+	printf("%-28s %4u bytes  %6.2f transfer calls/sample (byte at a time %6.2f)  %6.1f ns/sample\n",
+		name, length,
+		(double)calls / BENCH_ROUNDS / samples,
+		(double)(length + 1) / samples,
+		(double)elapsed / BENCH_ROUNDS / samples);
+}
+
+static void benchWrite(SfeSPI& bus, const char* name, uint16_t length)
+{
+	uint8_t data[64] = {};
+	uint64_t start;
+	uint64_t elapsed;
+	uint32_t calls;
+
+	SPI.stats = SPIMockStats();
+	start = benchNowNs();
+
+	for( uint32_t i = 0; i < BENCH_ROUNDS; i++ )
+		bus.writeRegisterRegion(0, 0x10, data, length);
+
+	elapsed = benchNowNs() - start;
+	calls = SPI.stats.numByteTransfers + SPI.stats.numBufferTransfers;
+
+	printf("%-28s %4u bytes  %6.2f transfer calls/write  (byte at a time %6.2f)  %6.1f ns/write\n",
+		name, length,
+		(double)calls / BENCH_ROUNDS,
+		(double)(length + 1),
+		(double)elapsed / BENCH_ROUNDS);
+}
+
+int main()
+{
+	SfeSPI bus;
+
+	bus.init(MOCK_SPI_CS);
+
+	// Accelerometer and gyroscope, status to accelerometer
+	benchRead(bus, "6DoF sample", 12, 1);
+	benchRead(bus, "combined sample", 16, 1);
+
+	// Either side of the staged and in place paths
+	benchRead(bus, "read, scratch size - 1", ISM_SPI_SCRATCH_SIZE - 1, 1);
+	benchRead(bus, "read, scratch size", ISM_SPI_SCRATCH_SIZE, 1);
+
+	// A FIFO chunk, one sample per word
+	benchRead(bus, "FIFO word", ISM_FIFO_WORD_SIZE, 1);
+	benchRead(bus, "FIFO chunk", ISM_FIFO_READ_WORDS * ISM_FIFO_WORD_SIZE, ISM_FIFO_READ_WORDS);
+
+	benchWrite(bus, "write, 1 byte", 1);
+	benchWrite(bus, "write, scratch size - 1", ISM_SPI_SCRATCH_SIZE - 1);
+	benchWrite(bus, "write, scratch size", ISM_SPI_SCRATCH_SIZE);
+
+	return 0;
+}
@@ -0,0 +1,221 @@
+// fifo_stream.h
+//
+// This is a library written for SparkFun Qwiic ISM330DHCX boards
+//
+// SparkFun sells these boards at its website: www.sparkfun.com
+//
+// Do you like this library? Help support SparkFun. Buy a board!
+//
+//SparkFun Qwiic 6DoF - ISM330DHCX        https://www.sparkfun.com/products/19764
+//
+// Repository:
+//     https://github.com/sparkfun/SparkFun_6DoF_ISM330DHCX_Arduino_Library
+//
+//
+// SparkFun code, firmware, and software is released under the MIT
+// License(http://opensource.org/licenses/MIT).
+//
+// SPDX-License-Identifier: MIT
+
+// Hand built FIFO streams for the decoder tests. FifoStreamBus is a bus that
+// answers the FIFO status and data registers from a list of tagged words, so
+// readFifo() can be fed any sequence of NC, NC_T_1, NC_T_2, 2xC and 3xC words
+// the simulated device doesn't produce. Every other register reads back what
+// was written, zero by default.
+
+#pragma once
+
+#include "sfe_bus.h"
+#include "sfe_ism330dhcx.h"
+#include <string.h>
+#include <vector>
+
+class FifoStreamBus : public sfe_ISM330DHCX::QwIDeviceBus
+{
+public:
+
+	FifoStreamBus() : numReads{0}, bytesRead{0}, _registers{}, _next{0} {}
+
+	bool ping(uint8_t address)
+	{
+		(void)address;
+		return true;
+	}
+
+	bool writeRegisterByte(uint8_t address, uint8_t offset, uint8_t data)
+	{
+		return writeRegisterRegion(address, offset, &data, 1) == 0;
+	}
+
+	int writeRegisterRegion(uint8_t address, uint8_t offset, const uint8_t* data, uint16_t length)
+	{
+		(void)address;
+
+		for( uint16_t i = 0; i < length; i++ )
+			_registers[(offset + i) & 0x7F] = data[i];
+
+		return 0;
+	}
+
+	int readRegisterRegion(uint8_t address, uint8_t reg, uint8_t* data, uint16_t numBytes)
+	{
+		uint16_t level = getLevel();
+
+		(void)address;
+
+		numReads++;
+		bytesRead += numBytes;
+
+		// The address rolls back to FIFO_DATA_OUT_TAG after every word
+		if( reg == ISM330DHCX_FIFO_DATA_OUT_TAG )
+		{
+			if( numBytes % ISM_FIFO_WORD_SIZE || numBytes / ISM_FIFO_WORD_SIZE > level )
+				return -1;
+
+			memcpy(data, &_words[_next * ISM_FIFO_WORD_SIZE], numBytes);
+			_next += numBytes / ISM_FIFO_WORD_SIZE;
+			return 0;
+		}
+
+		_registers[ISM330DHCX_FIFO_STATUS1] = (uint8_t)level;
+		_registers[ISM330DHCX_FIFO_STATUS2] = (uint8_t)(level >> 8);
+
+		for( uint16_t i = 0; i < numBytes; i++ )
+			data[i] = _registers[(reg + i) & 0x7F];
+
+		return 0;
+	}
+
+	// Batch rates of FIFO_CTRL3 the decoder places the samples by
+	void setBatchRates(uint8_t fifoCtrl3)
+	{
+		_registers[ISM330DHCX_FIFO_CTRL3] = fifoCtrl3;
+	}
+
+	// Makes the words written so far unread again
+	void rewind()
+	{
+		_next = 0;
+	}
+
+	uint16_t getLevel()
+	{
+		return (uint16_t)(_words.size() / ISM_FIFO_WORD_SIZE - _next);
+	}
+
+	// A word written at time slot "slot", the tag counter is the slot modulo 4
+	void addWord(uint8_t tag, uint32_t slot, const uint8_t* data)
+	{
+		_words.push_back((uint8_t)((tag << 3) | ((slot & 0x03) << 1)));
+		_words.insert(_words.end(), data, data + 6);
+	}
+
+	// One uncompressed sample at slot - age sample periods
+	void addNc(bool gyro, uint32_t slot, uint8_t age, const sfe_ism_raw_data_t& sample)
+	{
+		static const uint8_t xlTags[] = { ISM330DHCX_XL_NC_TAG, ISM330DHCX_XL_NC_T_1_TAG, ISM330DHCX_XL_NC_T_2_TAG };
+		static const uint8_t gyTags[] = { ISM330DHCX_GYRO_NC_TAG, ISM330DHCX_GYRO_NC_T_1_TAG, ISM330DHCX_GYRO_NC_T_2_TAG };
+		uint8_t data[6];
+
+		putInt16(&data[0], sample.xData);
+		putInt16(&data[2], sample.yData);
+		putInt16(&data[4], sample.zData);
+
+		addWord(gyro ? gyTags[age] : xlTags[age], slot, data);
+	}
+
+	// Samples at slot - 2 and slot - 1 sample periods as 8 bit differences
+	void add2xC(bool gyro, uint32_t slot, const sfe_ism_raw_data_t& prev, const sfe_ism_raw_data_t* samples)
+	{
+		uint8_t data[6];
+		const sfe_ism_raw_data_t* last = &prev;
+
+		for( int i = 0; i < 2; i++ )
+		{
+			data[3 * i] = (uint8_t)(samples[i].xData - last->xData);
+			data[3 * i + 1] = (uint8_t)(samples[i].yData - last->yData);
+			data[3 * i + 2] = (uint8_t)(samples[i].zData - last->zData);
+			last = &samples[i];
+		}
+
+		addWord(gyro ? ISM330DHCX_GYRO_2XC_TAG : ISM330DHCX_XL_2XC_TAG, slot, data);
+	}
+
+	// Samples at slot - 2, slot - 1 sample periods and slot as 5 bit 
+	// differences
+	void add3xC(bool gyro, uint32_t slot, const sfe_ism_raw_data_t& prev, const sfe_ism_raw_data_t* samples)
+	{
+		uint8_t data[6];
+		const sfe_ism_raw_data_t* last = &prev;
+		uint16_t packed;
+
+		for( int i = 0; i < 3; i++ )
+		{
+			packed = (uint16_t)(((samples[i].xData - last->xData) & 0x1F) |
+			                    (((samples[i].yData - last->yData) & 0x1F) << 5) |
+			                    (((samples[i].zData - last->zData) & 0x1F) << 10));
+			data[2 * i] = (uint8_t)packed;
+			data[2 * i + 1] = (uint8_t)(packed >> 8);
+			last = &samples[i];
+		}
+
+		addWord(gyro ? ISM330DHCX_GYRO_3XC_TAG : ISM330DHCX_XL_3XC_TAG, slot, data);
+	}
+
+	// Writes the samples of one sensor at consecutive slots from "slot" the 
+	// way the compressor picks words: three samples per word when every 
+	// difference fits 5 bits, two when they fit 8 bits and one otherwise. 
+	// Without compression every sample is a NC word.
+	void addSamples(bool gyro, uint32_t slot, const sfe_ism_raw_data_t* samples, uint32_t num, bool compress)
+	{
+		uint32_t i = 0;
+
+		while( i < num )
+		{
+			if( compress && i > 0 && i + 3 <= num && fits(&samples[i - 1], 4, 16) )
+			{
+				add3xC(gyro, slot + i + 2, samples[i - 1], &samples[i]);
+				i += 3;
+			}
+			else if( compress && i > 0 && i + 2 <= num && fits(&samples[i - 1], 3, 128) )
+			{
+				add2xC(gyro, slot + i + 2, samples[i - 1], &samples[i]);
+				i += 2;
+			}
+			else
+			{
+				addNc(gyro, slot + i, 0, samples[i]);
+				i++;
+			}
+		}
+	}
+
+	uint32_t numReads;
+	uint32_t bytesRead;
+
+private:
+
+	static void putInt16(uint8_t* data, int16_t val)
+	{
+		data[0] = (uint8_t)val;
+		data[1] = (uint8_t)((uint16_t)val >> 8);
+	}
+
+	// Every difference of "num" consecutive samples within +-limit
+	static bool fits(const sfe_ism_raw_data_t* samples, int num, int limit)
+	{
+		for( int i = 1; i < num; i++ )
+		{
+			if( samples[i].xData - samples[i - 1].xData >= limit || samples[i].xData - samples[i - 1].xData < -limit ||
+			    samples[i].yData - samples[i - 1].yData >= limit || samples[i].yData - samples[i - 1].yData < -limit ||
+			    samples[i].zData - samples[i - 1].zData >= limit || samples[i].zData - samples[i - 1].zData < -limit )
+				return false;
+		}
+
+		return true;
+	}
+
+	uint8_t _registers[128];
+	std::vector<uint8_t> _words;
+	uint32_t _next;
+};
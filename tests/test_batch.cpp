@@ -0,0 +1,101 @@
+// test_batch.cpp
+//
+// The block conversions of sfe_ism_batch.cpp against a scalar reference, for
+// every length up to a few vectors and at unaligned buffers. Build with e.g.
+// OPT="-O2 -mavx2" to test the other x86 kernels, or with 
+// OPT="-O2 -mno-sse2 -mfpmath=387" for the plain loops.
+
+#include "sfe_ism_batch.h"
+#include "test_util.h"
+#include <stdlib.h>
+
+#define TEST_MAX_SAMPLES 4096
+// Guard values after the last output
+#define TEST_GUARD 8
+
+static int16_t raw[3 * TEST_MAX_SAMPLES + 1];
+static float xData[TEST_MAX_SAMPLES + TEST_GUARD + 1];
+static float yData[TEST_MAX_SAMPLES + TEST_GUARD + 1];
+static float zData[TEST_MAX_SAMPLES + TEST_GUARD + 1];
+static int32_t xInt[TEST_MAX_SAMPLES + TEST_GUARD + 1];
+static int32_t yInt[TEST_MAX_SAMPLES + TEST_GUARD + 1];
+static int32_t zInt[TEST_MAX_SAMPLES + TEST_GUARD + 1];
+
+// Scalar reference, rounded to float like the kernels store it even where the
+// FPU computes with more precision (x87)
+static float reference(int16_t value, float scale)
+{
+	volatile float product = value * scale;
+
+	return product;
+}
+
+static void checkFloat(const int16_t* in, uint16_t num, float scale, uint16_t offset)
+{
+	for( int i = 0; i < num + TEST_GUARD; i++ )
+		xData[offset + i] = yData[offset + i] = zData[offset + i] = -1.5f;
+
+	sfe_ism_scale_block(in, num, scale, xData + offset, yData + offset, zData + offset);
+
+	for( uint16_t i = 0; i < num; i++ )
+	{
+		// int16 to float is exact, one multiply rounds the same way
+		CHECK(xData[offset + i] == reference(in[3 * i], scale));
+		CHECK(yData[offset + i] == reference(in[3 * i + 1], scale));
+		CHECK(zData[offset + i] == reference(in[3 * i + 2], scale));
+	}
+
+	for( int i = num; i < num + TEST_GUARD; i++ )
+		CHECK(xData[offset + i] == -1.5f && yData[offset + i] == -1.5f && zData[offset + i] == -1.5f);
+}
+
+static void checkInt(const int16_t* in, uint16_t num, int32_t scale, uint16_t offset)
+{
+	for( int i = 0; i < num + TEST_GUARD; i++ )
+		xInt[offset + i] = yInt[offset + i] = zInt[offset + i] = -7;
+
+	sfe_ism_scale_block_int(in, num, scale, xInt + offset, yInt + offset, zInt + offset);
+
+	for( uint16_t i = 0; i < num; i++ )
+	{
+		CHECK_EQ(xInt[offset + i], in[3 * i] * scale);
+		CHECK_EQ(yInt[offset + i], in[3 * i + 1] * scale);
+		CHECK_EQ(zInt[offset + i], in[3 * i + 2] * scale);
+	}
+
+	for( int i = num; i < num + TEST_GUARD; i++ )
+		CHECK(xInt[offset + i] == -7 && yInt[offset + i] == -7 && zInt[offset + i] == -7);
+}
+
+int main()
+{
+	static const uint16_t lengths[] = { 64, 511, 512, 4095, 4096 };
+
+	srand(1);
+
+	for( int i = 0; i < 3 * TEST_MAX_SAMPLES + 1; i++ )
+		raw[i] = (int16_t)(rand() & 0xFFFF);
+
+	// Extremes, the largest sensitivities must not overflow
+	raw[0] = 32767;
+	raw[1] = -32768;
+	raw[2] = -1;
+
+	// Every tail length of the 4 and 8 sample kernels, aligned and not
+	for( uint16_t num = 0; num <= 40; num++ )
+	{
+		checkFloat(raw, num, 0.061f, 0);
+		checkFloat(raw + 1, num, 8.75f, 1);
+		checkInt(raw, num, 488, 0);
+		checkInt(raw + 1, num, 140 << 8, 1);
+	}
+
+	for( uint16_t num : lengths )
+	{
+		checkFloat(raw, num, 0.0001f, 0);
+		checkInt(raw, num, 61, 0);
+		checkInt(raw, num, -3, 0);
+	}
+
+	return testResult("test_batch");
+}
@@ -0,0 +1,230 @@
+// test_capture.cpp
+//
+// Triggered captures against the simulated device: stream-to-FIFO reads
+// nothing before the trigger, windows read over several calls complete once
+// "depth" words were read in total, and the trigger time and sample times
+// match the device time the trigger event was injected at.
+
+#include "sfe_ism330dhcx.h"
+#include "sfe_ism330dhcx_sim.h"
+#include "test_util.h"
+
+using namespace sfe_ISM330DHCX;
+
+#define CAPTURE_SIZE 512
+
+// One 104Hz ODR period of the simulated device
+#define CAPTURE_ODR_NS 9615385ULL
+
+static sfe_ism_raw_data_t accel[CAPTURE_SIZE];
+static sfe_ism_raw_data_t gyro[CAPTURE_SIZE];
+static uint64_t accelTime[CAPTURE_SIZE];
+static uint64_t gyroTime[CAPTURE_SIZE];
+static uint32_t timestamps[CAPTURE_SIZE];
+
+// Returns the simulator time the timestamp counter started from zero at
+static uint64_t configure(QwSimISM330DHCX& sim, QwDevISM330DHCX& dev, sfe_ism_capture_t* capture)
+{
+	uint64_t counterStart;
+
+	CHECK(dev.init());
+	CHECK(dev.setAccelDataRate(ISM_XL_ODR_104Hz));
+	CHECK(dev.setGyroDataRate(ISM_GY_ODR_104Hz));
+	CHECK(dev.setAccelFifoBatchSet(ISM_XL_BATCH_AT_104Hz));
+	CHECK(dev.setGyroFifoBatchSet(ISM_GY_BATCH_AT_104Hz));
+	CHECK(dev.enableTimestamp());
+	counterStart = sim.getTime();
+	CHECK(dev.setFifoTimestampDec(ISM_DEC_8));
+
+	*capture = {};
+	capture->fifo.accelData = accel;
+	capture->fifo.accelSize = CAPTURE_SIZE;
+	capture->fifo.accelTime = accelTime;
+	capture->fifo.gyroData = gyro;
+	capture->fifo.gyroSize = CAPTURE_SIZE;
+	capture->fifo.gyroTime = gyroTime;
+	capture->fifo.timestampData = timestamps;
+	capture->fifo.timestampSize = CAPTURE_SIZE;
+
+	return counterStart;
+}
+
+static uint16_t wordsRead(const sfe_ism_capture_t& capture)
+{
+	return capture.fifo.numAccel + capture.fifo.numGyro + capture.fifo.numTimestamp;
+}
+
+// One ODR period apart, within a timestamp tick and the error of the nominal
+// period the driver starts from
+static void checkSampleTimes(const uint64_t* times, uint16_t num)
+{
+	for( uint16_t i = 1; i < num; i++ )
+		CHECK_NEAR((double)(times[i] - times[i - 1]), (double)CAPTURE_ODR_NS, 2.0 * ISM_TIMESTAMP_NS);
+}
+
+static void testStreamToFifo()
+{
+	QwSimISM330DHCX sim;
+	QwDevISM330DHCX dev;
+	sfe_ism_capture_t capture;
+	uint16_t level;
+	uint64_t counterStart;
+	uint64_t triggerNs;
+
+	dev.setCommunicationBus(sim, ISM330DHCX_ADDRESS_HIGH);
+	counterStart = configure(sim, dev, &capture);
+
+	CHECK(dev.armCapture(ISM_EVENT_WAKE_UP, 1, ISM_STREAM_TO_FIFO_MODE, 100));
+
+	// The FIFO holds the latest words, none are read before the trigger
+	sim.advance(2000000000ULL);
+	level = sim.getFifoLevel();
+	CHECK_EQ(level, 100);
+
+	CHECK(dev.readCapture(&capture));
+	CHECK(!capture.complete);
+	CHECK_EQ(wordsRead(capture), 0);
+	CHECK_EQ(sim.getFifoLevel(), level);
+
+	// A trigger event not armed doesn't start the read either
+	sim.injectEvent(kSimDoubleTap);
+	CHECK(dev.readCapture(&capture));
+	CHECK_EQ(wordsRead(capture), 0);
+
+	sim.injectEvent(kSimWakeUp);
+	triggerNs = sim.getTime() - counterStart;
+	sim.advance(300000000ULL);
+
+	CHECK(dev.readCapture(&capture));
+	CHECK(capture.complete);
+	CHECK_EQ(wordsRead(capture), 100);
+	CHECK_EQ(capture.accelBefore, capture.fifo.numAccel);
+	CHECK_EQ(capture.gyroBefore, capture.fifo.numGyro);
+	CHECK_EQ(capture.fifo.numDropped, 0);
+
+	// The window ends with the last sample before the trigger
+	CHECK(capture.triggerTime <= triggerNs + ISM_TIMESTAMP_NS);
+	CHECK(capture.triggerTime + CAPTURE_ODR_NS + ISM_TIMESTAMP_NS > triggerNs);
+	CHECK_EQ(capture.triggerTime, accelTime[capture.fifo.numAccel - 1]);
+	CHECK_EQ(gyroTime[capture.fifo.numGyro - 1], accelTime[capture.fifo.numAccel - 1]);
+	checkSampleTimes(accelTime, capture.fifo.numAccel);
+	checkSampleTimes(gyroTime, capture.fifo.numGyro);
+
+	// The capture ended and the FIFO is back in bypass
+	CHECK(!dev.readCapture(&capture));
+	CHECK_EQ(sim.peekRegister(0, ISM330DHCX_FIFO_CTRL4) & 0x07, ISM_BYPASS_MODE);
+}
+
+static void testMarkedTrigger()
+{
+	QwSimISM330DHCX sim;
+	QwDevISM330DHCX dev;
+	sfe_ism_capture_t capture;
+	sfe_ism_events_t events;
+
+	dev.setCommunicationBus(sim, ISM330DHCX_ADDRESS_HIGH);
+	configure(sim, dev, &capture);
+
+	CHECK(dev.armCapture(ISM_EVENT_WAKE_UP, 1, ISM_STREAM_TO_FIFO_MODE, 80));
+	sim.advance(1000000000ULL);
+	sim.injectEvent(kSimWakeUp);
+
+	// The application cleared ALL_INT_SRC, markTrigger() still opens the window
+	CHECK(dev.getEvents(&events));
+	CHECK(dev.markTrigger());
+	sim.advance(100000000ULL);
+
+	CHECK(dev.readCapture(&capture));
+	CHECK(capture.complete);
+	CHECK_EQ(wordsRead(capture), 80);
+}
+
+static void testBypassToFifo()
+{
+	QwSimISM330DHCX sim;
+	QwDevISM330DHCX dev;
+	sfe_ism_capture_t capture;
+	uint16_t first;
+
+	dev.setCommunicationBus(sim, ISM330DHCX_ADDRESS_HIGH);
+	configure(sim, dev, &capture);
+
+	CHECK(dev.armCapture(ISM_EVENT_DOUBLE_TAP, 2, ISM_BYPASS_TO_FIFO_MODE, 120));
+	sim.advance(1000000000ULL);
+	CHECK_EQ(sim.getFifoLevel(), 0);
+
+	// About 70 words of the window after 300ms
+	sim.injectEvent(kSimDoubleTap);
+	sim.advance(300000000ULL);
+
+	CHECK(dev.readCapture(&capture));
+	CHECK(!capture.complete);
+	first = wordsRead(capture);
+	CHECK(first > 0 && first < 120);
+
+	// The FIFO refills past the words read, the window still ends at 120
+	sim.advance(2000000000ULL);
+
+	CHECK(dev.readCapture(&capture));
+	CHECK(capture.complete);
+	CHECK_EQ(first + wordsRead(capture), 120);
+	CHECK(!dev.readCapture(&capture));
+}
+
+static void testBypassToStream()
+{
+	QwSimISM330DHCX sim;
+	QwDevISM330DHCX dev;
+	sfe_ism_capture_t capture;
+	uint16_t total;
+	uint64_t counterStart;
+	uint64_t triggerNs;
+
+	dev.setCommunicationBus(sim, ISM330DHCX_ADDRESS_HIGH);
+	counterStart = configure(sim, dev, &capture);
+
+	CHECK(dev.armCapture(ISM_EVENT_WAKE_UP, 1, ISM_BYPASS_TO_STREAM_MODE, 60));
+	sim.advance(500000000ULL);
+	sim.injectEvent(kSimWakeUp);
+	triggerNs = sim.getTime() - counterStart;
+	sim.advance(150000000ULL);
+
+	CHECK(dev.readCapture(&capture));
+	total = wordsRead(capture);
+	CHECK(total > 0 && total < 60);
+	CHECK(!capture.complete);
+
+	// The window starts with the first sample after the trigger
+	CHECK_EQ(capture.accelBefore, 0);
+	CHECK_EQ(capture.gyroBefore, 0);
+	CHECK(capture.triggerTime + ISM_TIMESTAMP_NS >= triggerNs);
+	CHECK(capture.triggerTime < triggerNs + CAPTURE_ODR_NS + ISM_TIMESTAMP_NS);
+	CHECK_EQ(capture.triggerTime, accelTime[0]);
+	CHECK_EQ(gyroTime[0], accelTime[0]);
+	checkSampleTimes(accelTime, capture.fifo.numAccel);
+	checkSampleTimes(gyroTime, capture.fifo.numGyro);
+
+	sim.advance(150000000ULL);
+
+	CHECK(dev.readCapture(&capture));
+	total += wordsRead(capture);
+	CHECK(accelTime[0] > capture.triggerTime);
+	CHECK(total >= 60);
+	CHECK(capture.complete);
+
+	// Collection continues until the FIFO is put back in bypass
+	sim.advance(100000000ULL);
+	CHECK(dev.readCapture(&capture));
+	CHECK(wordsRead(capture) > 0);
+	CHECK(capture.complete);
+}
+
+int main()
+{
+	testStreamToFifo();
+	testMarkedTrigger();
+	testBypassToFifo();
+	testBypassToStream();
+
+	return testResult("test_capture");
+}
@@ -0,0 +1,163 @@
+// test_clock.cpp
+//
+// QwISM330DHCXClock fed by syncClock() from the simulated device, whose
+// oscillator runs off by a set number of ppm, against a host clock derived
+// from simulated time: the rate seeded from INTERNAL_FREQ_FINE, the fit
+// converging to the real rate, device times mapped to host time, and the
+// timestamp counter rolling over.
+
+#include "sfe_ism330dhcx.h"
+#include "sfe_ism330dhcx_sim.h"
+#include "sfe_ism_clock.h"
+#include "test_util.h"
+
+using namespace sfe_ISM330DHCX;
+
+// The host clock runs on simulated time, from an arbitrary epoch
+#define TEST_HOST_EPOCH 5000000000000ULL
+
+// Sync interval
+#define TEST_SYNC_NS 100000000ULL
+
+static QwSimISM330DHCX* hostSim;
+
+static uint64_t simHostClock()
+{
+	return TEST_HOST_EPOCH + hostSim->getTime();
+}
+
+// Host ns per device ns minus one, the device counting "ppm" fast
+static double expectedSkewPpm(double ppm)
+{
+	return (1.0 / (1.0 + ppm * 1e-6) - 1.0) * 1e6;
+}
+
+static void setUp(QwSimISM330DHCX& sim, QwDevISM330DHCX& dev, QwISM330DHCXClock& clock, int32_t ppm)
+{
+	hostSim = &sim;
+	sim.setClockError(ppm);
+
+	// Every transaction takes time, syncClock() takes the midpoint
+	sim.setBusTiming(50000, 20000);
+
+	dev.setCommunicationBus(sim, ISM330DHCX_ADDRESS_HIGH);
+	CHECK(dev.init());
+	CHECK(dev.enableTimestamp());
+
+	clock.setHostClock(simHostClock);
+}
+
+// Host time of the device's counter read now
+static void checkMapping(QwDevISM330DHCX& dev, QwISM330DHCXClock& clock)
+{
+	uint32_t ticks;
+	uint64_t before = simHostClock();
+	uint64_t mapped;
+
+	CHECK(dev.getTimestamp(&ticks));
+	mapped = clock.toHostNs(clock.ticksToNs(ticks));
+
+	// The counter read is within the transaction, the counter resolves 25us
+	CHECK(mapped + ISM_TIMESTAMP_NS >= before);
+	CHECK(mapped <= simHostClock() + ISM_TIMESTAMP_NS);
+}
+
+static void testConvergence(int32_t ppm)
+{
+	QwSimISM330DHCX sim;
+	QwDevISM330DHCX dev;
+	QwISM330DHCXClock clock;
+
+	setUp(sim, dev, clock, ppm);
+
+	// One pair: the rate is the one INTERNAL_FREQ_FINE reports in 0.15% steps
+	CHECK(clock.toHostNs(0) == 0);
+	CHECK(dev.syncClock(&clock));
+	CHECK_EQ(clock.getNumPairs(), 1);
+	CHECK_NEAR(clock.getSkewPpm(), expectedSkewPpm(1500.0 * (ppm / 1500)), 0.5);
+
+	for( int i = 0; i < 100; i++ )
+	{
+		sim.advance(TEST_SYNC_NS);
+		CHECK(dev.syncClock(&clock));
+	}
+
+	CHECK_EQ(clock.getNumPairs(), 101);
+	CHECK_NEAR(clock.getSkewPpm(), expectedSkewPpm(ppm), 5.0);
+
+	// Device times map to host time now, and a second of device time ahead
+	// maps to a second of host time at the real rate
+	checkMapping(dev, clock);
+
+	uint64_t now = clock.toHostNs(1000000000ULL * 10);
+	uint64_t later = clock.toHostNs(1000000000ULL * 11);
+	CHECK_NEAR((double)(later - now), 1e9 * (1.0 + expectedSkewPpm(ppm) * 1e-6), 10000.0);
+}
+
+// Syncs while the counter rolls over from 0xFFFFFFFF to 0
+static void testRollOver()
+{
+	QwSimISM330DHCX sim;
+	QwDevISM330DHCX dev;
+	QwISM330DHCXClock clock;
+	uint32_t ticks;
+	uint64_t lastNs = 0;
+
+	setUp(sim, dev, clock, -2000);
+
+	// Two seconds before the roll over
+	sim.setTimestamp(0xFFFFFFFF - 80000);
+
+	for( int i = 0; i < 50; i++ )
+	{
+		CHECK(dev.syncClock(&clock));
+		CHECK(dev.getTimestamp(&ticks));
+
+		// Device time keeps counting up past 2^32 ticks
+		CHECK(clock.ticksToNs(ticks) > lastNs);
+		lastNs = clock.ticksToNs(ticks);
+
+		sim.advance(TEST_SYNC_NS);
+	}
+
+	// Three seconds past the roll over
+	CHECK(ticks < 200000);
+	CHECK(lastNs > 0xFFFFFFFFULL * ISM_TIMESTAMP_NS);
+	CHECK_NEAR(clock.getSkewPpm(), expectedSkewPpm(-2000), 5.0);
+	checkMapping(dev, clock);
+}
+
+// ticksToNs() places a counter value in the roll over period closest to the
+// last pair
+static void testTicksToNs()
+{
+	QwISM330DHCXClock clock;
+
+	// Before any pair values are taken as they are
+	CHECK_EQ(clock.ticksToNs(1234), 1234ULL * ISM_TIMESTAMP_NS);
+
+	clock.addPair(0xFFFFFF00, 1000);
+	CHECK_EQ(clock.ticksToNs(0xFFFFFF80), 0xFFFFFF80ULL * ISM_TIMESTAMP_NS);
+	CHECK_EQ(clock.ticksToNs(0x00000010), 0x100000010ULL * ISM_TIMESTAMP_NS);
+
+	// After a pair past the roll over, values from before it stay before it
+	clock.addPair(0x00000100, 1000 + 0x200ULL * ISM_TIMESTAMP_NS);
+	CHECK_EQ(clock.ticksToNs(0xFFFFFFF0), 0xFFFFFFF0ULL * ISM_TIMESTAMP_NS);
+	CHECK_EQ(clock.ticksToNs(0x00000200), 0x100000200ULL * ISM_TIMESTAMP_NS);
+
+	// Close to the start of the counter nothing goes below zero
+	clock.reset();
+	clock.addPair(0x00000010, 1000);
+	CHECK_EQ(clock.ticksToNs(0xFFFFFFF0), 0xFFFFFFF0ULL * ISM_TIMESTAMP_NS);
+}
+
+int main()
+{
+	testConvergence(2500);
+	testConvergence(-4000);
+	testConvergence(0);
+	testRollOver();
+	testTicksToNs();
+
+	return testResult("test_clock");
+}
@@ -0,0 +1,144 @@
+// test_config.cpp
+//
+// Deferred configuration against the simulated device: an init sequence
+// between beginConfig() and commitConfig() leaves the same registers as the
+// setters called one by one, takes at most ISM_CONFIG_MAX_RUNS bursts, and
+// reads inside the deferral see the pending values. Accesses the shadow
+// can't serve write the pending registers first.
+
+#include "sfe_ism330dhcx.h"
+#include "sfe_ism330dhcx_sim.h"
+#include "test_util.h"
+
+using namespace sfe_ISM330DHCX;
+
+#define SIM_USER_BANK 0
+
+static void setUp(QwSimISM330DHCX& sim, QwDevISM330DHCX& dev)
+{
+	dev.setCommunicationBus(sim, ISM330DHCX_ADDRESS_HIGH);
+	CHECK(dev.init());
+}
+
+// The data rate setters read the FSM enables from the embedded function
+// bank, which writes the pending registers, so they go first
+static void setDataRates(QwDevISM330DHCX& dev)
+{
+	CHECK(dev.setAccelDataRate(ISM_XL_ODR_104Hz));
+	CHECK(dev.setGyroDataRate(ISM_GY_ODR_104Hz));
+}
+
+static void configure(QwDevISM330DHCX& dev)
+{
+	CHECK(dev.setAccelFullScale(ISM_4g));
+	CHECK(dev.setGyroFullScale(ISM_500dps));
+	CHECK(dev.setBlockDataUpdate());
+	CHECK(dev.setAccelFilterLP2());
+	CHECK(dev.setPinMode(true));
+	CHECK(dev.setFifoWatermark(64));
+	CHECK(dev.setAccelFifoBatchSet(ISM_XL_BATCH_AT_104Hz));
+	CHECK(dev.setGyroFifoBatchSet(ISM_GY_BATCH_AT_104Hz));
+	CHECK(dev.setFifoMode(ISM_STREAM_MODE));
+	CHECK(dev.enableTimestamp());
+	CHECK(dev.setFifoInterrupt(1, ISM_FIFO_INT_THRESHOLD));
+	CHECK(dev.setInterruptRouting(ISM_EVENT_WAKE_UP, 0));
+}
+
+static void testCommit()
+{
+	QwSimISM330DHCX plainSim, sim;
+	QwDevISM330DHCX plain, dev;
+	QwSimStats direct;
+
+	// One by one
+	setUp(plainSim, plain);
+	plainSim.resetStats();
+	setDataRates(plain);
+	configure(plain);
+	direct = plainSim.getStats();
+
+	// Deferred: nothing reaches the device before commitConfig()
+	setUp(sim, dev);
+	CHECK(dev.beginConfig());
+	setDataRates(dev);
+
+	sim.resetStats();
+	configure(dev);
+	CHECK_EQ(sim.getStats().numReads, 0);
+	CHECK_EQ(sim.getStats().numWrites, 0);
+	CHECK_EQ(sim.peekRegister(SIM_USER_BANK, ISM330DHCX_CTRL1_XL) & 0x0C, 0);
+
+	CHECK(dev.commitConfig());
+	CHECK(sim.getStats().numWrites <= ISM_CONFIG_MAX_RUNS);
+	CHECK(sim.getStats().numWrites < direct.numWrites / 3);
+	CHECK_EQ(sim.getStats().numReads, 0);
+
+	for( unsigned reg = 0; reg < 0x80; reg++ )
+	{
+		// The FIFO and status registers follow time
+		if( reg >= ISM330DHCX_STATUS_REG && reg < ISM330DHCX_TAP_CFG0 )
+			continue;
+		if( reg >= ISM330DHCX_FIFO_DATA_OUT_TAG )
+			continue;
+
+		CHECK_EQ(sim.peekRegister(SIM_USER_BANK, reg), plainSim.peekRegister(SIM_USER_BANK, reg));
+	}
+
+	// Nothing pending, nothing written
+	sim.resetStats();
+	CHECK(dev.beginConfig());
+	CHECK(dev.commitConfig());
+	CHECK_EQ(sim.getStats().numWrites, 0);
+}
+
+// Reads inside the deferral see the pending values
+static void testReads()
+{
+	QwSimISM330DHCX sim;
+	QwDevISM330DHCX dev;
+	uint8_t val;
+
+	setUp(sim, dev);
+	CHECK(dev.beginConfig());
+
+	sim.resetStats();
+	CHECK(dev.setAccelFullScale(ISM_8g));
+	CHECK(dev.setFifoWatermark(300));
+
+	CHECK_EQ(dev.getAccelFullScale(), ISM_8g);
+	CHECK_EQ(dev.readRegisterRegion(ISM330DHCX_FIFO_CTRL1, &val, 1), 0);
+	CHECK_EQ(val, 300 & 0xFF);
+
+	// Read-modify-writes build on the pending value
+	CHECK(dev.setBlockDataUpdate());
+	CHECK(dev.setAccelFullScale(ISM_16g));
+	CHECK_EQ(dev.getAccelFullScale(), ISM_16g);
+
+	CHECK_EQ(sim.getStats().numReads, 0);
+	CHECK_EQ(sim.getStats().numWrites, 0);
+	CHECK_EQ(sim.peekRegister(SIM_USER_BANK, ISM330DHCX_FIFO_CTRL1), 0);
+
+	// A register the shadow doesn't hold is read after the pending writes
+	CHECK_EQ(dev.readRegisterRegion(ISM330DHCX_STATUS_REG, &val, 1), 0);
+	CHECK_EQ(sim.getStats().numReads, 1);
+	CHECK(sim.getStats().numWrites > 0);
+	CHECK_EQ(sim.peekRegister(SIM_USER_BANK, ISM330DHCX_FIFO_CTRL1), 300 & 0xFF);
+	CHECK_EQ(sim.peekRegister(SIM_USER_BANK, ISM330DHCX_CTRL1_XL) & 0x0C, 0x04);
+	CHECK_EQ(sim.peekRegister(SIM_USER_BANK, ISM330DHCX_CTRL3_C) & 0x40, 0x40);
+
+	// Still deferred after that
+	sim.resetStats();
+	CHECK(dev.setGyroFullScale(ISM_1000dps));
+	CHECK_EQ(sim.getStats().numWrites, 0);
+	CHECK(dev.commitConfig());
+	CHECK_EQ(sim.getStats().numWrites, 1);
+	CHECK_EQ(dev.getGyroFullScale(), ISM_1000dps);
+}
+
+int main()
+{
+	testCommit();
+	testReads();
+
+	return testResult("test_config");
+}
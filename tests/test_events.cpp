@@ -0,0 +1,192 @@
+// test_events.cpp
+//
+// getEvents() against the simulated device: every injected event and data
+// ready flag in events.events, the second burst over the status copies at
+// 0x35 - 0x3B only for the sources enabled through the driver, and a FIFO
+// overrun that getEvents() read and cleared still reported by readFifo().
+
+#include "sfe_ism330dhcx.h"
+#include "sfe_ism330dhcx_sim.h"
+#include "test_util.h"
+
+using namespace sfe_ISM330DHCX;
+
+#define SIM_USER_BANK 0
+
+static void setUp(QwSimISM330DHCX& sim, QwDevISM330DHCX& dev)
+{
+	dev.setCommunicationBus(sim, ISM330DHCX_ADDRESS_HIGH);
+	CHECK(dev.init());
+}
+
+// Each injected event on its own, cleared by the read that reported it
+static void testInjected()
+{
+	static const struct
+	{
+		QwSimEvent event;
+		uint32_t expected;
+	} cases[] = {
+		{ kSimFreeFall, ISM_EVENT_FREE_FALL },
+		{ kSimWakeUp, ISM_EVENT_WAKE_UP },
+		{ kSimSingleTap, ISM_EVENT_SINGLE_TAP },
+		{ kSimDoubleTap, ISM_EVENT_DOUBLE_TAP },
+		{ kSim6D, ISM_EVENT_6D },
+		{ kSimSleepChange, ISM_EVENT_SLEEP_CHANGE },
+	};
+	QwSimISM330DHCX sim;
+	QwDevISM330DHCX dev;
+	sfe_ism_events_t events;
+
+	setUp(sim, dev);
+
+	CHECK(dev.getEvents(&events));
+	CHECK_EQ(events.events, 0);
+
+	for( const auto& c : cases )
+	{
+		sim.injectEvent(c.event);
+
+		CHECK(dev.getEvents(&events));
+		CHECK_EQ(events.events, c.expected);
+		CHECK_EQ(events.fsmStatus, 0);
+
+		CHECK(dev.getEvents(&events));
+		CHECK_EQ(events.events, 0);
+	}
+
+	// Several at once
+	sim.injectEvent(kSimWakeUp);
+	sim.injectEvent(kSimDoubleTap);
+	CHECK(dev.getEvents(&events));
+	CHECK_EQ(events.events, ISM_EVENT_WAKE_UP | ISM_EVENT_DOUBLE_TAP);
+
+	// Data ready from STATUS_REG, in the same burst
+	CHECK(dev.setAccelDataRate(ISM_XL_ODR_104Hz));
+	CHECK(dev.setGyroDataRate(ISM_GY_ODR_104Hz));
+	sim.advance(20000000ULL);
+	sim.resetStats();
+
+	CHECK(dev.getEvents(&events));
+	CHECK_EQ(events.events & (ISM_EVENT_ACCEL_READY | ISM_EVENT_GYRO_READY | ISM_EVENT_TEMP_READY),
+	         ISM_EVENT_ACCEL_READY | ISM_EVENT_GYRO_READY | ISM_EVENT_TEMP_READY);
+	CHECK_EQ(sim.getStats().numReads, 1);
+	CHECK_EQ(sim.getStats().bytesRead, 5);
+}
+
+// The second burst covers only what the enabled sources need
+static void testSources()
+{
+	QwSimISM330DHCX sim;
+	QwDevISM330DHCX dev;
+	sfe_ism_events_t events;
+
+	setUp(sim, dev);
+
+	// Status copies set without their sources enabled aren't read
+	sim.pokeRegister(SIM_USER_BANK, ISM330DHCX_EMB_FUNC_STATUS_MAINPAGE, 0x80);
+	sim.pokeRegister(SIM_USER_BANK, ISM330DHCX_FSM_STATUS_A_MAINPAGE, 0x05);
+	sim.pokeRegister(SIM_USER_BANK, ISM330DHCX_FSM_STATUS_B_MAINPAGE, 0x80);
+	sim.pokeRegister(SIM_USER_BANK, ISM330DHCX_MLC_STATUS_MAINPAGE, 0x03);
+	sim.pokeRegister(SIM_USER_BANK, ISM330DHCX_STATUS_MASTER_MAINPAGE, 0x01);
+
+	sim.resetStats();
+	CHECK(dev.getEvents(&events));
+	CHECK_EQ(events.events, 0);
+	CHECK_EQ(sim.getStats().numReads, 1);
+
+	// FIFO interrupts routed: FIFO_STATUS1/2 only
+	CHECK(dev.setFifoWatermark(10));
+	CHECK(dev.setAccelDataRate(ISM_XL_ODR_104Hz));
+	CHECK(dev.setAccelFifoBatchSet(ISM_XL_BATCH_AT_104Hz));
+	CHECK(dev.setFifoMode(ISM_FIFO_MODE));
+	CHECK(dev.setFifoInterrupt(1, ISM_FIFO_INT_THRESHOLD));
+	sim.advance(200000000ULL);
+
+	sim.resetStats();
+	CHECK(dev.getEvents(&events));
+	CHECK_EQ(events.events & ~(ISM_EVENT_ACCEL_READY | ISM_EVENT_TEMP_READY), ISM_EVENT_FIFO_THRESHOLD);
+	CHECK_EQ(sim.getStats().numReads, 2);
+	CHECK_EQ(sim.getStats().bytesRead, 5 + 2);
+
+	// The MLC: EMB_FUNC_STATUS_MAINPAGE - STATUS_MASTER_MAINPAGE as well
+	CHECK(dev.enableMlc());
+
+	sim.resetStats();
+	CHECK(dev.getEvents(&events));
+	CHECK_EQ(events.events & ~(ISM_EVENT_ACCEL_READY | ISM_EVENT_TEMP_READY),
+	         ISM_EVENT_FIFO_THRESHOLD | ISM_EVENT_FSM_LONG_COUNTER | ISM_EVENT_FSM |
+	         ISM_EVENT_SENSOR_HUB_END | ISM_EVENT_MLC1 | (ISM_EVENT_MLC1 << 1));
+	CHECK_EQ(events.fsmStatus, 0x8005);
+	CHECK_EQ(sim.getStats().numReads, 2);
+	CHECK_EQ(sim.getStats().bytesRead, 5 + 7);
+
+	// FIFO interrupts off again: up to STATUS_MASTER_MAINPAGE
+	CHECK(dev.setFifoInterrupt(1, 0));
+	sim.pokeRegister(SIM_USER_BANK, ISM330DHCX_EMB_FUNC_STATUS_MAINPAGE, 0x38);
+	sim.pokeRegister(SIM_USER_BANK, ISM330DHCX_FSM_STATUS_A_MAINPAGE, 0x00);
+	sim.pokeRegister(SIM_USER_BANK, ISM330DHCX_FSM_STATUS_B_MAINPAGE, 0x00);
+
+	sim.resetStats();
+	CHECK(dev.getEvents(&events));
+	CHECK_EQ(events.events & ~(ISM_EVENT_ACCEL_READY | ISM_EVENT_TEMP_READY),
+	         ISM_EVENT_STEP | ISM_EVENT_TILT | ISM_EVENT_SIG_MOTION |
+	         ISM_EVENT_SENSOR_HUB_END | ISM_EVENT_MLC1 | (ISM_EVENT_MLC1 << 1));
+	CHECK_EQ(events.fsmStatus, 0);
+	CHECK_EQ(sim.getStats().numReads, 2);
+	CHECK_EQ(sim.getStats().bytesRead, 5 + 5);
+
+	// Nothing enabled any more, one burst
+	CHECK(dev.enableMlc(false));
+
+	sim.resetStats();
+	CHECK(dev.getEvents(&events));
+	CHECK_EQ(events.events & ~(ISM_EVENT_ACCEL_READY | ISM_EVENT_TEMP_READY), 0);
+	CHECK_EQ(sim.getStats().numReads, 1);
+}
+
+// FIFO_OVR_LATCHED cleared by getEvents() is handed on to readFifo()
+static void testOverrun()
+{
+	static sfe_ism_raw_data_t accel[QwSimISM330DHCX::kFifoWords];
+	QwSimISM330DHCX sim;
+	QwDevISM330DHCX dev;
+	sfe_ism_events_t events;
+	sfe_ism_fifo_data_t fifo = {};
+
+	fifo.accelData = accel;
+	fifo.accelSize = QwSimISM330DHCX::kFifoWords;
+
+	setUp(sim, dev);
+	CHECK(dev.setAccelDataRate(ISM_XL_ODR_104Hz));
+	CHECK(dev.setAccelFifoBatchSet(ISM_XL_BATCH_AT_104Hz));
+	CHECK(dev.setFifoInterrupt(1, ISM_FIFO_INT_OVERRUN));
+	CHECK(dev.setFifoMode(ISM_FIFO_MODE));
+
+	// Full, then emptied through bypass: only the latched flag is left
+	sim.advance(6000000000ULL);
+	CHECK(dev.setFifoMode(ISM_BYPASS_MODE));
+	CHECK(dev.setFifoMode(ISM_STREAM_MODE));
+	CHECK_EQ(sim.getFifoLevel(), 0);
+
+	CHECK(dev.getEvents(&events));
+	CHECK(events.events & ISM_EVENT_FIFO_OVERRUN);
+
+	// Cleared on the device by that read, reported once
+	CHECK(dev.readFifo(&fifo));
+	CHECK(fifo.overrun);
+	CHECK(dev.readFifo(&fifo));
+	CHECK(!fifo.overrun);
+
+	CHECK(dev.getEvents(&events));
+	CHECK(!(events.events & ISM_EVENT_FIFO_OVERRUN));
+}
+
+int main()
+{
+	testInjected();
+	testSources();
+	testOverrun();
+
+	return testResult("test_events");
+}
@@ -0,0 +1,306 @@
+// test_fifo_compression.cpp
+//
+// readFifo() on hand built streams of NC, NC_T_1, NC_T_2, 2xC and 3xC words:
+// the reconstructed samples, their time slots across tag counter wraps and
+// across reads, the compressed stream against the same samples sent
+// uncompressed, and blocks of readFifoBlock() ending inside a compressed word.
+
+#include "fifo_stream.h"
+#include "test_util.h"
+
+using namespace sfe_ISM330DHCX;
+
+// Accelerometer and gyroscope batched at 417Hz, one sample per time slot
+#define TEST_RATES_EQUAL 0x66
+// Accelerometer at 833Hz and gyroscope at 417Hz, a gyroscope sample every
+// second slot
+#define TEST_RATES_HALF 0x67
+
+struct FifoBuffers
+{
+	sfe_ism_raw_data_t accel[64];
+	sfe_ism_raw_data_t gyro[64];
+	uint32_t accelSlot[64];
+	uint32_t gyroSlot[64];
+	sfe_ism_fifo_data_t fifo;
+
+	FifoBuffers() : fifo{}
+	{
+		fifo.accelData = accel;
+		fifo.accelSize = 64;
+		fifo.gyroData = gyro;
+		fifo.gyroSize = 64;
+		fifo.accelSlot = accelSlot;
+		fifo.gyroSlot = gyroSlot;
+	}
+};
+
+static sfe_ism_raw_data_t sample(int16_t x, int16_t y, int16_t z)
+{
+	sfe_ism_raw_data_t s = { x, y, z };
+	return s;
+}
+
+static void checkSamples(const sfe_ism_raw_data_t* actual, const sfe_ism_raw_data_t* expected, uint16_t num)
+{
+	for( uint16_t i = 0; i < num; i++ )
+	{
+		CHECK_EQ(actual[i].xData, expected[i].xData);
+		CHECK_EQ(actual[i].yData, expected[i].yData);
+		CHECK_EQ(actual[i].zData, expected[i].zData);
+	}
+}
+
+// Every word type of both sensors, the tag counter wrapping twice and the
+// stream split over two reads
+static void testWordTypes()
+{
+	const sfe_ism_raw_data_t a[] = {
+		sample(100, -200, 16000),
+		sample(227, -328, 15999), sample(99, -201, 16126),             // 2xC, +127/-128
+		sample(114, -217, 16126), sample(98, -218, 16111), sample(97, -217, 16112), // 3xC, +15/-16
+		sample(-32768, 32767, 0),                                      // NC_T_1
+		sample(5, 6, 7),                                               // NC_T_2
+		sample(-10, 20, -30), sample(-20, 40, -60),                    // 2xC
+		sample(1234, -1234, 4321),                                     // NC
+	};
+	const sfe_ism_raw_data_t g[] = {
+		sample(10, 20, 30),
+		sample(25, 4, 30), sample(9, 19, 31), sample(10, 20, 30),      // 3xC
+		sample(-100, 120, 30), sample(27, -8, -98),                    // 2xC
+		sample(300, 301, 302), sample(-1, -2, -3), sample(7, 8, 9),    // NC_T_2, NC_T_1, NC
+	};
+	FifoStreamBus bus;
+	QwDevISM330DHCX dev;
+	FifoBuffers first;
+	FifoBuffers second;
+
+	bus.setBatchRates(TEST_RATES_EQUAL);
+
+	// Slot 0, tag counter 0
+	bus.addNc(false, 0, 0, a[0]);
+	bus.addNc(true, 0, 0, g[0]);
+	// Slot 3, counter 3
+	bus.add2xC(false, 3, a[0], &a[1]);
+	bus.add3xC(true, 3, g[0], &g[1]);
+	// Slot 5, counter wraps to 1
+	bus.add3xC(false, 5, a[2], &a[3]);
+	// Slot 6
+	bus.add2xC(true, 6, g[3], &g[4]);
+	// Slot 7
+	bus.addNc(false, 7, 1, a[6]);
+	// Slot 8, counter wraps to 0
+	bus.addNc(true, 8, 2, g[6]);
+	bus.addNc(true, 8, 1, g[7]);
+	bus.addNc(true, 8, 0, g[8]);
+	// Slot 9
+	bus.addNc(false, 9, 2, a[7]);
+	// Slot 10
+	bus.add2xC(false, 10, a[7], &a[8]);
+	bus.addNc(false, 10, 0, a[10]);
+
+	CHECK_EQ(bus.getLevel(), 13);
+
+	dev.setCommunicationBus(bus, ISM330DHCX_ADDRESS_HIGH);
+
+	// The decoder keeps the last samples and the slot between reads
+	CHECK(dev.readFifo(&first.fifo, 6));
+	CHECK(dev.readFifo(&second.fifo));
+	CHECK_EQ(bus.getLevel(), 0);
+
+	CHECK_EQ(first.fifo.numAccel, 6);
+	CHECK_EQ(first.fifo.numGyro, 6);
+	CHECK_EQ(second.fifo.numAccel, 5);
+	CHECK_EQ(second.fifo.numGyro, 3);
+
+	checkSamples(first.accel, &a[0], 6);
+	checkSamples(second.accel, &a[6], 5);
+	checkSamples(first.gyro, &g[0], 6);
+	checkSamples(second.gyro, &g[6], 3);
+
+	for( uint16_t i = 0; i < 6; i++ )
+	{
+		CHECK_EQ(first.accelSlot[i], i);
+		CHECK_EQ(first.gyroSlot[i], i);
+	}
+
+	for( uint16_t i = 0; i < 5; i++ )
+		CHECK_EQ(second.accelSlot[i], 6 + i);
+
+	for( uint16_t i = 0; i < 3; i++ )
+		CHECK_EQ(second.gyroSlot[i], 6 + i);
+
+	// Every slot accounted for
+	CHECK_EQ(first.fifo.accelMissing + second.fifo.accelMissing, 0);
+	CHECK_EQ(first.fifo.gyroMissing + second.fifo.gyroMissing, 0);
+	CHECK_EQ(first.fifo.numDropped + second.fifo.numDropped, 0);
+}
+
+// T-1 and T-2 are sample periods of the sensor, not slots
+static void testSlowerSensor()
+{
+	const sfe_ism_raw_data_t g[] = {
+		sample(0, 0, 0),
+		sample(1, 2, 3), sample(3, 5, 7), sample(-5, -9, -9),    // 3xC
+		sample(60, -60, 0), sample(-60, 60, 0),                  // 2xC
+		sample(1000, 2000, 3000),                                // NC_T_1
+	};
+	FifoStreamBus bus;
+	QwDevISM330DHCX dev;
+	FifoBuffers data;
+
+	bus.setBatchRates(TEST_RATES_HALF);
+
+	// The accelerometer fills every slot, gyroscope samples are at even slots
+	for( uint32_t slot = 0; slot <= 14; slot++ )
+	{
+		bus.addNc(false, slot, 0, sample((int16_t)slot, 0, 0));
+
+		if( slot == 0 )
+			bus.addNc(true, 0, 0, g[0]);
+		else if( slot == 6 )
+			bus.add3xC(true, 6, g[0], &g[1]);
+		else if( slot == 12 )
+			bus.add2xC(true, 12, g[3], &g[4]);
+		else if( slot == 14 )
+			bus.addNc(true, 14, 1, g[6]);
+	}
+
+	dev.setCommunicationBus(bus, ISM330DHCX_ADDRESS_HIGH);
+
+	CHECK(dev.readFifo(&data.fifo));
+	CHECK_EQ(data.fifo.numGyro, 7);
+	CHECK_EQ(data.fifo.numAccel, 15);
+	checkSamples(data.gyro, g, 7);
+
+	for( uint16_t i = 0; i < 7; i++ )
+		CHECK_EQ(data.gyroSlot[i], 2 * i);
+
+	CHECK_EQ(data.fifo.gyroMissing, 0);
+	CHECK_EQ(data.fifo.accelMissing, 0);
+}
+
+// A slot jump larger than the sample period counts the samples in between 
+// as missing
+static void testGap()
+{
+	FifoStreamBus bus;
+	QwDevISM330DHCX dev;
+	FifoBuffers data;
+
+	bus.setBatchRates(TEST_RATES_EQUAL);
+	bus.addNc(false, 0, 0, sample(1, 1, 1));
+	bus.addNc(false, 1, 0, sample(2, 2, 2));
+	// Slots 2 and 3 lost, the counter still tells the distance
+	bus.addNc(false, 4, 0, sample(5, 5, 5));
+
+	dev.setCommunicationBus(bus, ISM330DHCX_ADDRESS_HIGH);
+
+	CHECK(dev.readFifo(&data.fifo));
+	CHECK_EQ(data.fifo.numAccel, 3);
+	CHECK_EQ(data.accelSlot[2], 4);
+	CHECK_EQ(data.fifo.accelMissing, 2);
+}
+
+// A slowly moving signal through the compressor picks all word types and 
+// decodes to the same samples as the uncompressed stream
+static void testCompressedMatchesPlain()
+{
+	sfe_ism_raw_data_t samples[60];
+	FifoStreamBus plainBus;
+	FifoStreamBus compressedBus;
+	QwDevISM330DHCX plainDev;
+	QwDevISM330DHCX compressedDev;
+	FifoBuffers plain;
+	FifoBuffers compressed;
+
+	for( int i = 0; i < 60; i++ )
+	{
+		// Steps of 3, 60 and 3000 LSB
+		int step = i < 20 ? 3 : i < 40 ? 60 : 3000;
+		samples[i] = sample((int16_t)(i * step), (int16_t)(-i * step), (int16_t)(16000 + (i & 1)));
+	}
+
+	plainBus.setBatchRates(TEST_RATES_EQUAL);
+	compressedBus.setBatchRates(TEST_RATES_EQUAL);
+	plainBus.addSamples(false, 0, samples, 60, false);
+	compressedBus.addSamples(false, 0, samples, 60, true);
+
+	CHECK_EQ(plainBus.getLevel(), 60);
+	CHECK(compressedBus.getLevel() < 45);
+
+	plainDev.setCommunicationBus(plainBus, ISM330DHCX_ADDRESS_HIGH);
+	compressedDev.setCommunicationBus(compressedBus, ISM330DHCX_ADDRESS_HIGH);
+
+	CHECK(plainDev.readFifo(&plain.fifo));
+	CHECK(compressedDev.readFifo(&compressed.fifo));
+
+	CHECK_EQ(plain.fifo.numAccel, 60);
+	CHECK_EQ(compressed.fifo.numAccel, 60);
+	checkSamples(compressed.accel, samples, 60);
+	checkSamples(plain.accel, samples, 60);
+
+	for( uint16_t i = 0; i < 60; i++ )
+		CHECK_EQ(compressed.accelSlot[i], plain.accelSlot[i]);
+
+	CHECK_EQ(compressed.fifo.accelMissing, 0);
+}
+
+// Blocks that end inside a 2xC or 3xC word: the samples past the end start
+// the next block, every block holds exactly "block" samples and none is lost
+static void testBlockCarry(uint16_t block)
+{
+	sfe_ism_raw_data_t samples[60];
+	FifoStreamBus bus;
+	QwDevISM330DHCX dev;
+	FifoBuffers data;
+	uint16_t total = 0;
+
+	for( int i = 0; i < 60; i++ )
+		samples[i] = sample((int16_t)(i * 3), (int16_t)(-i * 3), 16000);
+
+	bus.setBatchRates(TEST_RATES_EQUAL);
+	bus.addSamples(false, 0, samples, 60, true);
+
+	// The setters go through the ST context set up by init()
+	CHECK(bus.writeRegisterByte(ISM330DHCX_ADDRESS_HIGH, ISM330DHCX_WHO_AM_I, ISM330DHCX_ID));
+	dev.setCommunicationBus(bus, ISM330DHCX_ADDRESS_HIGH);
+	CHECK(dev.init());
+	CHECK(dev.setFifoCompression(ISM_FIFO_COMPRESSION_ALWAYS));
+	CHECK(dev.setBatchCounter(ISM_XL_BATCH_EVENT, block));
+
+	// No room past the block, an overshoot would be dropped
+	data.fifo.accelSize = block;
+
+	while( total < 60 )
+	{
+		if( !dev.readFifoBlock(&data.fifo) )
+			break;
+
+		CHECK_EQ(data.fifo.numAccel, block);
+		CHECK_EQ(data.fifo.numDropped, 0);
+		checkSamples(data.accel, &samples[total], block);
+
+		for( uint16_t i = 0; i < block; i++ )
+			CHECK_EQ(data.accelSlot[i], total + i);
+
+		total += block;
+	}
+
+	CHECK_EQ(total, 60);
+	CHECK_EQ(bus.getLevel(), 0);
+	CHECK(!dev.readFifoBlock(&data.fifo));
+	CHECK_EQ(data.fifo.numAccel, 0);
+}
+
+int main()
+{
+	testWordTypes();
+	testSlowerSensor();
+	testGap();
+	testCompressedMatchesPlain();
+	testBlockCarry(10);
+	testBlockCarry(1);
+
+	return testResult("test_fifo_compression");
+}
@@ -0,0 +1,224 @@
+// test_fifo_time.cpp
+//
+// accelTime/gyroTime from readFifo() against the instants the simulated
+// device batched the samples at: samples before the first TIMESTAMP word,
+// the slot period measured between words against the driver's nominal one,
+// the 32 bit counter rolling over, and every timestamp decimation.
+
+#include "sfe_ism330dhcx.h"
+#include "sfe_ism330dhcx_sim.h"
+#include "test_util.h"
+#include <vector>
+
+using namespace sfe_ISM330DHCX;
+
+// The simulator batches slot k at (k + 1) periods of 104Hz after the FIFO
+// started. The driver starts from 6667Hz / 64, 0.16% faster, until it has
+// measured the period between two TIMESTAMP words.
+#define TEST_SLOT_NS 9615385ULL
+
+// Error per slot of the nominal period
+#define TEST_NOMINAL_NS_PER_SLOT 16000
+
+// Reads every 100ms
+#define TEST_READ_NS 100000000ULL
+
+#define TEST_BUFFER_SIZE 128
+
+static sfe_ism_raw_data_t accel[TEST_BUFFER_SIZE];
+static sfe_ism_raw_data_t gyro[TEST_BUFFER_SIZE];
+static uint64_t accelTime[TEST_BUFFER_SIZE];
+static uint64_t gyroTime[TEST_BUFFER_SIZE];
+static uint32_t timestamps[TEST_BUFFER_SIZE];
+
+// When the simulated FIFO and timestamp counter started
+struct TestClock
+{
+	uint64_t fifoStart;
+	uint64_t counterStart;
+	uint32_t counterOffset;
+};
+
+static void configure(QwSimISM330DHCX& sim, QwDevISM330DHCX& dev, uint8_t dec, bool timestamp)
+{
+	dev.setCommunicationBus(sim, ISM330DHCX_ADDRESS_HIGH);
+	CHECK(dev.init());
+	CHECK(dev.setAccelDataRate(ISM_XL_ODR_104Hz));
+	CHECK(dev.setGyroDataRate(ISM_GY_ODR_104Hz));
+	CHECK(dev.setAccelFifoBatchSet(ISM_XL_BATCH_AT_104Hz));
+	CHECK(dev.setGyroFifoBatchSet(ISM_GY_BATCH_AT_52Hz));
+	CHECK(dev.setFifoTimestampDec(dec));
+	CHECK(dev.setFifoMode(ISM_STREAM_MODE));
+
+	if( timestamp )
+		CHECK(dev.enableTimestamp());
+}
+
+// Device time of FIFO time slot "slot", before the counter started too
+static int64_t slotDeviceNs(const TestClock& clock, uint32_t slot)
+{
+	int64_t sinceCounter = (int64_t)(clock.fifoStart + (slot + 1) * TEST_SLOT_NS) - (int64_t)clock.counterStart;
+
+	return (int64_t)clock.counterOffset * ISM_TIMESTAMP_NS + sinceCounter;
+}
+
+// Reads the FIFO every 100ms for "ns", the times of all samples in order
+static void collect(QwSimISM330DHCX& sim, QwDevISM330DHCX& dev, uint64_t ns,
+                    std::vector<uint64_t>* accelTimes, std::vector<uint64_t>* gyroTimes)
+{
+	sfe_ism_fifo_data_t fifo = {};
+
+	fifo.accelData = accel;
+	fifo.accelSize = TEST_BUFFER_SIZE;
+	fifo.accelTime = accelTime;
+	fifo.gyroData = gyro;
+	fifo.gyroSize = TEST_BUFFER_SIZE;
+	fifo.gyroTime = gyroTime;
+	fifo.timestampData = timestamps;
+	fifo.timestampSize = TEST_BUFFER_SIZE;
+
+	for( uint64_t t = 0; t < ns; t += TEST_READ_NS )
+	{
+		sim.advance(TEST_READ_NS);
+
+		CHECK(dev.readFifo(&fifo));
+		CHECK_EQ(fifo.numDropped, 0);
+		CHECK(!fifo.overrun);
+
+		accelTimes->insert(accelTimes->end(), accelTime, accelTime + fifo.numAccel);
+		gyroTimes->insert(gyroTimes->end(), gyroTime, gyroTime + fifo.numGyro);
+	}
+}
+
+// Sample i of a sensor batched every "step" slots, from the first slot on,
+// with a TIMESTAMP word every "slotsPerWord" slots from slot "first". Up to
+// the second word the samples are timed from the first one with the nominal
+// period, after that from the last word before them with the period measured
+// between words, which is off by up to a tick over "slotsPerWord" slots.
+static void checkTimes(const TestClock& clock, const std::vector<uint64_t>& times, uint32_t step,
+                       uint32_t first, uint32_t slotsPerWord)
+{
+	for( size_t i = 0; i < times.size(); i++ )
+	{
+		uint32_t slot = (uint32_t)i * step;
+		double tolerance = ISM_TIMESTAMP_NS + 1000;
+
+		if( slot < first + slotsPerWord )
+			tolerance += (double)(slot < first ? first - slot : slot - first) * TEST_NOMINAL_NS_PER_SLOT;
+		else
+			tolerance += (double)((slot - first) % slotsPerWord) * ISM_TIMESTAMP_NS / slotsPerWord;
+
+		CHECK_NEAR((double)times[i], (double)slotDeviceNs(clock, slot), tolerance);
+
+		if( i > 0 )
+			CHECK(times[i] > times[i - 1]);
+	}
+}
+
+// Every decimation: with a word every slot up to one in 32, the first word in
+// slot 0 and the period measured from the second word on
+static void testDecimation(uint8_t dec, uint32_t slotsPerWord)
+{
+	QwSimISM330DHCX sim;
+	QwDevISM330DHCX dev;
+	std::vector<uint64_t> accelTimes, gyroTimes;
+	TestClock clock;
+
+	configure(sim, dev, dec, true);
+	clock.fifoStart = sim.getTime();
+	clock.counterStart = sim.getTime();
+	clock.counterOffset = 0;
+
+	collect(sim, dev, 1000000000ULL, &accelTimes, &gyroTimes);
+
+	CHECK(accelTimes.size() >= 100);
+	CHECK(gyroTimes.size() >= 50);
+
+	// The nominal period holds up to the second word
+	checkTimes(clock, accelTimes, 1, 0, slotsPerWord);
+	checkTimes(clock, gyroTimes, 2, 0, slotsPerWord);
+
+	// Measured from there on, e.g. over the last 64 slots
+	size_t last = accelTimes.size() - 1;
+	CHECK_NEAR((double)(accelTimes[last] - accelTimes[last - 64]), 64.0 * TEST_SLOT_NS, 2.0 * ISM_TIMESTAMP_NS);
+}
+
+// The counter starts after the FIFO: the samples before the first word are
+// timed back from it with the nominal period
+static void testBeforeFirstWord()
+{
+	QwSimISM330DHCX sim;
+	QwDevISM330DHCX dev;
+	std::vector<uint64_t> accelTimes, gyroTimes;
+	TestClock clock;
+
+	configure(sim, dev, ISM_DEC_8, false);
+	clock.fifoStart = sim.getTime();
+
+	// Slots 0 - 4 without a TIMESTAMP word, the first one in slot 8
+	sim.advance(5 * TEST_SLOT_NS + TEST_SLOT_NS / 2);
+	CHECK(dev.enableTimestamp());
+	sim.setTimestamp(1000000);
+	clock.counterStart = sim.getTime();
+	clock.counterOffset = 1000000;
+
+	collect(sim, dev, 500000000ULL, &accelTimes, &gyroTimes);
+
+	// Eight slots timed back from the word in slot 8, the next one measures
+	// the period
+	checkTimes(clock, accelTimes, 1, 8, 8);
+	checkTimes(clock, gyroTimes, 2, 8, 8);
+	CHECK(accelTimes[0] < (uint64_t)1000000 * ISM_TIMESTAMP_NS);
+}
+
+// The samples keep counting up past 2^32 ticks
+static void testRollOver()
+{
+	QwSimISM330DHCX sim;
+	QwDevISM330DHCX dev;
+	std::vector<uint64_t> accelTimes, gyroTimes;
+	TestClock clock;
+
+	configure(sim, dev, ISM_DEC_8, true);
+	sim.setTimestamp(0xFFFFFFFF - 20000);
+	clock.fifoStart = sim.getTime();
+	clock.counterStart = sim.getTime();
+	clock.counterOffset = 0xFFFFFFFF - 20000;
+
+	// Half a second before the roll over, half after
+	collect(sim, dev, 1000000000ULL, &accelTimes, &gyroTimes);
+
+	checkTimes(clock, accelTimes, 1, 0, 8);
+	checkTimes(clock, gyroTimes, 2, 0, 8);
+	CHECK(accelTimes.front() < 0xFFFFFFFFULL * ISM_TIMESTAMP_NS);
+	CHECK(accelTimes.back() > 0x100000000ULL * ISM_TIMESTAMP_NS);
+}
+
+// An oscillator off by a few thousand ppm: the samples and the counter run
+// off together, device time stays the simulator's 104Hz schedule
+static void testClockError()
+{
+	QwSimISM330DHCX sim;
+	QwDevISM330DHCX dev;
+	std::vector<uint64_t> accelTimes, gyroTimes;
+
+	sim.setClockError(3000);
+	configure(sim, dev, ISM_DEC_1, true);
+
+	collect(sim, dev, 500000000ULL, &accelTimes, &gyroTimes);
+
+	for( size_t i = 1; i < accelTimes.size(); i++ )
+		CHECK_NEAR((double)(accelTimes[i] - accelTimes[0]), (double)i * TEST_SLOT_NS, ISM_TIMESTAMP_NS + 1000);
+}
+
+int main()
+{
+	testDecimation(ISM_DEC_1, 1);
+	testDecimation(ISM_DEC_8, 8);
+	testDecimation(ISM_DEC_32, 32);
+	testBeforeFirstWord();
+	testRollOver();
+	testClockError();
+
+	return testResult("test_fifo_time");
+}
@@ -0,0 +1,246 @@
+// test_fifo_view.cpp
+//
+// QwFifoView and QwFifoWord over the words readFifoRaw() read: the tag and
+// tag counter of every word, the axes, temperature and timestamp decoded
+// against the values the simulated device batched, two views walking the
+// same buffer independently, and compressed words of a hand built stream,
+// which the simulated device doesn't produce.
+
+#include "sfe_ism330dhcx.h"
+#include "sfe_ism330dhcx_sim.h"
+#include "sfe_ism_fifo_view.h"
+#include "fifo_stream.h"
+#include "test_util.h"
+
+using namespace sfe_ISM330DHCX;
+
+// The simulator batches slot k at (k + 1) periods of 104Hz after the FIFO
+// started
+#define TEST_SLOT_NS 9615385ULL
+
+static uint8_t words[QwSimISM330DHCX::kFifoWords * ISM_FIFO_WORD_SIZE];
+
+// Raw values at 2g, 250dps and 256 LSB/C from 25C
+static const int16_t accelRaw[3] = { 100, -200, 16000 };
+static const int16_t gyroRaw[3] = { -300, 400, 1000 };
+static const int16_t tempRaw = 512;
+
+class ConstantSource : public QwSimSource
+{
+public:
+
+	void accel(uint64_t timeNs, float* mg)
+	{
+		(void)timeNs;
+
+		for( int i = 0; i < 3; i++ )
+			mg[i] = accelRaw[i] * 0.061f;
+	}
+
+	void gyro(uint64_t timeNs, float* mdps)
+	{
+		(void)timeNs;
+
+		for( int i = 0; i < 3; i++ )
+			mdps[i] = gyroRaw[i] * 8.75f;
+	}
+
+	float temp(uint64_t timeNs)
+	{
+		(void)timeNs;
+
+		return 25.0f + tempRaw / 256.0f;
+	}
+};
+
+static void checkRaw(const QwFifoWord& word, const int16_t* expected)
+{
+	sfe_ism_raw_data_t raw;
+
+	word.getRaw(&raw);
+	CHECK_EQ(raw.xData, expected[0]);
+	CHECK_EQ(raw.yData, expected[1]);
+	CHECK_EQ(raw.zData, expected[2]);
+}
+
+// Accelerometer at 104Hz, gyroscope at 52Hz, temperature at 52Hz and a
+// TIMESTAMP word every slot
+static void testDecode()
+{
+	QwSimISM330DHCX sim;
+	QwDevISM330DHCX dev;
+	ConstantSource source;
+	uint16_t level;
+	uint16_t numWords;
+	uint16_t numAccel = 0, numGyro = 0, numTemp = 0, numSlots = 0;
+	uint8_t count = 0;
+	uint8_t val;
+
+	sim.setSource(&source);
+	dev.setCommunicationBus(sim, ISM330DHCX_ADDRESS_HIGH);
+	CHECK(dev.init());
+	CHECK(dev.setAccelFullScale(ISM_2g));
+	CHECK(dev.setGyroFullScale(ISM_250dps));
+	CHECK(dev.setAccelDataRate(ISM_XL_ODR_104Hz));
+	CHECK(dev.setGyroDataRate(ISM_GY_ODR_104Hz));
+	CHECK(dev.setAccelFifoBatchSet(ISM_XL_BATCH_AT_104Hz));
+	CHECK(dev.setGyroFifoBatchSet(ISM_GY_BATCH_AT_52Hz));
+	CHECK(dev.setFifoTimestampDec(ISM_DEC_1));
+	CHECK(dev.enableTimestamp());
+
+	// ODR_T_BATCH at 52Hz, the driver has no setter for it
+	CHECK_EQ(dev.readRegisterRegion(ISM330DHCX_FIFO_CTRL4, &val, 1), 0);
+	val |= 0x30;
+	CHECK_EQ(dev.writeRegisterRegion(ISM330DHCX_FIFO_CTRL4, &val, 1), 0);
+
+	CHECK(dev.setFifoMode(ISM_STREAM_MODE));
+
+	sim.advance(200000000ULL);
+	level = sim.getFifoLevel();
+
+	CHECK(dev.readFifoRaw(words, QwSimISM330DHCX::kFifoWords, &numWords));
+	CHECK_EQ(numWords, level);
+	CHECK_EQ(sim.getFifoLevel(), 0);
+
+	QwFifoView view(words, numWords);
+	CHECK_EQ(view.size(), numWords);
+
+	for( QwFifoWord word : view )
+	{
+		CHECK(!word.isCompressed());
+		CHECK_EQ(word.data(), (const uint8_t*)&words[(numAccel + numGyro + numTemp + numSlots) * ISM_FIFO_WORD_SIZE + 1]);
+
+		switch( word.tag() )
+		{
+			case ISM330DHCX_TIMESTAMP_TAG:
+				// Every slot starts with one, the counter advances by one
+				if( numSlots > 0 )
+					CHECK_EQ(word.tagCount(), (count + 1) & 0x03);
+
+				count = word.tagCount();
+				CHECK_NEAR((double)word.getTimestamp(), (double)((numSlots + 1) * TEST_SLOT_NS / ISM_TIMESTAMP_NS), 1.0);
+				numSlots++;
+				break;
+
+			case ISM330DHCX_XL_NC_TAG:
+				CHECK(word.isAccel());
+				CHECK(!word.isGyro());
+				CHECK_EQ(word.tagCount(), count);
+				checkRaw(word, accelRaw);
+				numAccel++;
+				break;
+
+			case ISM330DHCX_GYRO_NC_TAG:
+				CHECK(word.isGyro());
+				CHECK(!word.isAccel());
+				CHECK_EQ(word.tagCount(), count);
+				checkRaw(word, gyroRaw);
+				numGyro++;
+				break;
+
+			case ISM330DHCX_TEMPERATURE_TAG:
+				CHECK_EQ(word.getTemp(), tempRaw);
+				numTemp++;
+				break;
+
+			default:
+				CHECK(false);
+				break;
+		}
+	}
+
+	// 200ms: 20 slots, a gyroscope and temperature sample every second one
+	CHECK_EQ(numSlots, 20);
+	CHECK_EQ(numAccel, numSlots);
+	CHECK_EQ(numGyro, numSlots / 2);
+	CHECK(numTemp >= 9 && numTemp <= 11);
+
+	// A second view over the second half, walked alongside the first with
+	// an index
+	uint16_t half = numWords / 2;
+	QwFifoView second(words + half * ISM_FIFO_WORD_SIZE, numWords - half);
+	uint16_t index = 0;
+
+	CHECK_EQ(second.size(), numWords - half);
+
+	for( QwFifoWord word : view )
+	{
+		if( index >= half )
+		{
+			CHECK_EQ(second[index - half].tag(), word.tag());
+			CHECK_EQ(second[index - half].tagCount(), word.tagCount());
+			CHECK_EQ(second[index - half].data(), word.data());
+		}
+
+		index++;
+	}
+
+	CHECK_EQ(index, numWords);
+}
+
+// Compressed words are reported for what they are, the uncompressed ones
+// between them still decode
+static void testCompressed()
+{
+	sfe_ism_raw_data_t samples[12];
+	FifoStreamBus bus;
+	QwDevISM330DHCX dev;
+	uint16_t numWords;
+	uint16_t numCompressed = 0;
+
+	for( int i = 0; i < 12; i++ )
+	{
+		samples[i].xData = (int16_t)(1000 + i);
+		samples[i].yData = (int16_t)(-1000 - 2 * i);
+		samples[i].zData = (int16_t)(16000 + 4 * i);
+	}
+
+	// 417Hz both, one sample per time slot
+	bus.setBatchRates(0x66);
+	bus.addSamples(false, 0, samples, 12, true);
+	bus.addNc(true, 12, 1, samples[11]);
+	bus.addNc(true, 12, 2, samples[10]);
+
+	dev.setCommunicationBus(bus, ISM330DHCX_ADDRESS_HIGH);
+	CHECK(dev.readFifoRaw(words, QwSimISM330DHCX::kFifoWords, &numWords));
+	CHECK_EQ(bus.getLevel(), 0);
+
+	// NC, three 3xC, a 2xC and the two gyroscope words
+	CHECK_EQ(numWords, 7);
+
+	QwFifoView view(words, numWords);
+
+	// The first sample uncompressed, the rest 3xC and 2xC
+	CHECK(!view[0].isCompressed());
+	CHECK(view[0].isAccel());
+	CHECK_EQ(view[0].tagCount(), 0);
+	const int16_t first[3] = { samples[0].xData, samples[0].yData, samples[0].zData };
+	checkRaw(view[0], first);
+
+	for( QwFifoWord word : view )
+	{
+		if( !word.isCompressed() )
+			continue;
+
+		CHECK(!word.isAccel());
+		CHECK(!word.isGyro());
+		numCompressed++;
+	}
+
+	CHECK_EQ(view[1].tag(), ISM330DHCX_XL_3XC_TAG);
+	CHECK_EQ(view[4].tag(), ISM330DHCX_XL_2XC_TAG);
+
+	// NC_T_1 and NC_T_2 count as compressed, they belong to the stream
+	CHECK_EQ(view[numWords - 2].tag(), ISM330DHCX_GYRO_NC_T_1_TAG);
+	CHECK_EQ(view[numWords - 1].tag(), ISM330DHCX_GYRO_NC_T_2_TAG);
+	CHECK(view[numWords - 1].isCompressed());
+	CHECK_EQ(numCompressed, numWords - 1);
+}
+
+int main()
+{
+	testDecode();
+	testCompressed();
+
+	return testResult("test_fifo_view");
+}
@@ -0,0 +1,103 @@
+// test_int.cpp
+//
+// The integer outputs against the float outputs at every full scale, with the
+// fixed point factors derived from ISM_GYRO_INT_FRAC_BITS.
+
+#include "sfe_ism330dhcx.h"
+#include "sfe_ism330dhcx_sim.h"
+#include "test_util.h"
+
+using namespace sfe_ISM330DHCX;
+
+static const int16_t rawValues[] = { 0, 1, -1, 1000, -1000, 12345, 32767, -32768 };
+
+static void testGyro()
+{
+	static const struct
+	{
+		uint8_t fullScale;
+		double mdps;
+	} scales[] = {
+		{ ISM_125dps, 4.375 },
+		{ ISM_250dps, 8.75 },
+		{ ISM_500dps, 17.5 },
+		{ ISM_1000dps, 35 },
+		{ ISM_2000dps, 70 },
+		{ ISM_4000dps, 140 },
+	};
+	QwSimISM330DHCX sim;
+	QwDevISM330DHCX dev;
+	const double unit = 1.0 / (1L << ISM_GYRO_INT_FRAC_BITS);
+	// Exact with 3 fractional bits or more, 4.375 mdps is rounded with fewer
+	const double tolerance = ISM_GYRO_INT_FRAC_BITS >= 3 ? 0 : 32768 * unit / 2;
+
+	dev.setCommunicationBus(sim, ISM330DHCX_ADDRESS_HIGH);
+	CHECK(dev.init());
+
+	for( const auto& scale : scales )
+	{
+		CHECK(dev.setGyroFullScale(scale.fullScale));
+
+		for( int16_t value : rawValues )
+		{
+			sfe_ism_raw_data_t raw = { value, (int16_t)-value, (int16_t)(value / 3) };
+			sfe_ism_int_data_t fixed;
+			sfe_ism_data_t mdps;
+
+			dev.convertIntGyro(&raw, &fixed);
+			dev.convertGyroData(&raw, &mdps);
+
+			CHECK_NEAR(fixed.xData * unit, raw.xData * scale.mdps, tolerance);
+			CHECK_NEAR(fixed.yData * unit, raw.yData * scale.mdps, tolerance);
+			CHECK_NEAR(fixed.zData * unit, raw.zData * scale.mdps, tolerance);
+			CHECK_NEAR(fixed.xData * unit, mdps.xData, fabs(mdps.xData) * 1e-6 + tolerance);
+			CHECK_NEAR(fixed.zData * unit, mdps.zData, fabs(mdps.zData) * 1e-6 + tolerance);
+		}
+	}
+}
+
+static void testAccel()
+{
+	static const struct
+	{
+		uint8_t fullScale;
+		int32_t ug;
+	} scales[] = {
+		{ ISM_2g, 61 },
+		{ ISM_4g, 122 },
+		{ ISM_8g, 244 },
+		{ ISM_16g, 488 },
+	};
+	QwSimISM330DHCX sim;
+	QwDevISM330DHCX dev;
+
+	dev.setCommunicationBus(sim, ISM330DHCX_ADDRESS_HIGH);
+	CHECK(dev.init());
+
+	for( const auto& scale : scales )
+	{
+		CHECK(dev.setAccelFullScale(scale.fullScale));
+
+		for( int16_t value : rawValues )
+		{
+			sfe_ism_raw_data_t raw = { value, (int16_t)-value, 0 };
+			sfe_ism_int_data_t ug;
+			sfe_ism_data_t mg;
+
+			dev.convertIntAccel(&raw, &ug);
+			dev.convertAccelData(&raw, &mg);
+
+			CHECK_EQ(ug.xData, raw.xData * scale.ug);
+			CHECK_EQ(ug.yData, raw.yData * scale.ug);
+			CHECK_NEAR(ug.xData * 1e-3, mg.xData, fabs(mg.xData) * 1e-6);
+		}
+	}
+}
+
+int main()
+{
+	testGyro();
+	testAccel();
+
+	return testResult("test_int");
+}
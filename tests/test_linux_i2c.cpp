@@ -0,0 +1,252 @@
+// test_linux_i2c.cpp
+//
+// QwLinuxI2C with rdwr() replaced by a fake i2c-dev driver: the I2C_RDWR
+// messages of reads, writes and mixed batches, the split of long batches
+// into several calls, and a failing ioctl.
+
+#include "sfe_bus_linux.h"
+#include "test_util.h"
+#include <linux/i2c.h>
+#include <linux/i2c-dev.h>
+#include <string.h>
+#include <vector>
+
+using namespace sfe_ISM330DHCX;
+
+#define TEST_ADDRESS 0x6B
+
+// One message as the driver saw it, the bytes of writes are copied
+struct FakeMsg
+{
+	uint16_t addr;
+	uint16_t flags;
+	uint16_t len;
+	std::vector<uint8_t> bytes;
+};
+
+// Answers the messages like a device with auto-incrementing registers
+class FakeI2C : public QwLinuxI2C
+{
+public:
+
+	FakeI2C() : failCall{-1}, _pointer{0}
+	{
+		for( int i = 0; i < 128; i++ )
+			registers[i] = (uint8_t)(i * 5 + 1);
+	}
+
+	std::vector<std::vector<FakeMsg> > calls;
+	uint8_t registers[128];
+	int failCall;
+
+protected:
+
+	int rdwr(struct i2c_rdwr_ioctl_data* rdwrData)
+	{
+		std::vector<FakeMsg> msgs;
+
+		if( (int)calls.size() == failCall )
+		{
+			calls.push_back(msgs);
+			return -1;
+		}
+
+		for( uint32_t i = 0; i < rdwrData->nmsgs; i++ )
+		{
+			struct i2c_msg* msg = &rdwrData->msgs[i];
+			FakeMsg fake = { msg->addr, msg->flags, msg->len, std::vector<uint8_t>() };
+
+			if( msg->flags & I2C_M_RD )
+			{
+				for( uint16_t j = 0; j < msg->len; j++ )
+					msg->buf[j] = registers[(_pointer++) & 0x7F];
+			}
+			else
+			{
+				fake.bytes.assign(msg->buf, msg->buf + msg->len);
+
+				// The first byte moves the register pointer, the rest is data
+				_pointer = msg->buf[0];
+				for( uint16_t j = 1; j < msg->len; j++ )
+					registers[(_pointer++) & 0x7F] = msg->buf[j];
+			}
+
+			msgs.push_back(fake);
+		}
+
+		calls.push_back(msgs);
+		return 0;
+	}
+
+private:
+
+	uint8_t _pointer;
+};
+
+// Register address then data with a repeated start, one call
+static void testRead()
+{
+	FakeI2C bus;
+	uint8_t data[300];
+
+	CHECK_EQ(bus.readRegisterRegion(TEST_ADDRESS, 0x22, data, 12), 0);
+
+	CHECK_EQ(bus.calls.size(), 1);
+	CHECK_EQ(bus.calls[0].size(), 2);
+	CHECK_EQ(bus.calls[0][0].addr, TEST_ADDRESS);
+	CHECK_EQ(bus.calls[0][0].flags, 0);
+	CHECK_EQ(bus.calls[0][0].len, 1);
+	CHECK_EQ(bus.calls[0][0].bytes[0], 0x22);
+	CHECK_EQ(bus.calls[0][1].addr, TEST_ADDRESS);
+	CHECK_EQ(bus.calls[0][1].flags, I2C_M_RD);
+	CHECK_EQ(bus.calls[0][1].len, 12);
+
+	for( int i = 0; i < 12; i++ )
+		CHECK_EQ(data[i], bus.registers[0x22 + i]);
+
+	// No chunk limit, a FIFO burst is still one read message
+	CHECK_EQ(bus.readRegisterRegion(TEST_ADDRESS, 0x78, data, 7 * 40), 0);
+	CHECK_EQ(bus.calls.size(), 2);
+	CHECK_EQ(bus.calls[1].size(), 2);
+	CHECK_EQ(bus.calls[1][1].len, 7 * 40);
+}
+
+// Register address and data in one message
+static void testWrite()
+{
+	FakeI2C bus;
+	const uint8_t data[] = { 0xA0, 0x4C, 0x03 };
+
+	CHECK_EQ(bus.writeRegisterRegion(TEST_ADDRESS, 0x10, data, 3), 0);
+
+	CHECK_EQ(bus.calls.size(), 1);
+	CHECK_EQ(bus.calls[0].size(), 1);
+	CHECK_EQ(bus.calls[0][0].addr, TEST_ADDRESS);
+	CHECK_EQ(bus.calls[0][0].flags, 0);
+	CHECK_EQ(bus.calls[0][0].len, 4);
+	CHECK_EQ(bus.calls[0][0].bytes[0], 0x10);
+	CHECK(memcmp(&bus.calls[0][0].bytes[1], data, 3) == 0);
+	CHECK(memcmp(&bus.registers[0x10], data, 3) == 0);
+
+	CHECK(bus.writeRegisterByte(TEST_ADDRESS, 0x12, 0x55));
+	CHECK_EQ(bus.calls[1][0].len, 2);
+	CHECK_EQ(bus.registers[0x12], 0x55);
+
+	// ping() only moves the register pointer
+	CHECK(bus.ping(TEST_ADDRESS));
+	CHECK_EQ(bus.calls[2].size(), 1);
+	CHECK_EQ(bus.calls[2][0].len, 1);
+}
+
+// Writes and reads in order in one call, a read sees the write before it
+static void testMixedBatch()
+{
+	FakeI2C bus;
+	uint8_t ctrl[2] = { 0x44, 0x4C };
+	uint8_t readBack[2];
+	uint8_t status;
+	QwBusTransfer batch[] = {
+		{ 0x10, ctrl, 2, false },
+		{ 0x10, readBack, 2, true },
+		{ 0x1E, &status, 1, true },
+	};
+
+	CHECK_EQ(bus.transferBatch(TEST_ADDRESS, batch, 3), 0);
+
+	CHECK_EQ(bus.calls.size(), 1);
+	CHECK_EQ(bus.calls[0].size(), 5);
+
+	CHECK_EQ(bus.calls[0][0].flags, 0);
+	CHECK_EQ(bus.calls[0][0].len, 3);
+	CHECK_EQ(bus.calls[0][0].bytes[0], 0x10);
+	CHECK_EQ(bus.calls[0][0].bytes[1], 0x44);
+	CHECK_EQ(bus.calls[0][0].bytes[2], 0x4C);
+
+	CHECK_EQ(bus.calls[0][1].flags, 0);
+	CHECK_EQ(bus.calls[0][1].bytes[0], 0x10);
+	CHECK_EQ(bus.calls[0][2].flags, I2C_M_RD);
+	CHECK_EQ(bus.calls[0][2].len, 2);
+
+	CHECK_EQ(bus.calls[0][3].bytes[0], 0x1E);
+	CHECK_EQ(bus.calls[0][4].flags, I2C_M_RD);
+	CHECK_EQ(bus.calls[0][4].len, 1);
+
+	CHECK_EQ(readBack[0], 0x44);
+	CHECK_EQ(readBack[1], 0x4C);
+	CHECK_EQ(status, bus.registers[0x1E]);
+}
+
+// A read takes two messages and is never split across calls
+static void testSplit()
+{
+	FakeI2C bus;
+	uint8_t data[100];
+	QwBusTransfer batch[100];
+	uint32_t total = 0;
+
+	for( int i = 0; i < 100; i++ )
+		batch[i] = { (uint8_t)i, &data[i], 1, (i % 3) != 0 };
+
+	CHECK_EQ(bus.transferBatch(TEST_ADDRESS, batch, 100), 0);
+	CHECK(bus.calls.size() > 1);
+
+	for( size_t c = 0; c < bus.calls.size(); c++ )
+	{
+		CHECK(bus.calls[c].size() <= I2C_RDWR_IOCTL_MAX_MSGS);
+
+		// A call is only cut short when the next transaction doesn't fit
+		if( c + 1 < bus.calls.size() )
+			CHECK(bus.calls[c].size() + ((bus.calls[c + 1][1].flags & I2C_M_RD) ? 2 : 1) > I2C_RDWR_IOCTL_MAX_MSGS);
+
+		// Every read message follows its register address
+		for( size_t m = 0; m < bus.calls[c].size(); m++ )
+		{
+			if( bus.calls[c][m].flags & I2C_M_RD )
+				CHECK(m > 0 && !(bus.calls[c][m - 1].flags & I2C_M_RD) && bus.calls[c][m - 1].len == 1);
+		}
+
+		total += bus.calls[c].size();
+	}
+
+	// 34 writes of one message and 66 reads of two
+	CHECK_EQ(total, 34 + 66 * 2);
+}
+
+// A failing call fails the transfer and the rest of the batch isn't sent
+static void testError()
+{
+	FakeI2C bus;
+	uint8_t data[100];
+	QwBusTransfer batch[100];
+
+	bus.failCall = 0;
+	CHECK(bus.readRegisterRegion(TEST_ADDRESS, 0x0F, data, 1) != 0);
+	bus.failCall = 1;
+	CHECK(!bus.writeRegisterByte(TEST_ADDRESS, 0x10, 0x01));
+	bus.failCall = 2;
+	CHECK(!bus.ping(TEST_ADDRESS));
+
+	for( int i = 0; i < 100; i++ )
+		batch[i] = { (uint8_t)i, &data[i], 1, true };
+
+	bus.calls.clear();
+	bus.failCall = 0;
+	CHECK(bus.transferBatch(TEST_ADDRESS, batch, 100) != 0);
+	CHECK_EQ(bus.calls.size(), 1);
+
+	// Without a device open the real driver call fails
+	QwLinuxI2C closed;
+	CHECK(closed.readRegisterRegion(TEST_ADDRESS, 0x0F, data, 1) != 0);
+	CHECK(!closed.ping(TEST_ADDRESS));
+}
+
+int main()
+{
+	testRead();
+	testWrite();
+	testMixedBatch();
+	testSplit();
+	testError();
+
+	return testResult("test_linux_i2c");
+}
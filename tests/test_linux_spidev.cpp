@@ -0,0 +1,276 @@
+// test_linux_spidev.cpp
+//
+// QwLinuxSPI with message() replaced by a fake spidev driver: the transfers
+// and chip select pattern of reads, writes and batches, the split of long
+// batches at ISM_SPIDEV_BUFSIZ and at 16 transactions per call, and the
+// rejection of a transaction longer than the driver's buffer.
+
+#include "sfe_bus_linux.h"
+#include "test_util.h"
+#include <linux/spi/spidev.h>
+#include <string.h>
+#include <vector>
+
+using namespace sfe_ISM330DHCX;
+
+// Transactions QwLinuxSPI chains into one call
+#define TEST_MAX_TRANSACTIONS 16
+
+// One transfer as the driver saw it, the transmitted bytes are copied
+struct FakeXfer
+{
+	uint32_t len;
+	bool rx;
+	uint8_t csChange;
+	uint32_t speedHz;
+	std::vector<uint8_t> tx;
+};
+
+// Answers the transfers like the device: the first byte after chip select
+// is the register, bit 7 set for a read, and the address increments.
+class FakeSPI : public QwLinuxSPI
+{
+public:
+
+	FakeSPI() : failCall{-1}, _selected{false}, _pointer{0}, _read{false}
+	{
+		_speedHz = 1000000;
+
+		for( int i = 0; i < 128; i++ )
+			registers[i] = (uint8_t)(i * 3 + 7);
+	}
+
+	std::vector<std::vector<FakeXfer> > calls;
+	uint8_t registers[128];
+	int failCall;
+
+protected:
+
+	int message(struct spi_ioc_transfer* transfers, uint32_t count)
+	{
+		std::vector<FakeXfer> xfers;
+		uint32_t bytes = 0;
+
+		if( (int)calls.size() == failCall )
+		{
+			calls.push_back(xfers);
+			return -1;
+		}
+
+		for( uint32_t i = 0; i < count; i++ )
+		{
+			struct spi_ioc_transfer* t = &transfers[i];
+			const uint8_t* tx = (const uint8_t*)(uintptr_t)t->tx_buf;
+			uint8_t* rx = (uint8_t*)(uintptr_t)t->rx_buf;
+			FakeXfer fake = { t->len, rx != nullptr, t->cs_change, t->speed_hz, std::vector<uint8_t>() };
+
+			if( tx )
+				fake.tx.assign(tx, tx + t->len);
+
+			for( uint32_t j = 0; j < t->len; j++ )
+			{
+				if( !_selected )
+				{
+					_selected = true;
+					_read = (tx[j] & 0x80) != 0;
+					_pointer = tx[j] & 0x7F;
+				}
+				else if( _read )
+					rx[j] = registers[(_pointer++) & 0x7F];
+				else
+					registers[(_pointer++) & 0x7F] = tx[j];
+			}
+
+			// cs_change releases chip select after the transfer, the last
+			// transfer of a message always releases it
+			if( t->cs_change || i + 1 == count )
+				_selected = false;
+
+			bytes += t->len;
+			xfers.push_back(fake);
+		}
+
+		// spidev's limit for one call
+		if( bytes > ISM_SPIDEV_BUFSIZ )
+			return -1;
+
+		calls.push_back(xfers);
+		return 0;
+	}
+
+private:
+
+	bool _selected;
+	uint8_t _pointer;
+	bool _read;
+};
+
+// Register byte and data with chip select held, released at the end
+static void testRead()
+{
+	FakeSPI bus;
+	uint8_t data[16];
+
+	CHECK_EQ(bus.readRegisterRegion(0, 0x22, data, 12), 0);
+
+	CHECK_EQ(bus.calls.size(), 1);
+	CHECK_EQ(bus.calls[0].size(), 2);
+	CHECK_EQ(bus.calls[0][0].len, 1);
+	CHECK_EQ(bus.calls[0][0].tx[0], 0x22 | 0x80);
+	CHECK_EQ(bus.calls[0][0].csChange, 0);
+	CHECK_EQ(bus.calls[0][0].speedHz, 1000000);
+	CHECK_EQ(bus.calls[0][1].len, 12);
+	CHECK(bus.calls[0][1].rx);
+	CHECK_EQ(bus.calls[0][1].csChange, 0);
+
+	for( int i = 0; i < 12; i++ )
+		CHECK_EQ(data[i], bus.registers[0x22 + i]);
+}
+
+static void testWrite()
+{
+	FakeSPI bus;
+	const uint8_t data[] = { 0xA0, 0x4C, 0x03 };
+
+	CHECK_EQ(bus.writeRegisterRegion(0, 0x10, data, 3), 0);
+
+	CHECK_EQ(bus.calls.size(), 1);
+	CHECK_EQ(bus.calls[0].size(), 2);
+	CHECK_EQ(bus.calls[0][0].tx[0], 0x10);
+	CHECK_EQ(bus.calls[0][0].csChange, 0);
+	CHECK_EQ(bus.calls[0][1].len, 3);
+	CHECK(!bus.calls[0][1].rx);
+	CHECK(memcmp(bus.calls[0][1].tx.data(), data, 3) == 0);
+	CHECK_EQ(bus.calls[0][1].csChange, 0);
+	CHECK(memcmp(&bus.registers[0x10], data, 3) == 0);
+}
+
+// Chip select is released after every transaction but the last
+static void testBatch()
+{
+	FakeSPI bus;
+	uint8_t ctrl[2] = { 0x44, 0x4C };
+	uint8_t readBack[2];
+	uint8_t status;
+	QwBusTransfer batch[] = {
+		{ 0x10, ctrl, 2, false },
+		{ 0x10, readBack, 2, true },
+		{ 0x1E, &status, 1, true },
+	};
+
+	CHECK_EQ(bus.transferBatch(0, batch, 3), 0);
+
+	CHECK_EQ(bus.calls.size(), 1);
+	CHECK_EQ(bus.calls[0].size(), 6);
+
+	for( int i = 0; i < 6; i++ )
+		CHECK_EQ(bus.calls[0][i].csChange, (i % 2 == 1 && i < 5) ? 1 : 0);
+
+	CHECK_EQ(bus.calls[0][0].tx[0], 0x10);
+	CHECK_EQ(bus.calls[0][2].tx[0], 0x10 | 0x80);
+	CHECK_EQ(bus.calls[0][4].tx[0], 0x1E | 0x80);
+
+	CHECK_EQ(readBack[0], 0x44);
+	CHECK_EQ(readBack[1], 0x4C);
+	CHECK_EQ(status, bus.registers[0x1E]);
+}
+
+static void checkCalls(const FakeSPI& bus)
+{
+	for( size_t c = 0; c < bus.calls.size(); c++ )
+	{
+		uint32_t bytes = 0;
+		size_t n = bus.calls[c].size();
+
+		CHECK(n % 2 == 0);
+
+		for( size_t i = 0; i < n; i++ )
+		{
+			CHECK_EQ(bus.calls[c][i].csChange, (i % 2 == 1 && i + 1 < n) ? 1 : 0);
+			bytes += bus.calls[c][i].len;
+		}
+
+		CHECK(bytes <= ISM_SPIDEV_BUFSIZ);
+	}
+}
+
+// Long batches are split by the number of transactions and by bytes
+static void testSplit()
+{
+	FakeSPI bus;
+	uint8_t data[40];
+	static uint8_t big[5][1000];
+	QwBusTransfer batch[40];
+
+	for( int i = 0; i < 40; i++ )
+		batch[i] = { (uint8_t)i, &data[i], 1, (i & 1) != 0 };
+
+	CHECK_EQ(bus.transferBatch(0, batch, 40), 0);
+	CHECK_EQ(bus.calls.size(), 3);
+	CHECK_EQ(bus.calls[0].size(), 2 * TEST_MAX_TRANSACTIONS);
+	CHECK_EQ(bus.calls[1].size(), 2 * TEST_MAX_TRANSACTIONS);
+	CHECK_EQ(bus.calls[2].size(), 2 * (40 - 2 * TEST_MAX_TRANSACTIONS));
+	checkCalls(bus);
+
+	// Four reads of 1001 bytes fit the buffer, the fifth goes in a new call
+	bus.calls.clear();
+	for( int i = 0; i < 5; i++ )
+		batch[i] = { 0x78, big[i], 1000, true };
+
+	CHECK_EQ(bus.transferBatch(0, batch, 5), 0);
+	CHECK_EQ(bus.calls.size(), 2);
+	CHECK_EQ(bus.calls[0].size(), 8);
+	CHECK_EQ(bus.calls[1].size(), 2);
+	checkCalls(bus);
+}
+
+// A transaction longer than the buffer fails before anything is sent
+static void testTooLong()
+{
+	FakeSPI bus;
+	static uint8_t fifo[ISM_SPIDEV_BUFSIZ];
+	uint8_t data;
+	QwBusTransfer batch[] = {
+		{ 0x3A, &data, 1, true },
+		{ 0x78, fifo, ISM_SPIDEV_BUFSIZ, true },
+	};
+
+	CHECK(bus.readRegisterRegion(0, 0x78, fifo, ISM_SPIDEV_BUFSIZ) != 0);
+	CHECK(bus.transferBatch(0, batch, 2) != 0);
+	CHECK_EQ(bus.calls.size(), 0);
+
+	// The longest transaction that fits
+	CHECK_EQ(bus.readRegisterRegion(0, 0x78, fifo, ISM_SPIDEV_BUFSIZ - 1), 0);
+	CHECK_EQ(bus.calls.size(), 1);
+}
+
+// A failing call fails the transfer and the rest of the batch isn't sent
+static void testError()
+{
+	FakeSPI bus;
+	uint8_t data[40];
+	QwBusTransfer batch[40];
+
+	for( int i = 0; i < 40; i++ )
+		batch[i] = { (uint8_t)i, &data[i], 1, true };
+
+	bus.failCall = 0;
+	CHECK(bus.transferBatch(0, batch, 40) != 0);
+	CHECK_EQ(bus.calls.size(), 1);
+
+	QwLinuxSPI closed;
+	CHECK(closed.readRegisterRegion(0, 0x0F, data, 1) != 0);
+	CHECK(!closed.ping(0));
+}
+
+int main()
+{
+	testRead();
+	testWrite();
+	testBatch();
+	testSplit();
+	testTooLong();
+	testError();
+
+	return testResult("test_linux_spidev");
+}
@@ -0,0 +1,241 @@
+// test_ring.cpp
+//
+// QwSampleRing: bulk pushes and pops across the wrap, the overrun count, and
+// a producer and a consumer thread hammering one ring. Run it under 
+// ThreadSanitizer with
+//
+//   make -C tests OUT=build-tsan OPT="-O1 -g -fsanitize=thread" build-tsan/test_ring
+
+#include "sfe_ism_ring.h"
+#include "test_util.h"
+#include <string.h>
+#include <atomic>
+#include <deque>
+#include <thread>
+
+#define RING_CAPACITY 64
+#define STRESS_ITEMS 1000000
+
+typedef QwSampleRing<sfe_ism_sample_t, RING_CAPACITY> TestRing;
+
+// Every field derives from the sequence number, a torn copy doesn't match
+static void makeSample(uint32_t seq, sfe_ism_sample_t* sample)
+{
+	sample->time = seq;
+	sample->accelData.xData = (int16_t)seq;
+	sample->accelData.yData = (int16_t)(seq >> 16);
+	sample->accelData.zData = (int16_t)~seq;
+	sample->gyroData.xData = (int16_t)(seq * 3);
+	sample->gyroData.yData = (int16_t)(seq * 5);
+	sample->gyroData.zData = (int16_t)(seq * 7);
+}
+
+static bool isSample(const sfe_ism_sample_t& sample)
+{
+	sfe_ism_sample_t expected;
+
+	makeSample((uint32_t)sample.time, &expected);
+
+	return sample.accelData.xData == expected.accelData.xData &&
+	       sample.accelData.yData == expected.accelData.yData &&
+	       sample.accelData.zData == expected.accelData.zData &&
+	       sample.gyroData.xData == expected.gyroData.xData &&
+	       sample.gyroData.yData == expected.gyroData.yData &&
+	       sample.gyroData.zData == expected.gyroData.zData;
+}
+
+static void testWrap()
+{
+	static TestRing ring;
+	std::deque<uint32_t> queued;
+	sfe_ism_sample_t in[45];
+	sfe_ism_sample_t out[45];
+	uint32_t seq = 0;
+	uint32_t dropped = 0;
+	uint16_t n;
+
+	CHECK_EQ(ring.capacity(), RING_CAPACITY);
+	CHECK_EQ(ring.size(), 0);
+	CHECK(!ring.pop(out));
+
+	// Bulk transfers of lengths that don't divide the capacity start every 
+	// copy at all positions of the wrap
+	for( int round = 0; round < 500; round++ )
+	{
+		uint16_t pushCount = (uint16_t)(1 + (round * 7) % 45);
+		uint16_t popCount = (uint16_t)(1 + (round * 11) % 43);
+
+		for( uint16_t i = 0; i < pushCount; i++ )
+			makeSample(seq + i, &in[i]);
+
+		// The samples that fit are queued, the rest dropped
+		n = ring.push(in, pushCount);
+		CHECK_EQ(n, pushCount < RING_CAPACITY - queued.size() ? pushCount : RING_CAPACITY - queued.size());
+
+		for( uint16_t i = 0; i < n; i++ )
+			queued.push_back(seq + i);
+
+		dropped += pushCount - n;
+		seq += pushCount;
+
+		CHECK_EQ(ring.size(), queued.size());
+		CHECK_EQ(ring.getOverruns(), dropped);
+
+		n = ring.pop(out, popCount);
+		CHECK_EQ(n, popCount < queued.size() ? popCount : queued.size());
+
+		for( uint16_t i = 0; i < n; i++ )
+		{
+			CHECK(isSample(out[i]));
+			CHECK_EQ(out[i].time, queued.front());
+			queued.pop_front();
+		}
+	}
+
+	CHECK(dropped > 0);
+}
+
+// Exact overrun accounting: a full ring takes nothing and counts it all
+static void testOverruns()
+{
+	static TestRing ring;
+	sfe_ism_sample_t in[RING_CAPACITY + 10];
+	sfe_ism_sample_t out[RING_CAPACITY];
+
+	for( uint16_t i = 0; i < RING_CAPACITY + 10; i++ )
+		makeSample(i, &in[i]);
+
+	CHECK_EQ(ring.push(in, RING_CAPACITY + 10), RING_CAPACITY);
+	CHECK_EQ(ring.getOverruns(), 10);
+	CHECK(!ring.push(in[0]));
+	CHECK_EQ(ring.getOverruns(), 11);
+
+	// Queued samples are never overwritten
+	CHECK_EQ(ring.pop(out, RING_CAPACITY), RING_CAPACITY);
+
+	for( uint16_t i = 0; i < RING_CAPACITY; i++ )
+		CHECK_EQ(out[i].time, i);
+
+	CHECK_EQ(ring.size(), 0);
+	CHECK_EQ(ring.getOverruns(), 11);
+}
+
+// A producer thread pushes batches while a consumer thread pops batches. The
+// consumer must see the accepted samples exactly once, in order and intact,
+// and the overruns must match the samples push() refused. A lossless 
+// producer retries what didn't fit, a lossy one drops it.
+static void testThreads(bool lossy)
+{
+	static TestRing ring;
+	uint32_t overrunsBefore = ring.getOverruns();
+	uint32_t accepted = 0;
+	uint32_t refused = 0;
+	uint32_t received = 0;
+	uint32_t bad = 0;
+	uint32_t outOfOrder = 0;
+	uint32_t gaps = 0;
+	std::atomic<bool> done(false);
+
+	std::thread producer([&]()
+	{
+		sfe_ism_sample_t batch[37];
+		uint32_t seq = 0;
+		uint16_t count;
+		uint16_t n;
+
+		while( seq < STRESS_ITEMS )
+		{
+			count = (uint16_t)(1 + seq % 37);
+
+			if( count > STRESS_ITEMS - seq )
+				count = (uint16_t)(STRESS_ITEMS - seq);
+
+			for( uint16_t i = 0; i < count; i++ )
+				makeSample(seq + i, &batch[i]);
+
+			n = ring.push(batch, count);
+			accepted += n;
+			refused += count - n;
+
+			if( lossy )
+				seq += count;
+			else
+				seq += n;
+
+			// Lets the consumer catch up rather than spinning on a full ring
+			if( n < count )
+				std::this_thread::yield();
+		}
+
+		done.store(true, std::memory_order_release);
+	});
+
+	std::thread consumer([&]()
+	{
+		sfe_ism_sample_t batch[29];
+		uint32_t next = 0;
+		uint16_t n;
+		bool last = false;
+
+		while( !last )
+		{
+			// One more pass after the producer finished empties the ring
+			last = done.load(std::memory_order_acquire);
+			n = ring.pop(batch, (uint16_t)(1 + received % 29));
+
+			for( uint16_t i = 0; i < n; i++ )
+			{
+				if( !isSample(batch[i]) )
+					bad++;
+
+				if( batch[i].time < next )
+					outOfOrder++;
+				else if( batch[i].time > next )
+					gaps++;
+
+				next = (uint32_t)batch[i].time + 1;
+			}
+
+			received += n;
+
+			if( n )
+				last = false;
+			else
+				std::this_thread::yield();
+		}
+	});
+
+	producer.join();
+	consumer.join();
+
+	CHECK_EQ(bad, 0);
+	CHECK_EQ(outOfOrder, 0);
+	CHECK_EQ(received, accepted);
+	CHECK_EQ(ring.size(), 0);
+	// Every sample push() refused counts, also those retried later
+	CHECK_EQ(ring.getOverruns() - overrunsBefore, refused);
+
+	if( lossy )
+	{
+		CHECK_EQ(accepted + refused, STRESS_ITEMS);
+		CHECK(accepted > 100 * RING_CAPACITY);
+	}
+	else
+	{
+		CHECK_EQ(accepted, STRESS_ITEMS);
+		CHECK_EQ(gaps, 0);
+	}
+
+	printf("test_ring: %s, %u of %u samples passed, %u overruns\n", lossy ? "lossy" : "lossless",
+		accepted, STRESS_ITEMS, (unsigned)(ring.getOverruns() - overrunsBefore));
+}
+
+int main()
+{
+	testWrap();
+	testOverruns();
+	testThreads(false);
+	testThreads(true);
+
+	return testResult("test_ring");
+}
@@ -0,0 +1,219 @@
+// test_routing.cpp
+//
+// setInterruptRouting() against the simulated device: INT1_CTRL/INT2_CTRL,
+// MD1_CFG/MD2_CFG and EMB_FUNC_INT1 - MLC_INT2 for a set of events,
+// INTERRUPTS_ENABLE in TAP_CFG2 following the basic interrupts, no writes
+// when the routing doesn't change, events a pin can't signal, and injected
+// events reaching the pins they were routed to.
+
+#include "sfe_ism330dhcx.h"
+#include "sfe_ism330dhcx_sim.h"
+#include "test_util.h"
+
+using namespace sfe_ISM330DHCX;
+
+#define SIM_USER_BANK 0
+#define SIM_EMB_BANK 2
+
+static void setUp(QwSimISM330DHCX& sim, QwDevISM330DHCX& dev)
+{
+	dev.setCommunicationBus(sim, ISM330DHCX_ADDRESS_HIGH);
+	CHECK(dev.init());
+}
+
+static uint8_t userRegister(QwSimISM330DHCX& sim, uint8_t reg)
+{
+	return sim.peekRegister(SIM_USER_BANK, reg);
+}
+
+static uint8_t embRegister(QwSimISM330DHCX& sim, uint8_t reg)
+{
+	return sim.peekRegister(SIM_EMB_BANK, reg);
+}
+
+static void testRegisters()
+{
+	QwSimISM330DHCX sim;
+	QwDevISM330DHCX dev;
+
+	setUp(sim, dev);
+
+	// DEN_DRDY_FLAG and the tap threshold are not part of the routing
+	sim.pokeRegister(SIM_USER_BANK, ISM330DHCX_INT1_CTRL, 0x80);
+	sim.pokeRegister(SIM_USER_BANK, ISM330DHCX_TAP_CFG2, 0x25);
+
+	CHECK(dev.setInterruptRouting(
+		ISM_EVENT_ACCEL_READY | ISM_EVENT_FIFO_THRESHOLD | ISM_EVENT_WAKE_UP |
+		ISM_EVENT_SENSOR_HUB_END | ISM_EVENT_STEP | ISM_EVENT_MLC1,
+		ISM_EVENT_TEMP_READY | ISM_EVENT_FIFO_FULL | ISM_EVENT_DOUBLE_TAP |
+		ISM_EVENT_TIMESTAMP_END | ISM_EVENT_FSM));
+
+	CHECK_EQ(userRegister(sim, ISM330DHCX_INT1_CTRL), 0x80 | 0x08 | 0x01);
+	CHECK_EQ(userRegister(sim, ISM330DHCX_INT2_CTRL), 0x20 | 0x04);
+	CHECK_EQ(userRegister(sim, ISM330DHCX_MD1_CFG), 0x20 | 0x02 | 0x01);
+	CHECK_EQ(userRegister(sim, ISM330DHCX_MD2_CFG), 0x08 | 0x02 | 0x01);
+	CHECK_EQ(userRegister(sim, ISM330DHCX_TAP_CFG2), 0x80 | 0x25);
+
+	CHECK_EQ(embRegister(sim, ISM330DHCX_EMB_FUNC_INT1), 0x08);
+	CHECK_EQ(embRegister(sim, ISM330DHCX_FSM_INT1_A), 0x00);
+	CHECK_EQ(embRegister(sim, ISM330DHCX_FSM_INT1_B), 0x00);
+	CHECK_EQ(embRegister(sim, ISM330DHCX_MLC_INT1), 0x01);
+	CHECK_EQ(embRegister(sim, ISM330DHCX_EMB_FUNC_INT2), 0x00);
+	CHECK_EQ(embRegister(sim, ISM330DHCX_FSM_INT2_A), 0xFF);
+	CHECK_EQ(embRegister(sim, ISM330DHCX_FSM_INT2_B), 0xFF);
+	CHECK_EQ(embRegister(sim, ISM330DHCX_MLC_INT2), 0x00);
+	CHECK_EQ(userRegister(sim, ISM330DHCX_FUNC_CFG_ACCESS), 0x00);
+
+	// Only data ready left: INTERRUPTS_ENABLE goes off, the rest of TAP_CFG2
+	// and the embedded routing (gated by MDx_CFG) stay
+	CHECK(dev.setInterruptRouting(ISM_EVENT_ACCEL_READY, ISM_EVENT_GYRO_READY));
+
+	CHECK_EQ(userRegister(sim, ISM330DHCX_INT1_CTRL), 0x80 | 0x01);
+	CHECK_EQ(userRegister(sim, ISM330DHCX_INT2_CTRL), 0x02);
+	CHECK_EQ(userRegister(sim, ISM330DHCX_MD1_CFG), 0x00);
+	CHECK_EQ(userRegister(sim, ISM330DHCX_MD2_CFG), 0x00);
+	CHECK_EQ(userRegister(sim, ISM330DHCX_TAP_CFG2), 0x25);
+
+	// And on again for a basic interrupt on either pin
+	CHECK(dev.setInterruptRouting(0, ISM_EVENT_SLEEP_CHANGE));
+	CHECK_EQ(userRegister(sim, ISM330DHCX_MD2_CFG), 0x80);
+	CHECK_EQ(userRegister(sim, ISM330DHCX_TAP_CFG2), 0x80 | 0x25);
+
+	// Embedded events alone don't need it
+	CHECK(dev.setInterruptRouting(ISM_EVENT_TILT, 0));
+	CHECK_EQ(userRegister(sim, ISM330DHCX_MD1_CFG), 0x02);
+	CHECK_EQ(userRegister(sim, ISM330DHCX_TAP_CFG2), 0x25);
+	CHECK_EQ(embRegister(sim, ISM330DHCX_EMB_FUNC_INT1), 0x10);
+	CHECK_EQ(embRegister(sim, ISM330DHCX_FSM_INT2_A), 0x00);
+}
+
+// The same routing twice writes nothing the second time
+static void testUnchanged(bool shadow)
+{
+	QwSimISM330DHCX sim;
+	QwDevISM330DHCX dev;
+	const uint32_t int1 = ISM_EVENT_WAKE_UP | ISM_EVENT_FIFO_THRESHOLD | ISM_EVENT_STEP;
+	const uint32_t int2 = ISM_EVENT_DOUBLE_TAP | ISM_EVENT_FSM;
+
+	setUp(sim, dev);
+
+	if( shadow )
+		CHECK(dev.enableShadow());
+
+	CHECK(dev.setInterruptRouting(int1, int2));
+
+	sim.resetStats();
+	CHECK(dev.setInterruptRouting(int1, int2));
+
+	// Reading the embedded function registers back takes the bank switches,
+	// with the shadow nothing goes to the device
+	if( shadow )
+	{
+		CHECK_EQ(sim.getStats().numReads, 0);
+		CHECK_EQ(sim.getStats().numWrites, 0);
+	}
+	else
+	{
+		CHECK(sim.getStats().numReads > 0);
+		CHECK_EQ(sim.getStats().numWrites, sim.getStats().numBankWrites);
+		CHECK_EQ(sim.getStats().numBankWrites, 2);
+	}
+
+	// Without embedded events not even the bank is switched
+	CHECK(dev.setInterruptRouting(ISM_EVENT_WAKE_UP, ISM_EVENT_DOUBLE_TAP));
+	sim.resetStats();
+	CHECK(dev.setInterruptRouting(ISM_EVENT_WAKE_UP, ISM_EVENT_DOUBLE_TAP));
+	CHECK_EQ(sim.getStats().numWrites, 0);
+
+	// One pin changing is one write of the pair
+	sim.resetStats();
+	CHECK(dev.setInterruptRouting(ISM_EVENT_WAKE_UP, ISM_EVENT_SINGLE_TAP));
+	CHECK_EQ(sim.getStats().numWrites, 1);
+	CHECK_EQ(userRegister(sim, ISM330DHCX_MD2_CFG), 0x40);
+}
+
+// Events only one of the pins can signal fail on the other, nothing written
+static void testWrongPin()
+{
+	QwSimISM330DHCX sim;
+	QwDevISM330DHCX dev;
+
+	setUp(sim, dev);
+	CHECK(dev.setInterruptRouting(ISM_EVENT_WAKE_UP, ISM_EVENT_DOUBLE_TAP));
+	sim.resetStats();
+
+	CHECK(!dev.setInterruptRouting(ISM_EVENT_TEMP_READY, 0));
+	CHECK(!dev.setInterruptRouting(ISM_EVENT_TIMESTAMP_END | ISM_EVENT_WAKE_UP, 0));
+	CHECK(!dev.setInterruptRouting(0, ISM_EVENT_SENSOR_HUB_END));
+	CHECK(!dev.setInterruptRouting(ISM_EVENT_STEP, ISM_EVENT_SENSOR_HUB_END | ISM_EVENT_FSM));
+
+	CHECK_EQ(sim.getStats().numWrites, 0);
+	CHECK_EQ(userRegister(sim, ISM330DHCX_MD1_CFG), 0x20);
+	CHECK_EQ(userRegister(sim, ISM330DHCX_MD2_CFG), 0x08);
+
+	// On the right pin they are fine
+	CHECK(dev.setInterruptRouting(ISM_EVENT_SENSOR_HUB_END, ISM_EVENT_TEMP_READY | ISM_EVENT_TIMESTAMP_END));
+	CHECK_EQ(userRegister(sim, ISM330DHCX_MD1_CFG), 0x01);
+	CHECK_EQ(userRegister(sim, ISM330DHCX_INT2_CTRL), 0x04);
+	CHECK_EQ(userRegister(sim, ISM330DHCX_MD2_CFG), 0x01);
+}
+
+// Injected events drive the pin they are routed to and only that one
+static void testPins()
+{
+	QwSimISM330DHCX sim;
+	QwDevISM330DHCX dev;
+	sfe_ism_events_t events;
+
+	setUp(sim, dev);
+	CHECK(dev.setInterruptRouting(ISM_EVENT_WAKE_UP | ISM_EVENT_FREE_FALL, ISM_EVENT_DOUBLE_TAP));
+	CHECK(!sim.getInt1());
+	CHECK(!sim.getInt2());
+
+	sim.injectEvent(kSimWakeUp);
+	CHECK(sim.getInt1());
+	CHECK(!sim.getInt2());
+
+	// Reading the sources releases the pin
+	CHECK(dev.getEvents(&events));
+	CHECK(!sim.getInt1());
+
+	sim.injectEvent(kSimDoubleTap);
+	CHECK(!sim.getInt1());
+	CHECK(sim.getInt2());
+	CHECK(dev.getEvents(&events));
+
+	sim.injectEvent(kSimFreeFall);
+	CHECK(sim.getInt1());
+	CHECK(dev.getEvents(&events));
+
+	// Not routed, no pin
+	sim.injectEvent(kSimSingleTap);
+	sim.injectEvent(kSimSleepChange);
+	CHECK(!sim.getInt1());
+	CHECK(!sim.getInt2());
+	CHECK(dev.getEvents(&events));
+
+	// Moved to the other pin
+	CHECK(dev.setInterruptRouting(0, ISM_EVENT_WAKE_UP));
+	sim.injectEvent(kSimWakeUp);
+	CHECK(!sim.getInt1());
+	CHECK(sim.getInt2());
+	CHECK(dev.getEvents(&events));
+
+	// Routed away, INTERRUPTS_ENABLE off, the event reaches neither
+	CHECK(dev.setInterruptRouting(ISM_EVENT_ACCEL_READY, 0));
+	sim.injectEvent(kSimWakeUp);
+	CHECK(!sim.getInt2());
+}
+
+int main()
+{
+	testRegisters();
+	testUnchanged(false);
+	testUnchanged(true);
+	testWrongPin();
+	testPins();
+
+	return testResult("test_routing");
+}
@@ -0,0 +1,215 @@
+// test_shadow.cpp
+//
+// The register shadow against the simulated device: the bus reads a typical
+// configuration saves with the same registers written, bits that clear
+// themselves on the device not kept in the shadow, and the shadow dropped by
+// a software reset and matching the device again after syncShadow().
+
+#include "sfe_ism330dhcx.h"
+#include "sfe_ism330dhcx_sim.h"
+#include "test_util.h"
+
+using namespace sfe_ISM330DHCX;
+
+#define SIM_USER_BANK 0
+#define SIM_EMB_BANK 2
+
+// Registers held in the shadow, first and last of each range
+static const uint8_t userRanges[][2] = {
+	{ ISM330DHCX_PIN_CTRL, ISM330DHCX_PIN_CTRL },
+	{ ISM330DHCX_FIFO_CTRL1, ISM330DHCX_INT2_CTRL },
+	{ ISM330DHCX_CTRL1_XL, ISM330DHCX_CTRL10_C },
+	{ ISM330DHCX_TAP_CFG0, ISM330DHCX_MD2_CFG },
+	{ ISM330DHCX_X_OFS_USR, ISM330DHCX_Z_OFS_USR },
+};
+
+static const uint8_t embRanges[][2] = {
+	{ ISM330DHCX_PAGE_SEL, ISM330DHCX_PAGE_SEL },
+	{ ISM330DHCX_EMB_FUNC_EN_A, ISM330DHCX_EMB_FUNC_EN_B },
+	{ ISM330DHCX_EMB_FUNC_INT1, ISM330DHCX_MLC_INT2 },
+	{ ISM330DHCX_PAGE_RW, ISM330DHCX_PAGE_RW },
+};
+
+// The data rate setters read FSM_ENABLE_A/B, which the shadow doesn't hold
+#define TEST_UNSHADOWED_READS 4
+
+static void setUp(QwSimISM330DHCX& sim, QwDevISM330DHCX& dev)
+{
+	dev.setCommunicationBus(sim, ISM330DHCX_ADDRESS_HIGH);
+	CHECK(dev.init());
+}
+
+static void configure(QwDevISM330DHCX& dev)
+{
+	CHECK(dev.setAccelFullScale(ISM_4g));
+	CHECK(dev.setGyroFullScale(ISM_500dps));
+	CHECK(dev.setAccelDataRate(ISM_XL_ODR_104Hz));
+	CHECK(dev.setGyroDataRate(ISM_GY_ODR_104Hz));
+	CHECK(dev.setBlockDataUpdate());
+	CHECK(dev.setAccelFilterLP2());
+	CHECK(dev.setPinMode(true));
+	CHECK(dev.setFifoWatermark(64));
+	CHECK(dev.setAccelFifoBatchSet(ISM_XL_BATCH_AT_104Hz));
+	CHECK(dev.setGyroFifoBatchSet(ISM_GY_BATCH_AT_104Hz));
+	CHECK(dev.setFifoMode(ISM_STREAM_MODE));
+	CHECK(dev.enableTimestamp());
+	CHECK(dev.setInterruptRouting(ISM_EVENT_WAKE_UP | ISM_EVENT_STEP, ISM_EVENT_FIFO_THRESHOLD));
+}
+
+// Every shadowed register read through the driver without a bus read, and
+// equal to the device's
+static void checkShadow(QwSimISM330DHCX& sim, QwDevISM330DHCX& dev)
+{
+	uint8_t val;
+
+	sim.resetStats();
+
+	for( const auto& range : userRanges )
+	{
+		for( int reg = range[0]; reg <= range[1]; reg++ )
+		{
+			CHECK_EQ(dev.readRegisterRegion(reg, &val, 1), 0);
+			CHECK_EQ(val, sim.peekRegister(SIM_USER_BANK, reg));
+		}
+	}
+
+	CHECK(dev.beginBankSession(ISM330DHCX_EMBEDDED_FUNC_BANK));
+
+	for( const auto& range : embRanges )
+	{
+		for( int reg = range[0]; reg <= range[1]; reg++ )
+		{
+			CHECK_EQ(dev.readRegisterRegion(reg, &val, 1), 0);
+			CHECK_EQ(val, sim.peekRegister(SIM_EMB_BANK, reg));
+		}
+	}
+
+	CHECK(dev.endBankSession());
+
+	CHECK_EQ(sim.getStats().numReads, 0);
+	CHECK_EQ(sim.getStats().numWrites, 0);
+}
+
+// The same configuration with and without the shadow
+static void testReads()
+{
+	QwSimISM330DHCX plainSim, shadowSim;
+	QwDevISM330DHCX plain, shadowed;
+	QwSimStats without, with;
+
+	setUp(plainSim, plain);
+	setUp(shadowSim, shadowed);
+	CHECK(shadowed.enableShadow());
+
+	plainSim.resetStats();
+	configure(plain);
+	without = plainSim.getStats();
+
+	shadowSim.resetStats();
+	configure(shadowed);
+	with = shadowSim.getStats();
+
+	// Read-modify-writes without the reads, the writes are the same
+	CHECK(without.numReads >= 13 + TEST_UNSHADOWED_READS);
+	CHECK_EQ(with.numReads, TEST_UNSHADOWED_READS);
+	CHECK_EQ(with.numWrites, without.numWrites);
+	CHECK_EQ(with.bytesWritten, without.bytesWritten);
+
+	for( const auto& range : userRanges )
+	{
+		for( int reg = range[0]; reg <= range[1]; reg++ )
+			CHECK_EQ(shadowSim.peekRegister(SIM_USER_BANK, reg), plainSim.peekRegister(SIM_USER_BANK, reg));
+	}
+
+	for( const auto& range : embRanges )
+	{
+		for( int reg = range[0]; reg <= range[1]; reg++ )
+			CHECK_EQ(shadowSim.peekRegister(SIM_EMB_BANK, reg), plainSim.peekRegister(SIM_EMB_BANK, reg));
+	}
+
+	checkShadow(shadowSim, shadowed);
+
+	// Turned off every read goes to the device again
+	CHECK(shadowed.enableShadow(false));
+	shadowSim.resetStats();
+	CHECK(shadowed.setAccelFullScale(ISM_8g));
+	CHECK_EQ(shadowSim.getStats().numReads, 1);
+}
+
+// RST_COUNTER_BDR and BOOT clear themselves, the shadow doesn't keep them
+static void testSelfClearing()
+{
+	QwSimISM330DHCX sim;
+	QwDevISM330DHCX dev;
+	uint8_t val;
+
+	setUp(sim, dev);
+	CHECK(dev.enableShadow());
+
+	CHECK(dev.setBatchCounter(ISM_GY_BATCH_EVENT, 300));
+	CHECK(dev.resetBatchCounter());
+	checkShadow(sim, dev);
+
+	CHECK_EQ(dev.readRegisterRegion(ISM330DHCX_COUNTER_BDR_REG1, &val, 1), 0);
+	CHECK_EQ(val, 0x20 | 0x01);
+
+	// A later read-modify-write doesn't restart the counter again
+	sim.resetStats();
+	CHECK(dev.setDataReadyMode(1));
+	CHECK_EQ(sim.getStats().numReads, 0);
+	CHECK_EQ(sim.peekRegister(SIM_USER_BANK, ISM330DHCX_COUNTER_BDR_REG1), 0x80 | 0x20 | 0x01);
+
+	// BOOT drops the shadow, the next read goes to the device
+	CHECK_EQ(dev.readRegisterRegion(ISM330DHCX_CTRL3_C, &val, 1), 0);
+	val |= 0x80;
+	CHECK_EQ(dev.writeRegisterRegion(ISM330DHCX_CTRL3_C, &val, 1), 0);
+
+	sim.resetStats();
+	CHECK_EQ(dev.readRegisterRegion(ISM330DHCX_CTRL3_C, &val, 1), 0);
+	CHECK_EQ(sim.getStats().numReads, 1);
+	CHECK_EQ(val & 0x80, 0);
+
+	CHECK(dev.syncShadow());
+	checkShadow(sim, dev);
+}
+
+// A software reset drops the shadow, syncShadow() loads the defaults
+static void testReset()
+{
+	QwSimISM330DHCX sim;
+	QwDevISM330DHCX dev;
+	uint8_t val;
+
+	setUp(sim, dev);
+	CHECK(dev.enableShadow());
+	configure(dev);
+	checkShadow(sim, dev);
+
+	CHECK(dev.deviceReset());
+
+	sim.resetStats();
+	CHECK_EQ(dev.readRegisterRegion(ISM330DHCX_CTRL1_XL, &val, 1), 0);
+	CHECK_EQ(sim.getStats().numReads, 1);
+	CHECK_EQ(val, 0);
+
+	while( !dev.getDeviceReset() )
+		sim.advance(1000000ULL);
+
+	CHECK(dev.syncShadow());
+	checkShadow(sim, dev);
+
+	// Set up again from the shadow
+	sim.resetStats();
+	configure(dev);
+	CHECK_EQ(sim.getStats().numReads, TEST_UNSHADOWED_READS);
+	checkShadow(sim, dev);
+}
+
+int main()
+{
+	testReads();
+	testSelfClearing();
+	testReset();
+
+	return testResult("test_shadow");
+}
@@ -0,0 +1,280 @@
+// test_sim.cpp
+//
+// Smoke test of the driver against the simulated device: init, a combined
+// sample read, a drain of the tagged FIFO, the float output units and the
+// full scales init() finds already set.
+
+#include "sfe_ism330dhcx.h"
+#include "sfe_ism330dhcx_sim.h"
+#include "test_util.h"
+
+using namespace sfe_ISM330DHCX;
+
+#define TEST_PI 3.14159265358979323846
+
+// Acceleration in mg and angular rate in mdps the source below measures
+static const float accelMg[3] = { 100.0f, -200.0f, 1000.0f };
+static const float gyroMdps[3] = { 1000.0f, -2000.0f, 30000.0f };
+
+class ConstantSource : public QwSimSource
+{
+public:
+
+	void accel(uint64_t timeNs, float* mg)
+	{
+		(void)timeNs;
+
+		for( int i = 0; i < 3; i++ )
+			mg[i] = accelMg[i];
+	}
+
+	void gyro(uint64_t timeNs, float* mdps)
+	{
+		(void)timeNs;
+
+		for( int i = 0; i < 3; i++ )
+			mdps[i] = gyroMdps[i];
+	}
+};
+
+static void configure(QwDevISM330DHCX& dev)
+{
+	CHECK(dev.deviceReset());
+	CHECK(dev.setDeviceConfig());
+	CHECK(dev.setBlockDataUpdate());
+	CHECK(dev.setAccelDataRate(ISM_XL_ODR_104Hz));
+	CHECK(dev.setAccelFullScale(ISM_4g));
+	CHECK(dev.setGyroDataRate(ISM_GY_ODR_104Hz));
+	CHECK(dev.setGyroFullScale(ISM_500dps));
+}
+
+static void testInit()
+{
+	QwSimISM330DHCX sim;
+	QwDevISM330DHCX dev;
+
+	dev.setCommunicationBus(sim, ISM330DHCX_ADDRESS_HIGH);
+
+	CHECK(dev.init());
+	CHECK(dev.isConnected());
+	CHECK_EQ(dev.getUniqueId(), ISM330DHCX_ID);
+
+	// Nothing answers at the other address
+	QwDevISM330DHCX other;
+	other.setCommunicationBus(sim, ISM330DHCX_ADDRESS_LOW);
+	CHECK(!other.init());
+}
+
+static void testCombinedRead()
+{
+	QwSimISM330DHCX sim;
+	QwDevISM330DHCX dev;
+	sfe_ism_all_data_t data;
+
+	dev.setCommunicationBus(sim, ISM330DHCX_ADDRESS_HIGH);
+	CHECK(dev.init());
+	configure(dev);
+
+	sim.advance(50000000ULL);
+	sim.resetStats();
+
+	CHECK(dev.getAllData(&data));
+
+	// Status, temperature, gyroscope and accelerometer in one burst
+	CHECK_EQ(sim.getStats().numReads, 1);
+	CHECK(data.accelReady);
+	CHECK(data.gyroReady);
+	CHECK_NEAR(data.accelData.xData, 0.0, 1.0);
+	CHECK_NEAR(data.accelData.yData, 0.0, 1.0);
+	CHECK_NEAR(data.accelData.zData, 1000.0, 1.0);
+	CHECK_NEAR(data.gyroData.xData, 0.0, 20.0);
+	CHECK_NEAR(data.gyroData.zData, 0.0, 20.0);
+	CHECK_NEAR(data.tempData, 25.0, 0.5);
+
+	// The data ready bits clear once the outputs were read
+	CHECK(dev.getAllData(&data));
+	CHECK(!data.accelReady);
+	CHECK(!data.gyroReady);
+}
+
+static void testFifoDrain()
+{
+	QwSimISM330DHCX sim;
+	QwDevISM330DHCX dev;
+	sfe_ism_raw_data_t accel[64];
+	sfe_ism_raw_data_t gyro[64];
+	uint32_t timestamps[16];
+	sfe_ism_fifo_data_t fifo = {};
+	uint16_t level;
+
+	dev.setCommunicationBus(sim, ISM330DHCX_ADDRESS_HIGH);
+	CHECK(dev.init());
+	configure(dev);
+
+	CHECK(dev.setAccelFifoBatchSet(ISM_XL_BATCH_AT_104Hz));
+	CHECK(dev.setGyroFifoBatchSet(ISM_GY_BATCH_AT_52Hz));
+	CHECK(dev.enableTimestamp());
+	CHECK(dev.setFifoTimestampDec(ISM_DEC_8));
+	CHECK(dev.setFifoMode(ISM_FIFO_MODE));
+
+	// 100ms: 10 or 11 accelerometer, 5 or 6 gyroscope samples and a timestamp
+	// every 8 time slots
+	sim.advance(100000000ULL);
+
+	CHECK(dev.getFifoLevel(&level));
+	CHECK(level >= 16);
+
+	fifo.accelData = accel;
+	fifo.accelSize = 64;
+	fifo.gyroData = gyro;
+	fifo.gyroSize = 64;
+	fifo.timestampData = timestamps;
+	fifo.timestampSize = 16;
+
+	CHECK(dev.readFifo(&fifo));
+	CHECK(fifo.numAccel >= 10 && fifo.numAccel <= 11);
+	CHECK(fifo.numGyro >= 5 && fifo.numGyro <= 6);
+	CHECK(fifo.numTimestamp >= 1);
+	CHECK_EQ(fifo.numAccel + fifo.numGyro + fifo.numTimestamp, level);
+	CHECK_EQ(fifo.numDropped, 0);
+	CHECK(!fifo.overrun);
+
+	// 1000mg at 0.122mg/LSB
+	for( uint16_t i = 0; i < fifo.numAccel; i++ )
+	{
+		CHECK_NEAR(accel[i].xData, 0, 1);
+		CHECK_NEAR(accel[i].zData, 8197, 2);
+	}
+
+	for( uint16_t i = 1; i < fifo.numTimestamp; i++ )
+		CHECK(timestamps[i] > timestamps[i - 1]);
+
+	CHECK(dev.getFifoLevel(&level));
+	CHECK_EQ(level, 0);
+}
+
+// Both outputs against the source in the selected units, "accelScale" and
+// "gyroScale" from mg and mdps, within an LSB of "accelLsb" mg and "gyroLsb"
+// mdps
+static void checkUnits(QwDevISM330DHCX& dev, double accelScale, double accelLsb, double gyroScale, double gyroLsb)
+{
+	sfe_ism_data_t accel, gyro;
+
+	CHECK(dev.getAccel(&accel));
+	CHECK(dev.getGyro(&gyro));
+
+	CHECK_NEAR(accel.xData, accelMg[0] * accelScale, accelLsb * accelScale);
+	CHECK_NEAR(accel.yData, accelMg[1] * accelScale, accelLsb * accelScale);
+	CHECK_NEAR(accel.zData, accelMg[2] * accelScale, accelLsb * accelScale);
+	CHECK_NEAR(gyro.xData, gyroMdps[0] * gyroScale, gyroLsb * gyroScale);
+	CHECK_NEAR(gyro.yData, gyroMdps[1] * gyroScale, gyroLsb * gyroScale);
+	CHECK_NEAR(gyro.zData, gyroMdps[2] * gyroScale, gyroLsb * gyroScale);
+}
+
+static void testOutputUnits()
+{
+	QwSimISM330DHCX sim;
+	QwDevISM330DHCX dev;
+	ConstantSource source;
+	sfe_ism_data_t mg, mdps, si;
+	const double toMs2 = ISM_STANDARD_GRAVITY * 1e-3;
+	const double toRads = 1e-3 * TEST_PI / 180.0;
+
+	sim.setSource(&source);
+	dev.setCommunicationBus(sim, ISM330DHCX_ADDRESS_HIGH);
+	CHECK(dev.init());
+	configure(dev);
+	sim.advance(20000000ULL);
+
+	CHECK_EQ(dev.getOutputUnits(), ISM_UNITS_MG_MDPS);
+	checkUnits(dev, 1.0, 0.122, 1.0, 17.5);
+	CHECK(dev.getAccel(&mg));
+	CHECK(dev.getGyro(&mdps));
+
+	// The same samples in m/s^2 and rad/s, mg and mdps times the constants
+	CHECK(dev.setOutputUnits(ISM_UNITS_SI));
+	CHECK_EQ(dev.getOutputUnits(), ISM_UNITS_SI);
+
+	CHECK(dev.getAccel(&si));
+	CHECK_NEAR(si.xData, mg.xData * toMs2, 1e-5);
+	CHECK_NEAR(si.zData, mg.zData * toMs2, 1e-5);
+
+	CHECK(dev.getGyro(&si));
+	CHECK_NEAR(si.yData, mdps.yData * toRads, 1e-7);
+	CHECK_NEAR(si.zData, mdps.zData * toRads, 1e-7);
+
+	// A full scale set afterwards keeps the unit in the sensitivity
+	CHECK(dev.setAccelFullScale(ISM_16g));
+	CHECK(dev.setGyroFullScale(ISM_2000dps));
+	sim.advance(20000000ULL);
+	checkUnits(dev, toMs2, 0.488, toRads, 70.0);
+
+	CHECK(dev.setOutputUnits(ISM_UNITS_G_DPS));
+	CHECK(dev.setAccelFullScale(ISM_2g));
+	CHECK(dev.setGyroFullScale(ISM_125dps));
+	sim.advance(20000000ULL);
+	checkUnits(dev, 1e-3, 0.061, 1e-3, 4.375);
+
+	// Units that don't exist change nothing
+	CHECK(!dev.setOutputUnits(ISM_UNITS_G_DPS + 1));
+	CHECK(!dev.setOutputUnits(0xFF));
+	CHECK_EQ(dev.getOutputUnits(), ISM_UNITS_G_DPS);
+	checkUnits(dev, 1e-3, 0.061, 1e-3, 4.375);
+
+	CHECK(dev.setOutputUnits(ISM_UNITS_MG_MDPS));
+	checkUnits(dev, 1.0, 0.061, 1.0, 4.375);
+}
+
+// CTRL2_G values init() finds, any combination of FS_4000, FS_125 and FS_G
+static void testFullScaleSync()
+{
+	static const struct
+	{
+		uint8_t ctrl2;
+		double lsb;
+	} cases[] = {
+		{ 0x00, 8.75 },
+		{ 0x0C, 70.0 },
+		{ 0x01, 140.0 },
+		{ 0x03, 140.0 },   // FS_4000 over FS_125
+		{ 0x05, 140.0 },   // and over FS_G
+		{ 0x0F, 140.0 },
+		{ 0x02, 4.375 },
+		{ 0x06, 4.375 },   // FS_125 over FS_G
+		{ 0x0E, 4.375 },
+	};
+
+	for( const auto& c : cases )
+	{
+		QwSimISM330DHCX sim;
+		QwDevISM330DHCX dev;
+		ConstantSource source;
+
+		sim.setSource(&source);
+		sim.pokeRegister(0, ISM330DHCX_CTRL1_XL, 0x0C);
+		sim.pokeRegister(0, ISM330DHCX_CTRL2_G, c.ctrl2);
+
+		dev.setCommunicationBus(sim, ISM330DHCX_ADDRESS_HIGH);
+		CHECK(dev.init());
+
+		// The data rates leave the full scales as they are
+		CHECK(dev.setAccelDataRate(ISM_XL_ODR_104Hz));
+		CHECK(dev.setGyroDataRate(ISM_GY_ODR_104Hz));
+		CHECK_EQ(sim.peekRegister(0, ISM330DHCX_CTRL2_G) & 0x0F, c.ctrl2);
+		sim.advance(20000000ULL);
+
+		// 8g
+		checkUnits(dev, 1.0, 0.244, 1.0, c.lsb);
+	}
+}
+
+int main()
+{
+	testInit();
+	testCombinedRead();
+	testFifoDrain();
+	testOutputUnits();
+	testFullScaleSync();
+
+	return testResult("test_sim");
+}
@@ -0,0 +1,112 @@
+// test_spi.cpp
+//
+// SfeSPI against the mock SPIClass: data integrity and the SPIClass calls of
+// reads and writes either side of the scratch buffer size, where SfeSPI
+// switches from staging the transfer to transferring in place.
+
+#include "sfe_bus.h"
+#include "test_util.h"
+
+using namespace sfe_ISM330DHCX;
+
+static void fillRegisters()
+{
+	for( int i = 0; i < 128; i++ )
+		SPI.registers[i] = (uint8_t)(i * 7 + 3);
+}
+
+static void testRead(SfeSPI& bus, uint16_t length)
+{
+	uint8_t data[128];
+
+	fillRegisters();
+	memset(data, 0xAA, sizeof(data));
+	SPI.stats = SPIMockStats();
+
+	CHECK_EQ(bus.readRegisterRegion(0, 0x10, data, length), 0);
+
+	for( uint16_t i = 0; i < length; i++ )
+		CHECK_EQ(data[i], SPI.registers[(0x10 + i) & 0x7F]);
+
+	// Nothing past the end of the buffer is touched
+	CHECK_EQ(data[length], 0xAA);
+
+	CHECK_EQ(SPI.stats.numTransactions, 1);
+	CHECK_EQ(SPI.stats.bytesTransferred, length + 1);
+
+	if( length < ISM_SPI_SCRATCH_SIZE )
+	{
+		// Register byte and data in one staged transfer
+		CHECK_EQ(SPI.stats.numByteTransfers, 0);
+		CHECK_EQ(SPI.stats.numBufferTransfers, 1);
+	}
+	else
+	{
+		// Register byte, then the caller's buffer in place
+		CHECK_EQ(SPI.stats.numByteTransfers, 1);
+		CHECK_EQ(SPI.stats.numBufferTransfers, 1);
+	}
+}
+
+static void testWrite(SfeSPI& bus, uint16_t length)
+{
+	uint8_t data[128] = {};
+
+	memset(SPI.registers, 0, sizeof(SPI.registers));
+	SPI.stats = SPIMockStats();
+
+	for( uint16_t i = 0; i < length; i++ )
+		data[i] = (uint8_t)(0x80 + i);
+
+	CHECK_EQ(bus.writeRegisterRegion(0, 0x20, data, length), 0);
+
+	for( uint16_t i = 0; i < length; i++ )
+		CHECK_EQ(SPI.registers[(0x20 + i) & 0x7F], data[i]);
+
+	CHECK_EQ(SPI.registers[(0x20 + length) & 0x7F], 0);
+
+	// The register byte rides in the first scratch buffer
+	CHECK_EQ(SPI.stats.numTransactions, 1);
+	CHECK_EQ(SPI.stats.numByteTransfers, 0);
+	CHECK_EQ(SPI.stats.numBufferTransfers, (length + ISM_SPI_SCRATCH_SIZE) / ISM_SPI_SCRATCH_SIZE);
+	CHECK_EQ(SPI.stats.bytesTransferred, length + 1);
+}
+
+static uint32_t hookCalls;
+
+static void countingHook(SPIClass* spiPort, uint8_t* buffer, size_t length)
+{
+	hookCalls++;
+	spiPort->transfer(buffer, length);
+}
+
+int main()
+{
+	SfeSPI bus;
+	uint8_t data[8];
+	static const uint16_t lengths[] = { 1, 2, 7, 12, 14,
+		ISM_SPI_SCRATCH_SIZE - 2, ISM_SPI_SCRATCH_SIZE - 1, ISM_SPI_SCRATCH_SIZE,
+		ISM_SPI_SCRATCH_SIZE + 1, 2 * ISM_SPI_SCRATCH_SIZE - 1, 2 * ISM_SPI_SCRATCH_SIZE,
+		112, 127 };
+
+	// No port yet
+	CHECK_EQ(bus.readRegisterRegion(0, 0x10, data, 1), -1);
+	CHECK(!bus.init(0));
+	CHECK(bus.init(MOCK_SPI_CS));
+
+	for( uint16_t length : lengths )
+	{
+		testRead(bus, length);
+		testWrite(bus, length);
+	}
+
+	// The hook replaces the buffer transfers of both paths
+	bus.setTransferHook(countingHook);
+	hookCalls = 0;
+	testRead(bus, ISM_SPI_SCRATCH_SIZE - 1);
+	testRead(bus, ISM_SPI_SCRATCH_SIZE);
+	testWrite(bus, 2 * ISM_SPI_SCRATCH_SIZE);
+	CHECK_EQ(hookCalls, 5);
+
+	return testResult("test_spi");
+}
@@ -0,0 +1,132 @@
+// test_static.cpp
+//
+// QwDevISM330DHCXStatic reads the FIFO with the drain loop of the base class
+// through its own bus calls. Both must store the same samples with the same
+// bus transactions.
+
+#include "sfe_ism330dhcx_static.h"
+#include "sfe_ism330dhcx_sim.h"
+#include "test_util.h"
+#include <string.h>
+
+using namespace sfe_ISM330DHCX;
+
+struct FifoBuffers
+{
+	sfe_ism_raw_data_t accel[128];
+	sfe_ism_raw_data_t gyro[128];
+	uint32_t timestamps[32];
+	sfe_ism_fifo_data_t fifo;
+
+	FifoBuffers() : fifo{}
+	{
+		fifo.accelData = accel;
+		fifo.accelSize = 128;
+		fifo.gyroData = gyro;
+		fifo.gyroSize = 128;
+		fifo.timestampData = timestamps;
+		fifo.timestampSize = 32;
+	}
+};
+
+static void configure(QwDevISM330DHCX& dev)
+{
+	CHECK(dev.init());
+	CHECK(dev.deviceReset());
+	CHECK(dev.setDeviceConfig());
+	CHECK(dev.setBlockDataUpdate());
+	CHECK(dev.setAccelDataRate(ISM_XL_ODR_416Hz));
+	CHECK(dev.setGyroDataRate(ISM_GY_ODR_416Hz));
+	CHECK(dev.setAccelFifoBatchSet(ISM_XL_BATCH_AT_417Hz));
+	CHECK(dev.setGyroFifoBatchSet(ISM_GY_BATCH_AT_417Hz));
+	CHECK(dev.enableTimestamp());
+	CHECK(dev.setFifoTimestampDec(ISM_DEC_8));
+	CHECK(dev.setFifoMode(ISM_STREAM_MODE));
+}
+
+static void testReadFifo()
+{
+	QwSimISM330DHCX baseSim;
+	QwSimISM330DHCX staticSim;
+	QwDevISM330DHCX base;
+	QwDevISM330DHCXStatic<QwSimISM330DHCX> direct;
+	FifoBuffers baseData;
+	FifoBuffers directData;
+
+	base.setCommunicationBus(baseSim, ISM330DHCX_ADDRESS_HIGH);
+	direct.setCommunicationBus(staticSim, ISM330DHCX_ADDRESS_HIGH);
+	configure(base);
+	configure(direct);
+
+	for( int round = 0; round < 5; round++ )
+	{
+		baseSim.advance(100000000ULL);
+		staticSim.advance(100000000ULL);
+		baseSim.resetStats();
+		staticSim.resetStats();
+
+		// Bounded so words are left behind for the next round
+		CHECK(base.readFifo(&baseData.fifo, 60));
+		CHECK(direct.readFifo(&directData.fifo, 60));
+
+		CHECK(baseData.fifo.numAccel > 0);
+		CHECK_EQ(directData.fifo.numAccel, baseData.fifo.numAccel);
+		CHECK_EQ(directData.fifo.numGyro, baseData.fifo.numGyro);
+		CHECK_EQ(directData.fifo.numTimestamp, baseData.fifo.numTimestamp);
+		CHECK_EQ(directData.fifo.numDropped, 0);
+		CHECK_EQ(directData.fifo.overrun, baseData.fifo.overrun);
+
+		for( uint16_t i = 0; i < baseData.fifo.numAccel; i++ )
+			CHECK_EQ(directData.accel[i].zData, baseData.accel[i].zData);
+
+		for( uint16_t i = 0; i < baseData.fifo.numTimestamp; i++ )
+			CHECK_EQ(directData.timestamps[i], baseData.timestamps[i]);
+
+		// Status and four bursts of up to ISM_FIFO_READ_WORDS words, the first
+		// read also fetches the batch rates for the decoder
+		CHECK_EQ(staticSim.getStats().numReads, baseSim.getStats().numReads);
+		CHECK_EQ(staticSim.getStats().numReads, (round == 0) + 1 + (60 + ISM_FIFO_READ_WORDS - 1) / ISM_FIFO_READ_WORDS);
+		CHECK_EQ(staticSim.getStats().bytesRead, baseSim.getStats().bytesRead);
+	}
+}
+
+static void testReadFifoRaw()
+{
+	QwSimISM330DHCX baseSim;
+	QwSimISM330DHCX staticSim;
+	QwDevISM330DHCX base;
+	QwDevISM330DHCXStatic<QwSimISM330DHCX> direct;
+	uint8_t baseWords[40 * ISM_FIFO_WORD_SIZE];
+	uint8_t directWords[40 * ISM_FIFO_WORD_SIZE];
+	uint16_t baseNum;
+	uint16_t directNum;
+
+	base.setCommunicationBus(baseSim, ISM330DHCX_ADDRESS_HIGH);
+	direct.setCommunicationBus(staticSim, ISM330DHCX_ADDRESS_HIGH);
+	configure(base);
+	configure(direct);
+
+	baseSim.advance(100000000ULL);
+	staticSim.advance(100000000ULL);
+	baseSim.resetStats();
+	staticSim.resetStats();
+
+	CHECK(base.readFifoRaw(baseWords, 40, &baseNum));
+	CHECK(direct.readFifoRaw(directWords, 40, &directNum));
+
+	CHECK_EQ(baseNum, 40);
+	CHECK_EQ(directNum, 40);
+	CHECK(memcmp(baseWords, directWords, sizeof(baseWords)) == 0);
+
+	// Status and a single burst
+	CHECK_EQ(staticSim.getStats().numReads, 2);
+	CHECK_EQ(baseSim.getStats().numReads, 2);
+}
+
+int main()
+{
+	testReadFifo();
+	testReadFifoRaw();
+
+	return testResult("test_static");
+}
@@ -0,0 +1,283 @@
+// test_ucf.cpp
+//
+// loadUcf() against the simulated device: a configuration that writes
+// registers of both banks and a program through PAGE_VALUE, given as a table
+// and as UCF text. Checks the registers and pages afterwards, the bursts it
+// takes, and that IF_INC and the register bank are restored after success
+// and failure. QwUcfReader on comments, WAIT and malformed lines.
+
+#include "sfe_ism330dhcx.h"
+#include "sfe_ism330dhcx_sim.h"
+#include "test_util.h"
+#include <string>
+#include <vector>
+
+using namespace sfe_ISM330DHCX;
+
+#define SIM_USER_BANK 0
+#define SIM_EMB_BANK 2
+
+// Program bytes written to page 1 from address 0x10, longer than a burst
+#define TEST_PROGRAM_BYTES 40
+
+static uint8_t programByte(int i)
+{
+	return (uint8_t)(i * 7 + 1);
+}
+
+// An MLC style configuration: output data rates off, the program written to
+// page 1 in page write mode, the MLC enabled and the data rates set again
+static std::vector<sfe_ism_ucf_line_t> configuration()
+{
+	std::vector<sfe_ism_ucf_line_t> lines;
+	sfe_ism_ucf_line_t line;
+
+	line = { ISM330DHCX_CTRL1_XL, 0x00 };       lines.push_back(line);
+	line = { ISM330DHCX_CTRL2_G, 0x00 };        lines.push_back(line);
+	line = { ISM330DHCX_FUNC_CFG_ACCESS, 0x80 }; lines.push_back(line);
+	line = { ISM330DHCX_EMB_FUNC_EN_B, 0x00 };  lines.push_back(line);
+	line = { ISM330DHCX_PAGE_RW, 0x40 };        lines.push_back(line);
+	line = { ISM330DHCX_PAGE_SEL, 0x11 };       lines.push_back(line);
+	line = { ISM330DHCX_PAGE_ADDRESS, 0x10 };   lines.push_back(line);
+
+	for( int i = 0; i < TEST_PROGRAM_BYTES; i++ )
+	{
+		line = { ISM330DHCX_PAGE_VALUE, programByte(i) };
+		lines.push_back(line);
+	}
+
+	line = { ISM330DHCX_PAGE_RW, 0x00 };        lines.push_back(line);
+	line = { ISM330DHCX_PAGE_SEL, 0x01 };       lines.push_back(line);
+	line = { ISM330DHCX_EMB_FUNC_EN_B, 0x10 };  lines.push_back(line);
+	line = { ISM330DHCX_FUNC_CFG_ACCESS, 0x00 }; lines.push_back(line);
+	line = { ISM330DHCX_CTRL1_XL, 0x4C };       lines.push_back(line);
+	line = { ISM330DHCX_CTRL2_G, 0x4C };        lines.push_back(line);
+
+	return lines;
+}
+
+// The configuration as a UCF file with comments, blank lines and a wait
+static std::string configurationText()
+{
+	std::vector<sfe_ism_ucf_line_t> lines = configuration();
+	std::string text = "-- Test configuration\r\n\r\n";
+	char buff[32];
+
+	for( size_t i = 0; i < lines.size(); i++ )
+	{
+		snprintf(buff, sizeof(buff), "Ac %02X %02x\n", lines[i].address, lines[i].data);
+		text += buff;
+
+		if( i == 1 )
+			text += "WAIT 1\n  -- indented comment\n";
+	}
+
+	return text;
+}
+
+static void setUp(QwSimISM330DHCX& sim, QwDevISM330DHCX& dev)
+{
+	dev.setCommunicationBus(sim, ISM330DHCX_ADDRESS_HIGH);
+	CHECK(dev.init());
+}
+
+// IF_INC set and the user bank selected, on the device and for the driver
+static void checkRestored(QwSimISM330DHCX& sim, QwDevISM330DHCX& dev)
+{
+	CHECK_EQ(sim.peekRegister(SIM_USER_BANK, ISM330DHCX_CTRL3_C) & 0x04, 0x04);
+	CHECK_EQ(sim.peekRegister(SIM_USER_BANK, ISM330DHCX_FUNC_CFG_ACCESS), 0x00);
+	CHECK_EQ(dev.getUniqueId(), ISM330DHCX_ID);
+}
+
+static void checkLoaded(QwSimISM330DHCX& sim)
+{
+	CHECK_EQ(sim.peekRegister(SIM_USER_BANK, ISM330DHCX_CTRL1_XL), 0x4C);
+	CHECK_EQ(sim.peekRegister(SIM_USER_BANK, ISM330DHCX_CTRL2_G), 0x4C);
+	CHECK_EQ(sim.peekRegister(SIM_EMB_BANK, ISM330DHCX_EMB_FUNC_EN_B), 0x10);
+	CHECK_EQ(sim.peekRegister(SIM_EMB_BANK, ISM330DHCX_PAGE_RW), 0x00);
+	CHECK_EQ(sim.peekRegister(SIM_EMB_BANK, ISM330DHCX_PAGE_SEL), 0x01);
+
+	// The program went to consecutive page addresses, nothing around it
+	for( int i = 0; i < TEST_PROGRAM_BYTES; i++ )
+		CHECK_EQ(sim.peekPage(1, 0x10 + i), programByte(i));
+
+	CHECK_EQ(sim.peekPage(1, 0x0F), 0);
+	CHECK_EQ(sim.peekPage(1, 0x10 + TEST_PROGRAM_BYTES), 0);
+	CHECK_EQ(sim.peekPage(0, 0x10), 0);
+	CHECK_EQ(sim.peekRegister(SIM_EMB_BANK, ISM330DHCX_PAGE_ADDRESS), 0x10 + TEST_PROGRAM_BYTES);
+}
+
+static void testTable()
+{
+	QwSimISM330DHCX sim;
+	QwDevISM330DHCX dev;
+	std::vector<sfe_ism_ucf_line_t> lines = configuration();
+
+	setUp(sim, dev);
+	sim.resetStats();
+
+	CHECK(dev.loadUcf(lines.data(), (uint16_t)lines.size(), false));
+
+	checkLoaded(sim);
+	checkRestored(sim, dev);
+
+	// 58 writes in 17 transactions: CTRL1_XL/CTRL2_G twice, EMB_FUNC_EN_B,
+	// PAGE_RW and PAGE_SEL twice each, PAGE_ADDRESS and the program in two
+	// bursts of up to ISM_UCF_RUN_BYTES. CTRL3_C clears IF_INC before the 
+	// program and sets it again for the last burst, with a switch to the user
+	// bank and back around the first. The configuration's own bank switches 
+	// take two.
+	CHECK_EQ(sim.getStats().numWrites, 17);
+	CHECK(sim.getStats().numWrites < lines.size() / 2);
+}
+
+static void testTableVerify()
+{
+	QwSimISM330DHCX sim;
+	QwDevISM330DHCX dev;
+	std::vector<sfe_ism_ucf_line_t> lines = configuration();
+	QwSimStats plain;
+
+	setUp(sim, dev);
+	sim.resetStats();
+	CHECK(dev.loadUcf(lines.data(), (uint16_t)lines.size(), false));
+	plain = sim.getStats();
+
+	// Loading again with verify reads every burst back, the program through
+	// page reads, and leaves the page in write mode where it was
+	sim.resetStats();
+	CHECK(dev.loadUcf(lines.data(), (uint16_t)lines.size(), true));
+
+	checkLoaded(sim);
+	checkRestored(sim, dev);
+	CHECK(sim.getStats().numReads > plain.numReads);
+	CHECK(sim.getStats().bytesRead >= plain.bytesRead + lines.size() - 4);
+}
+
+static void testText()
+{
+	QwSimISM330DHCX sim;
+	QwDevISM330DHCX dev;
+	std::string text = configurationText();
+
+	setUp(sim, dev);
+
+	CHECK(dev.loadUcf(text.c_str(), true));
+
+	checkLoaded(sim);
+	checkRestored(sim, dev);
+}
+
+// Failures part way through still restore IF_INC and the bank
+static void testFailedLoads()
+{
+	QwSimISM330DHCX sim;
+	QwDevISM330DHCX dev;
+	std::vector<sfe_ism_ucf_line_t> lines = configuration();
+	std::string text = configurationText();
+	size_t cut;
+
+	setUp(sim, dev);
+
+	// A malformed line after the first program burst, with IF_INC off and the
+	// embedded function bank selected
+	cut = text.find("Ac 17 00");
+	CHECK(cut != std::string::npos);
+	CHECK(!dev.loadUcf((text.substr(0, cut) + "Ac 17\n").c_str(), false));
+	checkRestored(sim, dev);
+
+	// A program run broken by a register write, then a write WHO_AM_I doesn't
+	// take which verify catches
+	lines.insert(lines.begin() + 20, sfe_ism_ucf_line_t{ ISM330DHCX_PAGE_SEL, 0x11 });
+	lines.push_back(sfe_ism_ucf_line_t{ ISM330DHCX_WHO_AM_I, 0x00 });
+	CHECK(!dev.loadUcf(lines.data(), (uint16_t)lines.size(), true));
+	checkRestored(sim, dev);
+
+	// A configuration that clears IF_INC itself keeps it cleared
+	const sfe_ism_ucf_line_t incOff[] = {
+		{ ISM330DHCX_CTRL3_C, 0x00 },
+		{ ISM330DHCX_CTRL1_XL, 0x40 },
+		{ ISM330DHCX_CTRL2_G, 0x40 },
+	};
+
+	CHECK(dev.loadUcf(incOff, 3, false));
+	CHECK_EQ(sim.peekRegister(SIM_USER_BANK, ISM330DHCX_CTRL3_C) & 0x04, 0);
+	CHECK_EQ(sim.peekRegister(SIM_USER_BANK, ISM330DHCX_FUNC_CFG_ACCESS), 0x00);
+	CHECK_EQ(sim.peekRegister(SIM_USER_BANK, ISM330DHCX_CTRL1_XL), 0x40);
+	CHECK_EQ(sim.peekRegister(SIM_USER_BANK, ISM330DHCX_CTRL2_G), 0x40);
+
+	// Not inside a deferred configuration
+	CHECK(dev.beginConfig());
+	CHECK(!dev.loadUcf(incOff, 3, false));
+	CHECK(dev.commitConfig());
+}
+
+static void testReader()
+{
+	const char* text =
+		"-- header\n"
+		"\n"
+		"Ac 10 4c\r\n"
+		"  \tAc\t11   A\n"
+		"WAIT   25\n"
+		"Ac 12 00   \n"
+		"Ac 13 00";
+	QwUcfReader reader(text);
+	sfe_ism_ucf_line_t line;
+	uint16_t waitMs;
+
+	CHECK_EQ(reader.next(&line, &waitMs), ISM_UCF_WRITE);
+	CHECK_EQ(reader.getLine(), 3);
+	CHECK_EQ(line.address, 0x10);
+	CHECK_EQ(line.data, 0x4C);
+
+	CHECK_EQ(reader.next(&line, &waitMs), ISM_UCF_WRITE);
+	CHECK_EQ(reader.getLine(), 4);
+	CHECK_EQ(line.address, 0x11);
+	CHECK_EQ(line.data, 0x0A);
+
+	CHECK_EQ(reader.next(&line, &waitMs), ISM_UCF_WAIT);
+	CHECK_EQ(reader.getLine(), 5);
+	CHECK_EQ(waitMs, 25);
+
+	CHECK_EQ(reader.next(&line, &waitMs), ISM_UCF_WRITE);
+	CHECK_EQ(line.address, 0x12);
+	CHECK_EQ(reader.next(&line, &waitMs), ISM_UCF_WRITE);
+	CHECK_EQ(reader.getLine(), 7);
+	CHECK_EQ(line.address, 0x13);
+	CHECK_EQ(reader.next(&line, &waitMs), ISM_UCF_END);
+
+	// Malformed lines and the line they are reported on
+	const char* bad[] = {
+		"Ac 10\n",
+		"Ac 100 00\n",
+		"Ac 10 0x\n",
+		"Ac10 00\n",
+		"Xx 10 00\n",
+		"WAIT\n",
+		"WAIT 70000\n",
+		"WAIT 5 ms\n",
+		"- single dash\n",
+	};
+
+	for( size_t i = 0; i < sizeof(bad) / sizeof(bad[0]); i++ )
+	{
+		std::string badText = std::string("-- ok\nAc 10 00\n") + bad[i] + "Ac 11 00\n";
+		QwUcfReader badReader(badText.c_str());
+
+		CHECK_EQ(badReader.next(&line, &waitMs), ISM_UCF_WRITE);
+		CHECK_EQ(badReader.next(&line, &waitMs), ISM_UCF_ERROR);
+		CHECK_EQ(badReader.getLine(), 3);
+	}
+}
+
+int main()
+{
+	testTable();
+	testTableVerify();
+	testText();
+	testFailedLoads();
+	testReader();
+
+	return testResult("test_ucf");
+}
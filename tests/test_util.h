@@ -0,0 +1,82 @@
+// test_util.h
+//
+// This is a library written for SparkFun Qwiic ISM330DHCX boards
+//
+// SparkFun sells these boards at its website: www.sparkfun.com
+//
+// Do you like this library? Help support SparkFun. Buy a board!
+//
+//SparkFun Qwiic 6DoF - ISM330DHCX        https://www.sparkfun.com/products/19764
+//
+// Repository:
+//     https://github.com/sparkfun/SparkFun_6DoF_ISM330DHCX_Arduino_Library
+//
+//
+// SparkFun code, firmware, and software is released under the MIT
+// License(http://opensource.org/licenses/MIT).
+//
+// SPDX-License-Identifier: MIT
+
+// Checks for the host tests, so they need no test framework. A failed check
+// prints where it failed and the test carries on, main() returns
+// testResult() which is non zero if any check failed.
+
+#pragma once
+
+#include <stdint.h>
+#include <stdio.h>
+#include <math.h>
+#include <time.h>
+
+static inline int& testFailures()
+{
+	static int failures = 0;
+	return failures;
+}
+
+#define CHECK(cond) \
+	do { \
+		if( !(cond) ) \
+		{ \
+			printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); \
+			testFailures()++; \
+		} \
+	} while( 0 )
+
+#define CHECK_EQ(a, b) \
+	do { \
+		long long va = (long long)(a); \
+		long long vb = (long long)(b); \
+		if( va != vb ) \
+		{ \
+			printf("%s:%d: CHECK_EQ(%s, %s) failed: %lld != %lld\n", __FILE__, __LINE__, #a, #b, va, vb); \
+			testFailures()++; \
+		} \
+	} while( 0 )
+
+#define CHECK_NEAR(a, b, tolerance) \
+	do { \
+		double va = (double)(a); \
+		double vb = (double)(b); \
+		if( fabs(va - vb) > (tolerance) ) \
+		{ \
+			printf("%s:%d: CHECK_NEAR(%s, %s) failed: %g != %g\n", __FILE__, __LINE__, #a, #b, va, vb); \
+			testFailures()++; \
+		} \
+	} while( 0 )
+
+static inline int testResult(const char* name)
+{
+	printf("%s: %s\n", name, testFailures() ? "FAILED" : "passed");
+	return testFailures() ? 1 : 0;
+}
+
+// Monotonic host time for the benchmarks
+static inline uint64_t benchNowNs()
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}